@@ -0,0 +1,210 @@
+/***************************************************************************************************
+ FILE:	audio.analysis.hpp
+ CPP:	audio.analysis.cpp
+ DESCR:	Level and waveform analysis of audio data
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_ANALYSIS
+#define ROBINLE_AUDIO_ANALYSIS
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+
+//==================================================================================================
+// FORWARD DECLARATIONS
+
+namespace rl
+{
+	class Sound;
+}
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// The level of a single channel in a range of audio data
+	/// </summary>
+	struct AudioLevel
+	{
+		float fMin; // lowest sample value (-1.0f to 1.0f)
+		float fMax; // highest sample value (-1.0f to 1.0f)
+		float fRMS; // root mean square
+
+		inline float peak() const noexcept { return fMax > -fMin ? fMax : -fMin; }
+	};
+
+
+
+	/// <summary>
+	/// Analyze interleaved 32-bit float audio data
+	/// </summary>
+	/// <param name="pDest">= Receives one <c>AudioLevel</c> per channel</param>
+	void AnalyzeAudio(const float* pData, size_t iSampleCount, uint8_t iChannelCount,
+		AudioLevel* pDest) noexcept;
+
+	/// <summary>
+	/// Analyze a range of samples of a <c>Sound</c>
+	/// </summary>
+	/// <param name="pDest">= Receives one <c>AudioLevel</c> per channel</param>
+	/// <param name="iSampleCount">
+	/// = The maximum count of samples. Gets limited to the samples available.
+	/// </param>
+	/// <returns>Was the range valid?</returns>
+	bool AnalyzeSound(const Sound& sound, AudioLevel* pDest, size_t iFirstSample = 0,
+		size_t iSampleCount = (size_t)-1) noexcept;
+
+	/// <summary>
+	/// Get a summary of the waveform of a <c>Sound</c>, e.g. for drawing it<para/>
+	/// The range is split into <c>iBucketCount</c> buckets of (almost) equal size, every bucket
+	/// is analyzed individually
+	/// </summary>
+	/// <param name="pDest">
+	/// = Receives <c>iBucketCount</c> * channel count <c>AudioLevel</c>s, ordered by bucket, then
+	/// channel
+	/// </param>
+	/// <param name="iSampleCount">
+	/// = The maximum count of samples. Gets limited to the samples available.
+	/// </param>
+	/// <returns>Was the range valid?</returns>
+	bool GetWaveformSummary(const Sound& sound, AudioLevel* pDest, size_t iBucketCount,
+		size_t iFirstSample = 0, size_t iSampleCount = (size_t)-1) noexcept;
+
+
+
+	/// <summary>
+	/// A precalculated, multi-resolution summary of the levels of a <c>Sound</c><para/>
+	/// Level 0 holds one <c>AudioLevel</c> per channel for every block of <c>getBlockSize()</c>
+	/// samples, every further level combines two buckets of the level below, up to a single bucket
+	/// for the whole sound. Any range can be answered from O(log n) buckets, so drawing a waveform
+	/// or querying the loudness of a window is independent of the length of the sound.<para/>
+	/// The results are those of the blocks that overlap the range, i.e. the range is extended to
+	/// multiples of the block size.<para/>
+	/// Attach an envelope to its sound via <c>Sound::setEnvelope()</c>; <c>SoundBank</c> stores
+	/// attached envelopes, <c>save()</c> creates data for any other storage (like a
+	/// <c>FileContainer</c>).
+	/// </summary>
+	class AudioEnvelope final
+	{
+	public: // static variables
+
+		static constexpr uint32_t DefaultBlockSize = 256;
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Calculate the envelope of a sound
+		/// </summary>
+		/// <returns>The envelope or <c>nullptr</c> if the sound is empty</returns>
+		static std::shared_ptr<AudioEnvelope> Create(const Sound& sound,
+			uint32_t iBlockSize = DefaultBlockSize);
+		/// <summary>
+		/// Load an envelope from data created by <c>save()</c>
+		/// </summary>
+		/// <returns>The envelope or <c>nullptr</c> if the data is invalid</returns>
+		static std::shared_ptr<AudioEnvelope> FromMemory(const void* data, size_t size);
+
+
+	public: // methods
+
+		AudioEnvelope() = default;
+		AudioEnvelope(const AudioEnvelope& other) = default;
+		AudioEnvelope(AudioEnvelope&& rval) = default;
+		~AudioEnvelope() = default;
+
+		AudioEnvelope& operator=(const AudioEnvelope& other) = default;
+		AudioEnvelope& operator=(AudioEnvelope&& rval) = default;
+
+		/// <summary>
+		/// Write the envelope to memory<para/>
+		/// Only level 0 is stored, the other levels are recalculated when loading.
+		/// </summary>
+		void save(std::vector<uint8_t>& oDest) const;
+
+		inline size_t getSampleCount() const noexcept { return m_iSampleCount; }
+		inline uint8_t getChannelCount() const noexcept { return m_iChannelCount; }
+		inline uint32_t getBlockSize() const noexcept { return m_iBlockSize; }
+		inline size_t getLevelCount() const noexcept { return m_oLevels.size(); }
+
+		/// <summary>
+		/// Get the count of buckets in a level
+		/// </summary>
+		size_t getBucketCount(size_t iLevel) const noexcept;
+		/// <summary>
+		/// Get the buckets of a level
+		/// </summary>
+		/// <returns>
+		/// <c>getBucketCount(iLevel)</c> * channel count <c>AudioLevel</c>s, ordered by bucket,
+		/// then channel (<c>nullptr</c> if the level doesn't exist)
+		/// </returns>
+		const AudioLevel* getLevelData(size_t iLevel) const noexcept;
+
+		/// <summary>
+		/// Get the levels of a range of samples (like <c>AnalyzeSound()</c>)
+		/// </summary>
+		/// <param name="pDest">= Receives one <c>AudioLevel</c> per channel</param>
+		/// <returns>Was the range valid?</returns>
+		bool analyze(AudioLevel* pDest, size_t iFirstSample = 0,
+			size_t iSampleCount = (size_t)-1) const noexcept;
+
+		/// <summary>
+		/// Get a summary of the waveform (like <c>GetWaveformSummary()</c>)
+		/// </summary>
+		/// <returns>Was the range valid?</returns>
+		bool getWaveformSummary(AudioLevel* pDest, size_t iBucketCount, size_t iFirstSample = 0,
+			size_t iSampleCount = (size_t)-1) const noexcept;
+
+
+	private: // methods
+
+		/// <summary>
+		/// Calculate levels 1 to n from level 0
+		/// </summary>
+		void createPyramid();
+
+		/// <summary>
+		/// Get the count of samples summarized by a bucket
+		/// </summary>
+		size_t getBucketSampleCount(size_t iLevel, size_t iBucket) const noexcept;
+
+
+	private: // variables
+
+		size_t m_iSampleCount = 0;
+		uint8_t m_iChannelCount = 0;
+		uint32_t m_iBlockSize = 0;
+		std::vector<std::vector<AudioLevel>> m_oLevels;
+
+	};
+
+
+
+	/// <summary>
+	/// Get the envelope attached to a sound; create and attach it if there is none yet
+	/// </summary>
+	/// <returns>The envelope or <c>nullptr</c> if the sound is empty</returns>
+	const AudioEnvelope* GetEnvelope(Sound& sound);
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_ANALYSIS
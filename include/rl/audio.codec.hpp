@@ -0,0 +1,117 @@
+/***************************************************************************************************
+ FILE:	audio.codec.hpp
+ CPP:	audio.codec.cpp
+ DESCR:	Block-based compression of 16-bit PCM audio data (IMA ADPCM, MS ADPCM, lossless)
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_CODEC
+#define ROBINLE_AUDIO_CODEC
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// Compression methods for sample data that's kept in memory<para/>
+	/// All methods decode to 16-bit PCM.
+	/// </summary>
+	enum class AudioCompression : uint8_t
+	{
+		None,
+		/// <summary>
+		/// IMA/DVI ADPCM (<c>WAVE_FORMAT_IMA_ADPCM</c>), 4 bits per sample
+		/// </summary>
+		IMA_ADPCM,
+		/// <summary>
+		/// Microsoft ADPCM (<c>WAVE_FORMAT_ADPCM</c>) with the standard coefficients, 4 bits per
+		/// sample
+		/// </summary>
+		MS_ADPCM,
+		/// <summary>
+		/// Fixed linear prediction (order 0 to 3) with Rice coded residuals, bit-exact
+		/// </summary>
+		Lossless
+	};
+
+
+
+	/// <summary>
+	/// The layout of compressed sample data<para/>
+	/// Compressed data is a series of blocks that can be decoded independently.
+	/// ADPCM blocks have a fixed size of <c>iBlockAlign</c> bytes (the last one may be shorter);
+	/// lossless data starts with the sample count and a table of block offsets (block count + 1),
+	/// all stored as <c>uint32_t</c>.
+	/// </summary>
+	struct AudioCompressionFormat
+	{
+		AudioCompression eCompression = AudioCompression::None;
+		uint32_t iSamplesPerBlock = 0;
+		uint32_t iBlockAlign = 0; // ADPCM only
+	};
+
+
+
+	/// <summary>
+	/// Check if a compression format is supported and consistent
+	/// </summary>
+	bool ValidCompressionFormat(const AudioCompressionFormat& oFormat,
+		uint8_t iChannelCount) noexcept;
+
+	/// <summary>
+	/// Get the count of blocks in compressed data
+	/// </summary>
+	size_t GetCompressedBlockCount(const AudioCompressionFormat& oFormat, const uint8_t* pData,
+		size_t iDataSize) noexcept;
+
+	/// <summary>
+	/// Get the count of samples that can be decoded from compressed data<para/>
+	/// IMA ADPCM blocks hold a multiple of 8 samples (plus one), so the last block might contain
+	/// up to 7 padding samples. The exact count has to be stored separately (like in the
+	/// <c>"fact"</c> chunk of a WAV file).
+	/// </summary>
+	size_t GetCompressedSampleCount(const AudioCompressionFormat& oFormat, uint8_t iChannelCount,
+		const uint8_t* pData, size_t iDataSize) noexcept;
+
+	/// <summary>
+	/// Decode a single block of compressed data to interleaved 16-bit PCM
+	/// </summary>
+	/// <param name="pDest">
+	/// = The destination buffer. Must have room for <c>iSamplesPerBlock</c> * channel count
+	/// values.
+	/// </param>
+	/// <returns>The count of samples decoded (0 on invalid data)</returns>
+	size_t DecodeAudioBlock(const AudioCompressionFormat& oFormat, uint8_t iChannelCount,
+		const uint8_t* pData, size_t iDataSize, size_t iBlock, int16_t* pDest) noexcept;
+
+	/// <summary>
+	/// Compress interleaved 16-bit PCM data
+	/// </summary>
+	/// <param name="oFormat">= Receives the layout of the compressed data</param>
+	/// <param name="oDest">= Receives the compressed data</param>
+	/// <returns>Could the data be compressed?</returns>
+	bool EncodeAudio(AudioCompression eCompression, const int16_t* pSamples, size_t iSampleCount,
+		uint8_t iChannelCount, AudioCompressionFormat& oFormat, std::vector<uint8_t>& oDest);
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_CODEC
@@ -0,0 +1,518 @@
+/***************************************************************************************************
+ FILE:	audio.effects.hpp
+ CPP:	audio.effects.cpp
+ DESCR:	Block-based DSP effects (filters, dynamics, delay, convolution reverb) that can be
+		inserted on submix and mastering voices
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_EFFECTS
+#define ROBINLE_AUDIO_EFFECTS
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "audio.engine.hpp"
+#include "tools.publishedptr.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <xmmintrin.h> // SSE
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// A block of audio data in the layout all effects work on<para/>
+	/// The channels are stored as a structure of arrays in groups of 4 lanes:
+	/// The channels <c>4g</c> to <c>4g + 3</c> of sample <c>i</c> are stored in
+	/// <c>pData[i * iGroupCount + g]</c>. Unused lanes are zero.
+	/// </summary>
+	struct AudioEffectBlock
+	{
+		__m128* pData;
+		uint32_t iSampleCount;
+		uint8_t iChannelCount;
+		uint8_t iGroupCount;
+	};
+
+
+
+	/// <summary>
+	/// An effect parameter that can be set from any thread and is smoothly followed by the audio
+	/// thread (exponential approach with a configurable time constant)
+	/// </summary>
+	class SmoothedParameter final
+	{
+	public: // types
+
+		/// <summary>
+		/// A linear ramp over a sub-block of samples
+		/// </summary>
+		struct Ramp
+		{
+			float fValue; // value at the first sample
+			float fStep; // value increment per sample
+		};
+
+
+	public: // methods
+
+		SmoothedParameter(float fValue) noexcept : m_fTarget(fValue), m_fCurrent(fValue) {}
+
+		inline void set(float fValue) noexcept
+		{
+			m_fTarget.store(fValue, std::memory_order_relaxed);
+		}
+		inline float get() const noexcept { return m_fTarget.load(std::memory_order_relaxed); }
+
+
+		// audio thread only
+
+		/// <summary>
+		/// Set the smoothing time and jump to the target value
+		/// </summary>
+		/// <param name="fTimeConstant">= The time constant of the smoothing, in seconds</param>
+		void init(uint32_t iSampleRate, float fTimeConstant = 0.01f) noexcept;
+
+		/// <summary>
+		/// Advance the smoothing by a count of samples
+		/// </summary>
+		/// <returns>The linear ramp that leads from the current value to the new value</returns>
+		Ramp advance(uint32_t iSampleCount) noexcept;
+
+		inline float current() const noexcept { return m_fCurrent; }
+		inline bool isSmoothing() const noexcept { return m_fCurrent != get(); }
+
+
+	private: // variables
+
+		std::atomic<float> m_fTarget;
+		float m_fCurrent;
+		float m_fTimeConstant = 1.0f; // in samples
+
+	};
+
+
+
+	/// <summary>
+	/// Interface for block-based audio effects<para/>
+	/// Parameters may be changed from any thread while the effect is processed, everything
+	/// else must be synchronized by the owner (usually an <c>AudioEffectChain</c>).
+	/// </summary>
+	class IAudioEffect
+	{
+	public: // methods
+
+		virtual ~IAudioEffect() = default;
+
+		/// <summary>
+		/// Allocate the internal state for a format<para/>
+		/// Must be called before the first call to <c>process()</c>. Resets the effect.
+		/// </summary>
+		/// <param name="iMaxSampleCount">
+		/// = The maximum sample count that will be passed to <c>process()</c>
+		/// </param>
+		virtual void prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+			uint32_t iMaxSampleCount) = 0;
+
+		/// <summary>
+		/// Clear the internal state (filter memory, delay lines etc.)
+		/// </summary>
+		virtual void reset() noexcept = 0;
+
+		/// <summary>
+		/// Process a block of audio data in place
+		/// </summary>
+		virtual void process(AudioEffectBlock& oBlock) noexcept = 0;
+
+		inline void setBypass(bool bBypass) noexcept { m_bBypass = bBypass; }
+		inline bool getBypass() const noexcept { return m_bBypass; }
+
+		inline uint32_t getSampleRate() const noexcept { return m_iSampleRate; }
+		inline uint8_t getChannelCount() const noexcept { return m_iChannelCount; }
+
+
+	protected: // variables
+
+		uint32_t m_iSampleRate = 0;
+		uint8_t m_iChannelCount = 0;
+
+
+	private: // variables
+
+		std::atomic<bool> m_bBypass = false;
+
+	};
+
+
+
+	/// <summary>
+	/// Second order IIR filter ("Audio EQ Cookbook" coefficients)<para/>
+	/// All channels are filtered at once, one channel per SIMD lane.
+	/// </summary>
+	class BiquadFilter final : public IAudioEffect
+	{
+	public: // types
+
+		enum class Type : uint8_t
+		{
+			LowPass,
+			HighPass,
+			BandPass,
+			Notch,
+			Peak, // uses the gain
+			LowShelf, // uses the gain
+			HighShelf // uses the gain
+		};
+
+
+	public: // methods
+
+		BiquadFilter(Type eType = Type::LowPass, float fFrequency = 1000.0f,
+			float fQ = 0.70710678f, float fGainDB = 0.0f) noexcept;
+
+		void prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+			uint32_t iMaxSampleCount) override;
+		void reset() noexcept override;
+		void process(AudioEffectBlock& oBlock) noexcept override;
+
+		inline void setType(Type eType) noexcept { m_eType = eType; }
+		inline void setFrequency(float fFrequency) noexcept { m_oFrequency.set(fFrequency); }
+		inline void setQ(float fQ) noexcept { m_oQ.set(fQ); }
+		inline void setGain(float fGainDB) noexcept { m_oGainDB.set(fGainDB); }
+
+		inline Type getType() const noexcept { return m_eType; }
+		inline float getFrequency() const noexcept { return m_oFrequency.get(); }
+		inline float getQ() const noexcept { return m_oQ.get(); }
+		inline float getGain() const noexcept { return m_oGainDB.get(); }
+
+
+	private: // methods
+
+		void calcCoefficients(Type eType) noexcept;
+
+
+	private: // variables
+
+		std::atomic<Type> m_eType;
+		SmoothedParameter m_oFrequency;
+		SmoothedParameter m_oQ;
+		SmoothedParameter m_oGainDB;
+
+		Type m_eCurrentType;
+		float m_fB0 = 1.0f, m_fB1 = 0.0f, m_fB2 = 0.0f, m_fA1 = 0.0f, m_fA2 = 0.0f;
+		std::vector<__m128> m_oZ1, m_oZ2; // transposed direct form II state, one per group
+
+	};
+
+
+
+	/// <summary>
+	/// Feed-forward compressor with a soft knee<para/>
+	/// The level is detected from the loudest channel (linked stereo/surround), the gain
+	/// computer works in the logarithmic domain, 4 samples at once.
+	/// </summary>
+	class Compressor : public IAudioEffect
+	{
+	public: // methods
+
+		Compressor(float fThresholdDB = -20.0f, float fRatio = 4.0f, float fAttack = 0.01f,
+			float fRelease = 0.1f, float fKneeDB = 6.0f, float fMakeupGainDB = 0.0f) noexcept;
+
+		void prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+			uint32_t iMaxSampleCount) override;
+		void reset() noexcept override;
+		void process(AudioEffectBlock& oBlock) noexcept override;
+
+		inline void setThreshold(float fThresholdDB) noexcept { m_oThresholdDB.set(fThresholdDB); }
+		/// <summary>
+		/// Set the compression ratio (>= 1.0f, <c>INFINITY</c> = limiter)
+		/// </summary>
+		void setRatio(float fRatio) noexcept;
+		/// <summary>Set the attack time, in seconds</summary>
+		inline void setAttack(float fAttack) noexcept { m_fAttack = fAttack; }
+		/// <summary>Set the release time, in seconds</summary>
+		inline void setRelease(float fRelease) noexcept { m_fRelease = fRelease; }
+		inline void setKnee(float fKneeDB) noexcept { m_oKneeDB.set(fKneeDB); }
+		inline void setMakeupGain(float fGainDB) noexcept { m_oMakeupGainDB.set(fGainDB); }
+
+		inline float getThreshold() const noexcept { return m_oThresholdDB.get(); }
+		float getRatio() const noexcept;
+		inline float getAttack() const noexcept { return m_fAttack; }
+		inline float getRelease() const noexcept { return m_fRelease; }
+		inline float getKnee() const noexcept { return m_oKneeDB.get(); }
+		inline float getMakeupGain() const noexcept { return m_oMakeupGainDB.get(); }
+
+		/// <summary>
+		/// Get the maximum gain reduction of the last processed block, in dB (>= 0.0f)
+		/// </summary>
+		inline float getGainReduction() const noexcept { return m_fGainReduction; }
+
+
+	private: // variables
+
+		SmoothedParameter m_oThresholdDB;
+		SmoothedParameter m_oSlope; // 1 - 1 / ratio
+		SmoothedParameter m_oKneeDB;
+		SmoothedParameter m_oMakeupGainDB;
+		std::atomic<float> m_fAttack;
+		std::atomic<float> m_fRelease;
+		std::atomic<float> m_fGainReduction = 0.0f;
+
+		float m_fEnvelope = 0.0f;
+		std::vector<float> m_oLevels; // per sample: detected level, then gain
+
+	};
+
+
+
+	/// <summary>
+	/// A compressor with an infinite ratio, a hard knee and a fast attack
+	/// </summary>
+	class Limiter final : public Compressor
+	{
+	public: // methods
+
+		Limiter(float fThresholdDB = -1.0f, float fRelease = 0.05f) noexcept :
+			Compressor(fThresholdDB, INFINITY, 0.0005f, fRelease, 0.0f) {}
+
+	};
+
+
+
+	/// <summary>
+	/// Feedback delay with a smoothly modulated (fractional) delay time
+	/// </summary>
+	class Delay final : public IAudioEffect
+	{
+	public: // methods
+
+		/// <param name="fMaxDelayTime">= The maximum delay time, in seconds</param>
+		Delay(float fDelayTime = 0.25f, float fFeedback = 0.4f, float fMix = 0.3f,
+			float fMaxDelayTime = 2.0f) noexcept;
+
+		void prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+			uint32_t iMaxSampleCount) override;
+		void reset() noexcept override;
+		void process(AudioEffectBlock& oBlock) noexcept override;
+
+		/// <summary>Set the delay time, in seconds</summary>
+		inline void setDelayTime(float fSeconds) noexcept { m_oDelayTime.set(fSeconds); }
+		/// <summary>Set the feedback gain (<c>[0.0f, 1.0f)</c>)</summary>
+		inline void setFeedback(float fFeedback) noexcept { m_oFeedback.set(fFeedback); }
+		/// <summary>Set the wet/dry mix (0.0f = dry only, 1.0f = wet only)</summary>
+		inline void setMix(float fMix) noexcept { m_oMix.set(fMix); }
+
+		inline float getDelayTime() const noexcept { return m_oDelayTime.get(); }
+		inline float getFeedback() const noexcept { return m_oFeedback.get(); }
+		inline float getMix() const noexcept { return m_oMix.get(); }
+		inline float getMaxDelayTime() const noexcept { return m_fMaxDelayTime; }
+
+
+	private: // variables
+
+		const float m_fMaxDelayTime;
+		SmoothedParameter m_oDelayTime;
+		SmoothedParameter m_oFeedback;
+		SmoothedParameter m_oMix;
+
+		std::vector<__m128> m_oBuffer; // ring buffer, same layout as AudioEffectBlock
+		size_t m_iBufferSampleCount = 0;
+		size_t m_iWritePos = 0;
+
+	};
+
+
+
+	/// <summary>
+	/// Reverb by convolution with an impulse response<para/>
+	/// Uses uniformly partitioned overlap-save FFT convolution, the wet signal has a latency of
+	/// <c>PartitionSize</c> samples. With a mono impulse response, two channels are convolved
+	/// by a single complex FFT.
+	/// </summary>
+	class ConvolutionReverb final : public IAudioEffect
+	{
+	public: // types
+
+		static constexpr uint32_t PartitionSize = 256;
+
+
+	public: // methods
+
+		ConvolutionReverb(float fWet = 0.3f, float fDry = 1.0f) noexcept;
+		~ConvolutionReverb();
+
+		/// <summary>
+		/// Set the impulse response<para/>
+		/// Can be called at any time, the transformation is done on the calling thread.
+		/// <c>process()</c> switches to the new impulse response without waiting.
+		/// </summary>
+		/// <param name="pData">= Interleaved impulse response samples</param>
+		/// <param name="iSampleCount">= The length of the impulse response, in samples</param>
+		/// <param name="iChannelCount">
+		/// = 1 (for all channels) or the channel count of the processed audio
+		/// </param>
+		/// <returns>Could the impulse response be set?</returns>
+		bool setImpulseResponse(const float* pData, size_t iSampleCount, uint8_t iChannelCount);
+
+		/// <summary>
+		/// Set the impulse response to the samples of a <c>Sound</c>
+		/// </summary>
+		bool setImpulseResponse(const Sound& oSound);
+
+		void prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+			uint32_t iMaxSampleCount) override;
+		void reset() noexcept override;
+		void process(AudioEffectBlock& oBlock) noexcept override;
+
+		inline void setWet(float fWet) noexcept { m_oWet.set(fWet); }
+		inline void setDry(float fDry) noexcept { m_oDry.set(fDry); }
+
+		inline float getWet() const noexcept { return m_oWet.get(); }
+		inline float getDry() const noexcept { return m_oDry.get(); }
+
+
+	private: // types
+
+		struct Kernel; // transformed impulse response
+		struct Line; // state of one convolution (one or two channels)
+		struct State; // kernel and lines, replaced as a whole
+
+
+	private: // methods
+
+		/// <summary>
+		/// Create new lines for the current kernel and format and hand them to
+		/// <c>process()</c><para/>
+		/// Requires <c>m_mux</c> to be locked.
+		/// </summary>
+		void publishState();
+
+
+	private: // variables
+
+		SmoothedParameter m_oWet;
+		SmoothedParameter m_oDry;
+
+		std::mutex m_mux; // serializes the state changes, never locked by process()
+		std::shared_ptr<const Kernel> m_spKernel; // the latest impulse response
+		PublishedPtr<State> m_oState; // read by process()
+
+	};
+
+
+
+	/// <summary>
+	/// A series of effects that's applied to interleaved 32-bit float audio data<para/>
+	/// Effects can be added and removed while the chain is being processed. Every modification
+	/// publishes a new immutable effect list that <c>process()</c> picks up with a plain atomic
+	/// load (see <c>PublishedPtr</c>), so the audio thread never waits for a lock and never skips
+	/// the effects. Replaced lists are released by the modifying thread once <c>process()</c> is
+	/// done with them, not by the audio thread.
+	/// </summary>
+	class AudioEffectChain final
+	{
+	public: // methods
+
+		AudioEffectChain() = default;
+		AudioEffectChain(const AudioEffectChain&) = delete;
+		~AudioEffectChain() = default;
+
+		/// <summary>
+		/// Append an effect to the chain<para/>
+		/// If the chain was already prepared, the effect is prepared for the same format.
+		/// </summary>
+		void add(std::shared_ptr<IAudioEffect> spEffect);
+
+		/// <summary>
+		/// Create an effect and append it to the chain
+		/// </summary>
+		template <typename T, typename... Args>
+		std::shared_ptr<T> add(Args&&... args)
+		{
+			auto sp = std::make_shared<T>(std::forward<Args>(args)...);
+			add(std::static_pointer_cast<IAudioEffect>(sp));
+			return sp;
+		}
+
+		void remove(const IAudioEffect* pEffect);
+		void clear();
+		size_t size() const;
+
+		/// <summary>
+		/// Prepare all effects for a format
+		/// </summary>
+		/// <returns>Is the format supported?</returns>
+		bool prepare(uint32_t iSampleRate, uint8_t iChannelCount, uint32_t iMaxSampleCount);
+		void reset() noexcept;
+
+		/// <summary>
+		/// Process interleaved 32-bit float data in place<para/>
+		/// Never waits for a lock. Must only be called by one thread at a time.
+		/// </summary>
+		void process(float* pData, uint32_t iSampleCount) noexcept;
+
+		inline bool isPrepared() const noexcept { return m_iChannelCount != 0; }
+		inline uint32_t getSampleRate() const noexcept { return m_iSampleRate; }
+		inline uint8_t getChannelCount() const noexcept { return m_iChannelCount; }
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Replace the effect chain of a submix or mastering voice<para/>
+		/// The chain is prepared by the audio thread and kept alive by the voice.
+		/// </summary>
+		/// <param name="spChain">= The effect chain. <c>nullptr</c> = remove all effects</param>
+		/// <returns>Could the effect chain be set?</returns>
+		static bool AttachToVoice(AudioEngine::SubmixVoice& oVoice,
+			std::shared_ptr<AudioEffectChain> spChain);
+
+
+	private: // types
+
+		using EffectList = std::vector<std::shared_ptr<IAudioEffect>>;
+
+
+	private: // methods
+
+		/// <summary>
+		/// Replace the effect list that's used by <c>process()</c><para/>
+		/// Requires <c>m_mux</c> to be locked.
+		/// </summary>
+		void publish(std::shared_ptr<const EffectList> spEffects);
+
+
+	private: // variables
+
+		mutable std::mutex m_mux; // serializes the modifications, never locked by process()
+		PublishedPtr<const EffectList> m_oEffects; // nullptr = no effects
+		std::vector<__m128> m_oBuffer;
+
+		uint32_t m_iSampleRate = 0;
+		uint8_t m_iChannelCount = 0;
+		uint32_t m_iMaxSampleCount = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_EFFECTS
@@ -44,11 +44,17 @@ using int32_t = int;
 using uint32_t = unsigned int;
 
 
+#include "audio.codec.hpp"
+#include "audio.resampler.hpp"
+#include "tools.mpscqueue.hpp"
+
+#include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <set>
+#include <thread>
 #include <vector>
 #include <xaudio2.h>
 
@@ -174,6 +180,47 @@ namespace rl
 
 
 
+	/// <summary>
+	/// A read-only view of the samples of a single channel in interleaved audio data<para/>
+	/// Doesn't own or copy the data
+	/// </summary>
+	template <typename T>
+	class AudioChannelView
+	{
+	public: // methods
+
+		AudioChannelView() = default;
+		AudioChannelView(const void* pFirst, size_t iCount, size_t iStride) noexcept :
+			m_pFirst(static_cast<const uint8_t*>(pFirst)), m_iCount(iCount), m_iStride(iStride) {}
+
+		inline T operator[](size_t i) const noexcept
+		{
+			return *reinterpret_cast<const T*>(m_pFirst + i * m_iStride);
+		}
+
+		/// <summary>
+		/// The count of samples in this view
+		/// </summary>
+		inline size_t size() const noexcept { return m_iCount; }
+		inline bool empty() const noexcept { return m_iCount == 0; }
+		/// <summary>
+		/// The distance, in bytes, between two samples
+		/// </summary>
+		inline size_t stride() const noexcept { return m_iStride; }
+
+
+	private: // variables
+
+		const uint8_t* m_pFirst = nullptr;
+		size_t m_iCount = 0;
+		size_t m_iStride = 0;
+
+	};
+
+
+
+
+
 	/// <summary>
 	/// XAudio2-based audio engine
 	/// </summary>
@@ -186,6 +233,8 @@ namespace rl
 			DestroyVoice,
 			DestroyEngine,
 			DeleteSoundInstance,
+			ApplyBatch, // ptr = ParameterBatch*, gets deleted after being applied
+			Signal, // ptr = std::promise<void>*, gets set when all earlier messages were processed
 			Quit
 		};
 
@@ -199,7 +248,21 @@ namespace rl
 	public: // static methods
 
 		static AudioEngine& GetInstance();
+		/// <summary>
+		/// Post a message to the engine thread<para/>
+		/// Lock-free, can be called from any thread (including XAudio2 callbacks)
+		/// </summary>
 		static void PostMsg(MessageVal eMsg, void* ptr);
+		/// <summary>
+		/// Get a new XAudio2 operation set ID, unique across all threads<para/>
+		/// Never returns <c>XAUDIO2_COMMIT_NOW</c> or <c>XAUDIO2_COMMIT_ALL</c>.
+		/// </summary>
+		static UINT32 AllocateOperationSet() noexcept;
+		/// <summary>
+		/// Wait until the engine thread has processed all messages posted so far<para/>
+		/// Must not be called from the engine thread or an XAudio2 callback.
+		/// </summary>
+		static void Flush();
 
 
 	private: // static methods
@@ -211,10 +274,10 @@ namespace rl
 	private: // static variables
 
 		static std::thread trdMsgLoop;
-		static std::mutex muxMsgLoop;
-		static std::condition_variable cvMsgLoop;
-		static std::queue<Message> oMessageQueue;
+		static MPSCQueue<Message> oMessageQueue;
+		static std::atomic<uint32_t> iMessageSignal; // changes on every new message
 		static HRESULT hr;
+		static std::atomic<UINT32> iNextOperationSet;
 
 
 	public: // types
@@ -226,6 +289,36 @@ namespace rl
 			SourceVoice
 		};
 
+		/// <summary>
+		/// A snapshot of the metrics of the audio engine, see <c>getMetrics()</c><para/>
+		/// All times are in seconds.
+		/// </summary>
+		struct Metrics
+		{
+			size_t iVoiceCount[3]; // existing voices, indexed by VoiceType
+
+			// IAudioStream data generation (all streams, since the last resetMetrics())
+			uint64_t iStreamBlocks; // count of blocks generated
+			uint64_t iStreamUnderruns; // count of blocks generated after the queue ran empty
+			double dFillTimeP50; // median duration of generating a block
+			double dFillTimeP99;
+			float fFillRatioP50; // median duration of generating a block / block duration
+			float fFillRatioP99;
+
+			double dDeviceLatency; // latency of XAudio2 (mastering voice to device)
+			double dMaxStreamQueued; // maximum duration of audio queued by a single stream
+			double dQueuedLatency; // dDeviceLatency + dMaxStreamQueued
+
+			/// <summary>
+			/// The share of the CPU time used by XAudio2's audio thread since the last call to
+			/// <c>getMetrics()</c>
+			/// </summary>
+			float fAudioThreadLoad;
+
+			size_t iSoundMemory; // bytes allocated by Sound objects
+			size_t iSoundMemoryReferenced; // bytes referenced by Sound objects (may overlap)
+		};
+
 		class SubmixVoice; // forward declaration
 
 		/// <summary>
@@ -255,6 +348,13 @@ namespace rl
 
 			// destroy this voice without locking the AudioEngine::m_muxVoicese mutex
 			virtual void destroy();
+			/// <summary>
+			/// Destroy the XAudio2 voice, without destroying any sub voices<para/>
+			/// Unlike <c>destroy()</c>, this waits until the voice was destroyed and all of its
+			/// running callbacks have returned. Messages posted before, like parameter batches,
+			/// are still processed first. Must not be called from an XAudio2 callback.
+			/// </summary>
+			void destroyAndWait();
 
 			inline auto getPtr() { return m_pVoice; }
 			inline auto& getParents() { return m_oParents; }
@@ -392,6 +492,86 @@ namespace rl
 
 		};
 
+		/// <summary>
+		/// A set of voice parameter changes that's applied at once<para/>
+		/// When posted via <c>PostBatch()</c>, all changes are applied by the engine thread in a
+		/// single XAudio2 operation set, so they take effect at the start of the same audio
+		/// processing pass.<para/>
+		/// The voices are destroyed on the engine thread too, so a voice destroyed after
+		/// <c>PostBatch()</c> returned is only destroyed after the batch was applied. Use
+		/// <c>AudioEngine::Flush()</c> to wait until the batch was applied.
+		/// </summary>
+		class ParameterBatch
+		{
+			friend class AudioEngine;
+
+		public: // methods
+
+			void setVolume(Voice& voice, float fVolume);
+			/// <summary>
+			/// Set the pitch of a source voice
+			/// </summary>
+			void setFrequencyRatio(SourceVoice& voice, float fRatio);
+			/// <summary>
+			/// Set the volume levels of a send (<c>IXAudio2Voice::SetOutputMatrix()</c>)
+			/// </summary>
+			/// <param name="pDest">
+			/// = The voice to set the send levels for. Can be <c>nullptr</c> if the voice only has
+			/// one output.
+			/// </param>
+			/// <param name="pLevelMatrix">
+			/// = <c>iSourceChannels</c> * <c>iDestChannels</c> values, see XAudio2 documentation
+			/// </param>
+			void setOutputMatrix(Voice& voice, Voice* pDest, UINT32 iSourceChannels,
+				UINT32 iDestChannels, const float* pLevelMatrix);
+
+			inline bool empty() const noexcept { return m_oChanges.empty(); }
+			void clear() noexcept;
+
+
+		private: // types
+
+			enum class ChangeType
+			{
+				Volume,
+				FrequencyRatio,
+				OutputMatrix
+			};
+
+			struct Change
+			{
+				ChangeType eType;
+				IXAudio2Voice* pVoice;
+				IXAudio2Voice* pDest;
+				UINT32 iSourceChannels;
+				UINT32 iDestChannels;
+				size_t iMatrixOffset; // index of the first value in m_oMatrixValues
+				float fValue;
+			};
+
+
+		private: // methods
+
+			void apply(UINT32 iOperationSet) const;
+
+
+		private: // variables
+
+			std::vector<Change> m_oChanges;
+			std::vector<float> m_oMatrixValues;
+
+		};
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Apply a set of parameter changes atomically, on the engine thread<para/>
+		/// Lock-free, can be called from any thread. The batch is applied before any message
+		/// posted later, <c>Flush()</c> waits until it was applied.
+		/// </summary>
+		static void PostBatch(ParameterBatch&& batch);
+
 
 	public: // operators
 
@@ -425,6 +605,21 @@ namespace rl
 			UINT32 Flags = 0, float MaxFrequencyRatio = XAUDIO2_DEFAULT_FREQ_RATIO,
 			const VoiceSends* sends = nullptr, const XAUDIO2_EFFECT_CHAIN* pEffectChain = nullptr);
 
+		/// <summary>
+		/// Get a snapshot of the engine's metrics<para/>
+		/// The counters are updated lock-free, so they're always enabled
+		/// </summary>
+		Metrics getMetrics();
+		/// <summary>
+		/// Reset the stream block counters and fill time histograms
+		/// </summary>
+		void resetMetrics();
+
+		/// <summary>
+		/// Apply all changes that were made with the operation set <c>OperationSet</c>
+		/// </summary>
+		HRESULT commitChanges(UINT32 OperationSet = XAUDIO2_COMMIT_ALL);
+
 		inline HRESULT getHRESULT() { return hr; }
 
 
@@ -457,15 +652,23 @@ namespace rl
 
 
 	// forward declaration
+	class AudioEnvelope;
+	class SoundBank;
 	class SoundInstance;
 	class SoundInstance3D;
 
 	/// <summary>
 	/// An audio track that's loaded into memory at once<br />
-	/// Currently only supports WAV PCM data (8/16/24/32 bits per sample)
+	/// Supports WAV PCM data (8/16/24/32 bits per sample) and IMA/MS ADPCM data<para/>
+	/// The sample data is either owned by the <c>Sound</c> object or referenced in external memory
+	/// (a memory-mapped file, a resource or a caller-owned buffer, see <c>ownsData()</c>)<para/>
+	/// Compressed sample data (see <c>isCompressed()</c>) is decoded to 16-bit PCM when it's read
+	/// or played.
 	/// </summary>
 	class Sound
 	{
+		friend class SoundBank;
+
 	public: // operators
 
 		Sound& operator=(const Sound& other);
@@ -477,27 +680,61 @@ namespace rl
 		/// <summary>
 		/// Load a WAV file
 		/// </summary>
+		/// <param name="bMapFile">
+		/// If <c>true</c>, the file is memory-mapped and the sample data is referenced instead of
+		/// copied into memory. The mapping stays alive as long as any <c>Sound</c> references it.
+		/// </param>
 		/// <returns>
 		/// * On success: Pointer to a <c>Sound</c> instance<para />
 		/// * On failure: <c>nullptr</c>
 		/// </returns>
-		static Sound* FromFile(const wchar_t* szFileName);
+		static Sound* FromFile(const wchar_t* szFileName, bool bMapFile = false);
 		/// <summary>
 		/// Load a <c>"WAVE"</c> resource
 		/// </summary>
+		/// <param name="bCopy">
+		/// If <c>false</c>, the sample data is referenced inside the resource.<para/>
+		/// The module must not be unloaded while the <c>Sound</c> exists.
+		/// </param>
 		/// <returns>
 		/// * On success: Pointer to a <c>Sound</c> instance<para />
 		/// * On failure: <c>nullptr</c>
 		/// </returns>
-		static Sound* FromResource(HMODULE hModule, LPCWSTR lpName);
+		static Sound* FromResource(HMODULE hModule, LPCWSTR lpName, bool bCopy = true);
 		/// <summary>
 		/// Load audio from RIFF waveform data in memory
 		/// </summary>
+		/// <param name="bCopy">
+		/// If <c>false</c>, the sample data is referenced inside of <c>data</c> (for example the
+		/// data of a <c>FileContainer::File</c>).<para/>
+		/// The buffer must stay valid and unchanged while the <c>Sound</c> exists.
+		/// </param>
 		/// <returns>
 		/// * On success: Pointer to a <c>Sound</c> instance<para />
 		/// * On failure: <c>nullptr</c>
 		/// </returns>
-		static Sound* FromMemory(const void* data, size_t size);
+		static Sound* FromMemory(const void* data, size_t size, bool bCopy = true);
+		/// <summary>
+		/// Create a copy of a <c>Sound</c>, converted to another sample rate<para/>
+		/// Use this to convert sounds to the sample rate of the mastering voice when loading them,
+		/// so XAudio2 doesn't have to resample them during playback.
+		/// </summary>
+		/// <returns>
+		/// * On success: Pointer to a <c>Sound</c> instance with 32-bit float samples<para />
+		/// * On failure: <c>nullptr</c>
+		/// </returns>
+		static Sound* FromResampled(const Sound& source, uint32_t iSampleRate,
+			ResamplerQuality eQuality = ResamplerQuality::Medium);
+		/// <summary>
+		/// Create a compressed copy of a <c>Sound</c><para/>
+		/// The samples are converted to 16 bits first. ADPCM needs about a quarter of the memory of
+		/// 16-bit PCM; lossless compression is bit-exact.
+		/// </summary>
+		/// <returns>
+		/// * On success: Pointer to a compressed <c>Sound</c> instance<para />
+		/// * On failure: <c>nullptr</c>
+		/// </returns>
+		static Sound* FromCompressed(const Sound& source, AudioCompression eCompression);
 
 
 	public: // methods
@@ -510,16 +747,139 @@ namespace rl
 
 		void clear();
 
+		/// <summary>
+		/// Copy a single sample into newly allocated memory<para/>
+		/// For reading many samples, use <c>getChannel()</c> or <c>getSamplesAsFloat()</c> instead,
+		/// as they don't allocate memory
+		/// </summary>
 		bool getSample(MultiChannelAudioSample& dest, size_t iSampleID) const;
 
+		/// <summary>
+		/// Get a view of a range of samples of a single channel, without copying any data
+		/// </summary>
+		/// <typeparam name="T">
+		/// = The sample type matching the bit depth (<c>audio8_t</c>, <c>audio16_t</c>,
+		/// <c>audio24_t</c> or <c>audio32_t</c>)
+		/// </typeparam>
+		/// <param name="iSampleCount">
+		/// = The maximum count of samples. Gets limited to the samples available.
+		/// </param>
+		/// <returns>
+		/// An empty view if <c>T</c> doesn't match the bit depth, the range is invalid or the
+		/// sample data is compressed
+		/// </returns>
+		template <typename T>
+		AudioChannelView<T> getChannel(uint8_t iChannel, size_t iFirstSample = 0,
+			size_t iSampleCount = (size_t)-1) const noexcept
+		{
+			if (isCompressed() || sizeof(T) * 8 != static_cast<size_t>(m_oWavFmt.eBitDepth) ||
+				iChannel >= m_oWavFmt.iChannelCount || iFirstSample >= m_iSampleCount)
+				return {};
+
+			if (iSampleCount > m_iSampleCount - iFirstSample)
+				iSampleCount = m_iSampleCount - iFirstSample;
+
+			const uint8_t* pFirst = m_pData + iFirstSample * m_iSampleAlign + iChannel * sizeof(T);
+			return AudioChannelView<T>(pFirst, iSampleCount, m_iSampleAlign);
+		}
+
+		/// <summary>
+		/// Convert a range of samples to interleaved 32-bit float values (-1.0f to 1.0f)
+		/// </summary>
+		/// <param name="pDest">
+		/// = The destination buffer. Must have room for <c>iSampleCount</c> * channel count
+		/// values.
+		/// </param>
+		/// <returns>The count of samples converted</returns>
+		size_t getSamplesAsFloat(float* pDest, size_t iFirstSample,
+			size_t iSampleCount) const noexcept;
+
 		inline const void* getDataPtr() const { return m_pData; }
 		inline auto getDataSize() const { return m_iDataSize; }
 
+		/// <summary>
+		/// Is the sample data owned by this object?<para/>
+		/// If <c>false</c>, the data is referenced in external memory and copies of this object
+		/// reference the same memory.
+		/// </summary>
+		inline bool ownsData() const { return m_bOwnsData; }
+
 		inline auto getSampleCount() const { return m_iSampleCount; }
+		/// <summary>
+		/// Get the format of the (decoded) samples
+		/// </summary>
 		inline const auto& getWaveFormat() const { return m_oWavFmt; }
 
+		inline bool isCompressed() const
+		{
+			return m_oCompression.eCompression != AudioCompression::None;
+		}
+		inline const auto& getCompressionFormat() const { return m_oCompression; }
+		/// <summary>
+		/// Get the count of independently decodable blocks of compressed sample data
+		/// </summary>
+		size_t getBlockCount() const noexcept;
+		/// <summary>
+		/// Decode a block of compressed sample data to interleaved 16-bit PCM
+		/// </summary>
+		/// <param name="pDest">
+		/// = The destination buffer. Must have room for <c>getCompressionFormat().iSamplesPerBlock
+		/// </c> * channel count values.
+		/// </param>
+		/// <returns>The count of samples decoded</returns>
+		size_t decodeBlock(size_t iBlock, int16_t* pDest) const noexcept;
+
+		/// <summary>
+		/// Get the envelope attached to this sound (see <c>AudioEnvelope</c>)
+		/// </summary>
+		/// <returns>The envelope or <c>nullptr</c> if there is none</returns>
+		inline const AudioEnvelope* getEnvelope() const noexcept { return m_spEnvelope.get(); }
+		/// <summary>
+		/// Attach an envelope<para/>
+		/// It's shared with all copies of this sound. Pass <c>nullptr</c> to remove it.
+		/// </summary>
+		/// <returns>Does the envelope match the sound's sample count and channel count?</returns>
+		bool setEnvelope(std::shared_ptr<const AudioEnvelope> spEnvelope) noexcept;
+
 		SoundInstance* play(float volume = 1.0f);
-		SoundInstance3D* play3D(const Audio3DPos& pos, float volume = 1.0f);
+		/// <param name="bVirtual">
+		/// = Start as a virtual instance, without an XAudio2 voice (see
+		/// <c>SoundInstance::isVirtual()</c>)
+		/// </param>
+		SoundInstance3D* play3D(const Audio3DPos& pos, float volume = 1.0f, bool bVirtual = false);
+
+
+	private: // methods
+
+		/// <summary>
+		/// Create a <c>Sound</c> from RIFF waveform data<para/>
+		/// Copies the sample data if <c>bCopy</c> is <c>true</c>, otherwise references it and keeps
+		/// <c>spOwner</c> alive
+		/// </summary>
+		static Sound* FromRIFF(const void* data, size_t size, bool bCopy,
+			std::shared_ptr<const void> spOwner);
+
+		/// <summary>
+		/// Reference sample data in external memory, keeping <c>spOwner</c> alive
+		/// </summary>
+		/// <returns>Are the format and the data valid?</returns>
+		bool reference(const WaveFormat& oFormat, const AudioCompressionFormat& oCompression,
+			size_t iSampleCount, const uint8_t* pData, size_t iDataSize,
+			std::shared_ptr<const void> spOwner);
+
+		/// <summary>
+		/// Decode the block of compressed sample data that contains a certain sample<para/>
+		/// The last decoded block is cached per thread, so sequential reads decode every block
+		/// only once.
+		/// </summary>
+		/// <param name="iSampleCount">
+		/// = Receives the count of samples available from <c>iFirstSample</c> to the end of the
+		/// block
+		/// </param>
+		/// <returns>
+		/// A pointer to the decoded <c>iFirstSample</c> or <c>nullptr</c> on failure
+		/// </returns>
+		const int16_t* decodeSamples(size_t iFirstSample, size_t& iSampleCount) const noexcept;
 
 
 	private: // variables
@@ -528,8 +888,12 @@ namespace rl
 		size_t m_iSampleAlign;
 		size_t m_iSampleCount;
 		size_t m_iDataSize;
+		AudioCompressionFormat m_oCompression;
 
-		uint8_t* m_pData;
+		const uint8_t* m_pData;
+		bool m_bOwnsData;
+		std::shared_ptr<const void> m_spDataOwner; // keeps referenced data alive (e.g. a mapping)
+		std::shared_ptr<const AudioEnvelope> m_spEnvelope;
 
 	};
 
@@ -560,18 +924,78 @@ namespace rl
 		inline auto getType() const { return m_eType; }
 		inline bool getPlaying() const { return m_bPlaying; }
 		inline bool getPaused() const { return m_bPaused; }
+		/// <summary>
+		/// Is the instance currently virtual?<para/>
+		/// A virtual instance has no XAudio2 voice and costs no mixing time, but its play position
+		/// keeps advancing in real time. When it gets a voice again, it continues at the position
+		/// it would have reached by then.
+		/// </summary>
+		inline bool isVirtual() const { return m_bVirtual; }
 
 
 	protected: // methods
 
-		SoundInstance(SoundInstanceType type, float volume) : m_eType(type), m_fVolume(volume) {}
+		SoundInstance(const Sound& sound, SoundInstanceType type, float volume) :
+			m_fVolume(volume), m_eType(type), m_pSound(&sound) {}
 
 		virtual bool createVoices(const WAVEFORMATEX& format);
 		virtual void destroyVoices();
+		/// <summary>
+		/// Destroy the voices and the decode cache once no callback can use them anymore<para/>
+		/// <c>lm</c> is unlocked while waiting for running callbacks, as they might need
+		/// <c>m_mux</c>.
+		/// </summary>
+		void destroyVoicesAndWait(std::unique_lock<std::mutex>& lm);
 
-		bool loadSound(const Sound& sound);
+		/// <param name="iFirstSample">= The sample to start playing at</param>
+		bool loadSound(const Sound& sound, size_t iFirstSample = 0);
 		void onEnd();
 
+		/// <summary>
+		/// Start playing as a virtual instance, without creating any voices
+		/// </summary>
+		void startVirtual();
+		/// <summary>
+		/// Release the XAudio2 voices, but keep track of the play position
+		/// </summary>
+		/// <returns>Was the instance virtualized?</returns>
+		bool virtualize();
+		/// <summary>
+		/// Recreate the XAudio2 voices and continue at the current virtual play position
+		/// </summary>
+		/// <returns>Does the instance play on a voice again?</returns>
+		bool devirtualize();
+		/// <summary>
+		/// End a virtual instance if its play position passed the end of the sound
+		/// </summary>
+		void updateVirtual();
+
+
+	private: // types
+
+		struct DecodeCache;
+
+
+	private: // methods
+
+		/// <summary>
+		/// Decode the next blocks of a compressed sound into a buffer of the decode cache and
+		/// submit it
+		/// </summary>
+		bool submitDecoded(uint8_t iBuffer);
+
+		/// <summary>
+		/// Get the current play position of a virtual instance<para/>
+		/// <c>m_mux</c> must be locked.
+		/// </summary>
+		size_t getVirtualPos() const;
+		/// <summary>
+		/// End a virtual instance if its play position passed the end of the sound<para/>
+		/// <c>m_mux</c> must be locked.
+		/// </summary>
+		/// <returns>Has the instance ended?</returns>
+		bool checkVirtualEnd();
+
 
 	protected: // variables
 
@@ -587,6 +1011,13 @@ namespace rl
 		const SoundInstanceType m_eType;
 		std::mutex m_mux;
 		std::condition_variable m_cv;
+		DecodeCache* m_pDecodeCache = nullptr; // only for compressed sounds
+
+		const Sound* m_pSound = nullptr;
+		size_t m_iStartSample = 0; // the sample the current voice started playing at
+		std::atomic<bool> m_bVirtual = false;
+		size_t m_iVirtualPos = 0; // play position at m_tpVirtualPos
+		std::chrono::steady_clock::time_point m_tpVirtualPos;
 	};
 
 	/// <summary>
@@ -594,11 +1025,18 @@ namespace rl
 	/// </summary>
 	class SoundInstance3D : public SoundInstance
 	{
+		friend class AudioSpatializer;
+
 	public: // methods
 
-		SoundInstance3D(const Sound& sound, float volume, const Audio3DPos& pos);
+		SoundInstance3D(const Sound& sound, float volume, const Audio3DPos& pos,
+			bool bVirtual = false);
 
 		void set3DPos(const Audio3DPos& pos);
+		/// <summary>
+		/// Add the position change to a batch instead of applying it immediately
+		/// </summary>
+		void set3DPos(const Audio3DPos& pos, AudioEngine::ParameterBatch& batch);
 		inline auto get3DPos() const { return m_o3DPos; }
 
 
@@ -612,6 +1050,13 @@ namespace rl
 
 		void applyPos();
 
+		/// <summary>
+		/// Apply a precalculated output matrix (8 values)<para/>
+		/// Does nothing if no value changed by at least <c>fThreshold</c>
+		/// </summary>
+		/// <returns>Was the matrix applied?</returns>
+		bool applyMatrix(const float* pMatrix, float fThreshold, UINT32 iOperationSet);
+
 
 	private: // variables
 
@@ -626,11 +1071,104 @@ namespace rl
 
 
 
+	// forward declaration
+	class IAudioStream;
+
+	/// <summary>
+	/// A fixed-size pool of threads that generate the audio data of all running
+	/// <c>IAudioStream</c> objects<para/>
+	/// The stream with the least audio data queued in XAudio2 (the one that would run out
+	/// first) is always served first.
+	/// </summary>
+	class AudioWorkerPool final
+	{
+		friend class IAudioStream;
+
+	public: // static methods
+
+		static AudioWorkerPool& GetInstance();
+
+
+	public: // methods
+
+		/// <summary>
+		/// Set the count of worker threads<para/>
+		/// Only possible while no audio stream is running
+		/// </summary>
+		/// <returns>Was the thread count changed?</returns>
+		bool setThreadCount(size_t iThreadCount);
+		size_t getThreadCount() const;
+
+		/// <summary>
+		/// Get the maximum duration, in seconds, of the audio data queued by a running stream
+		/// </summary>
+		double getMaxQueuedTime() const;
+
+
+	private: // methods
+
+		AudioWorkerPool(); // --> singleton
+		~AudioWorkerPool();
+
+		void add(IAudioStream* pStream);
+
+		/// <summary>
+		/// Unregister a stream<para/>
+		/// Waits until no worker is currently generating data for this stream
+		/// </summary>
+		void remove(IAudioStream* pStream);
+
+		/// <summary>
+		/// Wake up a worker (a stream has free buffer blocks)
+		/// </summary>
+		void notify();
+
+		void workerFunc();
+
+		/// <summary>
+		/// Get the stream to be served next<para/>
+		/// <c>m_mux</c> must be locked
+		/// </summary>
+		/// <returns>
+		/// <c>nullptr</c> if no stream needs data
+		/// </returns>
+		IAudioStream* nextStream() const;
+
+
+	private: // variables
+
+		mutable std::mutex m_mux;
+		std::condition_variable m_cvWork;
+		std::condition_variable m_cvIdle; // a worker finished a block
+		std::vector<IAudioStream*> m_oStreams;
+		std::vector<std::thread> m_oThreads;
+		size_t m_iThreadCount;
+		bool m_bQuit = false;
+
+	};
+
+
+
+	/// <summary>
+	/// Diagnostic data of an <c>IAudioStream</c>
+	/// </summary>
+	struct AudioStreamStats
+	{
+		uint64_t iBlocksGenerated; // count of blocks generated since the last start
+		uint64_t iUnderruns; // count of blocks generated when no audio was queued anymore
+		double dTotalGenerationTime; // total time spent generating audio, in seconds
+		double dMaxGenerationTime; // longest time spent generating a single block, in seconds
+		double dLastGenerationTime; // time spent generating the last block, in seconds
+	};
+
 	/// <summary>
-	/// An interface for buffered real-time audio generation
+	/// An interface for buffered real-time audio generation<para/>
+	/// The audio data is generated by the threads of the <c>AudioWorkerPool</c>
 	/// </summary>
 	class IAudioStream
 	{
+		friend class AudioWorkerPool;
+
 	public: // methods
 
 		virtual ~IAudioStream();
@@ -646,6 +1184,16 @@ namespace rl
 		inline bool running() const noexcept { return m_bRunning; }
 		inline bool paused() const noexcept { return m_bPaused; }
 
+		/// <summary>
+		/// Get the generation time and underrun statistics since the last start
+		/// </summary>
+		AudioStreamStats getStats() const noexcept;
+
+		/// <summary>
+		/// Get the count of samples that were already played by XAudio2 since the last start
+		/// </summary>
+		uint64_t getPlayedSamples() const;
+
 
 	protected: // methods
 
@@ -669,21 +1217,42 @@ namespace rl
 		/// </returns>
 		virtual bool nextSample(float fElapsedTime, MultiChannelAudioSample& dest) noexcept = 0;
 
+		/// <summary>
+		/// Get the next audio samples<para/>
+		/// The default implementation calls <c>nextSample()</c> for every sample. Override this
+		/// method if the stream can produce whole blocks of sample data at once.
+		/// </summary>
+		/// <param name="pDest">
+		/// = The destination for the interleaved sample data, in the format passed to
+		/// <c>internalStart()</c>
+		/// </param>
+		/// <param name="iSampleCount">= The count of samples to generate</param>
+		/// <returns>
+		/// The count of samples written (if less than <c>iSampleCount</c>, the audio stream will
+		/// terminate)
+		/// </returns>
+		virtual size_t nextSamples(uint8_t* pDest, size_t iSampleCount) noexcept;
+
 
 	private: // methods
 
-		void threadFunc(); // audio generation thread
+		/// <summary>
+		/// Generate one buffer block, called by the <c>AudioWorkerPool</c>
+		/// </summary>
+		void processBlock();
 		void fillBlock(); // fill the current buffer block with audio data
 
+		/// <summary>
+		/// The duration of the audio data that's currently queued in XAudio2, in seconds
+		/// </summary>
+		double getQueuedTime() const noexcept;
+
 
 	private: // variables
 
 		AudioEngine::SourceVoice* m_pSourceVoice = nullptr;
 		uint8_t* m_pBuffer = nullptr;
 
-		std::mutex m_mux;
-		std::condition_variable m_cv;
-
 		// audio metadata
 		WaveFormat m_oFormat = {};
 		float m_fVolume = 0.0f;
@@ -700,13 +1269,164 @@ namespace rl
 		uint8_t m_iByteDepth = 0; // m_oFormat.eBitDepth in bytes
 		uint8_t m_iSampleAlign = 0;
 
-		// thread stuff
-		std::thread m_trdSampleGeneration;
+		// worker pool stuff
+		bool m_bInWork = false; // a worker is generating data (guarded by the pool's mutex)
+		bool m_bVoiceStarted = false;
 		std::atomic_bool m_bPaused = false;
 		std::atomic_bool m_bRunning = false;
 		bool m_bEndOfStream = false; // nextSample() returned FALSE
 
-	}; \
+		// diagnostics
+		std::atomic<uint64_t> m_iStatBlocks = 0;
+		std::atomic<uint64_t> m_iStatUnderruns = 0;
+		std::atomic<uint64_t> m_iStatTotalNS = 0;
+		std::atomic<uint64_t> m_iStatMaxNS = 0;
+		std::atomic<uint64_t> m_iStatLastNS = 0;
+
+	};
+
+
+
+
+
+	/// <summary>
+	/// An audio stream that plays a WAV file without loading it into memory at once<para/>
+	/// The sample data is read in blocks by a background thread, so the memory usage doesn't
+	/// depend on the length of the file. The audio stream never waits for the reading thread:
+	/// If no data was read in time, silence is played instead and counted as an underrun.
+	/// </summary>
+	class WaveFileStream : public IAudioStream
+	{
+	public: // methods
+
+		WaveFileStream() = default;
+		virtual ~WaveFileStream();
+
+		/// <summary>
+		/// Open a WAV file for streaming<para/>
+		/// Closes the currently opened file, if present
+		/// </summary>
+		/// <param name="ReadBlockCount">= The count of blocks to read ahead</param>
+		/// <param name="SamplesPerReadBlock">
+		/// = The count of samples read from the file at once
+		/// </param>
+		/// <returns>Could the file be opened?</returns>
+		bool open(const wchar_t* szFileName, size_t ReadBlockCount = 4,
+			size_t SamplesPerReadBlock = 16384);
+		void close();
+
+		inline bool isOpen() const noexcept { return m_hFile != NULL; }
+
+		/// <summary>
+		/// Start playback at the current position<para/>
+		/// Waits until the file was read ahead. Does nothing when no file is opened.
+		/// </summary>
+		void play(float volume = 1.0f);
+
+		/// <summary>
+		/// Set the position of the next sample to be read<para/>
+		/// While playing, waits until the file was read ahead from the new position.
+		/// </summary>
+		void seek(size_t iSampleID);
+
+		/// <summary>
+		/// Get the position of the next sample to be passed to XAudio2<para/>
+		/// (Already buffered audio is not taken into account)
+		/// </summary>
+		size_t getPosition() const;
+
+		/// <summary>
+		/// Get the count of samples that were read ahead but not passed to XAudio2 yet
+		/// </summary>
+		size_t getBufferedSamples() const;
+
+		/// <summary>
+		/// Get the count of times the reading thread was behind and silence was played instead
+		/// of the file's contents (since <c>open()</c>)
+		/// </summary>
+		inline uint64_t getUnderruns() const noexcept { return m_iUnderruns; }
+
+		/// <summary>
+		/// Enable or disable looping<para/>
+		/// The loop is played seamlessly, from <c>iLoopBegin</c> up to (excluding)
+		/// <c>iLoopEnd</c>.
+		/// </summary>
+		/// <param name="iLoopEnd">
+		/// = The first sample after the loop. Zero means the end of the file.
+		/// </param>
+		void setLoop(bool bLoop, size_t iLoopBegin = 0, size_t iLoopEnd = 0);
+
+		inline bool getLoop() const noexcept { return m_bLoop; }
+		inline auto getSampleCount() const noexcept { return m_iSampleCount; }
+		inline const auto& getWaveFormat() const noexcept { return m_oFormat; }
+
+
+	protected: // methods
+
+		bool nextSample(float fElapsedTime, MultiChannelAudioSample& dest) noexcept override;
+		size_t nextSamples(uint8_t* pDest, size_t iSampleCount) noexcept override;
+
+
+	private: // types
+
+		struct ReadBlock
+		{
+			std::unique_ptr<uint8_t[]> upData;
+			size_t iSampleCount; // count of valid samples
+			size_t iConsumed; // count of samples already passed to the audio stream
+		};
+
+
+	private: // methods
+
+		void ioThreadFunc(); // file reading thread
+		/// <summary>
+		/// Wait until the reading thread has filled all blocks (or reached the end)
+		/// </summary>
+		/// <param name="lm">= A lock of <c>m_muxIO</c></param>
+		void waitForReadAhead(std::unique_lock<std::mutex>& lm);
+
+		/// <summary>
+		/// Read samples from the file, wrap around at the end of the loop
+		/// </summary>
+		/// <param name="iPos">= The position to read from, receives the next position</param>
+		/// <param name="bEnd">= Receives if the end of the file was reached</param>
+		/// <returns>The count of samples read</returns>
+		size_t readSamples(uint8_t* pDest, size_t iSampleCount, size_t& iPos, bool& bEnd,
+			bool bLoop, size_t iLoopBegin, size_t iLoopEnd);
+
+
+	private: // variables
+
+		HANDLE m_hFile = NULL;
+		WaveFormat m_oFormat = {};
+		size_t m_iSampleAlign = 0;
+		size_t m_iSampleCount = 0;
+		uint64_t m_iDataOffset = 0; // offset of the "data" chunk's contents in the file
+
+		std::vector<ReadBlock> m_oBlocks;
+		size_t m_iSamplesPerBlock = 0;
+		size_t m_iReadyFront = 0; // index of the first block that's ready to be consumed
+		size_t m_iReadyCount = 0; // count of blocks that are ready to be consumed
+
+		size_t m_iReadPos = 0; // position of the next sample to be read from the file
+		size_t m_iPlayPos = 0; // position of the next sample to be consumed
+		bool m_bReadEnd = false; // the end of the file was read (and no loop is active)
+		bool m_bSeekPending = false; // a block that's currently read must be discarded
+
+		std::atomic_bool m_bLoop = false;
+		size_t m_iLoopBegin = 0;
+		size_t m_iLoopEnd = 0;
+
+		mutable std::mutex m_muxIO;
+		std::condition_variable m_cvIO;
+		std::thread m_trdIO;
+		bool m_bQuitIO = false;
+		bool m_bWaitingForReadAhead = false; // silence is played because of a seek, no underrun
+
+		std::atomic<uint64_t> m_iUnderruns = 0;
+
+	};
 
 }
 
@@ -0,0 +1,232 @@
+/***************************************************************************************************
+ FILE:	audio.mixer.hpp
+ CPP:	audio.mixer.cpp
+ DESCR:	Sample-accurate scheduled playback of sounds, mixed into a single audio stream
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_MIXER
+#define ROBINLE_AUDIO_MIXER
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "audio.engine.hpp"
+#include "audio.resampler.hpp"
+#include "tools.mpscqueue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// An audio stream that mixes sounds according to a timeline of scheduled events<para/>
+	/// All positions are absolute sample positions on the mixer's clock: sample 0 is the first
+	/// sample output after <c>start()</c>. Events are processed at the exact sample they're
+	/// scheduled for; blocks are split at the event positions.<para/>
+	/// Events scheduled before <c>getGeneratedSamples()</c> were scheduled too late and are
+	/// processed at the start of the next block.<para/>
+	/// Sounds with a different sample rate are resampled while they're mixed, by a resampler per
+	/// voice. Sounds that are played often should be converted once via
+	/// <c>Sound::FromResampled()</c> instead.<para/>
+	/// All sounds must stay valid while they're scheduled or playing.<para/>
+	/// The scheduling methods can be called from any thread. They hand the events to the audio
+	/// thread through a lock-free queue; the memory for the voices and events is reserved in
+	/// <c>start()</c>, so mixing never waits for a lock or allocates memory.
+	/// </summary>
+	class AudioMixer : public IAudioStream
+	{
+	public: // types
+
+		using VoiceID = uint64_t;
+		static constexpr VoiceID InvalidVoice = 0;
+
+
+	public: // methods
+
+		AudioMixer() = default;
+		virtual ~AudioMixer();
+
+		/// <summary>
+		/// Start the mixer (32-bit float output)<para/>
+		/// Resets the clock and discards all scheduled events
+		/// </summary>
+		/// <param name="SamplesPerBufferBlock">
+		/// = The granularity of the timeline, in samples. Smaller blocks reduce the latency
+		/// between scheduling and playback.
+		/// </param>
+		/// <param name="MaxVoices">
+		/// = The maximum count of voices that are scheduled or playing at the same time
+		/// </param>
+		/// <param name="MaxEvents">
+		/// = The maximum count of events that are scheduled but not processed yet
+		/// </param>
+		/// <param name="eResamplerQuality">
+		/// = The quality used for sounds with a different sample rate
+		/// </param>
+		void start(uint32_t iSampleRate = 48000, uint8_t iChannelCount = 2, float volume = 1.0f,
+			size_t BufferBlockCount = 4, size_t SamplesPerBufferBlock = 256, size_t MaxVoices = 64,
+			size_t MaxEvents = 1024, ResamplerQuality eResamplerQuality = ResamplerQuality::Medium);
+
+		/// <summary>
+		/// Schedule the playback of a sound<para/>
+		/// If the sound has a different sample rate, the voice's resampler is prepared here, so
+		/// the filter table is calculated on the calling thread.
+		/// </summary>
+		/// <param name="iStartSample">= The absolute sample position to start at</param>
+		/// <returns>
+		/// The ID of the new voice or <c>InvalidVoice</c> if the sound's format isn't supported
+		/// or if the voices or events are used up
+		/// </returns>
+		VoiceID schedulePlay(const Sound& sound, uint64_t iStartSample, float fVolume = 1.0f,
+			bool bLoop = false);
+		/// <summary>
+		/// Schedule the end of the playback of a voice
+		/// </summary>
+		/// <returns>Was the event scheduled? (<c>false</c> if the events are used up)</returns>
+		bool scheduleStop(VoiceID id, uint64_t iSample);
+		/// <summary>
+		/// Schedule a volume change of a voice
+		/// </summary>
+		/// <returns>Was the event scheduled? (<c>false</c> if the events are used up)</returns>
+		bool scheduleVolume(VoiceID id, uint64_t iSample, float fVolume);
+
+		// getPlayedSamples() is the current position of the master clock
+
+		/// <summary>
+		/// Get the count of samples that were already mixed<para/>
+		/// Events at or after this position will be processed sample-accurately
+		/// </summary>
+		inline uint64_t getGeneratedSamples() const noexcept { return m_iGenerated; }
+
+		inline uint32_t getSampleRate() const noexcept { return m_iSampleRate; }
+		inline uint8_t getChannelCount() const noexcept { return m_iChannelCount; }
+
+
+	protected: // methods
+
+		bool nextSample(float fElapsedTime, MultiChannelAudioSample& dest) noexcept override;
+		size_t nextSamples(uint8_t* pDest, size_t iSampleCount) noexcept override;
+
+
+	private: // types
+
+		enum class EventType
+		{
+			Play,
+			Stop,
+			Volume
+		};
+
+		struct Event
+		{
+			uint64_t iSample;
+			uint64_t iSequence; // order of scheduling, for events at the same sample
+			EventType eType;
+			VoiceID id;
+			float fVolume;
+			const Sound* pSound;
+			size_t iSlot; // index in m_upVoiceSlots
+			bool bLoop;
+			bool bResample; // use the slot's resampler?
+		};
+
+		struct Voice
+		{
+			VoiceID id;
+			const Sound* pSound;
+			size_t iSlot; // index in m_upVoiceSlots
+			AudioResampler* pResampler; // nullptr if the sound has the mixer's sample rate
+			size_t iPos; // next sample of the sound
+			size_t iTail; // count of silent samples passed to the resampler after the end
+			float fVolume;
+			bool bLoop;
+		};
+
+		/// <summary>
+		/// A voice that's scheduled or playing
+		/// </summary>
+		struct VoiceSlot
+		{
+			std::atomic<bool> bUsed = false; // set by the scheduling API, reset by the audio thread
+			AudioResampler oResampler; // for sounds with a different sample rate
+		};
+
+
+	private: // methods
+
+		/// <summary>
+		/// Reserve one of the <c>MaxEvents</c> events
+		/// </summary>
+		/// <returns>Was an event available?</returns>
+		bool reserveEvent() noexcept;
+		void addEvent(Event&& ev);
+		/// <summary>
+		/// Free the slot of a voice that ended (called by the audio generation thread)
+		/// </summary>
+		void releaseVoice(const Voice& voice) noexcept;
+
+		/// <summary>
+		/// Process an event (called by the audio generation thread)
+		/// </summary>
+		void processEvent(const Event& ev);
+
+		/// <summary>
+		/// Resample the next samples of a voice into <c>m_upResampleBuf</c>
+		/// </summary>
+		/// <param name="bEnded">= Receives if the voice has ended</param>
+		/// <returns>The count of samples written</returns>
+		size_t readResampled(Voice& voice, size_t iMaxSampleCount, bool& bEnded) noexcept;
+
+		/// <summary>
+		/// Mix all active voices into a range of the output
+		/// </summary>
+		void mix(float* pDest, size_t iSampleCount) noexcept;
+
+
+	private: // variables
+
+		uint32_t m_iSampleRate = 0;
+		uint8_t m_iChannelCount = 0;
+		ResamplerQuality m_eResamplerQuality = ResamplerQuality::Medium;
+
+		size_t m_iMaxVoices = 0;
+		size_t m_iMaxEvents = 0;
+		std::unique_ptr<VoiceSlot[]> m_upVoiceSlots; // m_iMaxVoices slots
+
+		// scheduling API --> audio thread
+		MPSCQueue<Event> m_oPending;
+		std::atomic<size_t> m_iEventCount = 0; // events that are pending or in the timeline
+		std::atomic<uint64_t> m_iNextSequence = 0;
+		std::atomic<VoiceID> m_iNextVoiceID = 1;
+
+		// audio thread only (capacity reserved in start())
+		std::vector<Event> m_oTimeline; // sorted, next event at the back
+		std::vector<Voice> m_oVoices;
+		std::unique_ptr<float[]> m_upConvBuf; // conversion buffer for non-float sounds
+		std::unique_ptr<float[]> m_upResampleBuf; // output of the voices' resamplers
+
+		std::atomic<uint64_t> m_iGenerated = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_MIXER
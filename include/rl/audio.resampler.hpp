@@ -0,0 +1,170 @@
+/***************************************************************************************************
+ FILE:	audio.resampler.hpp
+ CPP:	audio.resampler.cpp
+ DESCR:	Sample rate conversion for interleaved 32-bit float audio data
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_RESAMPLER
+#define ROBINLE_AUDIO_RESAMPLER
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include <cstdint>
+#include <memory>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// The quality of a <c>AudioResampler</c><para/>
+	/// Higher qualities use longer filters and therefore need more CPU time
+	/// </summary>
+	enum class ResamplerQuality : uint8_t
+	{
+		/// <summary>
+		/// Linear interpolation. Cheap, but doesn't filter aliasing.
+		/// </summary>
+		Linear,
+		/// <summary>
+		/// Windowed sinc, 8 taps
+		/// </summary>
+		Low,
+		/// <summary>
+		/// Windowed sinc, 16 taps
+		/// </summary>
+		Medium,
+		/// <summary>
+		/// Windowed sinc, 32 taps
+		/// </summary>
+		High
+	};
+
+
+
+	/// <summary>
+	/// A streaming polyphase sample rate converter<para/>
+	/// The filter table is calculated once in <c>create()</c>. If the ratio between the sample
+	/// rates can be expressed with at most 1024 (quality-dependent) filter phases, the conversion
+	/// is exact, otherwise the nearest phase is used.<para/>
+	/// The output is aligned to the input (sample 0 of the output is at the time of sample 0 of
+	/// the input), so the last output samples are only generated after the input is followed by
+	/// <c>getLookahead()</c> more samples (for example silence at the end of a sound).
+	/// </summary>
+	class AudioResampler final
+	{
+	public: // methods
+
+		AudioResampler() = default;
+		AudioResampler(const AudioResampler& other) = delete;
+		AudioResampler(AudioResampler&& rval) = default;
+		~AudioResampler() = default;
+
+		AudioResampler& operator=(const AudioResampler& other) = delete;
+		AudioResampler& operator=(AudioResampler&& rval) = default;
+
+		/// <summary>
+		/// Initialize the resampler<para/>
+		/// Destroys the current state, if present
+		/// </summary>
+		/// <returns>Were the parameters valid?</returns>
+		bool create(uint32_t iInputSampleRate, uint32_t iOutputSampleRate, uint8_t iChannelCount,
+			ResamplerQuality eQuality = ResamplerQuality::Medium);
+		void destroy() noexcept;
+
+		/// <summary>
+		/// Reset the filter state (as if no input had been processed yet)
+		/// </summary>
+		void reset() noexcept;
+
+		inline bool isCreated() const noexcept { return m_iChannelCount != 0; }
+
+		/// <summary>
+		/// Convert interleaved audio data<para/>
+		/// Stops when either the input is used up or the output buffer is full.
+		/// </summary>
+		/// <param name="iInputSampleCount">
+		/// = The count of samples available in <c>pInput</c>
+		/// </param>
+		/// <param name="iInputUsed">= Receives the count of input samples consumed</param>
+		/// <param name="iMaxOutputSampleCount">
+		/// = The count of samples <c>pOutput</c> has room for
+		/// </param>
+		/// <returns>The count of samples written to <c>pOutput</c></returns>
+		size_t process(const float* pInput, size_t iInputSampleCount, size_t& iInputUsed,
+			float* pOutput, size_t iMaxOutputSampleCount) noexcept;
+
+		/// <summary>
+		/// Get the count of output samples that <c>iInputSampleCount</c> input samples result in,
+		/// when starting from the initial state
+		/// </summary>
+		size_t getOutputSampleCount(size_t iInputSampleCount) const noexcept;
+
+		/// <summary>
+		/// The count of input samples needed after an input sample before the output sample at
+		/// the same time can be generated
+		/// </summary>
+		inline size_t getLookahead() const noexcept { return m_iTaps / 2; }
+
+		inline auto getInputSampleRate() const noexcept { return m_iInputSampleRate; }
+		inline auto getOutputSampleRate() const noexcept { return m_iOutputSampleRate; }
+		inline auto getChannelCount() const noexcept { return m_iChannelCount; }
+		inline auto getQuality() const noexcept { return m_eQuality; }
+		inline auto getTapCount() const noexcept { return m_iTaps; }
+		inline auto getPhaseCount() const noexcept { return m_iPhaseCount; }
+
+
+	private: // methods
+
+		void calcFilterTable();
+
+		/// <summary>
+		/// Append an input sample to the history of all channels
+		/// </summary>
+		void push(const float* pSample) noexcept;
+
+
+	private: // variables
+
+		uint32_t m_iInputSampleRate = 0;
+		uint32_t m_iOutputSampleRate = 0;
+		uint8_t m_iChannelCount = 0;
+		ResamplerQuality m_eQuality = ResamplerQuality::Medium;
+
+		// rational step: with every output sample, the input position advances by
+		// m_iStep / m_iDenominator samples
+		uint32_t m_iStep = 0;
+		uint32_t m_iDenominator = 0;
+
+		size_t m_iTaps = 0; // filter length, always a multiple of 4
+		size_t m_iPhaseCount = 0;
+		std::unique_ptr<float[]> m_upFilter; // m_iPhaseCount rows of m_iTaps coefficients
+
+		// history of the last m_iTaps input samples, per channel. every channel has
+		// 2 * m_iTaps values and every sample is written twice, so the history is always
+		// available as a contiguous range.
+		std::unique_ptr<float[]> m_upHistory;
+		size_t m_iHistoryPos = 0;
+
+		uint32_t m_iPhase = 0; // current position between two input samples, in m_iDenominator
+		size_t m_iPendingInput = 0; // count of input samples needed before the next output
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_RESAMPLER
@@ -0,0 +1,138 @@
+/***************************************************************************************************
+ FILE:	audio.soundbank.hpp
+ CPP:	audio.soundbank.cpp
+ DESCR:	Storage of many sounds in a single file (.rlSBK) that can be loaded at once
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_SOUNDBANK
+#define ROBINLE_AUDIO_SOUNDBANK
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "audio.engine.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// A set of named sounds that's loaded from a single <c>.rlSBK</c> file<para/>
+	/// The file consists of a table of the sounds' formats and data ranges, a name table and a
+	/// single data region. The data region is page-aligned and the data of every sound is aligned
+	/// to 64 bytes, so the file can be memory-mapped and the <c>Sound</c> objects reference the
+	/// mapping directly instead of copying and parsing every sound on its own.
+	/// </summary>
+	class SoundBank final
+	{
+	public: // static variables
+
+		static constexpr size_t npos = (size_t)-1;
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Write a sound bank file<para/>
+		/// Compressed sounds are stored compressed, attached envelopes (see <c>AudioEnvelope</c>)
+		/// are stored too.
+		/// </summary>
+		/// <returns>Could the file be written?</returns>
+		static bool Save(const wchar_t* szPath,
+			const std::map<std::wstring, const Sound*>& oSounds);
+		/// <summary>
+		/// Create the contents of a sound bank file in memory (for example to store it inside a
+		/// <c>FileContainer</c>)
+		/// </summary>
+		/// <returns>Are all sounds valid?</returns>
+		static bool SaveToMemory(std::vector<uint8_t>& oDest,
+			const std::map<std::wstring, const Sound*>& oSounds);
+
+
+	public: // methods
+
+		SoundBank() = default;
+		SoundBank(const SoundBank& other) = delete;
+		SoundBank(SoundBank&& rval) = default;
+		~SoundBank() = default;
+
+		SoundBank& operator=(const SoundBank& other) = delete;
+		SoundBank& operator=(SoundBank&& rval) = default;
+
+		/// <summary>
+		/// Load a sound bank file<para/>
+		/// The file is memory-mapped; the mapping stays alive as long as any <c>Sound</c>
+		/// references it (including copies of the sounds of this bank).
+		/// </summary>
+		bool load(const wchar_t* szPath);
+		/// <summary>
+		/// Load a sound bank from memory
+		/// </summary>
+		/// <param name="bCopy">
+		/// If <c>false</c>, the sounds reference the sample data inside of <c>data</c> (for example
+		/// the data of a <c>FileContainer::File</c>).<para/>
+		/// The buffer must stay valid and unchanged while any of the sounds exists.
+		/// </param>
+		bool loadFromMemory(const void* data, size_t size, bool bCopy = true);
+
+		void clear() noexcept;
+
+		inline size_t size() const noexcept { return m_oSounds.size(); }
+
+		/// <summary>
+		/// Find the index of a sound by its name (binary search)
+		/// </summary>
+		/// <returns>
+		/// The index of the sound or <c>npos</c> if there's no sound by that name
+		/// </returns>
+		size_t find(std::wstring_view sName) const noexcept;
+
+		/// <returns>The sound or <c>nullptr</c> if the index is invalid</returns>
+		const Sound* get(size_t iIndex) const noexcept;
+		/// <returns>The sound or <c>nullptr</c> if there's no sound by that name</returns>
+		inline const Sound* get(std::wstring_view sName) const noexcept { return get(find(sName)); }
+
+		/// <summary>
+		/// Get the name of a sound<para/>
+		/// The names are sorted, so the index of a sound is the same as the index of its name in
+		/// the sorted list of all names.
+		/// </summary>
+		std::wstring_view getName(size_t iIndex) const noexcept;
+
+
+	private: // methods
+
+		bool parse(const uint8_t* pData, size_t iSize, std::shared_ptr<const void> spOwner);
+
+
+	private: // variables
+
+		std::shared_ptr<const void> m_spData; // the mapping or the copied data
+		std::vector<Sound> m_oSounds;
+		std::vector<std::wstring_view> m_oNames; // referencing the bank data, sorted
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_SOUNDBANK
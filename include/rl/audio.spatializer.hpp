@@ -0,0 +1,219 @@
+/***************************************************************************************************
+ FILE:	audio.spatializer.hpp
+ CPP:	audio.spatializer.cpp
+ DESCR:	Batched 3D positioning of many SoundInstance3D objects
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_AUDIO_SPATIALIZER
+#define ROBINLE_AUDIO_SPATIALIZER
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "audio.engine.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// Distance attenuation model (inverse distance, clamped)<para/>
+	/// gain = fMinDistance / (fMinDistance + fRolloff * (distance - fMinDistance)), with
+	/// the distance clamped to <c>[fMinDistance, fMaxDistance]</c>
+	/// </summary>
+	struct DistanceAttenuation
+	{
+		float fMinDistance = 1.0f; // up to this distance, the gain is 1.0f
+		float fMaxDistance = 100.0f; // beyond this distance, the gain doesn't decrease anymore
+		float fRolloff = 1.0f; // 0.0f = no attenuation
+	};
+
+
+
+	/// <summary>
+	/// Calculates the 7.1 output matrices of many <c>SoundInstance3D</c> objects at once<para/>
+	/// The positions are stored as a structure of arrays and all matrices are calculated in a
+	/// single vectorized pass per call to <c>update()</c>. Matrix changes are smoothed over time
+	/// to avoid zipper noise and applied to XAudio2 in a single operation set.
+	/// <para/>
+	/// Only the most audible emitters (volume * distance gain) play on a real XAudio2 voice; all
+	/// others are virtualized and get their voice back as soon as they're audible again. This way,
+	/// thousands of emitters cost no more mixing time than the voice limit.<para/>
+	/// Not thread-safe. Emitters must be removed before their <c>SoundInstance3D</c> is deleted.
+	/// </summary>
+	class AudioSpatializer final
+	{
+	public: // types
+
+		using EmitterID = size_t;
+		static constexpr EmitterID InvalidEmitter = (EmitterID)-1;
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Calculate the output matrices for positions given as a structure of arrays
+		/// </summary>
+		/// <param name="pGain">= Gain factor per position (may be <c>nullptr</c>)</param>
+		/// <param name="pMatrices">= Receives 8 values per position</param>
+		static void CalcMatrices(const float* pX, const float* pZ, const float* pRadius,
+			const float* pGain, size_t iCount, float* pMatrices) noexcept;
+
+
+	public: // methods
+
+		AudioSpatializer() = default;
+		AudioSpatializer(const AudioSpatializer& other) = delete;
+		~AudioSpatializer() = default;
+
+		AudioSpatializer& operator=(const AudioSpatializer& other) = delete;
+
+		/// <summary>
+		/// Start managing the position of a <c>SoundInstance3D</c><para/>
+		/// The matrix is applied immediately (without smoothing) on the next <c>update()</c>.
+		/// </summary>
+		/// <param name="fDistance">= The distance to the listener</param>
+		EmitterID add(SoundInstance3D& instance, const Audio3DPos& pos, float fDistance = 0.0f);
+		/// <summary>
+		/// Stop managing an emitter<para/>
+		/// If the spatializer virtualized its instance, the instance gets its voice back.
+		/// </summary>
+		void remove(EmitterID id);
+		/// <summary>
+		/// Stop managing all emitters<para/>
+		/// The instances the spatializer virtualized get their voices back.
+		/// </summary>
+		void clear();
+
+		void setPos(EmitterID id, const Audio3DPos& pos) noexcept;
+		void setDistance(EmitterID id, float fDistance) noexcept;
+
+		inline size_t getEmitterCount() const noexcept { return m_oInstances.size(); }
+
+		/// <summary>
+		/// Get the (smoothed) output matrix of an emitter that was calculated by the last
+		/// <c>update()</c>
+		/// </summary>
+		/// <returns>
+		/// 8 values in the order of the 7.1 speakers, <c>nullptr</c> if the ID is invalid
+		/// </returns>
+		const float* getMatrix(EmitterID id) const noexcept;
+
+		inline void setAttenuation(const DistanceAttenuation& att) noexcept
+		{
+			m_oAttenuation = att;
+		}
+		inline const auto& getAttenuation() const noexcept { return m_oAttenuation; }
+
+		/// <summary>
+		/// Set the maximum count of emitters that play on a real XAudio2 voice<para/>
+		/// Default is 64.
+		/// </summary>
+		inline void setVoiceLimit(size_t iMaxVoices) noexcept { m_iVoiceLimit = iMaxVoices; }
+		inline size_t getVoiceLimit() const noexcept { return m_iVoiceLimit; }
+
+		/// <summary>
+		/// Set the audibility (volume * distance gain) below which an emitter is virtualized
+		/// <para/>
+		/// Default is 0.001f (-60 dB).
+		/// </summary>
+		inline void setAudibilityThreshold(float fThreshold) noexcept
+		{
+			m_fAudibilityThreshold = fThreshold;
+		}
+		inline float getAudibilityThreshold() const noexcept { return m_fAudibilityThreshold; }
+
+		/// <summary>
+		/// Get the count of emitters that were virtual after the last <c>update()</c>
+		/// </summary>
+		inline size_t getVirtualCount() const noexcept { return m_iVirtualCount; }
+
+		/// <summary>
+		/// Set the share of the remaining difference to the target matrix that's applied per
+		/// 1/60 second<para/>
+		/// The smoothing depends on the elapsed time only, so it's equally fast at any update
+		/// rate. 1.0f means no smoothing. Default is 0.35f.
+		/// </summary>
+		void setSmoothing(float fFactor) noexcept;
+		inline float getSmoothing() const noexcept { return m_fSmoothing; }
+
+		/// <summary>
+		/// Recalculate all matrices and apply the changed ones<para/>
+		/// Should be called once per frame. The smoothing uses the time since the last call.
+		/// </summary>
+		void update();
+
+		/// <summary>
+		/// Recalculate all matrices and apply the changed ones
+		/// </summary>
+		/// <param name="fElapsedTime">
+		/// = The time, in seconds, the smoothing advances by (usually the time since the last
+		/// update)
+		/// </param>
+		void update(float fElapsedTime);
+
+
+	private: // methods
+
+		/// <summary>
+		/// Reserve padding so the SIMD pass can always process groups of 4 emitters
+		/// </summary>
+		void resizeArrays(size_t iCount);
+
+		/// <summary>
+		/// Give the most audible emitters a voice and virtualize all others
+		/// </summary>
+		void updateVoices(size_t iCount);
+
+
+	private: // variables
+
+		// structure of arrays, index = slot
+		std::vector<float> m_oX;
+		std::vector<float> m_oZ;
+		std::vector<float> m_oRadius;
+		std::vector<float> m_oDistance;
+		std::vector<float> m_oGain; // temporary buffer for update()
+		std::vector<float> m_oTarget; // 8 values per slot
+		std::vector<float> m_oCurrent; // 8 values per slot, smoothed
+		std::vector<SoundInstance3D*> m_oInstances;
+		std::vector<bool> m_oSnap; // apply the next matrix without smoothing
+		std::vector<bool> m_oVirtualized; // was the instance virtualized by updateVoices()?
+		std::vector<EmitterID> m_oIDOfSlot;
+		std::vector<std::pair<float, size_t>> m_oRanking; // temporary buffer for update()
+		std::vector<bool> m_oAudible; // temporary buffer for update()
+
+		std::vector<size_t> m_oSlotOfID; // InvalidEmitter = unused ID
+		std::vector<EmitterID> m_oFreeIDs;
+
+		DistanceAttenuation m_oAttenuation;
+		float m_fSmoothing = 0.35f;
+		std::chrono::steady_clock::time_point m_tpLastUpdate; // of update() without elapsed time
+
+		size_t m_iVoiceLimit = 64;
+		float m_fAudibilityThreshold = 0.001f;
+		size_t m_iVirtualCount = 0;
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_AUDIO_SPATIALIZER
@@ -30,6 +30,11 @@ namespace rl
 		using UChar_t = unsigned int; // 32 bit
 		using NameLen_t = unsigned short; // 16 bit
 
+		/// <summary>
+		/// Returned by <c>FindChar</c> if there's no character by the given name
+		/// </summary>
+		constexpr UChar_t InvalidChar = 0xFFFFFFFF;
+
 
 
 
@@ -49,7 +54,10 @@ namespace rl
 
 		
 		/// <summary>
-		/// Get the name of a unicode character
+		/// Get the name of a unicode character<para/>
+		/// The names of the Hangul syllables and the ideographs that are not listed individually
+		/// in UnicodeData.txt (e.g. <c>"CJK UNIFIED IDEOGRAPH-4E00"</c>) are derived from the code
+		/// point.
 		/// </summary>
 		/// <param name="ch">= raw unicode value of the character</param>
 		/// <param name="buf">= the buffer that should receive the name (pure ASCII)</param>
@@ -63,6 +71,43 @@ namespace rl
 		/// </returns>
 		UNICODEDATA_API NameLen_t __stdcall GetName(UChar_t ch, char* buf, NameLen_t buf_size);
 
+
+
+
+		/// <summary>
+		/// Find a character by its name (as returned by <c>GetName</c>)<para/>
+		/// The name is compared case-insensitively.
+		/// </summary>
+		/// <param name="szName">= the name of the character (pure ASCII)</param>
+		/// <returns>
+		/// If there is a character by this name, its raw unicode value<para/>
+		/// Otherwise, <c>InvalidChar</c>
+		/// </returns>
+		UNICODEDATA_API UChar_t __stdcall FindChar(const char* szName);
+
+
+
+
+		/// <summary>
+		/// Find all characters whose names match a pattern<para/>
+		/// The names are compared case-insensitively.
+		/// </summary>
+		/// <param name="szPattern">
+		/// = the pattern (pure ASCII). <c>*</c> matches any sequence of characters.<para/>
+		/// Examples: <c>"LATIN SMALL LETTER A WITH*"</c>, <c>"*WITH ACUTE*"</c>
+		/// </param>
+		/// <param name="buf">
+		/// = the buffer that should receive the raw unicode values of the matching characters, in
+		/// ascending order. Can be <c>nullptr</c> if <c>buf_size</c> is zero.
+		/// </param>
+		/// <param name="buf_size">= the count of values <c>buf</c> can hold</param>
+		/// <returns>
+		/// The total count of matching characters (can be greater than <c>buf_size</c>; in that
+		/// case, only the first <c>buf_size</c> values were written)
+		/// </returns>
+		UNICODEDATA_API unsigned int __stdcall FindChars(const char* szPattern, UChar_t* buf,
+			unsigned int buf_size);
+
 	}
 }
 
@@ -292,6 +292,12 @@ namespace rl
 		/// <param name="ch"></param>
 		void checkNoncharacter(char32_t ch);
 
+		/// <summary>
+		/// Check if an array contains noncharacters<para />
+		/// If it does, an <c>std::exception</c> is thrown
+		/// </summary>
+		void checkNoncharacters(const char32_t* p, size_t iCount);
+
 
 	private: // variables
 
@@ -227,6 +227,13 @@ namespace rl
 	};
 
 
+	/// <summary>
+	/// Lookup index of the characters of a font face<para/>
+	/// Opaque, built by <c>FontFaceCreate</c>
+	/// </summary>
+	struct FontFaceIndex;
+
+
 	/// <summary>
 	/// Data of a font face (in-memory representation of a rlFNT file [v2.0])<para/>
 	/// C-compatible struct
@@ -247,6 +254,11 @@ namespace rl
 		/// Use like an array of size <c>pHeader-&gt;iCharCount</c>
 		/// </summary>
 		FontFaceCharInfo* pInfos;
+		/// <summary>
+		/// Pointer to the lookup index of the characters<para/>
+		/// If it's a <c>nullptr</c>, <c>pInfos</c> is searched directly
+		/// </summary>
+		FontFaceIndex* pIndex;
 	};
 
 
@@ -254,7 +266,8 @@ namespace rl
 
 
 	/// <summary>
-	/// Load a <c>FontFace</c> struct from a byte buffer
+	/// Load a <c>FontFace</c> struct from a byte buffer<para/>
+	/// Also builds the lookup index of the characters, which must be sorted in ascending order
 	/// </summary>
 	/// <param name="dest">= a pointer to the destination struct</param>
 	/// <param name="buf">
@@ -292,6 +305,8 @@ namespace rl
 
 	/// <summary>
 	/// Get information about a character from a font face<para/>
+	/// Takes constant time for the characters of densely populated blocks (e.g. ASCII or CJK),
+	/// logarithmic time otherwise.
 	/// </summary>
 	/// <param name="face">- must point to a valid font face</param>
 	/// <returns><c>nullptr</c> if the function failed</returns>
@@ -0,0 +1,154 @@
+/***************************************************************************************************
+ FILE:	text.codepages.hpp
+ CPP:	text.codepages.cpp
+ DESCR:	Conversion between the single-byte characters of Windows codepages and Unicode
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_TEXT_CODEPAGES
+#define ROBINLE_TEXT_CODEPAGES
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "unicode.hpp" // Unicode::TranscodeResult
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// The conversion tables of a codepage<para/>
+	/// Only single-byte characters are supported; lead bytes of multi-byte codepages are
+	/// undefined.
+	/// </summary>
+	class CodepageTable final
+	{
+	public: // static variables
+
+		/// <summary>
+		/// The decoded value of bytes that don't represent a character
+		/// </summary>
+		static constexpr char16_t Undefined = 0xFFFF; // a noncharacter
+
+
+	public: // static methods
+
+		/// <summary>
+		/// Get the tables of a codepage<para/>
+		/// The tables are created on first use and stay valid until the program ends.
+		/// </summary>
+		/// <param name="bGlyphs">
+		/// = should the control characters of DOS codepages be decoded to the symbols that DOS
+		/// displayed for them? (only appropriate for fonts, not for text)
+		/// </param>
+		/// <returns>
+		/// A pointer to the tables, <c>nullptr</c> if the codepage isn't available
+		/// </returns>
+		static const CodepageTable* Get(uint16_t iCodepage, bool bGlyphs = false);
+
+
+	public: // methods
+
+		inline uint16_t getCodepage() const noexcept { return m_iCodepage; }
+
+		/// <summary>
+		/// Decode a single byte<para/>
+		/// Returns <c>CodepageTable::Undefined</c> if the byte isn't a character.
+		/// </summary>
+		inline char16_t decode(uint8_t c) const noexcept { return m_cDecode[c]; }
+
+		/// <summary>
+		/// Encode a single character
+		/// </summary>
+		/// <returns>Is the character part of the codepage?</returns>
+		bool encode(char32_t ch, uint8_t& iDest) const noexcept;
+
+		/// <summary>
+		/// Decode a string to UTF-16<para/>
+		/// A buffer of <c>iSrcLen</c> code units is always large enough.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-16 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult decode(const char* pSrc, size_t iSrcLen, char16_t* pDest,
+			size_t iDestLen) const noexcept;
+
+		/// <summary>
+		/// Decode a string to UTF-32<para/>
+		/// A buffer of <c>iSrcLen</c> code units is always large enough.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-32 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult decode(const char* pSrc, size_t iSrcLen, char32_t* pDest,
+			size_t iDestLen) const noexcept;
+
+		/// <summary>
+		/// Encode a UTF-16 string<para/>
+		/// A buffer of <c>iSrcLen</c> bytes is always large enough.<para/>
+		/// Characters that aren't part of the codepage are invalid.
+		/// </summary>
+		/// <param name="pDest">= the buffer that receives the string (not zero-terminated)</param>
+		/// <param name="iDestLen">= the size of the buffer, in bytes</param>
+		Unicode::TranscodeResult encode(const char16_t* pSrc, size_t iSrcLen, char* pDest,
+			size_t iDestLen) const noexcept;
+
+		/// <summary>
+		/// Encode a UTF-32 string<para/>
+		/// A buffer of <c>iSrcLen</c> bytes is always large enough.<para/>
+		/// Characters that aren't part of the codepage are invalid.
+		/// </summary>
+		/// <param name="pDest">= the buffer that receives the string (not zero-terminated)</param>
+		/// <param name="iDestLen">= the size of the buffer, in bytes</param>
+		Unicode::TranscodeResult encode(const char32_t* pSrc, size_t iSrcLen, char* pDest,
+			size_t iDestLen) const noexcept;
+
+
+	private: // methods
+
+		CodepageTable() = default;
+
+		/// <summary>
+		/// Build the encoding tables from the decoding table
+		/// </summary>
+		void createReverseTable();
+
+
+	private: // variables
+
+		uint16_t m_iCodepage = 0;
+		bool m_bASCII = false; // are bytes 0x00 to 0x7F the same as in ASCII?
+		char16_t m_cDecode[256] = {};
+
+		// The encoding table is split into pages of 256 characters; only the pages that contain
+		// characters of the codepage are stored. A looked-up byte is only valid if it decodes to
+		// the character again, so no separate "undefined" value is needed.
+		uint16_t m_iEncodePage[256] = {}; // high byte of the character --> page (0 = empty page)
+		std::vector<uint8_t> m_oEncode; // the pages; the low byte of the character is the index
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_TEXT_CODEPAGES
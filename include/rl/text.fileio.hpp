@@ -1,6 +1,7 @@
 /***************************************************************************************************
  FILE:	text.fileio.hpp
  CPP:	text.fileio.cpp
+		text.codepages.cpp
 		unicode.cpp
  DESCR:	Code for working with text files in one of the multiple common encodings
 ***************************************************************************************************/
@@ -20,6 +21,14 @@
 //--------------------------------------------------------------------------------------------------
 // <stdint.h>
 using uint8_t = unsigned char;
+using uint16_t = unsigned short;
+
+//--------------------------------------------------------------------------------------------------
+// "text.codepages.hpp"
+namespace rl
+{
+	class CodepageTable;
+}
 
 
 #include <fstream>
@@ -43,7 +52,8 @@ namespace rl
 		/// <para/>
 		/// When detected, the data wasn't valid with any other encoding. Might also
 		/// indicate a binary file.<para/>
-		/// When encoding or decoding with this value, Codepage 1252 is used.
+		/// When encoding or decoding with this value, the codepage of
+		/// <c>TextFileInfo::iCodepage</c> is used (default: Windows-1252).
 		/// </summary>
 		Codepage,
 		/// <summary>
@@ -110,9 +120,11 @@ namespace rl
 		TextEncoding eEncoding;
 		LineBreak eLineBreaks;
 		uint8_t iFlags;
+		uint16_t iCodepage; // only for TextEncoding::Codepage; 0 = Windows-1252
 	};
 
-	constexpr TextFileInfo TextFileInfo_Codepage(LineBreak eLineBreaks = LineBreak::OS) noexcept;
+	constexpr TextFileInfo TextFileInfo_Codepage(LineBreak eLineBreaks = LineBreak::OS,
+		uint16_t iCodepage = 1252) noexcept;
 	constexpr TextFileInfo TextFileInfo_ASCII   (LineBreak eLineBreaks = LineBreak::OS) noexcept;
 	constexpr TextFileInfo TextFileInfo_UTF8    (LineBreak eLineBreaks = LineBreak::OS) noexcept;
 	constexpr TextFileInfo TextFileInfo_UTF8BOM (LineBreak eLineBreaks = LineBreak::OS) noexcept;
@@ -217,7 +229,8 @@ namespace rl
 		/// </summary>
 		void open(const wchar_t* szFilePath);
 		/// <summary>
-		/// Open a text file using an explicit encoding.
+		/// Open a text file using an explicit encoding.<para/>
+		/// Fails if the encoding is <c>TextEncoding::Codepage</c> and the codepage isn't available.
 		/// </summary>
 		void open(const wchar_t* szFilePath, const TextFileInfo& oEncoding);
 		/// <summary>
@@ -261,6 +274,7 @@ namespace rl
 	private: // variables
 
 		TextFileInfo m_oEncoding{};
+		const CodepageTable* m_pCodepage = nullptr; // only for TextEncoding::Codepage
 		bool m_bTrailingLinebreak = false;
 		std::basic_ifstream<uint8_t> m_oFile;
 	};
@@ -354,6 +368,7 @@ namespace rl
 	private: // variables
 
 		TextFileInfo m_oEncoding = TextFileInfo_UTF8BOM();
+		const CodepageTable* m_pCodepage = nullptr; // only for TextEncoding::Codepage
 		std::basic_ofstream<uint8_t> m_oFile;
 	};
 
@@ -369,7 +384,7 @@ namespace rl
 	//==============================================================================================
 	// DEFINITIONS
 
-	constexpr TextFileInfo TextFileInfo_Codepage(LineBreak eLineBreaks) noexcept
+	constexpr TextFileInfo TextFileInfo_Codepage(LineBreak eLineBreaks, uint16_t iCodepage) noexcept
 	{
 		namespace flags = Flags::TextFileInfo;
 
@@ -377,6 +392,7 @@ namespace rl
 		result.eEncoding = TextEncoding::Codepage;
 		result.eLineBreaks = eLineBreaks;
 		result.iFlags = 0;
+		result.iCodepage = iCodepage;
 
 		return result;
 	}
@@ -0,0 +1,105 @@
+/***************************************************************************************************
+ FILE:	tools.mpscqueue.hpp
+ CPP:	<n/a>
+ DESCR:	Lock-free multiple producer, single consumer queue
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_TOOLS_MPSCQUEUE
+#define ROBINLE_TOOLS_MPSCQUEUE
+
+
+
+
+
+#include <atomic>
+#include <utility>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// An unbounded lock-free queue for multiple producer threads and a single consumer thread
+	/// <para/>
+	/// <c>push()</c> may be called from any thread. It only needs a single atomic exchange, so
+	/// producers never wait for each other or for the consumer (the nodes are allocated with the
+	/// default allocator, though).<para/>
+	/// <c>pop()</c> and <c>empty()</c> must only be called by one thread at a time.
+	/// </summary>
+	template <typename T>
+	class MPSCQueue final
+	{
+	public: // methods
+
+		MPSCQueue() : m_pTail(new Node()) { m_pHead = m_pTail; }
+		MPSCQueue(const MPSCQueue& other) = delete;
+		~MPSCQueue()
+		{
+			T tmp;
+			while (pop(tmp)) {}
+			delete m_pTail;
+		}
+
+		MPSCQueue& operator=(const MPSCQueue& other) = delete;
+
+		void push(const T& val) { pushNode(new Node{ val }); }
+		void push(T&& val) { pushNode(new Node{ std::move(val) }); }
+
+		/// <summary>
+		/// Remove the oldest element from the queue
+		/// </summary>
+		/// <returns>Was an element removed? (if <c>false</c>, the queue was empty)</returns>
+		bool pop(T& dest)
+		{
+			Node* pTail = m_pTail;
+			Node* pNext = pTail->pNext.load(std::memory_order_acquire);
+			if (pNext == nullptr)
+				return false;
+
+			// the next node becomes the new (empty) tail node
+			dest = std::move(pNext->val);
+			m_pTail = pNext;
+			delete pTail;
+			return true;
+		}
+
+		bool empty() const { return m_pTail->pNext.load(std::memory_order_acquire) == nullptr; }
+
+
+	private: // types
+
+		struct Node
+		{
+			T val{};
+			std::atomic<Node*> pNext = nullptr;
+		};
+
+
+	private: // methods
+
+		void pushNode(Node* pNode)
+		{
+			Node* pPrev = m_pHead.exchange(pNode, std::memory_order_acq_rel);
+			pPrev->pNext.store(pNode, std::memory_order_release);
+		}
+
+
+	private: // variables
+
+		std::atomic<Node*> m_pHead; // last pushed node (producers)
+		Node* m_pTail; // node before the oldest element (consumer)
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_TOOLS_MPSCQUEUE
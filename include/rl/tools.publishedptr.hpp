@@ -0,0 +1,152 @@
+/***************************************************************************************************
+ FILE:	tools.publishedptr.hpp
+ CPP:	<n/a>
+ DESCR:	Lock-free handover of immutable values from writer threads to a single reader thread
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_TOOLS_PUBLISHEDPTR
+#define ROBINLE_TOOLS_PUBLISHEDPTR
+
+
+
+
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+
+	/// <summary>
+	/// A value that's replaced by writer threads and read by a single reader thread without locks
+	/// <para/>
+	/// The reader accesses the value through a <c>ReadGuard</c>, which costs a plain atomic load
+	/// and two atomic increments of an epoch counter. Writers must be serialized by the owner.
+	/// <c>publish()</c> never waits for the reader: replaced values are kept until the reader has
+	/// left the read section it might still be using them in, and are then released by the next
+	/// <c>publish()</c> or <c>releaseRetired()</c>. The reader never releases a value.
+	/// </summary>
+	template <typename T>
+	class PublishedPtr final
+	{
+	public: // types
+
+		/// <summary>
+		/// A read section of the reader thread<para/>
+		/// The value stays valid until the guard is destroyed, even if a new one is published
+		/// meanwhile. Read sections must not be nested.
+		/// </summary>
+		class ReadGuard final
+		{
+		public: // methods
+
+			explicit ReadGuard(PublishedPtr& owner) noexcept : m_oOwner(owner)
+			{
+				m_oOwner.m_iEpoch.fetch_add(1, std::memory_order_seq_cst); // odd = reading
+				m_pValue = m_oOwner.m_pValue.load(std::memory_order_seq_cst);
+			}
+			ReadGuard(const ReadGuard& other) = delete;
+			~ReadGuard() { m_oOwner.m_iEpoch.fetch_add(1, std::memory_order_release); }
+
+			ReadGuard& operator=(const ReadGuard& other) = delete;
+
+			inline T* get() const noexcept { return m_pValue; }
+			inline T* operator->() const noexcept { return m_pValue; }
+			inline T& operator*() const noexcept { return *m_pValue; }
+			inline explicit operator bool() const noexcept { return m_pValue != nullptr; }
+
+
+		private: // variables
+
+			PublishedPtr& m_oOwner;
+			T* m_pValue;
+
+		};
+
+
+	public: // methods
+
+		PublishedPtr() = default;
+		PublishedPtr(const PublishedPtr& other) = delete;
+		~PublishedPtr() = default; // the reader must be done
+
+		PublishedPtr& operator=(const PublishedPtr& other) = delete;
+
+		/// <summary>
+		/// Replace the value that's seen by new read sections (writers only)
+		/// </summary>
+		void publish(std::shared_ptr<T> spValue)
+		{
+			m_pValue.exchange(spValue.get(), std::memory_order_seq_cst);
+			const uint32_t iEpoch = m_iEpoch.load(std::memory_order_seq_cst);
+
+			// even epoch = the reader isn't reading --> it will see the new value
+			if (m_spValue && (iEpoch & 1))
+				m_oRetired.push_back({ std::move(m_spValue), iEpoch });
+			m_spValue = std::move(spValue);
+
+			releaseRetired(iEpoch);
+		}
+
+		/// <summary>
+		/// Release the replaced values the reader is done with (writers only)
+		/// </summary>
+		void releaseRetired() { releaseRetired(m_iEpoch.load(std::memory_order_acquire)); }
+
+		/// <summary>
+		/// Get the current value (writers only)
+		/// </summary>
+		inline const std::shared_ptr<T>& get() const noexcept { return m_spValue; }
+
+		/// <summary>
+		/// Get the count of replaced values that are kept for the reader
+		/// </summary>
+		inline size_t getRetiredCount() const noexcept { return m_oRetired.size(); }
+
+
+	private: // types
+
+		struct Retired
+		{
+			std::shared_ptr<T> spValue;
+			uint32_t iEpoch; // the epoch of the read section that might still use the value
+		};
+
+
+	private: // methods
+
+		void releaseRetired(uint32_t iEpoch)
+		{
+			// once the epoch has changed, the reader has left the read section
+			std::erase_if(m_oRetired, [iEpoch](const Retired& o) { return o.iEpoch != iEpoch; });
+		}
+
+
+	private: // variables
+
+		static_assert(std::atomic<T*>::is_always_lock_free &&
+			std::atomic<uint32_t>::is_always_lock_free);
+
+		std::atomic<T*> m_pValue = nullptr; // read by the reader
+		std::atomic<uint32_t> m_iEpoch = 0; // incremented when the reader enters or leaves
+		std::shared_ptr<T> m_spValue; // owns *m_pValue (writers only)
+		std::vector<Retired> m_oRetired; // writers only
+
+	};
+
+}
+
+
+
+
+
+#endif // ROBINLE_TOOLS_PUBLISHEDPTR
@@ -11,6 +11,13 @@
 
 
 
+//==================================================================================================
+// INCLUDES
+
+#include "unicode.tables.hpp" // created by UnicodeData_Generator
+
+#include <cstddef>
+#include <cstdint>
 #if __cplusplus > 201703L
 #include <memory>
 #endif // C++17
@@ -36,6 +43,487 @@ namespace rl
 		/// </summary>
 		bool IsNoncharacter(char32_t ch) noexcept;
 
+
+
+		/// <summary>
+		/// Find the first character inside of a private use area in a UTF-32 string
+		/// </summary>
+		/// <returns>The index of the character, <c>iLen</c> if there is none</returns>
+		size_t FindPrivateUse(const char32_t* p, size_t iLen) noexcept;
+
+		/// <summary>
+		/// Find the first character inside of a private use area in a UTF-16 string<para/>
+		/// Unpaired surrogates are skipped.
+		/// </summary>
+		/// <returns>
+		/// The index of the first code unit of the character, <c>iLen</c> if there is none
+		/// </returns>
+		size_t FindPrivateUse(const char16_t* p, size_t iLen) noexcept;
+
+		/// <summary>
+		/// Find the first noncharacter in a UTF-32 string
+		/// </summary>
+		/// <returns>The index of the noncharacter, <c>iLen</c> if there is none</returns>
+		size_t FindNoncharacter(const char32_t* p, size_t iLen) noexcept;
+
+		/// <summary>
+		/// Find the first noncharacter in a UTF-16 string<para/>
+		/// Unpaired surrogates are skipped.
+		/// </summary>
+		/// <returns>
+		/// The index of the first code unit of the noncharacter, <c>iLen</c> if there is none
+		/// </returns>
+		size_t FindNoncharacter(const char16_t* p, size_t iLen) noexcept;
+
+
+
+
+
+		//------------------------------------------------------------------------------------------
+		// TRANSCODING (see the namespaces UTF8, UTF16 and UTF32)
+
+		/// <summary>
+		/// The outcome of a conversion between Unicode encoding forms
+		/// </summary>
+		enum class TranscodeStatus : uint8_t
+		{
+			OK,
+			InvalidInput, // the input at TranscodeResult::iRead is not valid
+			BufferTooSmall // the character at TranscodeResult::iRead didn't fit into the buffer
+		};
+
+		/// <summary>
+		/// The result of a conversion between Unicode encoding forms
+		/// </summary>
+		struct TranscodeResult
+		{
+			TranscodeStatus eStatus;
+			size_t iRead; // code units read (on failure: the index of the first unconverted one)
+			size_t iWritten; // code units written
+		};
+
+
+
+
+
+		//------------------------------------------------------------------------------------------
+		// CHARACTER PROPERTIES (based on "UnicodeData.txt", see unicode.tables.hpp)
+
+		/// <summary>
+		/// The general category of a code point
+		/// </summary>
+		enum class GeneralCategory : uint8_t
+		{
+			UppercaseLetter, // Lu
+			LowercaseLetter, // Ll
+			TitlecaseLetter, // Lt
+			ModifierLetter, // Lm
+			OtherLetter, // Lo
+			NonspacingMark, // Mn
+			SpacingMark, // Mc
+			EnclosingMark, // Me
+			DecimalNumber, // Nd
+			LetterNumber, // Nl
+			OtherNumber, // No
+			ConnectorPunctuation, // Pc
+			DashPunctuation, // Pd
+			OpenPunctuation, // Ps
+			ClosePunctuation, // Pe
+			InitialPunctuation, // Pi
+			FinalPunctuation, // Pf
+			OtherPunctuation, // Po
+			MathSymbol, // Sm
+			CurrencySymbol, // Sc
+			ModifierSymbol, // Sk
+			OtherSymbol, // So
+			SpaceSeparator, // Zs
+			LineSeparator, // Zl
+			ParagraphSeparator, // Zp
+			Control, // Cc
+			Format, // Cf
+			Surrogate, // Cs
+			PrivateUse, // Co
+			Unassigned // Cn
+		};
+
+		/// <summary>
+		/// The bidirectional class of a code point
+		/// </summary>
+		enum class BidiClass : uint8_t
+		{
+			LeftToRight, // L
+			RightToLeft, // R
+			ArabicLetter, // AL
+			EuropeanNumber, // EN
+			EuropeanSeparator, // ES
+			EuropeanTerminator, // ET
+			ArabicNumber, // AN
+			CommonSeparator, // CS
+			NonspacingMark, // NSM
+			BoundaryNeutral, // BN
+			ParagraphSeparator, // B
+			SegmentSeparator, // S
+			WhiteSpace, // WS
+			OtherNeutral, // ON
+			LeftToRightEmbedding, // LRE
+			LeftToRightOverride, // LRO
+			RightToLeftEmbedding, // RLE
+			RightToLeftOverride, // RLO
+			PopDirectionalFormat, // PDF
+			LeftToRightIsolate, // LRI
+			RightToLeftIsolate, // RLI
+			FirstStrongIsolate, // FSI
+			PopDirectionalIsolate // PDI
+		};
+
+		/// <summary>
+		/// The type of the decomposition mapping of a code point
+		/// </summary>
+		enum class DecompositionType : uint8_t
+		{
+			None,
+			Canonical,
+			Font, // <font>
+			NoBreak, // <noBreak>
+			Initial, // <initial>
+			Medial, // <medial>
+			Final, // <final>
+			Isolated, // <isolated>
+			Circle, // <circle>
+			Super, // <super>
+			Sub, // <sub>
+			Vertical, // <vertical>
+			Wide, // <wide>
+			Narrow, // <narrow>
+			Small, // <small>
+			Square, // <square>
+			Fraction, // <fraction>
+			Compat // <compat>
+		};
+
+		/// <summary>
+		/// The decomposition mapping of a code point
+		/// </summary>
+		struct Decomposition
+		{
+			DecompositionType eType;
+			uint8_t iLength; // the count of code points in pMapping
+			const char32_t* pMapping; // nullptr if eType is None
+		};
+
+
+
+		namespace Tables
+		{
+
+			/// <summary>
+			/// Get the index of the property record of a code point
+			/// </summary>
+			inline constexpr uint16_t GetRecord(char32_t ch) noexcept
+			{
+				if (ch >= 0x110000)
+					return 0; // unassigned
+
+				const uint32_t iBlock = Stage1[ch >> BlockShift];
+				return Stage2[(iBlock << BlockShift) | (ch & ((1u << BlockShift) - 1))];
+			}
+
+		}
+
+
+
+		/// <summary>
+		/// Get the general category of a code point<para/>
+		/// Unassigned code points (and values above <c>0x10FFFF</c>) are
+		/// <c>GeneralCategory::Unassigned</c>.
+		/// </summary>
+		inline constexpr GeneralCategory GetGeneralCategory(char32_t ch) noexcept
+		{
+			return GeneralCategory(Tables::GeneralCategories[Tables::GetRecord(ch)]);
+		}
+
+		/// <summary>
+		/// Get the canonical combining class of a code point (<c>0</c> = not reordered)
+		/// </summary>
+		inline constexpr uint8_t GetCombiningClass(char32_t ch) noexcept
+		{
+			return Tables::CombiningClasses[Tables::GetRecord(ch)];
+		}
+
+		/// <summary>
+		/// Get the bidirectional class of a code point<para/>
+		/// Unassigned code points are <c>BidiClass::LeftToRight</c>.
+		/// </summary>
+		inline constexpr BidiClass GetBidiClass(char32_t ch) noexcept
+		{
+			return BidiClass(Tables::BidiClasses[Tables::GetRecord(ch)]);
+		}
+
+		/// <summary>
+		/// Get the simple uppercase mapping of a code point<para/>
+		/// Code points without a mapping are returned unchanged.
+		/// </summary>
+		inline constexpr char32_t ToUpper(char32_t ch) noexcept
+		{
+			return char32_t(ch + Tables::UpperDeltas[Tables::GetRecord(ch)]);
+		}
+
+		/// <summary>
+		/// Get the simple lowercase mapping of a code point<para/>
+		/// Code points without a mapping are returned unchanged.
+		/// </summary>
+		inline constexpr char32_t ToLower(char32_t ch) noexcept
+		{
+			return char32_t(ch + Tables::LowerDeltas[Tables::GetRecord(ch)]);
+		}
+
+		/// <summary>
+		/// Get the simple titlecase mapping of a code point<para/>
+		/// Code points without a mapping are returned unchanged.
+		/// </summary>
+		inline constexpr char32_t ToTitle(char32_t ch) noexcept
+		{
+			return char32_t(ch + Tables::TitleDeltas[Tables::GetRecord(ch)]);
+		}
+
+		/// <summary>
+		/// Get the decomposition mapping of a code point<para/>
+		/// The mapping isn't applied recursively. Hangul syllables are decomposed algorithmically
+		/// and have no mapping here.
+		/// </summary>
+		inline constexpr Decomposition GetDecomposition(char32_t ch) noexcept
+		{
+			if (ch >= 0x110000)
+				return { DecompositionType::None, 0, nullptr };
+
+			using namespace Tables;
+			const uint32_t iBlock = DecompositionStage1[ch >> DecompositionShift];
+			const uint16_t iOffset = DecompositionStage2[(iBlock << DecompositionShift) |
+				(ch & ((1u << DecompositionShift) - 1))];
+			if (iOffset == 0)
+				return { DecompositionType::None, 0, nullptr };
+
+			const char32_t iHeader = Decompositions[iOffset]; // (type << 8) | length
+			return { DecompositionType(iHeader >> 8), uint8_t(iHeader & 0xFF),
+				Decompositions + iOffset + 1 };
+		}
+
+
+
+
+
+		//------------------------------------------------------------------------------------------
+		// BREAK PROPERTIES (based on "LineBreak.txt", "GraphemeBreakProperty.txt" and
+		// "emoji-data.txt", see unicode.tables.hpp and unicode.segmentation.hpp)
+
+		/// <summary>
+		/// The Grapheme_Cluster_Break property of a code point (UAX #29)
+		/// </summary>
+		enum class GraphemeClusterBreak : uint8_t
+		{
+			Other,
+			CR,
+			LF,
+			Control,
+			Extend,
+			ZWJ,
+			RegionalIndicator,
+			Prepend,
+			SpacingMark,
+			L,
+			V,
+			T,
+			LV,
+			LVT
+		};
+
+		/// <summary>
+		/// The line breaking class of a code point (UAX #14), without the resolution of rule LB1
+		/// </summary>
+		enum class LineBreakClass : uint8_t
+		{
+			MandatoryBreak, // BK
+			CarriageReturn, // CR
+			LineFeed, // LF
+			CombiningMark, // CM
+			NextLine, // NL
+			Surrogate, // SG
+			WordJoiner, // WJ
+			ZeroWidthSpace, // ZW
+			NonBreaking, // GL
+			Space, // SP
+			ZeroWidthJoiner, // ZWJ
+			BreakOpportunityBeforeAndAfter, // B2
+			BreakAfter, // BA
+			BreakBefore, // BB
+			Hyphen, // HY
+			ContingentBreak, // CB
+			ClosePunctuation, // CL
+			CloseParenthesis, // CP
+			Exclamation, // EX
+			Inseparable, // IN
+			Nonstarter, // NS
+			OpenPunctuation, // OP
+			Quotation, // QU
+			InfixSeparator, // IS
+			Numeric, // NU
+			PostfixNumeric, // PO
+			PrefixNumeric, // PR
+			SymbolsAllowingBreakAfter, // SY
+			Ambiguous, // AI
+			Alphabetic, // AL
+			ConditionalJapaneseStarter, // CJ
+			EmojiBase, // EB
+			EmojiModifier, // EM
+			HangulLVSyllable, // H2
+			HangulLVTSyllable, // H3
+			HebrewLetter, // HL
+			Ideographic, // ID
+			HangulLJamo, // JL
+			HangulVJamo, // JV
+			HangulTJamo, // JT
+			RegionalIndicator, // RI
+			ComplexContext, // SA
+			Unknown // XX
+		};
+
+
+
+		namespace Tables
+		{
+
+			/// <summary>
+			/// The flags of the break property values
+			/// </summary>
+			enum BreakFlags : uint16_t
+			{
+				BreakLineMask = 0x003F, // LineBreakClass
+				BreakGraphemeMask = 0x03C0, // GraphemeClusterBreak
+				BreakGraphemeShift = 6,
+				BreakExtendedPictographic = 0x0400,
+				BreakEastAsianWide = 0x0800, // East_Asian_Width F, W or H
+				BreakCombiningMark = 0x1000 // General_Category Mn or Mc
+			};
+
+			/// <summary>
+			/// Get the combined break property value of a code point (see <c>BreakFlags</c>)
+			/// </summary>
+			inline constexpr uint16_t GetBreakProperties(char32_t ch) noexcept
+			{
+				if (ch >= 0x110000)
+					return uint16_t(LineBreakClass::Unknown);
+
+				const uint32_t iBlock = BreakStage1[ch >> BreakShift];
+				return BreakStage2[(iBlock << BreakShift) | (ch & ((1u << BreakShift) - 1))];
+			}
+
+		}
+
+
+
+		/// <summary>
+		/// Get the Grapheme_Cluster_Break property of a code point
+		/// </summary>
+		inline constexpr GraphemeClusterBreak GetGraphemeClusterBreak(char32_t ch) noexcept
+		{
+			return GraphemeClusterBreak((Tables::GetBreakProperties(ch) &
+				Tables::BreakGraphemeMask) >> Tables::BreakGraphemeShift);
+		}
+
+		/// <summary>
+		/// Get the line breaking class of a code point<para/>
+		/// Unassigned code points are <c>LineBreakClass::Unknown</c>, unless they are part of a
+		/// block with another default value.
+		/// </summary>
+		inline constexpr LineBreakClass GetLineBreakClass(char32_t ch) noexcept
+		{
+			return LineBreakClass(Tables::GetBreakProperties(ch) & Tables::BreakLineMask);
+		}
+
+		/// <summary>
+		/// Does a code point have the Extended_Pictographic property?
+		/// </summary>
+		inline constexpr bool IsExtendedPictographic(char32_t ch) noexcept
+		{
+			return Tables::GetBreakProperties(ch) & Tables::BreakExtendedPictographic;
+		}
+
+
+
+
+
+
+		//------------------------------------------------------------------------------------------
+		// NORMALIZATION PROPERTIES (based on "UnicodeData.txt" and "DerivedNormalizationProps.txt",
+		// see unicode.tables.hpp and unicode.normalization.hpp)
+
+		/// <summary>
+		/// The value of a quick check property of a code point or the result of a quick check of a
+		/// string (UAX #15)
+		/// </summary>
+		enum class QuickCheckResult : uint8_t
+		{
+			Yes, // normalized
+			No, // not normalized
+			Maybe // can only be decided by normalizing the text
+		};
+
+
+
+		namespace Tables
+		{
+
+			/// <summary>
+			/// The flags of the normalization property values
+			/// </summary>
+			enum NormalizationFlags : uint16_t
+			{
+				NormalizationCombiningClassMask = 0x00FF,
+				NormalizationNFDNo = 0x0100, // NFD_Quick_Check = No
+				NormalizationNFCNo = 0x0200, // NFC_Quick_Check = No
+				NormalizationNFCMaybe = 0x0400 // NFC_Quick_Check = Maybe
+			};
+
+			/// <summary>
+			/// Get the combined normalization property value of a code point
+			/// (see <c>NormalizationFlags</c>)
+			/// </summary>
+			inline constexpr uint16_t GetNormalizationProperties(char32_t ch) noexcept
+			{
+				if (ch >= 0x110000)
+					return 0;
+
+				const uint32_t iBlock = NormalizationStage1[ch >> NormalizationShift];
+				return NormalizationStage2[(iBlock << NormalizationShift) |
+					(ch & ((1u << NormalizationShift) - 1))];
+			}
+
+		}
+
+
+
+		/// <summary>
+		/// Get the NFD_Quick_Check property of a code point (<c>Yes</c> or <c>No</c>)
+		/// </summary>
+		inline constexpr QuickCheckResult GetNFDQuickCheck(char32_t ch) noexcept
+		{
+			return (Tables::GetNormalizationProperties(ch) & Tables::NormalizationNFDNo) ?
+				QuickCheckResult::No : QuickCheckResult::Yes;
+		}
+
+		/// <summary>
+		/// Get the NFC_Quick_Check property of a code point
+		/// </summary>
+		inline constexpr QuickCheckResult GetNFCQuickCheck(char32_t ch) noexcept
+		{
+			const uint16_t iProperties = Tables::GetNormalizationProperties(ch);
+			if (iProperties & Tables::NormalizationNFCNo)
+				return QuickCheckResult::No;
+			if (iProperties & Tables::NormalizationNFCMaybe)
+				return QuickCheckResult::Maybe;
+			return QuickCheckResult::Yes;
+		}
+
 	}
 
 	namespace UTF16
@@ -63,13 +551,36 @@ namespace rl
 		/// </summary>
 		char32_t Decode(char16_t hi, char16_t lo) noexcept;
 
+		/// <summary>
+		/// Convert UTF-16 to UTF-32<para/>
+		/// A buffer of <c>iSrcLen</c> code units is always large enough.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-32 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult ToUTF32(const char16_t* pSrc, size_t iSrcLen, char32_t* pDest,
+			size_t iDestLen) noexcept;
+
+		/// <summary>
+		/// Convert UTF-16 to UTF-8<para/>
+		/// A buffer of <c>3 * iSrcLen</c> code units is always large enough.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-8 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult ToUTF8(const char16_t* pSrc, size_t iSrcLen, char* pDest,
+			size_t iDestLen) noexcept;
+
 
 
 #if __cplusplus > 201703L
 
 		/// <summary>
 		/// Decode a UTF-16 string to UTF-32<para />
-		/// Throws an <c>std::exception</c> if the input string is not valid
+		/// Throws an <c>std::exception</c> if the input string is not valid (use <c>ToUTF32</c>
+		/// for a conversion into an existing buffer without exceptions)
 		/// </summary>
 		/// <param name="len">
 		/// | If not <c>nullptr</c>, the pointed to variable receives the length, in characters, of
@@ -92,6 +603,63 @@ namespace rl
 #endif // C++17
 
 	}
+
+	namespace UTF8
+	{
+
+		/// <summary>
+		/// Convert UTF-8 to UTF-16<para/>
+		/// A buffer of <c>iSrcLen</c> code units is always large enough.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-16 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult ToUTF16(const char* pSrc, size_t iSrcLen, char16_t* pDest,
+			size_t iDestLen) noexcept;
+
+		/// <summary>
+		/// Convert UTF-8 to UTF-32<para/>
+		/// A buffer of <c>iSrcLen</c> code units is always large enough.<para/>
+		/// Overlong forms, encoded surrogates and values above <c>0x10FFFF</c> are invalid.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-32 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult ToUTF32(const char* pSrc, size_t iSrcLen, char32_t* pDest,
+			size_t iDestLen) noexcept;
+
+	}
+
+	namespace UTF32
+	{
+
+		/// <summary>
+		/// Convert UTF-32 to UTF-8<para/>
+		/// A buffer of <c>4 * iSrcLen</c> code units is always large enough.<para/>
+		/// Surrogates and values above <c>0x10FFFF</c> are invalid.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-8 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult ToUTF8(const char32_t* pSrc, size_t iSrcLen, char* pDest,
+			size_t iDestLen) noexcept;
+
+		/// <summary>
+		/// Convert UTF-32 to UTF-16<para/>
+		/// A buffer of <c>2 * iSrcLen</c> code units is always large enough.<para/>
+		/// Surrogates and values above <c>0x10FFFF</c> are invalid.
+		/// </summary>
+		/// <param name="pDest">
+		/// = the buffer that receives the UTF-16 string (not zero-terminated)
+		/// </param>
+		/// <param name="iDestLen">= the size of the buffer, in code units</param>
+		Unicode::TranscodeResult ToUTF16(const char32_t* pSrc, size_t iSrcLen, char16_t* pDest,
+			size_t iDestLen) noexcept;
+
+	}
 }
 
 
@@ -0,0 +1,117 @@
+/***************************************************************************************************
+ FILE:	unicode.normalization.hpp
+ CPP:	unicode.normalization.cpp
+ DESCR:	Canonical normalization forms NFC and NFD (UAX #15)
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_UNICODE_NORMALIZATION
+#define ROBINLE_UNICODE_NORMALIZATION
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "unicode.hpp" // normalization properties
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+	namespace Unicode
+	{
+
+		/// <summary>
+		/// A canonical normalization form
+		/// </summary>
+		enum class NormalizationForm : uint8_t
+		{
+			NFC, // canonical decomposition, followed by canonical composition
+			NFD // canonical decomposition
+		};
+
+
+
+		/// <summary>
+		/// Get the canonical composition of two code points (including Hangul syllables)
+		/// </summary>
+		/// <returns>
+		/// The primary composite, <c>0</c> if the code points can't be composed
+		/// </returns>
+		char32_t GetComposition(char32_t chFirst, char32_t chSecond) noexcept;
+
+		/// <summary>
+		/// Check if a UTF-32 string is normalized, without normalizing it<para/>
+		/// Doesn't allocate memory; characters that can't be part of a normalized text are
+		/// skipped block by block.
+		/// </summary>
+		QuickCheckResult QuickCheck(NormalizationForm eForm, const char32_t* p,
+			size_t iLen) noexcept;
+
+		/// <summary>
+		/// Check if a UTF-16 string is normalized, without normalizing it<para/>
+		/// Doesn't allocate memory; characters that can't be part of a normalized text are
+		/// skipped block by block. Unpaired surrogates are treated like normalized characters.
+		/// </summary>
+		QuickCheckResult QuickCheck(NormalizationForm eForm, const char16_t* p,
+			size_t iLen) noexcept;
+
+		/// <summary>
+		/// Check if a UTF-32 string is normalized<para/>
+		/// Only allocates memory if the quick check can't decide.
+		/// </summary>
+		bool IsNormalized(NormalizationForm eForm, const char32_t* p, size_t iLen);
+
+		/// <summary>
+		/// Check if a UTF-16 string is normalized<para/>
+		/// Only allocates memory if the quick check can't decide.
+		/// </summary>
+		bool IsNormalized(NormalizationForm eForm, const char16_t* p, size_t iLen);
+
+		/// <summary>
+		/// Normalize a UTF-32 string<para/>
+		/// Strings that are already normalized are left as they are, without allocating memory.
+		/// Otherwise, only the part starting at the first character that might change is
+		/// normalized.
+		/// </summary>
+		/// <returns>Was the string changed?</returns>
+		bool Normalize(NormalizationForm eForm, std::u32string& s);
+
+		/// <summary>
+		/// Normalize a UTF-16 string<para/>
+		/// Strings that are already normalized are left as they are, without allocating memory.
+		/// Otherwise, only the part starting at the first character that might change is
+		/// normalized. Unpaired surrogates are kept.
+		/// </summary>
+		/// <returns>Was the string changed?</returns>
+		bool Normalize(NormalizationForm eForm, std::u16string& s);
+
+#ifdef _WIN32
+		/// <summary>
+		/// Normalize a wide string<para/>
+		/// Strings that are already normalized are left as they are, without allocating memory.
+		/// </summary>
+		/// <returns>Was the string changed?</returns>
+		bool Normalize(NormalizationForm eForm, std::wstring& s);
+#endif // _WIN32
+
+	}
+}
+
+
+
+
+
+#endif // ROBINLE_UNICODE_NORMALIZATION
@@ -0,0 +1,145 @@
+/***************************************************************************************************
+ FILE:	unicode.segmentation.hpp
+ CPP:	unicode.segmentation.cpp
+ DESCR:	Grapheme cluster boundaries (UAX #29) and line break opportunities (UAX #14)
+***************************************************************************************************/
+
+
+#pragma once
+#ifndef ROBINLE_UNICODE_SEGMENTATION
+#define ROBINLE_UNICODE_SEGMENTATION
+
+
+
+
+
+//==================================================================================================
+// INCLUDES
+
+#include "unicode.hpp" // break properties
+
+#include <cstddef>
+#include <cstdint>
+
+
+
+
+
+//==================================================================================================
+// DECLARATION
+namespace rl
+{
+	namespace Unicode
+	{
+
+		/// <summary>
+		/// Finds the boundaries of extended grapheme clusters (UAX #29)<para/>
+		/// The text is passed one code point at a time, so texts of any size can be processed
+		/// incrementally (e.g. chunk by chunk while reading a file) without allocating memory.
+		/// </summary>
+		class GraphemeBreaker final
+		{
+		public: // methods
+
+			/// <summary>
+			/// Start a new text
+			/// </summary>
+			void reset() noexcept;
+
+			/// <summary>
+			/// Pass the next code point of the text
+			/// </summary>
+			/// <returns>
+			/// Does a new grapheme cluster start with this code point?<para/>
+			/// Always <c>true</c> for the first code point of a text.
+			/// </returns>
+			bool next(char32_t ch) noexcept;
+
+			/// <summary>
+			/// Pass the next part of the text
+			/// </summary>
+			/// <param name="pDest">
+			/// = receives the return value of <c>next()</c> for every code point; must have room
+			/// for <c>iLen</c> values
+			/// </param>
+			void next(const char32_t* p, size_t iLen, bool* pDest) noexcept;
+
+
+		private: // variables
+
+			bool m_bStart = true;
+			GraphemeClusterBreak m_ePrev = GraphemeClusterBreak::Other;
+			bool m_bPictographic = false; // preceded by "Extended_Pictographic Extend*"?
+			bool m_bPictographicZWJ = false; // preceded by "Extended_Pictographic Extend* ZWJ"?
+			bool m_bOddRI = false; // preceded by an odd count of regional indicators?
+
+		};
+
+
+
+		/// <summary>
+		/// The kinds of line break opportunities before a code point
+		/// </summary>
+		enum class LineBreakOpportunity : uint8_t
+		{
+			None, // a line break isn't allowed
+			Allowed, // a line break is allowed (if the line is too long)
+			Mandatory // the line must be broken (after a line feed etc.)
+		};
+
+		/// <summary>
+		/// Finds the line break opportunities of a text (the default algorithm of UAX #14)<para/>
+		/// The text is passed one code point at a time, so texts of any size can be processed
+		/// incrementally without allocating memory.<para/>
+		/// The tailorable rule LB25 is implemented with the pairs listed in UAX #14, without
+		/// looking ahead.
+		/// </summary>
+		class LineBreaker final
+		{
+		public: // methods
+
+			/// <summary>
+			/// Start a new text
+			/// </summary>
+			void reset() noexcept;
+
+			/// <summary>
+			/// Pass the next code point of the text
+			/// </summary>
+			/// <returns>
+			/// The kind of line break opportunity before this code point<para/>
+			/// Always <c>LineBreakOpportunity::None</c> for the first code point of a text.
+			/// </returns>
+			LineBreakOpportunity next(char32_t ch) noexcept;
+
+			/// <summary>
+			/// Pass the next part of the text
+			/// </summary>
+			/// <param name="pDest">
+			/// = receives the return value of <c>next()</c> for every code point; must have room
+			/// for <c>iLen</c> values
+			/// </param>
+			void next(const char32_t* p, size_t iLen, LineBreakOpportunity* pDest) noexcept;
+
+
+		private: // variables
+
+			bool m_bStart = true;
+			LineBreakClass m_ePrev = LineBreakClass::Space; // after rules LB9 and LB10
+			LineBreakClass m_ePrevPrev = LineBreakClass::Space;
+			LineBreakClass m_eBeforeSpaces = LineBreakClass::Space; // the last class except SP
+			bool m_bPrevZWJ = false; // was the previous code point a zero width joiner?
+			bool m_bPrevWide = false; // is m_ePrev East Asian (F, W or H)?
+			bool m_bPrevUnassignedPictographic = false; // is m_ePrev Extended_Pictographic and Cn?
+			bool m_bOddRI = false; // preceded by an odd count of regional indicators?
+
+		};
+
+	}
+}
+
+
+
+
+
+#endif // ROBINLE_UNICODE_SEGMENTATION
@@ -212,7 +212,9 @@ lib::LoadResult_FNT lib::RasterFontFace::loadFromData_FNT(const void* pData, siz
 		m_oMeta.sFaceName = (const char*)reader.begin() + hdr.dfFace;
 		m_oMeta.sDeviceName = (const char*)reader.begin() + hdr.dfDevice;
 		m_oMeta.sCopyright = hdr.dfCopyright;
-		if (!CodePageToUnicode(hdr.dfDefaultChar, m_oMeta.iCodepage, m_oMeta.cFallback))
+		// dfDefaultChar is relative to dfFirstChar
+		if (!CodePageToUnicode(m_oMeta.iCodepage, uint8_t(hdr.dfFirstChar + hdr.dfDefaultChar),
+			m_oMeta.cFallback))
 			m_oMeta.cFallback = 0; // no reason to cancel loading the font; just set to "undefined".
 		switch (hdr.dfPitchAndFamily)
 		{
@@ -0,0 +1,558 @@
+#include "rl/audio.analysis.hpp"
+#include "rl/audio.engine.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric> // std::lcm
+#include <stdint.h>
+#include <string.h> // memcpy
+#include <xmmintrin.h> // SSE
+
+
+
+
+
+namespace
+{
+
+	/// <summary>
+	/// Intermediate analysis result of a single channel
+	/// </summary>
+	struct LevelAccumulator
+	{
+		float fMin = std::numeric_limits<float>::infinity();
+		float fMax = -std::numeric_limits<float>::infinity();
+		double dSumOfSquares = 0.0;
+		size_t iCount = 0;
+	};
+
+	// the SIMD path supports up to 8 channels --> up to lcm(4, 7) / 4 = 7 vectors per stripe
+	constexpr uint8_t iMaxSIMDChannels = 8;
+
+	// values analyzed before the float sums are added to the double sums
+	constexpr size_t iValuesPerPass = 4096;
+
+	constexpr char szEnvelopeMagicNumber[]       = "rlENVELOPE";
+	constexpr uint8_t iEnvelopeCurrentVersion[2] = { 1, 0 };
+
+#pragma pack(push, 1)
+
+	struct EnvelopeHeader
+	{
+		char     szMagicNo[12];
+		uint8_t  iFormatVersion[2];
+		uint8_t  iChannelCount;
+		uint8_t  iReserved;
+		uint32_t iBlockSize;
+		uint64_t iSampleCount;
+	};
+
+#pragma pack(pop)
+
+	// the header is directly followed by the buckets of level 0 (rl::AudioLevel, ordered by bucket,
+	// then channel)
+	static_assert(sizeof(rl::AudioLevel) == 3 * sizeof(float));
+
+
+	/// <summary>
+	/// Add interleaved float data to the per-channel accumulators
+	/// </summary>
+	void Accumulate(const float* pData, size_t iSampleCount, uint8_t iChannelCount,
+		LevelAccumulator* pAcc) noexcept
+	{
+		const size_t iValueCount = iSampleCount * iChannelCount;
+		size_t i = 0;
+
+		if (iChannelCount <= iMaxSIMDChannels)
+		{
+			// A stripe is the smallest count of floats that's both a multiple of the vector size
+			// and of the channel count, so every vector lane always holds the same channel.
+			const size_t iStripe = std::lcm<size_t>(4, iChannelCount);
+			const size_t iVectors = iStripe / 4;
+
+			while (iValueCount - i >= iStripe)
+			{
+				__m128 vMin[iMaxSIMDChannels];
+				__m128 vMax[iMaxSIMDChannels];
+				__m128 vSum[iMaxSIMDChannels];
+				for (size_t k = 0; k < iVectors; ++k)
+				{
+					vMin[k] = _mm_set1_ps(std::numeric_limits<float>::infinity());
+					vMax[k] = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+					vSum[k] = _mm_setzero_ps();
+				}
+
+				size_t iPassEnd = i + iValuesPerPass - iValuesPerPass % iStripe;
+				if (iPassEnd > iValueCount)
+					iPassEnd = iValueCount;
+
+				for (; iPassEnd - i >= iStripe; i += iStripe)
+				{
+					for (size_t k = 0; k < iVectors; ++k)
+					{
+						const __m128 v = _mm_loadu_ps(pData + i + k * 4);
+						vMin[k] = _mm_min_ps(vMin[k], v);
+						vMax[k] = _mm_max_ps(vMax[k], v);
+						vSum[k] = _mm_add_ps(vSum[k], _mm_mul_ps(v, v));
+					}
+				}
+
+				// reduce the vector lanes to the channels
+				for (size_t k = 0; k < iVectors; ++k)
+				{
+					float fMin[4], fMax[4], fSum[4];
+					_mm_storeu_ps(fMin, vMin[k]);
+					_mm_storeu_ps(fMax, vMax[k]);
+					_mm_storeu_ps(fSum, vSum[k]);
+
+					for (uint8_t iLane = 0; iLane < 4; ++iLane)
+					{
+						auto& oAcc = pAcc[(k * 4 + iLane) % iChannelCount];
+						oAcc.fMin = std::min(oAcc.fMin, fMin[iLane]);
+						oAcc.fMax = std::max(oAcc.fMax, fMax[iLane]);
+						oAcc.dSumOfSquares += fSum[iLane];
+					}
+				}
+			}
+		}
+
+		// remaining values (i is always a multiple of the channel count)
+		for (; i < iValueCount; ++i)
+		{
+			const float f = pData[i];
+			auto& oAcc = pAcc[i % iChannelCount];
+			oAcc.fMin = std::min(oAcc.fMin, f);
+			oAcc.fMax = std::max(oAcc.fMax, f);
+			oAcc.dSumOfSquares += (double)f * f;
+		}
+
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			pAcc[iChannel].iCount += iSampleCount;
+		}
+	}
+
+	void GetLevels(const LevelAccumulator* pAcc, uint8_t iChannelCount,
+		rl::AudioLevel* pDest) noexcept
+	{
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			const auto& oAcc = pAcc[iChannel];
+			auto& oDest = pDest[iChannel];
+
+			if (oAcc.iCount == 0)
+			{
+				oDest = {};
+				continue;
+			}
+
+			oDest.fMin = oAcc.fMin;
+			oDest.fMax = oAcc.fMax;
+			oDest.fRMS = (float)std::sqrt(oAcc.dSumOfSquares / oAcc.iCount);
+		}
+	}
+
+	/// <summary>
+	/// Analyze a range of samples of a <c>Sound</c><para/>
+	/// The range must be valid
+	/// </summary>
+	void AnalyzeRange(const rl::Sound& sound, size_t iFirstSample, size_t iSampleCount,
+		rl::AudioLevel* pDest) noexcept
+	{
+		const auto& oFormat = sound.getWaveFormat();
+		LevelAccumulator oAcc[XAUDIO2_MAX_AUDIO_CHANNELS];
+
+		if (oFormat.eBitDepth == rl::AudioBitDepth::Audio32)
+		{
+			// already float --> no conversion needed
+			Accumulate(static_cast<const float*>(sound.getDataPtr()) +
+				iFirstSample * oFormat.iChannelCount, iSampleCount, oFormat.iChannelCount, oAcc);
+		}
+		else
+		{
+			float fBuf[iValuesPerPass];
+			const size_t iSamplesPerPass = iValuesPerPass / oFormat.iChannelCount;
+
+			while (iSampleCount > 0)
+			{
+				const size_t iConverted = sound.getSamplesAsFloat(fBuf, iFirstSample,
+					std::min(iSampleCount, iSamplesPerPass));
+				if (iConverted == 0)
+					break;
+
+				Accumulate(fBuf, iConverted, oFormat.iChannelCount, oAcc);
+				iFirstSample += iConverted;
+				iSampleCount -= iConverted;
+			}
+		}
+
+		GetLevels(oAcc, oFormat.iChannelCount, pDest);
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	void AnalyzeAudio(const float* pData, size_t iSampleCount, uint8_t iChannelCount,
+		AudioLevel* pDest) noexcept
+	{
+		if (iChannelCount == 0)
+			return;
+
+		LevelAccumulator oAcc[UINT8_MAX];
+		Accumulate(pData, iSampleCount, iChannelCount, oAcc);
+		GetLevels(oAcc, iChannelCount, pDest);
+	}
+
+	bool AnalyzeSound(const Sound& sound, AudioLevel* pDest, size_t iFirstSample,
+		size_t iSampleCount) noexcept
+	{
+		if (!sound.getDataPtr() || iFirstSample >= sound.getSampleCount())
+			return false;
+
+		if (iSampleCount > sound.getSampleCount() - iFirstSample)
+			iSampleCount = sound.getSampleCount() - iFirstSample;
+
+		AnalyzeRange(sound, iFirstSample, iSampleCount, pDest);
+		return true;
+	}
+
+	bool GetWaveformSummary(const Sound& sound, AudioLevel* pDest, size_t iBucketCount,
+		size_t iFirstSample, size_t iSampleCount) noexcept
+	{
+		if (!sound.getDataPtr() || iBucketCount == 0 || iFirstSample >= sound.getSampleCount())
+			return false;
+
+		if (iSampleCount > sound.getSampleCount() - iFirstSample)
+			iSampleCount = sound.getSampleCount() - iFirstSample;
+
+		const uint8_t iChannelCount = sound.getWaveFormat().iChannelCount;
+		for (size_t iBucket = 0; iBucket < iBucketCount; ++iBucket)
+		{
+			// 64-bit intermediate values to avoid an overflow on 32-bit builds
+			const size_t iBegin = (size_t)((uint64_t)iSampleCount * iBucket / iBucketCount);
+			const size_t iEnd = (size_t)((uint64_t)iSampleCount * (iBucket + 1) / iBucketCount);
+
+			AudioLevel* pBucket = pDest + iBucket * iChannelCount;
+			if (iBegin == iEnd)
+			{
+				for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+				{
+					pBucket[iChannel] = {};
+				}
+				continue;
+			}
+
+			AnalyzeRange(sound, iFirstSample + iBegin, iEnd - iBegin, pBucket);
+		}
+
+		return true;
+	}
+
+	const AudioEnvelope* GetEnvelope(Sound& sound)
+	{
+		if (!sound.getEnvelope())
+		{
+			auto spEnvelope = AudioEnvelope::Create(sound);
+			if (!spEnvelope)
+				return nullptr;
+
+			sound.setEnvelope(std::move(spEnvelope));
+		}
+
+		return sound.getEnvelope();
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class AudioEnvelope
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// STATIC METHODS
+
+	std::shared_ptr<AudioEnvelope> AudioEnvelope::Create(const Sound& sound, uint32_t iBlockSize)
+	{
+		const auto& oFormat = sound.getWaveFormat();
+		if (!sound.getDataPtr() || sound.getSampleCount() == 0 || iBlockSize == 0 ||
+			oFormat.iChannelCount == 0 || oFormat.iChannelCount > XAUDIO2_MAX_AUDIO_CHANNELS)
+			return nullptr;
+
+		auto spResult = std::make_shared<AudioEnvelope>();
+		spResult->m_iSampleCount = sound.getSampleCount();
+		spResult->m_iChannelCount = oFormat.iChannelCount;
+		spResult->m_iBlockSize = iBlockSize;
+
+		const uint8_t iChannelCount = oFormat.iChannelCount;
+		const size_t iBlockCount = (sound.getSampleCount() + iBlockSize - 1) / iBlockSize;
+		std::vector<AudioLevel> oLevel0(iBlockCount * iChannelCount);
+
+		// float data is analyzed in place, everything else is converted in chunks of whole blocks
+		const bool bFloat = oFormat.eBitDepth == AudioBitDepth::Audio32 && !sound.isCompressed();
+		const size_t iBlocksPerChunk = std::max<size_t>(1,
+			iValuesPerPass / ((size_t)iBlockSize * iChannelCount));
+		std::vector<float> oBuffer;
+		if (!bFloat)
+			oBuffer.resize(iBlocksPerChunk * iBlockSize * iChannelCount);
+
+		for (size_t iBlock = 0; iBlock < iBlockCount; iBlock += iBlocksPerChunk)
+		{
+			const size_t iFirstSample = iBlock * iBlockSize;
+			const size_t iChunkSamples = std::min(iBlocksPerChunk * iBlockSize,
+				sound.getSampleCount() - iFirstSample);
+
+			const float* pChunk;
+			if (bFloat)
+				pChunk = static_cast<const float*>(sound.getDataPtr()) +
+					iFirstSample * iChannelCount;
+			else
+			{
+				const size_t iConverted =
+					sound.getSamplesAsFloat(oBuffer.data(), iFirstSample, iChunkSamples);
+				if (iConverted < iChunkSamples) // invalid data --> silence
+					std::fill(oBuffer.begin() + iConverted * iChannelCount, oBuffer.end(), 0.0f);
+				pChunk = oBuffer.data();
+			}
+
+			for (size_t iOffset = 0; iOffset < iChunkSamples; iOffset += iBlockSize)
+			{
+				LevelAccumulator oAcc[XAUDIO2_MAX_AUDIO_CHANNELS];
+				Accumulate(pChunk + iOffset * iChannelCount,
+					std::min<size_t>(iBlockSize, iChunkSamples - iOffset), iChannelCount, oAcc);
+				GetLevels(oAcc, iChannelCount,
+					oLevel0.data() + (iBlock + iOffset / iBlockSize) * iChannelCount);
+			}
+		}
+
+		spResult->m_oLevels.push_back(std::move(oLevel0));
+		spResult->createPyramid();
+		return spResult;
+	}
+
+	std::shared_ptr<AudioEnvelope> AudioEnvelope::FromMemory(const void* data, size_t size)
+	{
+		EnvelopeHeader oHeader;
+		if (!data || size < sizeof(oHeader))
+			return nullptr; // too small for header
+		memcpy(&oHeader, data, sizeof(oHeader));
+
+		if (memcmp(oHeader.szMagicNo, szEnvelopeMagicNumber, sizeof(oHeader.szMagicNo)) != 0 ||
+			oHeader.iFormatVersion[0] != iEnvelopeCurrentVersion[0])
+			return nullptr; // not an envelope or incompatible version
+
+		if (oHeader.iChannelCount == 0 || oHeader.iChannelCount > XAUDIO2_MAX_AUDIO_CHANNELS ||
+			oHeader.iBlockSize == 0 || oHeader.iSampleCount == 0 ||
+			oHeader.iSampleCount > SIZE_MAX)
+			return nullptr; // invalid header
+
+		const uint64_t iBlockCount = oHeader.iSampleCount / oHeader.iBlockSize +
+			(oHeader.iSampleCount % oHeader.iBlockSize != 0 ? 1 : 0);
+		const size_t iBucketSize = oHeader.iChannelCount * sizeof(AudioLevel);
+		if (iBlockCount != (size - sizeof(oHeader)) / iBucketSize ||
+			(size - sizeof(oHeader)) % iBucketSize != 0)
+			return nullptr; // wrong data size
+
+		auto spResult = std::make_shared<AudioEnvelope>();
+		spResult->m_iSampleCount = (size_t)oHeader.iSampleCount;
+		spResult->m_iChannelCount = oHeader.iChannelCount;
+		spResult->m_iBlockSize = oHeader.iBlockSize;
+
+		std::vector<AudioLevel> oLevel0((size_t)iBlockCount * oHeader.iChannelCount);
+		memcpy(oLevel0.data(), static_cast<const uint8_t*>(data) + sizeof(oHeader),
+			oLevel0.size() * sizeof(AudioLevel));
+
+		spResult->m_oLevels.push_back(std::move(oLevel0));
+		spResult->createPyramid();
+		return spResult;
+	}
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void AudioEnvelope::save(std::vector<uint8_t>& oDest) const
+	{
+		oDest.clear();
+		if (m_oLevels.empty())
+			return;
+
+		EnvelopeHeader oHeader{};
+		memcpy(oHeader.szMagicNo, szEnvelopeMagicNumber, sizeof(oHeader.szMagicNo));
+		memcpy(oHeader.iFormatVersion, iEnvelopeCurrentVersion, sizeof(iEnvelopeCurrentVersion));
+		oHeader.iChannelCount = m_iChannelCount;
+		oHeader.iBlockSize    = m_iBlockSize;
+		oHeader.iSampleCount  = m_iSampleCount;
+
+		const auto& oLevel0 = m_oLevels[0];
+		oDest.resize(sizeof(oHeader) + oLevel0.size() * sizeof(AudioLevel));
+		memcpy(oDest.data(), &oHeader, sizeof(oHeader));
+		memcpy(oDest.data() + sizeof(oHeader), oLevel0.data(),
+			oLevel0.size() * sizeof(AudioLevel));
+	}
+
+	size_t AudioEnvelope::getBucketCount(size_t iLevel) const noexcept
+	{
+		if (iLevel >= m_oLevels.size())
+			return 0;
+
+		return m_oLevels[iLevel].size() / m_iChannelCount;
+	}
+
+	const AudioLevel* AudioEnvelope::getLevelData(size_t iLevel) const noexcept
+	{
+		if (iLevel >= m_oLevels.size())
+			return nullptr;
+
+		return m_oLevels[iLevel].data();
+	}
+
+	bool AudioEnvelope::analyze(AudioLevel* pDest, size_t iFirstSample,
+		size_t iSampleCount) const noexcept
+	{
+		if (m_oLevels.empty() || iFirstSample >= m_iSampleCount)
+			return false;
+
+		if (iSampleCount > m_iSampleCount - iFirstSample)
+			iSampleCount = m_iSampleCount - iFirstSample;
+
+		LevelAccumulator oAcc[XAUDIO2_MAX_AUDIO_CHANNELS];
+		auto fnAdd = [&](size_t iLevel, size_t iBucket)
+		{
+			const AudioLevel* pBucket = m_oLevels[iLevel].data() + iBucket * m_iChannelCount;
+			const size_t iCount = getBucketSampleCount(iLevel, iBucket);
+			for (uint8_t iChannel = 0; iChannel < m_iChannelCount; ++iChannel)
+			{
+				const auto& oLevel = pBucket[iChannel];
+				auto& o = oAcc[iChannel];
+				o.fMin = std::min(o.fMin, oLevel.fMin);
+				o.fMax = std::max(o.fMax, oLevel.fMax);
+				o.dSumOfSquares += (double)oLevel.fRMS * oLevel.fRMS * iCount;
+				o.iCount += iCount;
+			}
+		};
+
+		// bottom-up over the pyramid: the odd buckets at the borders of the range aren't covered
+		// by the bucket one level higher
+		size_t iBegin = iFirstSample / m_iBlockSize;
+		size_t iEnd = (iFirstSample + iSampleCount + m_iBlockSize - 1) / m_iBlockSize;
+		for (size_t iLevel = 0; iBegin < iEnd; ++iLevel, iBegin /= 2, iEnd /= 2)
+		{
+			if (iBegin % 2)
+				fnAdd(iLevel, iBegin++);
+			if (iEnd % 2)
+				fnAdd(iLevel, --iEnd);
+		}
+
+		GetLevels(oAcc, m_iChannelCount, pDest);
+		return true;
+	}
+
+	bool AudioEnvelope::getWaveformSummary(AudioLevel* pDest, size_t iBucketCount,
+		size_t iFirstSample, size_t iSampleCount) const noexcept
+	{
+		if (m_oLevels.empty() || iBucketCount == 0 || iFirstSample >= m_iSampleCount)
+			return false;
+
+		if (iSampleCount > m_iSampleCount - iFirstSample)
+			iSampleCount = m_iSampleCount - iFirstSample;
+
+		for (size_t iBucket = 0; iBucket < iBucketCount; ++iBucket)
+		{
+			// 64-bit intermediate values to avoid an overflow on 32-bit builds
+			const size_t iBegin = (size_t)((uint64_t)iSampleCount * iBucket / iBucketCount);
+			const size_t iEnd = (size_t)((uint64_t)iSampleCount * (iBucket + 1) / iBucketCount);
+
+			AudioLevel* pBucket = pDest + iBucket * m_iChannelCount;
+			if (iBegin == iEnd)
+			{
+				for (uint8_t iChannel = 0; iChannel < m_iChannelCount; ++iChannel)
+				{
+					pBucket[iChannel] = {};
+				}
+				continue;
+			}
+
+			analyze(pBucket, iFirstSample + iBegin, iEnd - iBegin);
+		}
+
+		return true;
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void AudioEnvelope::createPyramid()
+	{
+		m_oLevels.resize(1);
+
+		while (getBucketCount(m_oLevels.size() - 1) > 1)
+		{
+			const size_t iLevelBelow = m_oLevels.size() - 1;
+			const size_t iCountBelow = getBucketCount(iLevelBelow);
+
+			std::vector<AudioLevel> oLevel((iCountBelow + 1) / 2 * m_iChannelCount);
+			const AudioLevel* pBelow = m_oLevels[iLevelBelow].data();
+			for (size_t iBucket = 0; iBucket < oLevel.size() / m_iChannelCount; ++iBucket)
+			{
+				const size_t iLeft = iBucket * 2;
+				const size_t iRight = iLeft + 1;
+				AudioLevel* pDest = oLevel.data() + iBucket * m_iChannelCount;
+
+				if (iRight >= iCountBelow) // odd count --> last bucket is taken as is
+				{
+					std::copy_n(pBelow + iLeft * m_iChannelCount, m_iChannelCount, pDest);
+					continue;
+				}
+
+				const double dLeftCount = (double)getBucketSampleCount(iLevelBelow, iLeft);
+				const double dRightCount = (double)getBucketSampleCount(iLevelBelow, iRight);
+				for (uint8_t iChannel = 0; iChannel < m_iChannelCount; ++iChannel)
+				{
+					const auto& oLeft = pBelow[iLeft * m_iChannelCount + iChannel];
+					const auto& oRight = pBelow[iRight * m_iChannelCount + iChannel];
+
+					pDest[iChannel].fMin = std::min(oLeft.fMin, oRight.fMin);
+					pDest[iChannel].fMax = std::max(oLeft.fMax, oRight.fMax);
+					pDest[iChannel].fRMS = (float)std::sqrt(
+						((double)oLeft.fRMS * oLeft.fRMS * dLeftCount +
+						(double)oRight.fRMS * oRight.fRMS * dRightCount) /
+						(dLeftCount + dRightCount));
+				}
+			}
+
+			m_oLevels.push_back(std::move(oLevel));
+		}
+	}
+
+	size_t AudioEnvelope::getBucketSampleCount(size_t iLevel, size_t iBucket) const noexcept
+	{
+		const size_t iBucketSize = (size_t)m_iBlockSize << iLevel;
+		return std::min(iBucketSize, m_iSampleCount - iBucket * iBucketSize);
+	}
+
+}
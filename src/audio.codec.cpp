@@ -0,0 +1,838 @@
+#include "rl/audio.codec.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+
+
+
+
+namespace
+{
+
+	constexpr uint8_t iMaxChannelCount = 64; // XAUDIO2_MAX_AUDIO_CHANNELS
+
+	// block size of the ADPCM encoders, per channel
+	constexpr uint32_t iADPCMBlockAlignPerChannel = 512;
+
+	constexpr uint32_t iLosslessSamplesPerBlock = 4096;
+
+	inline int16_t ReadInt16(const uint8_t* p) noexcept
+	{
+		return int16_t(uint16_t(p[0] | (p[1] << 8)));
+	}
+
+	inline void WriteInt16(uint8_t* p, int32_t i) noexcept
+	{
+		p[0] = uint8_t(i);
+		p[1] = uint8_t(uint16_t(i) >> 8);
+	}
+
+	inline uint32_t ReadUInt32(const uint8_t* p) noexcept
+	{
+		return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+			(uint32_t(p[3]) << 24);
+	}
+
+	inline void WriteUInt32(uint8_t* p, uint32_t i) noexcept
+	{
+		for (uint8_t iByte = 0; iByte < 4; ++iByte)
+		{
+			p[iByte] = uint8_t(i >> (iByte * 8));
+		}
+	}
+
+	inline int32_t Clamp16(int32_t i) noexcept { return std::clamp(i, -32768, 32767); }
+
+
+
+
+
+	//==============================================================================================
+	// IMA ADPCM
+
+	constexpr int8_t IMAIndexTable[16] =
+	{
+		-1, -1, -1, -1, 2, 4, 6, 8,
+		-1, -1, -1, -1, 2, 4, 6, 8
+	};
+
+	constexpr int16_t IMAStepTable[89] =
+	{
+		7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60,
+		66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371,
+		408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707,
+		1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132,
+		7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+		27086, 29794, 32767
+	};
+
+	struct IMAState
+	{
+		int32_t iPredictor;
+		int32_t iIndex;
+	};
+
+	inline int16_t IMADecodeNibble(IMAState& oState, uint8_t iNibble) noexcept
+	{
+		const int32_t iStep = IMAStepTable[oState.iIndex];
+
+		int32_t iDiff = iStep >> 3;
+		if (iNibble & 1)
+			iDiff += iStep >> 2;
+		if (iNibble & 2)
+			iDiff += iStep >> 1;
+		if (iNibble & 4)
+			iDiff += iStep;
+		if (iNibble & 8)
+			iDiff = -iDiff;
+
+		oState.iPredictor = Clamp16(oState.iPredictor + iDiff);
+		oState.iIndex = std::clamp(oState.iIndex + IMAIndexTable[iNibble], 0, 88);
+		return (int16_t)oState.iPredictor;
+	}
+
+	inline uint8_t IMAEncodeSample(IMAState& oState, int16_t iSample) noexcept
+	{
+		int32_t iDiff = iSample - oState.iPredictor;
+		uint8_t iNibble = 0;
+		if (iDiff < 0)
+		{
+			iNibble = 8;
+			iDiff = -iDiff;
+		}
+
+		int32_t iStep = IMAStepTable[oState.iIndex];
+		for (uint8_t iBit = 4; iBit; iBit >>= 1, iStep >>= 1)
+		{
+			if (iDiff >= iStep)
+			{
+				iNibble |= iBit;
+				iDiff -= iStep;
+			}
+		}
+
+		IMADecodeNibble(oState, iNibble); // keep the predictor in sync with the decoder
+		return iNibble;
+	}
+
+	/// <summary>
+	/// Header: per channel the first sample (16 bit), the step index (8 bit) and a reserved byte.
+	/// <para/>
+	/// Data: groups of 8 samples per channel (4 bytes, low nibble first), channels interleaved.
+	/// </summary>
+	size_t IMASamplesInBlock(uint8_t iChannelCount, size_t iBlockSize) noexcept
+	{
+		const size_t iHeaderSize = 4 * size_t(iChannelCount);
+		if (iBlockSize < iHeaderSize)
+			return 0;
+
+		return (iBlockSize - iHeaderSize) / iHeaderSize * 8 + 1;
+	}
+
+	size_t IMADecodeBlock(const uint8_t* pBlock, size_t iBlockSize, uint8_t iChannelCount,
+		size_t iMaxSampleCount, int16_t* pDest) noexcept
+	{
+		const size_t iSampleCount =
+			std::min(IMASamplesInBlock(iChannelCount, iBlockSize), iMaxSampleCount);
+		if (iSampleCount == 0)
+			return 0;
+
+		const uint8_t* pData = pBlock + 4 * size_t(iChannelCount);
+		const size_t iGroupCount = (iSampleCount - 1 + 7) / 8;
+
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			IMAState oState;
+			oState.iPredictor = ReadInt16(pBlock + 4 * iChannel);
+			oState.iIndex = std::min<int32_t>(pBlock[4 * iChannel + 2], 88);
+
+			int16_t* p = pDest + iChannel;
+			*p = (int16_t)oState.iPredictor;
+			p += iChannelCount;
+
+			size_t iSample = 1;
+			for (size_t iGroup = 0; iGroup < iGroupCount; ++iGroup)
+			{
+				const uint8_t* pGroup = pData + (iGroup * iChannelCount + iChannel) * 4;
+				for (uint8_t i = 0; i < 8 && iSample < iSampleCount; ++i, ++iSample)
+				{
+					const uint8_t iNibble = (pGroup[i / 2] >> ((i & 1) * 4)) & 0x0F;
+					*p = IMADecodeNibble(oState, iNibble);
+					p += iChannelCount;
+				}
+			}
+		}
+
+		return iSampleCount;
+	}
+
+	void IMAEncode(const int16_t* pSamples, size_t iSampleCount, uint8_t iChannelCount,
+		uint32_t iSamplesPerBlock, std::vector<uint8_t>& oDest)
+	{
+		IMAState oStates[iMaxChannelCount] = {};
+
+		for (size_t iFirst = 0; iFirst < iSampleCount; iFirst += iSamplesPerBlock)
+		{
+			const size_t iCount = std::min<size_t>(iSamplesPerBlock, iSampleCount - iFirst);
+			const size_t iGroupCount = (iCount - 1 + 7) / 8;
+
+			const size_t iOffset = oDest.size();
+			oDest.resize(iOffset + 4 * size_t(iChannelCount) * (1 + iGroupCount));
+			uint8_t* pBlock = oDest.data() + iOffset;
+			uint8_t* pData = pBlock + 4 * size_t(iChannelCount);
+
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				const int16_t* p = pSamples + iFirst * iChannelCount + iChannel;
+
+				auto& oState = oStates[iChannel];
+				oState.iPredictor = p[0];
+				WriteInt16(pBlock + 4 * iChannel, oState.iPredictor);
+				pBlock[4 * iChannel + 2] = (uint8_t)oState.iIndex;
+
+				for (size_t iGroup = 0; iGroup < iGroupCount; ++iGroup)
+				{
+					uint8_t* pGroup = pData + (iGroup * iChannelCount + iChannel) * 4;
+					for (uint8_t i = 0; i < 8; ++i)
+					{
+						// the last group is padded with the last sample
+						const size_t iSample = std::min(1 + iGroup * 8 + i, iCount - 1);
+						const uint8_t iNibble =
+							IMAEncodeSample(oState, p[iSample * iChannelCount]);
+						pGroup[i / 2] |= iNibble << ((i & 1) * 4);
+					}
+				}
+			}
+		}
+	}
+
+
+
+
+
+	//==============================================================================================
+	// MS ADPCM
+
+	constexpr int32_t MSCoefficients[7][2] =
+	{
+		{ 256,    0 },
+		{ 512, -256 },
+		{   0,    0 },
+		{ 192,   64 },
+		{ 240,    0 },
+		{ 460, -208 },
+		{ 392, -232 }
+	};
+
+	constexpr int32_t MSAdaptationTable[16] =
+	{
+		230, 230, 230, 230, 307, 409, 512, 614,
+		768, 614, 512, 409, 307, 230, 230, 230
+	};
+
+	struct MSState
+	{
+		int32_t iCoef1;
+		int32_t iCoef2;
+		int32_t iDelta;
+		int32_t iSample1; // previous sample
+		int32_t iSample2; // sample before the previous sample
+	};
+
+	inline int16_t MSDecodeNibble(MSState& oState, uint8_t iNibble) noexcept
+	{
+		const int32_t iSigned = (iNibble & 8) ? int32_t(iNibble) - 16 : int32_t(iNibble);
+		const int32_t iPredicted =
+			(oState.iSample1 * oState.iCoef1 + oState.iSample2 * oState.iCoef2) / 256;
+
+		oState.iSample2 = oState.iSample1;
+		oState.iSample1 = Clamp16(iPredicted + iSigned * oState.iDelta);
+		oState.iDelta = std::max(16, (MSAdaptationTable[iNibble] * oState.iDelta) / 256);
+		return (int16_t)oState.iSample1;
+	}
+
+	inline uint8_t MSEncodeSample(MSState& oState, int16_t iSample) noexcept
+	{
+		const int32_t iPredicted =
+			(oState.iSample1 * oState.iCoef1 + oState.iSample2 * oState.iCoef2) / 256;
+		const int32_t iError = iSample - iPredicted;
+		const int32_t iBias = (iError < 0) ? -oState.iDelta / 2 : oState.iDelta / 2;
+
+		const int32_t iSigned = std::clamp((iError + iBias) / oState.iDelta, -8, 7);
+		const uint8_t iNibble = uint8_t(iSigned & 0x0F);
+
+		MSDecodeNibble(oState, iNibble); // keep the state in sync with the decoder
+		return iNibble;
+	}
+
+	/// <summary>
+	/// Header: per channel the predictor index (8 bit), then per channel the delta, then per
+	/// channel the second sample, then per channel the first sample (16 bit each).<para/>
+	/// Data: nibbles (high nibble first), channels interleaved.
+	/// </summary>
+	size_t MSSamplesInBlock(uint8_t iChannelCount, size_t iBlockSize) noexcept
+	{
+		const size_t iHeaderSize = 7 * size_t(iChannelCount);
+		if (iBlockSize < iHeaderSize)
+			return 0;
+
+		return (iBlockSize - iHeaderSize) * 2 / iChannelCount + 2;
+	}
+
+	size_t MSDecodeBlock(const uint8_t* pBlock, size_t iBlockSize, uint8_t iChannelCount,
+		size_t iMaxSampleCount, int16_t* pDest) noexcept
+	{
+		const size_t iSampleCount =
+			std::min(MSSamplesInBlock(iChannelCount, iBlockSize), iMaxSampleCount);
+		if (iSampleCount == 0)
+			return 0;
+
+		MSState oStates[iMaxChannelCount];
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			const uint8_t iPredictor = pBlock[iChannel];
+			if (iPredictor >= 7)
+				return 0; // custom coefficients are not supported
+
+			auto& oState = oStates[iChannel];
+			oState.iCoef1 = MSCoefficients[iPredictor][0];
+			oState.iCoef2 = MSCoefficients[iPredictor][1];
+			oState.iDelta = ReadInt16(pBlock + iChannelCount + 2 * iChannel);
+			oState.iSample1 = ReadInt16(pBlock + 3 * iChannelCount + 2 * iChannel);
+			oState.iSample2 = ReadInt16(pBlock + 5 * iChannelCount + 2 * iChannel);
+
+			pDest[iChannel] = (int16_t)oState.iSample2;
+			if (iSampleCount > 1)
+				pDest[iChannelCount + iChannel] = (int16_t)oState.iSample1;
+		}
+
+		const uint8_t* pData = pBlock + 7 * size_t(iChannelCount);
+		size_t iNibble = 0;
+		for (size_t iSample = 2; iSample < iSampleCount; ++iSample)
+		{
+			int16_t* p = pDest + iSample * iChannelCount;
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel, ++iNibble)
+			{
+				const uint8_t iByte = pData[iNibble / 2];
+				p[iChannel] = MSDecodeNibble(oStates[iChannel],
+					(iNibble & 1) ? (iByte & 0x0F) : (iByte >> 4));
+			}
+		}
+
+		return iSampleCount;
+	}
+
+	void MSEncode(const int16_t* pSamples, size_t iSampleCount, uint8_t iChannelCount,
+		uint32_t iSamplesPerBlock, std::vector<uint8_t>& oDest)
+	{
+		int32_t iDeltas[iMaxChannelCount];
+		std::fill(iDeltas, iDeltas + iChannelCount, 16);
+
+		for (size_t iFirst = 0; iFirst < iSampleCount; iFirst += iSamplesPerBlock)
+		{
+			const size_t iCount = std::min<size_t>(iSamplesPerBlock, iSampleCount - iFirst);
+			const int16_t* pFirst = pSamples + iFirst * iChannelCount;
+			const size_t iNibbleCount = (iCount > 2) ? (iCount - 2) * iChannelCount : 0;
+
+			const size_t iOffset = oDest.size();
+			oDest.resize(iOffset + 7 * size_t(iChannelCount) + (iNibbleCount + 1) / 2);
+			uint8_t* pBlock = oDest.data() + iOffset;
+			uint8_t* pData = pBlock + 7 * size_t(iChannelCount);
+
+			MSState oStates[iMaxChannelCount];
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				const int16_t* p = pFirst + iChannel;
+				const int32_t iFirstSample = p[0];
+				const int32_t iSecondSample = (iCount > 1) ? p[iChannelCount] : iFirstSample;
+
+				// choose the predictor with the smallest error
+				uint8_t iBestPredictor = 0;
+				int64_t iBestError = INT64_MAX;
+				for (uint8_t iPredictor = 0; iPredictor < 7; ++iPredictor)
+				{
+					MSState oState{ MSCoefficients[iPredictor][0], MSCoefficients[iPredictor][1],
+						iDeltas[iChannel], iSecondSample, iFirstSample };
+
+					int64_t iError = 0;
+					for (size_t i = 2; i < iCount && iError < iBestError; ++i)
+					{
+						const int16_t iSample = p[i * iChannelCount];
+						MSEncodeSample(oState, iSample);
+						const int64_t iDiff = int64_t(iSample) - oState.iSample1;
+						iError += iDiff * iDiff;
+					}
+
+					if (iError < iBestError)
+					{
+						iBestError = iError;
+						iBestPredictor = iPredictor;
+					}
+				}
+
+				auto& oState = oStates[iChannel];
+				oState = { MSCoefficients[iBestPredictor][0], MSCoefficients[iBestPredictor][1],
+					iDeltas[iChannel], iSecondSample, iFirstSample };
+
+				pBlock[iChannel] = iBestPredictor;
+				WriteInt16(pBlock + iChannelCount + 2 * iChannel, oState.iDelta);
+				WriteInt16(pBlock + 3 * iChannelCount + 2 * iChannel, iSecondSample);
+				WriteInt16(pBlock + 5 * iChannelCount + 2 * iChannel, iFirstSample);
+			}
+
+			size_t iNibble = 0;
+			for (size_t iSample = 2; iSample < iCount; ++iSample)
+			{
+				const int16_t* p = pFirst + iSample * iChannelCount;
+				for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel, ++iNibble)
+				{
+					const uint8_t iValue = MSEncodeSample(oStates[iChannel], p[iChannel]);
+					pData[iNibble / 2] |= (iNibble & 1) ? iValue : uint8_t(iValue << 4);
+				}
+			}
+
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				iDeltas[iChannel] = oStates[iChannel].iDelta;
+			}
+		}
+	}
+
+
+
+
+
+	//==============================================================================================
+	// LOSSLESS
+	// Data:  sample count (uint32_t), block offsets (uint32_t, block count + 1), blocks
+	// Block: per channel (byte-aligned): predictor order (2 bits), Rice parameter (5 bits),
+	//        <order> warm-up samples (16 bits each), Rice coded residuals
+
+	constexpr uint32_t iRiceEscape = 31; // quotients >= this are followed by the raw value
+	constexpr uint32_t iRiceEscapeBits = 20; // enough for the zigzag coded residual of order 3
+
+	class BitWriter final
+	{
+	public: // methods
+
+		BitWriter(std::vector<uint8_t>& oDest) : m_oDest(oDest) {}
+
+		// iBitCount <= 32
+		void write(uint32_t iValue, uint32_t iBitCount)
+		{
+			if (iBitCount == 0)
+				return;
+
+			m_iBuffer = (m_iBuffer << iBitCount) | (iValue & (uint64_t(-1) >> (64 - iBitCount)));
+			m_iBitCount += iBitCount;
+			while (m_iBitCount >= 8)
+			{
+				m_iBitCount -= 8;
+				m_oDest.push_back(uint8_t(m_iBuffer >> m_iBitCount));
+			}
+		}
+
+		void flush()
+		{
+			if (m_iBitCount)
+				m_oDest.push_back(uint8_t(m_iBuffer << (8 - m_iBitCount)));
+			m_iBitCount = 0;
+		}
+
+
+	private: // variables
+
+		std::vector<uint8_t>& m_oDest;
+		uint64_t m_iBuffer = 0;
+		uint32_t m_iBitCount = 0;
+
+	};
+
+	class BitReader final
+	{
+	public: // methods
+
+		BitReader(const uint8_t* pBegin, const uint8_t* pEnd) noexcept :
+			m_pNext(pBegin), m_pEnd(pEnd) {}
+
+		// iBitCount <= 32
+		inline uint32_t read(uint32_t iBitCount) noexcept
+		{
+			if (iBitCount == 0)
+				return 0;
+
+			refill();
+			const uint32_t iResult = uint32_t(m_iBuffer >> (64 - iBitCount));
+			skip(iBitCount);
+			return iResult;
+		}
+
+		/// <summary>
+		/// Read a Rice coded value
+		/// </summary>
+		inline uint32_t readRice(uint32_t iParameter) noexcept
+		{
+			refill();
+			const uint32_t iQuotient =
+				std::min<uint32_t>(std::countl_one(m_iBuffer), iRiceEscape);
+			if (iQuotient == iRiceEscape)
+			{
+				skip(iRiceEscape);
+				return read(iRiceEscapeBits);
+			}
+
+			skip(iQuotient + 1);
+			return (iQuotient << iParameter) | read(iParameter);
+		}
+
+		inline void alignToByte() noexcept { skip((8 - m_iConsumed % 8) % 8); }
+
+
+	private: // methods
+
+		inline void refill() noexcept
+		{
+			while (m_iBitCount <= 56)
+			{
+				const uint8_t iByte = (m_pNext < m_pEnd) ? *m_pNext++ : 0;
+				m_iBuffer |= uint64_t(iByte) << (56 - m_iBitCount);
+				m_iBitCount += 8;
+			}
+		}
+
+		inline void skip(uint32_t iBitCount) noexcept
+		{
+			m_iBuffer <<= iBitCount;
+			m_iBitCount -= iBitCount;
+			m_iConsumed += iBitCount;
+		}
+
+
+	private: // variables
+
+		const uint8_t* m_pNext;
+		const uint8_t* const m_pEnd;
+		uint64_t m_iBuffer = 0; // left-aligned
+		uint32_t m_iBitCount = 0;
+		size_t m_iConsumed = 0;
+
+	};
+
+	inline int32_t Predict(uint8_t iOrder, const int32_t* p) noexcept
+	{
+		switch (iOrder)
+		{
+		case 1:  return p[-1];
+		case 2:  return 2 * p[-1] - p[-2];
+		case 3:  return 3 * p[-1] - 3 * p[-2] + p[-3];
+		default: return 0;
+		}
+	}
+
+	inline uint32_t ZigZag(int32_t i) noexcept { return (uint32_t(i) << 1) ^ uint32_t(i >> 31); }
+	inline int32_t UnZigZag(uint32_t i) noexcept { return int32_t(i >> 1) ^ -int32_t(i & 1); }
+
+	uint32_t LosslessSampleCount(const uint8_t* pData, size_t iDataSize) noexcept
+	{
+		return (iDataSize < 4) ? 0 : ReadUInt32(pData);
+	}
+
+	size_t LosslessDecodeBlock(const uint8_t* pData, size_t iDataSize, uint8_t iChannelCount,
+		size_t iBlock, int16_t* pDest) noexcept
+	{
+		const size_t iSampleCount = LosslessSampleCount(pData, iDataSize);
+		const size_t iFirst = iBlock * iLosslessSamplesPerBlock;
+		const size_t iBlockCount =
+			(iSampleCount + iLosslessSamplesPerBlock - 1) / iLosslessSamplesPerBlock;
+		if (iFirst >= iSampleCount || 4 + (iBlockCount + 1) * 4 > iDataSize)
+			return 0;
+
+		const size_t iCount = std::min<size_t>(iLosslessSamplesPerBlock, iSampleCount - iFirst);
+		const size_t iBegin = ReadUInt32(pData + 4 + iBlock * 4);
+		const size_t iEnd = ReadUInt32(pData + 4 + (iBlock + 1) * 4);
+		if (iBegin > iEnd || iEnd > iDataSize)
+			return 0;
+
+		BitReader oReader(pData + iBegin, pData + iEnd);
+		int32_t iHistory[iLosslessSamplesPerBlock];
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			const uint8_t iOrder = (uint8_t)oReader.read(2);
+			const uint32_t iParameter = oReader.read(5);
+
+			const size_t iWarmup = std::min<size_t>(iOrder, iCount);
+			for (size_t i = 0; i < iWarmup; ++i)
+			{
+				iHistory[i] = int16_t(oReader.read(16));
+			}
+			for (size_t i = iWarmup; i < iCount; ++i)
+			{
+				iHistory[i] = Clamp16(Predict(iOrder, iHistory + i) +
+					UnZigZag(oReader.readRice(iParameter)));
+			}
+			oReader.alignToByte();
+
+			int16_t* p = pDest + iChannel;
+			for (size_t i = 0; i < iCount; ++i, p += iChannelCount)
+			{
+				*p = (int16_t)iHistory[i];
+			}
+		}
+
+		return iCount;
+	}
+
+	void LosslessEncode(const int16_t* pSamples, size_t iSampleCount, uint8_t iChannelCount,
+		std::vector<uint8_t>& oDest)
+	{
+		const size_t iBlockCount =
+			(iSampleCount + iLosslessSamplesPerBlock - 1) / iLosslessSamplesPerBlock;
+
+		oDest.resize(4 + (iBlockCount + 1) * 4);
+		WriteUInt32(oDest.data(), (uint32_t)iSampleCount);
+
+		std::vector<int32_t> oSamples(iLosslessSamplesPerBlock);
+		std::vector<uint32_t> oResiduals(iLosslessSamplesPerBlock);
+		BitWriter oWriter(oDest);
+
+		for (size_t iBlock = 0; iBlock < iBlockCount; ++iBlock)
+		{
+			WriteUInt32(oDest.data() + 4 + iBlock * 4, (uint32_t)oDest.size());
+
+			const size_t iFirst = iBlock * iLosslessSamplesPerBlock;
+			const size_t iCount = std::min<size_t>(iLosslessSamplesPerBlock, iSampleCount - iFirst);
+
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				for (size_t i = 0; i < iCount; ++i)
+				{
+					oSamples[i] = pSamples[(iFirst + i) * iChannelCount + iChannel];
+				}
+
+				// choose the predictor order with the smallest residuals
+				uint8_t iOrder = 0;
+				uint64_t iBestSum = UINT64_MAX;
+				for (uint8_t iTry = 0; iTry <= 3 && iTry < iCount; ++iTry)
+				{
+					uint64_t iSum = 0;
+					for (size_t i = iTry; i < iCount; ++i)
+					{
+						iSum += ZigZag(oSamples[i] - Predict(iTry, oSamples.data() + i));
+					}
+					if (iSum < iBestSum)
+					{
+						iBestSum = iSum;
+						iOrder = iTry;
+					}
+				}
+
+				for (size_t i = iOrder; i < iCount; ++i)
+				{
+					oResiduals[i] = ZigZag(oSamples[i] - Predict(iOrder, oSamples.data() + i));
+				}
+
+				// choose the Rice parameter with the smallest total size
+				uint32_t iParameter = 0;
+				uint64_t iBestBits = UINT64_MAX;
+				for (uint32_t iTry = 0; iTry <= 16; ++iTry)
+				{
+					uint64_t iBits = 0;
+					for (size_t i = iOrder; i < iCount; ++i)
+					{
+						const uint32_t iQuotient = oResiduals[i] >> iTry;
+						iBits += (iQuotient < iRiceEscape) ?
+							iQuotient + 1 + iTry : iRiceEscape + iRiceEscapeBits;
+					}
+					if (iBits < iBestBits)
+					{
+						iBestBits = iBits;
+						iParameter = iTry;
+					}
+				}
+
+				oWriter.write(iOrder, 2);
+				oWriter.write(iParameter, 5);
+				for (size_t i = 0; i < iOrder; ++i)
+				{
+					oWriter.write(uint16_t(oSamples[i]), 16);
+				}
+				for (size_t i = iOrder; i < iCount; ++i)
+				{
+					const uint32_t iQuotient = oResiduals[i] >> iParameter;
+					if (iQuotient < iRiceEscape)
+					{
+						oWriter.write(((1u << iQuotient) - 1) << 1, iQuotient + 1);
+						oWriter.write(oResiduals[i], iParameter);
+					}
+					else
+					{
+						oWriter.write((1u << iRiceEscape) - 1, iRiceEscape);
+						oWriter.write(oResiduals[i], iRiceEscapeBits);
+					}
+				}
+				oWriter.flush();
+			}
+		}
+
+		WriteUInt32(oDest.data() + 4 + iBlockCount * 4, (uint32_t)oDest.size());
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	bool ValidCompressionFormat(const AudioCompressionFormat& oFormat,
+		uint8_t iChannelCount) noexcept
+	{
+		if (iChannelCount == 0 || iChannelCount > iMaxChannelCount)
+			return false;
+
+		switch (oFormat.eCompression)
+		{
+		case AudioCompression::IMA_ADPCM:
+			return oFormat.iSamplesPerBlock > 0 && oFormat.iSamplesPerBlock <=
+				IMASamplesInBlock(iChannelCount, oFormat.iBlockAlign);
+
+		case AudioCompression::MS_ADPCM:
+			return oFormat.iSamplesPerBlock > 0 && oFormat.iSamplesPerBlock <=
+				MSSamplesInBlock(iChannelCount, oFormat.iBlockAlign);
+
+		case AudioCompression::Lossless:
+			return oFormat.iSamplesPerBlock == iLosslessSamplesPerBlock;
+
+		default:
+			return false;
+		}
+	}
+
+	size_t GetCompressedBlockCount(const AudioCompressionFormat& oFormat, const uint8_t* pData,
+		size_t iDataSize) noexcept
+	{
+		switch (oFormat.eCompression)
+		{
+		case AudioCompression::IMA_ADPCM:
+		case AudioCompression::MS_ADPCM:
+			if (oFormat.iBlockAlign == 0)
+				return 0;
+			return (iDataSize + oFormat.iBlockAlign - 1) / oFormat.iBlockAlign;
+
+		case AudioCompression::Lossless:
+			return (LosslessSampleCount(pData, iDataSize) + iLosslessSamplesPerBlock - 1) /
+				iLosslessSamplesPerBlock;
+
+		default:
+			return 0;
+		}
+	}
+
+	size_t GetCompressedSampleCount(const AudioCompressionFormat& oFormat, uint8_t iChannelCount,
+		const uint8_t* pData, size_t iDataSize) noexcept
+	{
+		if (iChannelCount == 0)
+			return 0;
+
+		size_t iLastBlockSamples = 0;
+		switch (oFormat.eCompression)
+		{
+		case AudioCompression::IMA_ADPCM:
+		case AudioCompression::MS_ADPCM:
+		{
+			const size_t iBlockCount = GetCompressedBlockCount(oFormat, pData, iDataSize);
+			if (iBlockCount == 0)
+				return 0;
+
+			const size_t iLastBlockSize = iDataSize - (iBlockCount - 1) * oFormat.iBlockAlign;
+			iLastBlockSamples = (oFormat.eCompression == AudioCompression::IMA_ADPCM) ?
+				IMASamplesInBlock(iChannelCount, iLastBlockSize) :
+				MSSamplesInBlock(iChannelCount, iLastBlockSize);
+			iLastBlockSamples = std::min<size_t>(iLastBlockSamples, oFormat.iSamplesPerBlock);
+
+			return (iBlockCount - 1) * oFormat.iSamplesPerBlock + iLastBlockSamples;
+		}
+
+		case AudioCompression::Lossless:
+			return LosslessSampleCount(pData, iDataSize);
+
+		default:
+			return 0;
+		}
+	}
+
+	size_t DecodeAudioBlock(const AudioCompressionFormat& oFormat, uint8_t iChannelCount,
+		const uint8_t* pData, size_t iDataSize, size_t iBlock, int16_t* pDest) noexcept
+	{
+		if (pData == nullptr || iChannelCount == 0 || iChannelCount > iMaxChannelCount)
+			return 0;
+
+		switch (oFormat.eCompression)
+		{
+		case AudioCompression::IMA_ADPCM:
+		case AudioCompression::MS_ADPCM:
+		{
+			const size_t iOffset = iBlock * oFormat.iBlockAlign;
+			if (oFormat.iBlockAlign == 0 || iOffset >= iDataSize)
+				return 0;
+
+			const size_t iBlockSize = std::min<size_t>(oFormat.iBlockAlign, iDataSize - iOffset);
+			if (oFormat.eCompression == AudioCompression::IMA_ADPCM)
+				return IMADecodeBlock(pData + iOffset, iBlockSize, iChannelCount,
+					oFormat.iSamplesPerBlock, pDest);
+			else
+				return MSDecodeBlock(pData + iOffset, iBlockSize, iChannelCount,
+					oFormat.iSamplesPerBlock, pDest);
+		}
+
+		case AudioCompression::Lossless:
+			return LosslessDecodeBlock(pData, iDataSize, iChannelCount, iBlock, pDest);
+
+		default:
+			return 0;
+		}
+	}
+
+	bool EncodeAudio(AudioCompression eCompression, const int16_t* pSamples, size_t iSampleCount,
+		uint8_t iChannelCount, AudioCompressionFormat& oFormat, std::vector<uint8_t>& oDest)
+	{
+		oDest.clear();
+		oFormat = {};
+
+		if (pSamples == nullptr || iSampleCount == 0 || iChannelCount == 0 ||
+			iChannelCount > iMaxChannelCount || iSampleCount > UINT32_MAX)
+			return false;
+
+		const uint32_t iBlockAlign = iADPCMBlockAlignPerChannel * iChannelCount;
+		switch (eCompression)
+		{
+		case AudioCompression::IMA_ADPCM:
+			oFormat.iBlockAlign = iBlockAlign;
+			oFormat.iSamplesPerBlock = (uint32_t)IMASamplesInBlock(iChannelCount, iBlockAlign);
+			IMAEncode(pSamples, iSampleCount, iChannelCount, oFormat.iSamplesPerBlock, oDest);
+			break;
+
+		case AudioCompression::MS_ADPCM:
+			oFormat.iBlockAlign = iBlockAlign;
+			oFormat.iSamplesPerBlock = (uint32_t)MSSamplesInBlock(iChannelCount, iBlockAlign);
+			MSEncode(pSamples, iSampleCount, iChannelCount, oFormat.iSamplesPerBlock, oDest);
+			break;
+
+		case AudioCompression::Lossless:
+			oFormat.iSamplesPerBlock = iLosslessSamplesPerBlock;
+			LosslessEncode(pSamples, iSampleCount, iChannelCount, oDest);
+			break;
+
+		default:
+			return false;
+		}
+
+		oFormat.eCompression = eCompression;
+		return true;
+	}
+
+}
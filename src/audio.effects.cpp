@@ -0,0 +1,1364 @@
+#include "rl/audio.effects.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <emmintrin.h> // SSE2
+#include <xapobase.h>
+
+#pragma comment(lib, "xapobase.lib")
+
+
+
+
+
+namespace
+{
+
+	// parameters are updated (and coefficients recalculated) once per sub-block
+	constexpr uint32_t iSubBlockSize = 32;
+
+	constexpr uint32_t iFFTSize = 2 * rl::ConvolutionReverb::PartitionSize;
+
+	constexpr float fDBPerOctave = 6.02059991f; // 20 * log10(2)
+
+	constexpr double dPi = 3.14159265358979323846;
+
+
+	inline uint8_t GroupCount(uint8_t iChannelCount) noexcept
+	{
+		return uint8_t((iChannelCount + 3) / 4);
+	}
+
+	inline float HorizontalMax(__m128 v) noexcept
+	{
+		v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+		v = _mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+		return _mm_cvtss_f32(v);
+	}
+
+	/// <summary>
+	/// Approximate <c>log2(x)</c> for <c>x > 0</c> (max. error 2e-4)
+	/// </summary>
+	inline __m128 FastLog2(__m128 x) noexcept
+	{
+		const __m128i i = _mm_castps_si128(x);
+		const __m128 vExponent =
+			_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(i, 23), _mm_set1_epi32(127)));
+		// mantissa in [1, 2)
+		const __m128 m = _mm_or_ps(_mm_castsi128_ps(_mm_and_si128(i, _mm_set1_epi32(0x007FFFFF))),
+			_mm_set1_ps(1.0f));
+
+		__m128 p = _mm_set1_ps(-0.0791538163f);
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(0.628841375f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.08112846f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(4.02845046f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.49680584f));
+
+		return _mm_add_ps(vExponent, p);
+	}
+
+	/// <summary>
+	/// Approximate <c>2^x</c> (max. relative error 1e-5)
+	/// </summary>
+	inline __m128 FastExp2(__m128 x) noexcept
+	{
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+
+		// floor(x)
+		const __m128 vTrunc = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		const __m128 vFloor =
+			_mm_sub_ps(vTrunc, _mm_and_ps(_mm_cmpgt_ps(vTrunc, x), _mm_set1_ps(1.0f)));
+		const __m128 f = _mm_sub_ps(x, vFloor); // [0, 1)
+
+		__m128 p = _mm_set1_ps(0.0136765608f);
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.0516670284f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.241709986f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.692931415f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.00000727f));
+
+		const __m128i iExponent = _mm_slli_epi32(
+			_mm_add_epi32(_mm_cvttps_epi32(vFloor), _mm_set1_epi32(127)), 23);
+		return _mm_mul_ps(p, _mm_castsi128_ps(iExponent));
+	}
+
+
+
+	/// <summary>
+	/// Radix-2 complex FFT on split real and imaginary parts<para/>
+	/// The inverse transform (scaled by the size) is done by swapping the real and the imaginary
+	/// part.
+	/// </summary>
+	class FFT final
+	{
+	public: // methods
+
+		explicit FFT(uint32_t iSize);
+
+		void transform(float* pRe, float* pIm) const noexcept;
+
+
+	private: // variables
+
+		const uint32_t m_iSize;
+		std::vector<std::pair<uint32_t, uint32_t>> m_oSwaps; // bit reversal permutation
+		std::vector<float> m_oTwiddleRe, m_oTwiddleIm; // stage with half size h at offset h - 1
+
+	};
+
+	FFT::FFT(uint32_t iSize) : m_iSize(iSize)
+	{
+		const uint32_t iBits = (uint32_t)std::log2(iSize);
+		for (uint32_t i = 0; i < iSize; ++i)
+		{
+			uint32_t iReversed = 0;
+			for (uint32_t iBit = 0; iBit < iBits; ++iBit)
+			{
+				if (i & (1 << iBit))
+					iReversed |= 1 << (iBits - 1 - iBit);
+			}
+			if (i < iReversed)
+				m_oSwaps.push_back({ i, iReversed });
+		}
+
+		m_oTwiddleRe.reserve(iSize - 1);
+		m_oTwiddleIm.reserve(iSize - 1);
+		for (uint32_t h = 1; h < iSize; h *= 2)
+		{
+			for (uint32_t k = 0; k < h; ++k)
+			{
+				m_oTwiddleRe.push_back((float)std::cos(dPi * k / h));
+				m_oTwiddleIm.push_back((float)-std::sin(dPi * k / h));
+			}
+		}
+	}
+
+	void FFT::transform(float* pRe, float* pIm) const noexcept
+	{
+		for (const auto& o : m_oSwaps)
+		{
+			std::swap(pRe[o.first], pRe[o.second]);
+			std::swap(pIm[o.first], pIm[o.second]);
+		}
+
+		for (uint32_t h = 1; h < m_iSize; h *= 2)
+		{
+			const float* pWRe = m_oTwiddleRe.data() + (h - 1);
+			const float* pWIm = m_oTwiddleIm.data() + (h - 1);
+
+			for (uint32_t s = 0; s < m_iSize; s += 2 * h)
+			{
+				float* pARe = pRe + s;
+				float* pAIm = pIm + s;
+				float* pBRe = pARe + h;
+				float* pBIm = pAIm + h;
+
+				if (h >= 4)
+				{
+					for (uint32_t k = 0; k < h; k += 4)
+					{
+						const __m128 vWRe = _mm_loadu_ps(pWRe + k);
+						const __m128 vWIm = _mm_loadu_ps(pWIm + k);
+						const __m128 vBRe = _mm_loadu_ps(pBRe + k);
+						const __m128 vBIm = _mm_loadu_ps(pBIm + k);
+						const __m128 vARe = _mm_loadu_ps(pARe + k);
+						const __m128 vAIm = _mm_loadu_ps(pAIm + k);
+
+						const __m128 vTRe =
+							_mm_sub_ps(_mm_mul_ps(vBRe, vWRe), _mm_mul_ps(vBIm, vWIm));
+						const __m128 vTIm =
+							_mm_add_ps(_mm_mul_ps(vBRe, vWIm), _mm_mul_ps(vBIm, vWRe));
+
+						_mm_storeu_ps(pBRe + k, _mm_sub_ps(vARe, vTRe));
+						_mm_storeu_ps(pBIm + k, _mm_sub_ps(vAIm, vTIm));
+						_mm_storeu_ps(pARe + k, _mm_add_ps(vARe, vTRe));
+						_mm_storeu_ps(pAIm + k, _mm_add_ps(vAIm, vTIm));
+					}
+				}
+				else
+				{
+					for (uint32_t k = 0; k < h; ++k)
+					{
+						const float fTRe = pBRe[k] * pWRe[k] - pBIm[k] * pWIm[k];
+						const float fTIm = pBRe[k] * pWIm[k] + pBIm[k] * pWRe[k];
+
+						pBRe[k] = pARe[k] - fTRe;
+						pBIm[k] = pAIm[k] - fTIm;
+						pARe[k] += fTRe;
+						pAIm[k] += fTIm;
+					}
+				}
+			}
+		}
+	}
+
+	const FFT& GetFFT()
+	{
+		static const FFT oFFT(iFFTSize);
+		return oFFT;
+	}
+
+	/// <summary>
+	/// pAcc += pX * pH (complex, element-wise)
+	/// </summary>
+	inline void ComplexMultiplyAdd(float* pAccRe, float* pAccIm, const float* pXRe,
+		const float* pXIm, const float* pHRe, const float* pHIm, uint32_t iCount) noexcept
+	{
+		for (uint32_t i = 0; i < iCount; i += 4)
+		{
+			const __m128 vXRe = _mm_loadu_ps(pXRe + i);
+			const __m128 vXIm = _mm_loadu_ps(pXIm + i);
+			const __m128 vHRe = _mm_loadu_ps(pHRe + i);
+			const __m128 vHIm = _mm_loadu_ps(pHIm + i);
+
+			const __m128 vRe = _mm_sub_ps(_mm_mul_ps(vXRe, vHRe), _mm_mul_ps(vXIm, vHIm));
+			const __m128 vIm = _mm_add_ps(_mm_mul_ps(vXRe, vHIm), _mm_mul_ps(vXIm, vHRe));
+
+			_mm_storeu_ps(pAccRe + i, _mm_add_ps(_mm_loadu_ps(pAccRe + i), vRe));
+			_mm_storeu_ps(pAccIm + i, _mm_add_ps(_mm_loadu_ps(pAccIm + i), vIm));
+		}
+	}
+
+
+
+	/// <summary>
+	/// XAPO that processes an <c>rl::AudioEffectChain</c> in place
+	/// </summary>
+	class EffectChainAPO final : public CXAPOBase
+	{
+	public: // methods
+
+		EffectChainAPO(std::shared_ptr<rl::AudioEffectChain> spChain);
+
+		STDMETHOD(LockForProcess)(UINT32 InputLockedParameterCount,
+			const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+			UINT32 OutputLockedParameterCount,
+			const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters) override;
+
+		STDMETHOD_(void, Reset)() override;
+
+		STDMETHOD_(void, Process)(UINT32 InputProcessParameterCount,
+			const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+			UINT32 OutputProcessParameterCount,
+			XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled) override;
+
+
+	private: // variables
+
+		std::shared_ptr<rl::AudioEffectChain> m_spChain;
+
+	};
+
+	const XAPO_REGISTRATION_PROPERTIES oEffectChainAPOProperties =
+	{
+		{ 0x6E2B1C7Au, 0x3F4D, 0x4A8E, { 0x9B, 0x51, 0x0C, 0x7D, 0x22, 0xE4, 0x86, 0x3F } },
+		L"rl::AudioEffectChain",
+		L"RobinLe",
+		1, 0,
+		XAPO_FLAG_CHANNELS_MUST_MATCH | XAPO_FLAG_FRAMERATE_MUST_MATCH |
+		XAPO_FLAG_BITSPERSAMPLE_MUST_MATCH | XAPO_FLAG_BUFFERCOUNT_MUST_MATCH |
+		XAPO_FLAG_INPLACE_SUPPORTED | XAPO_FLAG_INPLACE_REQUIRED,
+		1, 1, 1, 1
+	};
+
+	EffectChainAPO::EffectChainAPO(std::shared_ptr<rl::AudioEffectChain> spChain) :
+		CXAPOBase(&oEffectChainAPOProperties), m_spChain(std::move(spChain)) {}
+
+	HRESULT EffectChainAPO::LockForProcess(UINT32 InputLockedParameterCount,
+		const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pInputLockedParameters,
+		UINT32 OutputLockedParameterCount,
+		const XAPO_LOCKFORPROCESS_BUFFER_PARAMETERS* pOutputLockedParameters)
+	{
+		const HRESULT hr = CXAPOBase::LockForProcess(InputLockedParameterCount,
+			pInputLockedParameters, OutputLockedParameterCount, pOutputLockedParameters);
+		if (FAILED(hr))
+			return hr;
+
+		const auto& oParams = pInputLockedParameters[0];
+		if (oParams.pFormat->nChannels > XAUDIO2_MAX_AUDIO_CHANNELS ||
+			!m_spChain->prepare(oParams.pFormat->nSamplesPerSec,
+				(uint8_t)oParams.pFormat->nChannels, oParams.MaxFrameCount))
+			return XAPO_E_FORMAT_UNSUPPORTED;
+
+		return S_OK;
+	}
+
+	void EffectChainAPO::Reset()
+	{
+		m_spChain->reset();
+	}
+
+	void EffectChainAPO::Process(UINT32 InputProcessParameterCount,
+		const XAPO_PROCESS_BUFFER_PARAMETERS* pInputProcessParameters,
+		UINT32 OutputProcessParameterCount,
+		XAPO_PROCESS_BUFFER_PARAMETERS* pOutputProcessParameters, BOOL IsEnabled)
+	{
+		const auto& oInput = pInputProcessParameters[0];
+		auto& oOutput = pOutputProcessParameters[0];
+		oOutput.ValidFrameCount = oInput.ValidFrameCount;
+
+		if (!IsEnabled)
+		{
+			oOutput.BufferFlags = oInput.BufferFlags;
+			return;
+		}
+
+		// the effects might still produce output (delay, reverb tail)
+		auto pData = static_cast<float*>(oInput.pBuffer);
+		if (oInput.BufferFlags == XAPO_BUFFER_SILENT)
+			memset(pData, 0, sizeof(float) * oInput.ValidFrameCount * m_spChain->getChannelCount());
+
+		m_spChain->process(pData, oInput.ValidFrameCount);
+		oOutput.BufferFlags = XAPO_BUFFER_VALID;
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	/***********************************************************************************************
+	 class SmoothedParameter
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void SmoothedParameter::init(uint32_t iSampleRate, float fTimeConstant) noexcept
+	{
+		m_fTimeConstant = std::max(1.0f, fTimeConstant * iSampleRate);
+		m_fCurrent = get();
+	}
+
+	SmoothedParameter::Ramp SmoothedParameter::advance(uint32_t iSampleCount) noexcept
+	{
+		const float fTarget = get();
+		const float fStart = m_fCurrent;
+		if (fStart == fTarget || iSampleCount == 0)
+			return { fStart, 0.0f };
+
+		const float fFactor = std::exp(-(float)iSampleCount / m_fTimeConstant);
+		m_fCurrent = fTarget + (fStart - fTarget) * fFactor;
+		if (std::abs(m_fCurrent - fTarget) <= 1e-5f * std::max(1.0f, std::abs(fTarget)))
+			m_fCurrent = fTarget;
+
+		return { fStart, (m_fCurrent - fStart) / iSampleCount };
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class BiquadFilter
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	BiquadFilter::BiquadFilter(Type eType, float fFrequency, float fQ, float fGainDB) noexcept :
+		m_eType(eType), m_oFrequency(fFrequency), m_oQ(fQ), m_oGainDB(fGainDB),
+		m_eCurrentType(eType) {}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void BiquadFilter::prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+		uint32_t iMaxSampleCount)
+	{
+		m_iSampleRate = iSampleRate;
+		m_iChannelCount = iChannelCount;
+
+		m_oFrequency.init(iSampleRate);
+		m_oQ.init(iSampleRate);
+		m_oGainDB.init(iSampleRate);
+
+		m_oZ1.resize(GroupCount(iChannelCount));
+		m_oZ2.resize(GroupCount(iChannelCount));
+		reset();
+
+		m_eCurrentType = m_eType;
+		calcCoefficients(m_eCurrentType);
+	}
+
+	void BiquadFilter::reset() noexcept
+	{
+		std::fill(m_oZ1.begin(), m_oZ1.end(), _mm_setzero_ps());
+		std::fill(m_oZ2.begin(), m_oZ2.end(), _mm_setzero_ps());
+	}
+
+	void BiquadFilter::process(AudioEffectBlock& oBlock) noexcept
+	{
+		const uint8_t iGroupCount = oBlock.iGroupCount;
+
+		const Type eType = m_eType;
+		bool bRecalc = eType != m_eCurrentType;
+		m_eCurrentType = eType;
+
+		for (uint32_t iOffset = 0; iOffset < oBlock.iSampleCount; iOffset += iSubBlockSize)
+		{
+			const uint32_t iCount = std::min(iSubBlockSize, oBlock.iSampleCount - iOffset);
+
+			if (bRecalc || m_oFrequency.isSmoothing() || m_oQ.isSmoothing() ||
+				m_oGainDB.isSmoothing())
+			{
+				m_oFrequency.advance(iCount);
+				m_oQ.advance(iCount);
+				m_oGainDB.advance(iCount);
+				calcCoefficients(eType);
+				bRecalc = false;
+			}
+
+			const __m128 vB0 = _mm_set1_ps(m_fB0);
+			const __m128 vB1 = _mm_set1_ps(m_fB1);
+			const __m128 vB2 = _mm_set1_ps(m_fB2);
+			const __m128 vA1 = _mm_set1_ps(m_fA1);
+			const __m128 vA2 = _mm_set1_ps(m_fA2);
+
+			for (uint8_t iGroup = 0; iGroup < iGroupCount; ++iGroup)
+			{
+				__m128 vZ1 = m_oZ1[iGroup];
+				__m128 vZ2 = m_oZ2[iGroup];
+
+				__m128* p = oBlock.pData + size_t(iOffset) * iGroupCount + iGroup;
+				for (uint32_t i = 0; i < iCount; ++i, p += iGroupCount)
+				{
+					const __m128 vX = *p;
+					const __m128 vY = _mm_add_ps(_mm_mul_ps(vB0, vX), vZ1);
+					vZ1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vB1, vX), _mm_mul_ps(vA1, vY)), vZ2);
+					vZ2 = _mm_sub_ps(_mm_mul_ps(vB2, vX), _mm_mul_ps(vA2, vY));
+					*p = vY;
+				}
+
+				m_oZ1[iGroup] = vZ1;
+				m_oZ2[iGroup] = vZ2;
+			}
+		}
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void BiquadFilter::calcCoefficients(Type eType) noexcept
+	{
+		const double dFrequency = std::clamp<double>(m_oFrequency.current(), 10.0,
+			0.49 * m_iSampleRate);
+		const double dQ = std::max<double>(m_oQ.current(), 0.01);
+		const double dA = std::pow(10.0, m_oGainDB.current() / 40.0);
+
+		const double dW0 = 2.0 * dPi * dFrequency / m_iSampleRate;
+		const double dCos = std::cos(dW0);
+		const double dAlpha = std::sin(dW0) / (2.0 * dQ);
+		const double dShelf = 2.0 * std::sqrt(dA) * dAlpha;
+
+		double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+		switch (eType)
+		{
+		case Type::LowPass:
+			b0 = (1.0 - dCos) / 2.0;
+			b1 = 1.0 - dCos;
+			b2 = b0;
+			a0 = 1.0 + dAlpha;
+			a1 = -2.0 * dCos;
+			a2 = 1.0 - dAlpha;
+			break;
+
+		case Type::HighPass:
+			b0 = (1.0 + dCos) / 2.0;
+			b1 = -(1.0 + dCos);
+			b2 = b0;
+			a0 = 1.0 + dAlpha;
+			a1 = -2.0 * dCos;
+			a2 = 1.0 - dAlpha;
+			break;
+
+		case Type::BandPass: // constant 0 dB peak gain
+			b0 = dAlpha;
+			b1 = 0.0;
+			b2 = -dAlpha;
+			a0 = 1.0 + dAlpha;
+			a1 = -2.0 * dCos;
+			a2 = 1.0 - dAlpha;
+			break;
+
+		case Type::Notch:
+			b0 = 1.0;
+			b1 = -2.0 * dCos;
+			b2 = 1.0;
+			a0 = 1.0 + dAlpha;
+			a1 = -2.0 * dCos;
+			a2 = 1.0 - dAlpha;
+			break;
+
+		case Type::Peak:
+			b0 = 1.0 + dAlpha * dA;
+			b1 = -2.0 * dCos;
+			b2 = 1.0 - dAlpha * dA;
+			a0 = 1.0 + dAlpha / dA;
+			a1 = -2.0 * dCos;
+			a2 = 1.0 - dAlpha / dA;
+			break;
+
+		case Type::LowShelf:
+			b0 = dA * ((dA + 1.0) - (dA - 1.0) * dCos + dShelf);
+			b1 = 2.0 * dA * ((dA - 1.0) - (dA + 1.0) * dCos);
+			b2 = dA * ((dA + 1.0) - (dA - 1.0) * dCos - dShelf);
+			a0 = (dA + 1.0) + (dA - 1.0) * dCos + dShelf;
+			a1 = -2.0 * ((dA - 1.0) + (dA + 1.0) * dCos);
+			a2 = (dA + 1.0) + (dA - 1.0) * dCos - dShelf;
+			break;
+
+		case Type::HighShelf:
+			b0 = dA * ((dA + 1.0) + (dA - 1.0) * dCos + dShelf);
+			b1 = -2.0 * dA * ((dA - 1.0) + (dA + 1.0) * dCos);
+			b2 = dA * ((dA + 1.0) + (dA - 1.0) * dCos - dShelf);
+			a0 = (dA + 1.0) - (dA - 1.0) * dCos + dShelf;
+			a1 = 2.0 * ((dA - 1.0) - (dA + 1.0) * dCos);
+			a2 = (dA + 1.0) - (dA - 1.0) * dCos - dShelf;
+			break;
+		}
+
+		m_fB0 = float(b0 / a0);
+		m_fB1 = float(b1 / a0);
+		m_fB2 = float(b2 / a0);
+		m_fA1 = float(a1 / a0);
+		m_fA2 = float(a2 / a0);
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class Compressor
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	Compressor::Compressor(float fThresholdDB, float fRatio, float fAttack, float fRelease,
+		float fKneeDB, float fMakeupGainDB) noexcept :
+		m_oThresholdDB(fThresholdDB), m_oSlope(1.0f - 1.0f / std::max(1.0f, fRatio)),
+		m_oKneeDB(fKneeDB), m_oMakeupGainDB(fMakeupGainDB), m_fAttack(fAttack),
+		m_fRelease(fRelease) {}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void Compressor::setRatio(float fRatio) noexcept
+	{
+		m_oSlope.set(1.0f - 1.0f / std::max(1.0f, fRatio));
+	}
+
+	float Compressor::getRatio() const noexcept
+	{
+		const float fSlope = m_oSlope.get();
+		return (fSlope >= 1.0f) ? INFINITY : 1.0f / (1.0f - fSlope);
+	}
+
+	void Compressor::prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+		uint32_t iMaxSampleCount)
+	{
+		m_iSampleRate = iSampleRate;
+		m_iChannelCount = iChannelCount;
+
+		m_oThresholdDB.init(iSampleRate);
+		m_oSlope.init(iSampleRate);
+		m_oKneeDB.init(iSampleRate);
+		m_oMakeupGainDB.init(iSampleRate);
+
+		// the gain computer always processes 4 samples at once
+		m_oLevels.assign(iSubBlockSize, 0.0f);
+		reset();
+	}
+
+	void Compressor::reset() noexcept
+	{
+		m_fEnvelope = 0.0f;
+		m_fGainReduction = 0.0f;
+	}
+
+	void Compressor::process(AudioEffectBlock& oBlock) noexcept
+	{
+		const uint8_t iGroupCount = oBlock.iGroupCount;
+		const __m128 vAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+		const float fAttack = std::exp(-1.0f / std::max(1.0f, m_fAttack * m_iSampleRate));
+		const float fRelease = std::exp(-1.0f / std::max(1.0f, m_fRelease * m_iSampleRate));
+
+		float fEnvelope = m_fEnvelope;
+		__m128 vMaxReduction = _mm_setzero_ps();
+		float* pLevels = m_oLevels.data();
+
+		for (uint32_t iOffset = 0; iOffset < oBlock.iSampleCount; iOffset += iSubBlockSize)
+		{
+			const uint32_t iCount = std::min(iSubBlockSize, oBlock.iSampleCount - iOffset);
+			__m128* const pFirst = oBlock.pData + size_t(iOffset) * iGroupCount;
+
+			m_oThresholdDB.advance(iCount);
+			m_oSlope.advance(iCount);
+			m_oKneeDB.advance(iCount);
+			m_oMakeupGainDB.advance(iCount);
+
+
+			// level detection (peak of all channels, attack/release envelope)
+
+			const __m128* p = pFirst;
+			for (uint32_t i = 0; i < iCount; ++i)
+			{
+				__m128 vPeak = _mm_and_ps(*p++, vAbsMask);
+				for (uint8_t iGroup = 1; iGroup < iGroupCount; ++iGroup)
+				{
+					vPeak = _mm_max_ps(vPeak, _mm_and_ps(*p++, vAbsMask));
+				}
+				const float fPeak = HorizontalMax(vPeak);
+
+				const float fCoef = (fPeak > fEnvelope) ? fAttack : fRelease;
+				fEnvelope = fPeak + fCoef * (fEnvelope - fPeak);
+				pLevels[i] = fEnvelope;
+			}
+			for (uint32_t i = iCount; i % 4; ++i)
+			{
+				pLevels[i] = fEnvelope;
+			}
+
+
+			// gain computer (logarithmic domain, unit = octaves)
+			// over = level - threshold
+			// gain = makeup - max(slope * over, slope * (over + knee/2)^2 / (2 * knee))
+			// the soft knee term is clamped, so it's only relevant in [-knee/2, knee/2]
+
+			const float fKnee = std::max(0.001f, m_oKneeDB.current() / fDBPerOctave);
+			const __m128 vThreshold = _mm_set1_ps(m_oThresholdDB.current() / fDBPerOctave);
+			const __m128 vSlope = _mm_set1_ps(m_oSlope.current());
+			const __m128 vHalfKnee = _mm_set1_ps(fKnee * 0.5f);
+			const __m128 vKnee = _mm_set1_ps(fKnee);
+			const __m128 vKneeFactor = _mm_set1_ps(0.5f / fKnee);
+			const __m128 vMakeup = _mm_set1_ps(m_oMakeupGainDB.current() / fDBPerOctave);
+			const __m128 vMinLevel = _mm_set1_ps(1e-10f);
+			const __m128 vZero = _mm_setzero_ps();
+
+			for (uint32_t i = 0; i < iCount; i += 4)
+			{
+				const __m128 vLevel = FastLog2(_mm_max_ps(_mm_loadu_ps(pLevels + i), vMinLevel));
+				const __m128 vOver = _mm_sub_ps(vLevel, vThreshold);
+
+				const __m128 vKneeOver =
+					_mm_min_ps(_mm_max_ps(_mm_add_ps(vOver, vHalfKnee), vZero), vKnee);
+				const __m128 vSoft = _mm_mul_ps(_mm_mul_ps(vSlope, vKneeFactor),
+					_mm_mul_ps(vKneeOver, vKneeOver));
+				const __m128 vHard = _mm_mul_ps(vSlope, vOver);
+				const __m128 vReduction = _mm_max_ps(vSoft, vHard);
+
+				vMaxReduction = _mm_max_ps(vMaxReduction, vReduction);
+				_mm_storeu_ps(pLevels + i, FastExp2(_mm_sub_ps(vMakeup, vReduction)));
+			}
+
+
+			// apply the gain to all channels
+
+			__m128* pDest = pFirst;
+			for (uint32_t i = 0; i < iCount; ++i)
+			{
+				const __m128 vGain = _mm_set1_ps(pLevels[i]);
+				for (uint8_t iGroup = 0; iGroup < iGroupCount; ++iGroup, ++pDest)
+				{
+					*pDest = _mm_mul_ps(*pDest, vGain);
+				}
+			}
+		}
+
+		m_fEnvelope = fEnvelope;
+		m_fGainReduction = HorizontalMax(vMaxReduction) * fDBPerOctave;
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class Delay
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	Delay::Delay(float fDelayTime, float fFeedback, float fMix, float fMaxDelayTime) noexcept :
+		m_fMaxDelayTime(std::max(fMaxDelayTime, 0.001f)), m_oDelayTime(fDelayTime),
+		m_oFeedback(fFeedback), m_oMix(fMix) {}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void Delay::prepare(uint32_t iSampleRate, uint8_t iChannelCount, uint32_t iMaxSampleCount)
+	{
+		m_iSampleRate = iSampleRate;
+		m_iChannelCount = iChannelCount;
+
+		// the delay time is changed slowly to avoid pitch jumps
+		m_oDelayTime.init(iSampleRate, 0.1f);
+		m_oFeedback.init(iSampleRate);
+		m_oMix.init(iSampleRate);
+
+		m_iBufferSampleCount = size_t(std::ceil(m_fMaxDelayTime * iSampleRate)) + 2;
+		m_oBuffer.resize(m_iBufferSampleCount * GroupCount(iChannelCount));
+		reset();
+	}
+
+	void Delay::reset() noexcept
+	{
+		std::fill(m_oBuffer.begin(), m_oBuffer.end(), _mm_setzero_ps());
+		m_iWritePos = 0;
+	}
+
+	void Delay::process(AudioEffectBlock& oBlock) noexcept
+	{
+		const uint8_t iGroupCount = oBlock.iGroupCount;
+		const double dBufferSize = (double)m_iBufferSampleCount;
+		const float fMaxDelay = float(m_iBufferSampleCount - 2);
+
+		__m128* p = oBlock.pData;
+		for (uint32_t iOffset = 0; iOffset < oBlock.iSampleCount; iOffset += iSubBlockSize)
+		{
+			const uint32_t iCount = std::min(iSubBlockSize, oBlock.iSampleCount - iOffset);
+
+			const auto rDelay = m_oDelayTime.advance(iCount);
+			const auto rFeedback = m_oFeedback.advance(iCount);
+			const auto rMix = m_oMix.advance(iCount);
+
+			for (uint32_t i = 0; i < iCount; ++i)
+			{
+				const float fDelay =
+					std::clamp((rDelay.fValue + rDelay.fStep * i) * m_iSampleRate, 1.0f, fMaxDelay);
+				const __m128 vFeedback = _mm_set1_ps(
+					std::clamp(rFeedback.fValue + rFeedback.fStep * i, 0.0f, 0.999f));
+				const __m128 vMix = _mm_set1_ps(rMix.fValue + rMix.fStep * i);
+
+				// fractional read position (linear interpolation)
+				double dReadPos = (double)m_iWritePos - fDelay;
+				if (dReadPos < 0.0)
+					dReadPos += dBufferSize;
+				const size_t iRead0 = (size_t)dReadPos;
+				const size_t iRead1 = (iRead0 + 1 == m_iBufferSampleCount) ? 0 : iRead0 + 1;
+				const __m128 vFrac = _mm_set1_ps(float(dReadPos - (double)iRead0));
+
+				const __m128* pRead0 = m_oBuffer.data() + iRead0 * iGroupCount;
+				const __m128* pRead1 = m_oBuffer.data() + iRead1 * iGroupCount;
+				__m128* pWrite = m_oBuffer.data() + m_iWritePos * iGroupCount;
+
+				for (uint8_t iGroup = 0; iGroup < iGroupCount; ++iGroup, ++p)
+				{
+					const __m128 vDelayed = _mm_add_ps(pRead0[iGroup],
+						_mm_mul_ps(_mm_sub_ps(pRead1[iGroup], pRead0[iGroup]), vFrac));
+					const __m128 vDry = *p;
+
+					pWrite[iGroup] = _mm_add_ps(vDry, _mm_mul_ps(vDelayed, vFeedback));
+					*p = _mm_add_ps(vDry, _mm_mul_ps(_mm_sub_ps(vDelayed, vDry), vMix));
+				}
+
+				if (++m_iWritePos == m_iBufferSampleCount)
+					m_iWritePos = 0;
+			}
+		}
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class ConvolutionReverb
+	***********************************************************************************************/
+
+	struct ConvolutionReverb::Kernel
+	{
+		uint8_t iChannelCount;
+		size_t iPartitionCount;
+
+		// spectra of the partitions (scaled by 1 / iFFTSize), [channel][partition][bin]
+		std::vector<float> oRe, oIm;
+
+		inline const float* getRe(uint8_t iChannel, size_t iPartition) const noexcept
+		{
+			return oRe.data() + (iChannel * iPartitionCount + iPartition) * iFFTSize;
+		}
+		inline const float* getIm(uint8_t iChannel, size_t iPartition) const noexcept
+		{
+			return oIm.data() + (iChannel * iPartitionCount + iPartition) * iFFTSize;
+		}
+	};
+
+	struct ConvolutionReverb::Line
+	{
+		static constexpr uint8_t NoChannel = 0xFF;
+
+		uint8_t iKernelChannel;
+		uint8_t iChannelA; // real part
+		uint8_t iChannelB; // imaginary part, NoChannel if unused
+
+		std::vector<float> oInputRe, oInputIm; // the last 2 partitions of input
+		std::vector<float> oSpectraRe, oSpectraIm; // spectra of the last inputs (ring buffer)
+		size_t iSpectrumPos = 0; // index of the next spectrum to be written
+		std::vector<float> oWorkRe, oWorkIm;
+		std::vector<float> oOutputA, oOutputB; // wet output of the current partition
+
+		Line(uint8_t iKernelChannel, uint8_t iChannelA, uint8_t iChannelB,
+			size_t iPartitionCount) :
+			iKernelChannel(iKernelChannel), iChannelA(iChannelA), iChannelB(iChannelB),
+			oInputRe(iFFTSize), oInputIm(iFFTSize),
+			oSpectraRe(iPartitionCount * iFFTSize), oSpectraIm(iPartitionCount * iFFTSize),
+			oWorkRe(iFFTSize), oWorkIm(iFFTSize),
+			oOutputA(PartitionSize), oOutputB(PartitionSize) {}
+
+		void clear() noexcept
+		{
+			for (auto pVector : { &oInputRe, &oInputIm, &oSpectraRe, &oSpectraIm, &oOutputA,
+				&oOutputB })
+			{
+				std::fill(pVector->begin(), pVector->end(), 0.0f);
+			}
+			iSpectrumPos = 0;
+		}
+
+		/// <summary>
+		/// Convolve the last partition of input, calculate the next partition of output
+		/// </summary>
+		void convolve(const Kernel& oKernel) noexcept
+		{
+			const auto& oFFT = GetFFT();
+			const size_t iPartitionCount = oKernel.iPartitionCount;
+
+			// transform the input
+			float* pXRe = oSpectraRe.data() + iSpectrumPos * iFFTSize;
+			float* pXIm = oSpectraIm.data() + iSpectrumPos * iFFTSize;
+			memcpy(pXRe, oInputRe.data(), sizeof(float) * iFFTSize);
+			memcpy(pXIm, oInputIm.data(), sizeof(float) * iFFTSize);
+			oFFT.transform(pXRe, pXIm);
+
+			// multiply the spectra of the past inputs with the kernel partitions
+			std::fill(oWorkRe.begin(), oWorkRe.end(), 0.0f);
+			std::fill(oWorkIm.begin(), oWorkIm.end(), 0.0f);
+			size_t iSpectrum = iSpectrumPos;
+			for (size_t iPartition = 0; iPartition < iPartitionCount; ++iPartition)
+			{
+				ComplexMultiplyAdd(oWorkRe.data(), oWorkIm.data(),
+					oSpectraRe.data() + iSpectrum * iFFTSize,
+					oSpectraIm.data() + iSpectrum * iFFTSize,
+					oKernel.getRe(iKernelChannel, iPartition),
+					oKernel.getIm(iKernelChannel, iPartition), iFFTSize);
+
+				iSpectrum = (iSpectrum == 0) ? iPartitionCount - 1 : iSpectrum - 1;
+			}
+
+			// inverse transform, keep the (non-circular) second half
+			oFFT.transform(oWorkIm.data(), oWorkRe.data());
+			memcpy(oOutputA.data(), oWorkRe.data() + PartitionSize, sizeof(float) * PartitionSize);
+			memcpy(oOutputB.data(), oWorkIm.data() + PartitionSize, sizeof(float) * PartitionSize);
+
+			iSpectrumPos = (iSpectrumPos + 1) % iPartitionCount;
+
+			// overlap-save: the current input becomes the previous input
+			memcpy(oInputRe.data(), oInputRe.data() + PartitionSize, sizeof(float) * PartitionSize);
+			memcpy(oInputIm.data(), oInputIm.data() + PartitionSize, sizeof(float) * PartitionSize);
+		}
+	};
+
+	struct ConvolutionReverb::State
+	{
+		std::shared_ptr<const Kernel> spKernel;
+		std::vector<std::unique_ptr<Line>> oLines;
+		uint32_t iBlockPos = 0; // position in the current partition
+	};
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	ConvolutionReverb::ConvolutionReverb(float fWet, float fDry) noexcept :
+		m_oWet(fWet), m_oDry(fDry) {}
+
+	ConvolutionReverb::~ConvolutionReverb() {}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	bool ConvolutionReverb::setImpulseResponse(const float* pData, size_t iSampleCount,
+		uint8_t iChannelCount)
+	{
+		if (pData == nullptr || iSampleCount == 0 || iChannelCount == 0)
+			return false;
+
+		auto upKernel = std::make_unique<Kernel>();
+		upKernel->iChannelCount = iChannelCount;
+		upKernel->iPartitionCount = (iSampleCount + PartitionSize - 1) / PartitionSize;
+
+		const size_t iKernelSize = iChannelCount * upKernel->iPartitionCount * iFFTSize;
+		upKernel->oRe.resize(iKernelSize);
+		upKernel->oIm.resize(iKernelSize);
+
+		const auto& oFFT = GetFFT();
+		const float fScale = 1.0f / iFFTSize;
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			for (size_t iPartition = 0; iPartition < upKernel->iPartitionCount; ++iPartition)
+			{
+				float* pRe = upKernel->oRe.data() +
+					(iChannel * upKernel->iPartitionCount + iPartition) * iFFTSize;
+				float* pIm = upKernel->oIm.data() +
+					(iChannel * upKernel->iPartitionCount + iPartition) * iFFTSize;
+
+				// the second half stays zero
+				const size_t iFirst = iPartition * PartitionSize;
+				const size_t iCount = std::min<size_t>(PartitionSize, iSampleCount - iFirst);
+				for (size_t i = 0; i < iCount; ++i)
+				{
+					pRe[i] = pData[(iFirst + i) * iChannelCount + iChannel] * fScale;
+				}
+
+				oFFT.transform(pRe, pIm);
+			}
+		}
+
+		std::unique_lock lock(m_mux);
+		m_spKernel = std::move(upKernel);
+		publishState();
+		return true;
+	}
+
+	bool ConvolutionReverb::setImpulseResponse(const Sound& oSound)
+	{
+		const size_t iChannelCount = oSound.getWaveFormat().iChannelCount;
+		auto upSamples = std::make_unique<float[]>(oSound.getSampleCount() * iChannelCount);
+
+		const size_t iSampleCount =
+			oSound.getSamplesAsFloat(upSamples.get(), 0, oSound.getSampleCount());
+		return setImpulseResponse(upSamples.get(), iSampleCount, (uint8_t)iChannelCount);
+	}
+
+	void ConvolutionReverb::prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+		uint32_t iMaxSampleCount)
+	{
+		m_oWet.init(iSampleRate);
+		m_oDry.init(iSampleRate);
+
+		std::unique_lock lock(m_mux);
+		m_iSampleRate = iSampleRate;
+		m_iChannelCount = iChannelCount;
+		publishState();
+	}
+
+	void ConvolutionReverb::reset() noexcept
+	{
+		std::unique_lock lock(m_mux);
+		const auto& spState = m_oState.get();
+		if (!spState)
+			return;
+
+		for (auto& upLine : spState->oLines)
+		{
+			upLine->clear();
+		}
+		spState->iBlockPos = 0;
+	}
+
+	void ConvolutionReverb::process(AudioEffectBlock& oBlock) noexcept
+	{
+		const size_t iStride = size_t(oBlock.iGroupCount) * 4; // floats per sample
+		float* const pData = reinterpret_cast<float*>(oBlock.pData);
+
+		// a new state might be published meanwhile, this one stays valid until the end
+		const PublishedPtr<State>::ReadGuard spState(m_oState);
+		if (!spState || spState->oLines.empty())
+		{
+			// no impulse response (yet) --> dry signal only
+			for (uint32_t iOffset = 0; iOffset < oBlock.iSampleCount; iOffset += iSubBlockSize)
+			{
+				const uint32_t iCount = std::min(iSubBlockSize, oBlock.iSampleCount - iOffset);
+				const auto rDry = m_oDry.advance(iCount);
+				m_oWet.advance(iCount);
+
+				__m128* p = oBlock.pData + size_t(iOffset) * oBlock.iGroupCount;
+				for (uint32_t i = 0; i < iCount; ++i)
+				{
+					const __m128 vDry = _mm_set1_ps(rDry.fValue + rDry.fStep * i);
+					for (uint8_t iGroup = 0; iGroup < oBlock.iGroupCount; ++iGroup, ++p)
+					{
+						*p = _mm_mul_ps(*p, vDry);
+					}
+				}
+			}
+			return;
+		}
+		State& oState = *spState;
+
+		uint32_t iOffset = 0;
+		while (iOffset < oBlock.iSampleCount)
+		{
+			const uint32_t iCount = std::min({ iSubBlockSize, PartitionSize - oState.iBlockPos,
+				oBlock.iSampleCount - iOffset });
+			const auto rDry = m_oDry.advance(iCount);
+			const auto rWet = m_oWet.advance(iCount);
+
+			for (auto& upLine : oState.oLines)
+			{
+				auto& oLine = *upLine;
+				const uint8_t iChannels[2] = { oLine.iChannelA, oLine.iChannelB };
+				float* const pInputs[2] =
+				{
+					oLine.oInputRe.data() + PartitionSize + oState.iBlockPos,
+					oLine.oInputIm.data() + PartitionSize + oState.iBlockPos
+				};
+				const float* const pOutputs[2] =
+				{
+					oLine.oOutputA.data() + oState.iBlockPos,
+					oLine.oOutputB.data() + oState.iBlockPos
+				};
+
+				for (uint8_t iPart = 0; iPart < 2; ++iPart)
+				{
+					if (iChannels[iPart] == Line::NoChannel)
+						continue;
+
+					float* p = pData + iOffset * iStride + iChannels[iPart];
+					for (uint32_t i = 0; i < iCount; ++i, p += iStride)
+					{
+						const float fDry = *p;
+						pInputs[iPart][i] = fDry;
+						*p = fDry * (rDry.fValue + rDry.fStep * i) +
+							pOutputs[iPart][i] * (rWet.fValue + rWet.fStep * i);
+					}
+				}
+			}
+
+			iOffset += iCount;
+			oState.iBlockPos += iCount;
+			if (oState.iBlockPos == PartitionSize)
+			{
+				for (auto& upLine : oState.oLines)
+				{
+					upLine->convolve(*oState.spKernel);
+				}
+				oState.iBlockPos = 0;
+			}
+		}
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void ConvolutionReverb::publishState()
+	{
+		auto spState = std::make_shared<State>();
+		spState->spKernel = m_spKernel;
+
+		if (m_spKernel && m_iChannelCount != 0)
+		{
+			const size_t iPartitionCount = m_spKernel->iPartitionCount;
+			if (m_spKernel->iChannelCount == 1)
+			{
+				// same kernel for all channels --> two channels per complex convolution
+				for (uint8_t iChannel = 0; iChannel < m_iChannelCount; iChannel += 2)
+				{
+					const uint8_t iSecond = (iChannel + 1 < m_iChannelCount) ?
+						uint8_t(iChannel + 1) : Line::NoChannel;
+					spState->oLines.push_back(std::make_unique<Line>(uint8_t(0), iChannel,
+						iSecond, iPartitionCount));
+				}
+			}
+			else if (m_spKernel->iChannelCount == m_iChannelCount)
+			{
+				for (uint8_t iChannel = 0; iChannel < m_iChannelCount; ++iChannel)
+				{
+					spState->oLines.push_back(std::make_unique<Line>(iChannel, iChannel,
+						Line::NoChannel, iPartitionCount));
+				}
+			}
+			// else: unsupported channel count --> dry signal only
+		}
+
+		m_oState.publish(std::move(spState));
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class AudioEffectChain
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// STATIC METHODS
+
+	bool AudioEffectChain::AttachToVoice(AudioEngine::SubmixVoice& oVoice,
+		std::shared_ptr<AudioEffectChain> spChain)
+	{
+		auto pVoice = oVoice.getPtr();
+		if (pVoice == nullptr)
+			return false;
+
+		if (!spChain)
+			return SUCCEEDED(pVoice->SetEffectChain(nullptr));
+
+		XAUDIO2_VOICE_DETAILS oDetails{};
+		pVoice->GetVoiceDetails(&oDetails);
+
+		auto pAPO = new EffectChainAPO(std::move(spChain));
+
+		XAUDIO2_EFFECT_DESCRIPTOR oDescriptor{};
+		oDescriptor.pEffect = static_cast<IXAPO*>(pAPO);
+		oDescriptor.InitialState = true;
+		oDescriptor.OutputChannels = oDetails.InputChannels;
+
+		XAUDIO2_EFFECT_CHAIN oEffectChain{};
+		oEffectChain.EffectCount = 1;
+		oEffectChain.pEffectDescriptors = &oDescriptor;
+
+		const HRESULT hr = pVoice->SetEffectChain(&oEffectChain);
+		pAPO->Release(); // the voice holds its own reference
+		return SUCCEEDED(hr);
+	}
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void AudioEffectChain::add(std::shared_ptr<IAudioEffect> spEffect)
+	{
+		if (!spEffect)
+			return;
+
+		std::unique_lock lock(m_mux);
+		if (isPrepared())
+			spEffect->prepare(m_iSampleRate, m_iChannelCount, m_iMaxSampleCount);
+
+		const auto& spEffects = m_oEffects.get();
+		auto spNewEffects = spEffects ? std::make_shared<EffectList>(*spEffects) :
+			std::make_shared<EffectList>();
+		spNewEffects->push_back(std::move(spEffect));
+		publish(std::move(spNewEffects));
+	}
+
+	void AudioEffectChain::remove(const IAudioEffect* pEffect)
+	{
+		std::unique_lock lock(m_mux);
+		const auto& spEffects = m_oEffects.get();
+		if (!spEffects)
+			return;
+
+		auto it = std::find_if(spEffects->begin(), spEffects->end(),
+			[pEffect](const auto& sp) { return sp.get() == pEffect; });
+		if (it == spEffects->end())
+			return;
+
+		auto spNewEffects = std::make_shared<EffectList>(*spEffects);
+		spNewEffects->erase(spNewEffects->begin() + (it - spEffects->begin()));
+		publish(std::move(spNewEffects));
+	}
+
+	void AudioEffectChain::clear()
+	{
+		std::unique_lock lock(m_mux);
+		publish(nullptr);
+	}
+
+	size_t AudioEffectChain::size() const
+	{
+		std::unique_lock lock(m_mux);
+		const auto& spEffects = m_oEffects.get();
+		return spEffects ? spEffects->size() : 0;
+	}
+
+	bool AudioEffectChain::prepare(uint32_t iSampleRate, uint8_t iChannelCount,
+		uint32_t iMaxSampleCount)
+	{
+		if (iSampleRate == 0 || iChannelCount == 0 || iMaxSampleCount == 0)
+			return false;
+
+		std::unique_lock lock(m_mux);
+		m_iSampleRate = iSampleRate;
+		m_iChannelCount = iChannelCount;
+		m_iMaxSampleCount = iMaxSampleCount;
+		m_oBuffer.assign(size_t(iMaxSampleCount) * GroupCount(iChannelCount), _mm_setzero_ps());
+
+		const auto& spEffects = m_oEffects.get();
+		if (spEffects)
+		{
+			for (auto& sp : *spEffects)
+			{
+				sp->prepare(iSampleRate, iChannelCount, iMaxSampleCount);
+			}
+		}
+		return true;
+	}
+
+	void AudioEffectChain::reset() noexcept
+	{
+		std::unique_lock lock(m_mux);
+		const auto& spEffects = m_oEffects.get();
+		if (!spEffects)
+			return;
+
+		for (auto& sp : *spEffects)
+		{
+			sp->reset();
+		}
+	}
+
+	void AudioEffectChain::process(float* pData, uint32_t iSampleCount) noexcept
+	{
+		// the list stays valid until the end, even if a new one is published meanwhile
+		const PublishedPtr<const EffectList>::ReadGuard spEffects(m_oEffects);
+		if (!spEffects || spEffects->empty() || !isPrepared() || pData == nullptr)
+			return;
+
+		// flush denormals to zero (decaying filter states and reverb tails)
+		const unsigned iMXCSR = _mm_getcsr();
+		_mm_setcsr(iMXCSR | 0x8040);
+
+		AudioEffectBlock oBlock{};
+		oBlock.pData = m_oBuffer.data();
+		oBlock.iChannelCount = m_iChannelCount;
+		oBlock.iGroupCount = GroupCount(m_iChannelCount);
+
+		const size_t iChannelCount = m_iChannelCount;
+		const size_t iStride = size_t(oBlock.iGroupCount) * 4;
+		float* const pLanes = reinterpret_cast<float*>(m_oBuffer.data());
+
+		while (iSampleCount > 0)
+		{
+			oBlock.iSampleCount = std::min(iSampleCount, m_iMaxSampleCount);
+
+			// interleaved --> groups of 4 lanes (unused lanes stay zero)
+			if (iChannelCount == iStride)
+				memcpy(pLanes, pData, sizeof(float) * iStride * oBlock.iSampleCount);
+			else
+			{
+				for (size_t i = 0; i < oBlock.iSampleCount; ++i)
+				{
+					for (size_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+					{
+						pLanes[i * iStride + iChannel] = pData[i * iChannelCount + iChannel];
+					}
+				}
+			}
+
+			for (auto& sp : *spEffects)
+			{
+				if (!sp->getBypass())
+					sp->process(oBlock);
+			}
+
+			// groups of 4 lanes --> interleaved
+			if (iChannelCount == iStride)
+				memcpy(pData, pLanes, sizeof(float) * iStride * oBlock.iSampleCount);
+			else
+			{
+				for (size_t i = 0; i < oBlock.iSampleCount; ++i)
+				{
+					for (size_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+					{
+						pData[i * iChannelCount + iChannel] = pLanes[i * iStride + iChannel];
+					}
+				}
+			}
+
+			pData += iChannelCount * oBlock.iSampleCount;
+			iSampleCount -= oBlock.iSampleCount;
+		}
+
+		_mm_setcsr(iMXCSR);
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void AudioEffectChain::publish(std::shared_ptr<const EffectList> spEffects)
+	{
+		m_oEffects.publish(std::move(spEffects));
+	}
+
+}
@@ -1,11 +1,18 @@
 #include "rl/audio.engine.hpp"
+#include "rl/audio.analysis.hpp"
 #include "rl/tools.hresult.hpp"
 
+#include <algorithm>
+#include <bit> // std::bit_width
+#include <chrono>
+#include <cmath>
 #include <fstream> // std::ifstream
+#include <future> // std::promise
 #include <memory> // memcpy
 #include <stdint.h>
 #define NOMINMAX
 #include <Windows.h>
+#include <emmintrin.h> // SSE2
 
 #undef min
 #undef max
@@ -61,6 +68,306 @@ namespace rl
 		};
 
 		using WaveformHeader = WAVEFORMAT;
+
+
+		/// <summary>
+		/// The relevant contents of a RIFF waveform file
+		/// </summary>
+		struct WaveInfo
+		{
+			WaveFormat oFormat; // for compressed data: the format of the decoded samples
+			WORD wBlockAlign; // size of a (decoded) sample frame
+			AudioCompressionFormat oCompression;
+			size_t iSampleCount; // from the "fact" chunk, 0 if unknown (only for compressed data)
+			const uint8_t* pData; // start of the "data" chunk's contents
+			size_t iDataSize; // size of the "data" chunk's contents, multiple of wBlockAlign
+			                  // (unless compressed)
+		};
+
+		/// <summary>
+		/// Read the ADPCM-specific contents of a <c>"fmt "</c> chunk (<c>WAVEFORMATEX</c> and its
+		/// extension)
+		/// </summary>
+		/// <returns>Is the format valid and supported?</returns>
+		bool ParseADPCMFormat(const uint8_t* pChunk, size_t iChunkSize,
+			const WaveformHeader& hdr, WaveFormat& oFormat, WORD& wBlockAlign,
+			AudioCompressionFormat& oCompression)
+		{
+			// wBitsPerSample, cbSize, wSamplesPerBlock
+			constexpr size_t iSamplesPerBlockOffset = sizeof(WaveformHeader) + 2 * sizeof(WORD);
+			if (iChunkSize < iSamplesPerBlockOffset + sizeof(WORD))
+				return false;
+
+			WORD wBitsPerSample = 0;
+			WORD wSamplesPerBlock = 0;
+			memcpy(&wBitsPerSample, pChunk + sizeof(WaveformHeader), sizeof(WORD));
+			memcpy(&wSamplesPerBlock, pChunk + iSamplesPerBlockOffset, sizeof(WORD));
+			if (wBitsPerSample != 4)
+				return false;
+
+			oCompression = {};
+			oCompression.iSamplesPerBlock = wSamplesPerBlock;
+			oCompression.iBlockAlign = hdr.nBlockAlign;
+			if (hdr.wFormatTag == WAVE_FORMAT_IMA_ADPCM)
+				oCompression.eCompression = AudioCompression::IMA_ADPCM;
+			else
+			{
+				// wNumCoef and the coefficient pairs (only the standard ones are supported)
+				constexpr int16_t iStandardCoefs[] =
+				{ 256, 0, 512, -256, 0, 0, 192, 64, 240, 0, 460, -208, 392, -232 };
+				constexpr size_t iCoefOffset = iSamplesPerBlockOffset + 2 * sizeof(WORD);
+				if (iChunkSize < iCoefOffset + sizeof(iStandardCoefs))
+					return false;
+
+				WORD wCoefCount = 0;
+				memcpy(&wCoefCount, pChunk + iSamplesPerBlockOffset + sizeof(WORD), sizeof(WORD));
+				if (wCoefCount != 7 ||
+					memcmp(pChunk + iCoefOffset, iStandardCoefs, sizeof(iStandardCoefs)) != 0)
+					return false;
+
+				oCompression.eCompression = AudioCompression::MS_ADPCM;
+			}
+
+			oFormat.eBitDepth = AudioBitDepth::Audio16;
+			oFormat.iChannelCount = (uint8_t)hdr.nChannels;
+			oFormat.iSampleRate = hdr.nSamplesPerSec;
+			wBlockAlign = (WORD)(sizeof(int16_t) * hdr.nChannels);
+
+			return ValidWaveFormat(oFormat) && hdr.nChannels <= XAUDIO2_MAX_AUDIO_CHANNELS &&
+				ValidCompressionFormat(oCompression, oFormat.iChannelCount);
+		}
+
+		/// <summary>
+		/// Read the contents of a <c>"fmt "</c> chunk
+		/// </summary>
+		/// <param name="pCompression">
+		/// = Receives the compression format. If <c>nullptr</c>, compressed formats are rejected.
+		/// </param>
+		/// <returns>Is the format valid and supported?</returns>
+		bool ParseFormatChunk(const uint8_t* pChunk, size_t iChunkSize, WaveFormat& oFormat,
+			WORD& wBlockAlign, AudioCompressionFormat* pCompression = nullptr)
+		{
+			if (iChunkSize < sizeof(WaveformHeader))
+				return false;
+
+			WaveformHeader hdr = {};
+			memcpy(&hdr, pChunk, sizeof(hdr));
+
+			WORD wBitsPerSample = 0;
+			switch (hdr.wFormatTag)
+			{
+			case WAVE_FORMAT_PCM:
+				if (iChunkSize < sizeof(WaveformHeader) + sizeof(WORD))
+					return false; // bits per sample missing
+				memcpy(&wBitsPerSample, pChunk + sizeof(WaveformHeader), sizeof(WORD));
+				break;
+
+			case WAVE_FORMAT_IEEE_FLOAT:
+				wBitsPerSample = sizeof(float) * 8;
+				break;
+
+			case WAVE_FORMAT_ADPCM:
+			case WAVE_FORMAT_IMA_ADPCM:
+				return pCompression &&
+					ParseADPCMFormat(pChunk, iChunkSize, hdr, oFormat, wBlockAlign, *pCompression);
+
+			default:
+				return false; // unknown format
+			}
+
+			switch (wBitsPerSample)
+			{
+			case 8:
+			case 16:
+			case 24:
+			case 32:
+				break;
+
+			default:
+				return false; // unsupported bit depth
+			}
+
+			oFormat.eBitDepth = static_cast<AudioBitDepth>(wBitsPerSample);
+			oFormat.iChannelCount = (uint8_t)hdr.nChannels;
+			oFormat.iSampleRate = hdr.nSamplesPerSec;
+			wBlockAlign = (WORD)(wBitsPerSample / 8 * hdr.nChannels);
+
+			return ValidWaveFormat(oFormat) && hdr.nChannels <= XAUDIO2_MAX_AUDIO_CHANNELS &&
+				hdr.nBlockAlign == wBlockAlign;
+		}
+
+		/// <summary>
+		/// Walk the chunks of RIFF waveform data in memory<para/>
+		/// Every offset is checked against <c>size</c>; unknown chunks are skipped
+		/// </summary>
+		/// <returns>Is the data a supported RIFF waveform?</returns>
+		bool ParseWave(const void* data, size_t size, WaveInfo& dest)
+		{
+			constexpr FOURCC fccRIFF = FourCC("RIFF");
+			constexpr FOURCC fccWAVE = FourCC("WAVE");
+			constexpr FOURCC fccFmt  = FourCC("fmt ");
+			constexpr FOURCC fccFact = FourCC("fact");
+			constexpr FOURCC fccData = FourCC("data");
+
+			dest = {};
+
+			const uint8_t* const pBegin = static_cast<const uint8_t*>(data);
+			if (size < sizeof(ChunkHeader) + sizeof(FOURCC))
+				return false; // too small for RIFF header
+
+			ChunkHeader chRIFF;
+			memcpy(&chRIFF, pBegin, sizeof(chRIFF));
+			if (chRIFF.ckID != fccRIFF)
+				return false; // not a RIFF file
+
+			FOURCC fccForm;
+			memcpy(&fccForm, pBegin + sizeof(ChunkHeader), sizeof(fccForm));
+			if (fccForm != fccWAVE)
+				return false; // not a waveform
+
+			// a truncated file is accepted, trailing data after the RIFF chunk is ignored
+			const size_t iEnd = std::min<size_t>(size, (size_t)chRIFF.ckSize + sizeof(ChunkHeader));
+			size_t iOffset = sizeof(ChunkHeader) + sizeof(FOURCC);
+			if (iEnd < iOffset)
+				return false; // the RIFF chunk is too small for its form type
+
+			bool bFmt = false;
+
+			while (iEnd - iOffset >= sizeof(ChunkHeader))
+			{
+				ChunkHeader ch;
+				memcpy(&ch, pBegin + iOffset, sizeof(ch));
+				iOffset += sizeof(ChunkHeader);
+
+				const size_t iRemaining = iEnd - iOffset;
+
+				if (ch.ckID == fccFmt)
+				{
+					if (ch.ckSize > iRemaining || !ParseFormatChunk(pBegin + iOffset, ch.ckSize,
+						dest.oFormat, dest.wBlockAlign, &dest.oCompression))
+						return false; // invalid or unsupported format chunk
+
+					bFmt = true;
+				}
+				else if (ch.ckID == fccFact && ch.ckSize >= sizeof(DWORD) &&
+					ch.ckSize <= iRemaining)
+				{
+					DWORD dwSampleLength = 0;
+					memcpy(&dwSampleLength, pBegin + iOffset, sizeof(DWORD));
+					dest.iSampleCount = dwSampleLength;
+				}
+				else if (ch.ckID == fccData)
+				{
+					if (!bFmt)
+						return false; // "data" before "fmt "
+
+					dest.pData = pBegin + iOffset;
+					dest.iDataSize = std::min<size_t>(ch.ckSize, iRemaining); // truncated file
+					break;
+				}
+
+				if (ch.ckSize > iRemaining)
+					return false; // chunk exceeds the data
+				iOffset += ch.ckSize + (ch.ckSize & 1); // chunks are WORD-aligned
+				if (iOffset > iEnd)
+					break;
+			}
+
+			if (!dest.pData)
+				return false; // no "data" chunk
+
+			if (dest.oCompression.eCompression == AudioCompression::None)
+				dest.iDataSize -= dest.iDataSize % dest.wBlockAlign; // only full sample frames
+
+			return true;
+		}
+
+		/// <summary>
+		/// Walk the chunks of a RIFF waveform file without reading the sample data
+		/// </summary>
+		/// <param name="iDataOffset">
+		/// = Receives the offset of the <c>"data"</c> chunk's contents in the file
+		/// </param>
+		/// <param name="iDataSize">
+		/// = Receives the size of the <c>"data"</c> chunk's contents, a multiple of
+		/// <c>wBlockAlign</c>
+		/// </param>
+		/// <returns>Is the file a supported RIFF waveform?</returns>
+		bool ParseWaveFile(HANDLE hFile, WaveFormat& oFormat, WORD& wBlockAlign,
+			uint64_t& iDataOffset, uint64_t& iDataSize)
+		{
+			constexpr FOURCC fccRIFF = FourCC("RIFF");
+			constexpr FOURCC fccWAVE = FourCC("WAVE");
+			constexpr FOURCC fccFmt  = FourCC("fmt ");
+			constexpr FOURCC fccData = FourCC("data");
+
+			LARGE_INTEGER liFileSize{};
+			if (!GetFileSizeEx(hFile, &liFileSize))
+				return false;
+
+			DWORD dwRead = 0;
+			auto fnRead = [&](uint64_t iOffset, void* pDest, DWORD dwSize) -> bool
+			{
+				LARGE_INTEGER liOffset{};
+				liOffset.QuadPart = (LONGLONG)iOffset;
+				return SetFilePointerEx(hFile, liOffset, NULL, FILE_BEGIN) &&
+					ReadFile(hFile, pDest, dwSize, &dwRead, NULL) && dwRead == dwSize;
+			};
+
+			ChunkHeader chRIFF;
+			FOURCC fccForm;
+			if (!fnRead(0, &chRIFF, sizeof(chRIFF)) ||
+				!fnRead(sizeof(chRIFF), &fccForm, sizeof(fccForm)) ||
+				chRIFF.ckID != fccRIFF || fccForm != fccWAVE)
+				return false; // not a RIFF waveform
+
+			const uint64_t iEnd = std::min<uint64_t>(liFileSize.QuadPart,
+				(uint64_t)chRIFF.ckSize + sizeof(ChunkHeader));
+			uint64_t iOffset = sizeof(ChunkHeader) + sizeof(FOURCC);
+			if (iEnd < iOffset)
+				return false; // the RIFF chunk is too small for its form type
+
+			bool bFmt = false;
+
+			while (iEnd - iOffset >= sizeof(ChunkHeader))
+			{
+				ChunkHeader ch;
+				if (!fnRead(iOffset, &ch, sizeof(ch)))
+					return false;
+				iOffset += sizeof(ChunkHeader);
+
+				const uint64_t iRemaining = iEnd - iOffset;
+
+				if (ch.ckID == fccFmt)
+				{
+					uint8_t buf[sizeof(WaveformHeader) + sizeof(WORD)]{};
+					const DWORD dwSize = std::min<DWORD>(ch.ckSize, sizeof(buf));
+					if (ch.ckSize > iRemaining || !fnRead(iOffset, buf, dwSize) ||
+						!ParseFormatChunk(buf, dwSize, oFormat, wBlockAlign))
+						return false; // invalid or unsupported format chunk
+
+					bFmt = true;
+				}
+				else if (ch.ckID == fccData)
+				{
+					if (!bFmt)
+						return false; // "data" before "fmt "
+
+					iDataOffset = iOffset;
+					iDataSize = std::min<uint64_t>(ch.ckSize, iRemaining); // truncated file
+					iDataSize -= iDataSize % wBlockAlign; // only full sample frames
+					return true;
+				}
+
+				if (ch.ckSize > iRemaining)
+					return false; // chunk exceeds the file
+				iOffset += ch.ckSize + (ch.ckSize & 1); // chunks are WORD-aligned
+				if (iOffset > iEnd)
+					break;
+			}
+
+			return false; // no "data" chunk
+		}
 	}
 
 
@@ -101,6 +408,93 @@ namespace rl
 		fSideRight = fRelSide * fRelRight;
 	}
 
+	/// <summary>
+	/// Convert PCM values to 32-bit float values (-1.0f to 1.0f)
+	/// </summary>
+	/// <param name="iValueCount">= The count of values (samples * channels)</param>
+	void PCMToFloat(const uint8_t* pSrc, AudioBitDepth eBitDepth, size_t iValueCount,
+		float* pDest) noexcept
+	{
+		size_t i = 0;
+
+		switch (eBitDepth)
+		{
+		case AudioBitDepth::Audio8:
+		{
+			constexpr float fScale = 1.0f / 128.0f;
+
+			const __m128i vZero = _mm_setzero_si128();
+			const __m128i vOffset = _mm_set1_epi16(128);
+			const __m128 vScale = _mm_set1_ps(fScale);
+			for (; i + 16 <= iValueCount; i += 16)
+			{
+				const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+
+				// unsigned 8 bit --> signed 16 bit
+				const __m128i vLo16 = _mm_sub_epi16(_mm_unpacklo_epi8(v8, vZero), vOffset);
+				const __m128i vHi16 = _mm_sub_epi16(_mm_unpackhi_epi8(v8, vZero), vOffset);
+
+				// signed 16 bit --> signed 32 bit (sign extension via arithmetic shift)
+				const __m128i v32[4] =
+				{
+					_mm_srai_epi32(_mm_unpacklo_epi16(vLo16, vLo16), 16),
+					_mm_srai_epi32(_mm_unpackhi_epi16(vLo16, vLo16), 16),
+					_mm_srai_epi32(_mm_unpacklo_epi16(vHi16, vHi16), 16),
+					_mm_srai_epi32(_mm_unpackhi_epi16(vHi16, vHi16), 16)
+				};
+				for (uint8_t j = 0; j < 4; ++j)
+					_mm_storeu_ps(pDest + i + j * 4, _mm_mul_ps(_mm_cvtepi32_ps(v32[j]), vScale));
+			}
+			for (; i < iValueCount; ++i)
+				pDest[i] = ((int)pSrc[i] - 128) * fScale;
+			break;
+		}
+
+		case AudioBitDepth::Audio16:
+		{
+			constexpr float fScale = 1.0f / 32768.0f;
+
+			const __m128 vScale = _mm_set1_ps(fScale);
+			for (; i + 8 <= iValueCount; i += 8)
+			{
+				const __m128i v16 =
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * sizeof(int16_t)));
+				const __m128i vLo = _mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 16);
+				const __m128i vHi = _mm_srai_epi32(_mm_unpackhi_epi16(v16, v16), 16);
+
+				_mm_storeu_ps(pDest + i,     _mm_mul_ps(_mm_cvtepi32_ps(vLo), vScale));
+				_mm_storeu_ps(pDest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(vHi), vScale));
+			}
+			for (; i < iValueCount; ++i)
+			{
+				int16_t iVal;
+				memcpy(&iVal, pSrc + i * sizeof(int16_t), sizeof(iVal));
+				pDest[i] = iVal * fScale;
+			}
+			break;
+		}
+
+		case AudioBitDepth::Audio24:
+		{
+			constexpr float fScale = 1.0f / 8388608.0f;
+
+			for (; i < iValueCount; ++i)
+			{
+				const uint8_t* p = pSrc + i * 3;
+				// shift into the upper bytes, then back for sign extension
+				const int32_t iVal = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 |
+					(uint32_t)p[2] << 24) >> 8;
+				pDest[i] = iVal * fScale;
+			}
+			break;
+		}
+
+		case AudioBitDepth::Audio32:
+			memcpy(pDest, pSrc, iValueCount * sizeof(float));
+			break;
+		}
+	}
+
 	const Audio3DPos Audio3DPos::Center = { 0.0f, 0.0f };
 	const Audio3DPos Audio3DPos::Left = { -1.0f, 0.0f };
 	const Audio3DPos Audio3DPos::Right = { +1.0f, 0.0f };
@@ -142,6 +536,138 @@ namespace rl
 
 
 
+	namespace
+	{
+
+		/// <summary>
+		/// A lock-free histogram with logarithmic buckets (4 per power of two, max. 25% error)
+		/// </summary>
+		class Histogram
+		{
+		public: // methods
+
+			void add(uint64_t iValue) noexcept
+			{
+				m_iCounts[BucketOf(iValue)].fetch_add(1, std::memory_order_relaxed);
+			}
+
+			void reset() noexcept
+			{
+				for (auto& i : m_iCounts)
+				{
+					i.store(0, std::memory_order_relaxed);
+				}
+			}
+
+			/// <summary>
+			/// Get an approximation of a percentile
+			/// </summary>
+			/// <param name="dPercentile">= The percentile (0.0 to 1.0)</param>
+			uint64_t percentile(double dPercentile) const noexcept
+			{
+				uint64_t iCounts[iBucketCount];
+				uint64_t iTotal = 0;
+				for (size_t i = 0; i < iBucketCount; ++i)
+				{
+					iCounts[i] = m_iCounts[i].load(std::memory_order_relaxed);
+					iTotal += iCounts[i];
+				}
+				if (iTotal == 0)
+					return 0;
+
+				const uint64_t iRank = (uint64_t)std::ceil(dPercentile * iTotal);
+				uint64_t iSum = 0;
+				for (size_t i = 0; i < iBucketCount; ++i)
+				{
+					iSum += iCounts[i];
+					if (iSum >= iRank && iCounts[i] > 0)
+						return BucketCenter(i);
+				}
+				return BucketCenter(iBucketCount - 1);
+			}
+
+
+		private: // static methods
+
+			static size_t BucketOf(uint64_t iValue) noexcept
+			{
+				if (iValue < 4)
+					return (size_t)iValue;
+
+				const int iMSB = std::bit_width(iValue) - 1;
+				return 4 * (iMSB - 1) + (size_t)((iValue >> (iMSB - 2)) & 3);
+			}
+
+			static uint64_t BucketCenter(size_t iBucket) noexcept
+			{
+				if (iBucket < 4)
+					return iBucket;
+
+				const int iMSB = int(iBucket / 4) + 1;
+				const uint64_t iWidth = uint64_t(1) << (iMSB - 2);
+				return (4 + iBucket % 4) * iWidth + iWidth / 2;
+			}
+
+
+		private: // variables
+
+			static constexpr size_t iBucketCount = 4 * 63;
+			std::atomic<uint64_t> m_iCounts[iBucketCount] = {};
+
+		};
+
+
+		/// <summary>
+		/// The counters behind <c>AudioEngine::getMetrics()</c>
+		/// </summary>
+		struct MetricCounters
+		{
+			std::atomic<size_t> iVoiceCount[3] = {};
+
+			std::atomic<uint64_t> iStreamBlocks = 0;
+			std::atomic<uint64_t> iStreamUnderruns = 0;
+			Histogram oFillTime; // in nanoseconds
+			Histogram oFillRatio; // in 1/10000 of the block duration
+
+			std::atomic<size_t> iSoundMemory = 0;
+			std::atomic<size_t> iSoundMemoryReferenced = 0;
+		};
+
+		MetricCounters oMetricCounters;
+
+
+
+		/// <summary>
+		/// The block of compressed sample data that was decoded last on a thread
+		/// </summary>
+		struct DecodedBlock
+		{
+			const uint8_t* pData = nullptr; // the compressed data the block belongs to
+			uint64_t iGeneration = 0;
+			size_t iBlock = 0;
+			size_t iSampleCount = 0;
+			std::vector<int16_t> oSamples;
+		};
+
+		thread_local DecodedBlock tls_oDecodedBlock;
+
+		/// <summary>
+		/// Incremented whenever compressed sample data is released, so cached blocks of released
+		/// data (whose address might get reused) aren't used anymore
+		/// </summary>
+		std::atomic<uint64_t> iDecodeGeneration = 1;
+
+	}
+
+
+
+
+
+
+
+
+
+
 	/***********************************************************************************************
 	 struct MultiChannelAudioSample
 	***********************************************************************************************/
@@ -186,10 +712,10 @@ namespace rl
 	// STATIC VARIABLES
 
 	std::thread AudioEngine::trdMsgLoop;
-	std::mutex AudioEngine::muxMsgLoop;
-	std::condition_variable AudioEngine::cvMsgLoop;
-	std::queue<AudioEngine::Message> AudioEngine::oMessageQueue;
+	MPSCQueue<AudioEngine::Message> AudioEngine::oMessageQueue;
+	std::atomic<uint32_t> AudioEngine::iMessageSignal = 0;
 	HRESULT AudioEngine::hr;
+	std::atomic<UINT32> AudioEngine::iNextOperationSet = 1;
 
 
 
@@ -245,22 +771,47 @@ namespace rl
 
 	void AudioEngine::PostMsg(MessageVal eMsg, void* ptr)
 	{
-		std::unique_lock lm(muxMsgLoop);
 		oMessageQueue.push({ eMsg, ptr });
-		lm.unlock();
-		cvMsgLoop.notify_one();
+		ProcessMessages();
 	}
 
-	void AudioEngine::MessageLoop()
+	void AudioEngine::PostBatch(ParameterBatch&& batch)
+	{
+		if (batch.empty())
+			return;
+
+		PostMsg(MessageVal::ApplyBatch, new ParameterBatch(std::move(batch)));
+	}
+
+	void AudioEngine::Flush()
+	{
+		std::promise<void> oProcessed;
+		auto oFuture = oProcessed.get_future();
+		PostMsg(MessageVal::Signal, &oProcessed);
+		oFuture.wait();
+	}
+
+	UINT32 AudioEngine::AllocateOperationSet() noexcept
 	{
-		std::unique_lock lm(muxMsgLoop);
+		UINT32 iOperationSet;
+		do
+		{
+			iOperationSet = iNextOperationSet.fetch_add(1, std::memory_order_relaxed);
+		} while (iOperationSet == XAUDIO2_COMMIT_NOW || iOperationSet == XAUDIO2_COMMIT_ALL);
+
+		return iOperationSet;
+	}
 
+	void AudioEngine::MessageLoop()
+	{
+		Message msg;
 		while (true)
 		{
-			while (oMessageQueue.size() > 0)
-			{
-				auto& msg = oMessageQueue.front();
+			// read the signal before checking the queue, so no message can get lost
+			const uint32_t iSignal = iMessageSignal.load(std::memory_order_acquire);
 
+			while (oMessageQueue.pop(msg))
+			{
 				switch (msg.eMsg)
 				{
 				case MessageVal::DestroyVoice:
@@ -271,18 +822,43 @@ namespace rl
 					reinterpret_cast<IXAudio2*>(msg.ptr)->Release();
 					break;
 
+				case MessageVal::ApplyBatch:
+				{
+					auto pBatch = reinterpret_cast<ParameterBatch*>(msg.ptr);
+
+					auto& oEngine = GetInstance();
+					if (oEngine.m_bCreated)
+					{
+						const UINT32 iOperationSet = AllocateOperationSet();
+						pBatch->apply(iOperationSet);
+						oEngine.m_pEngine->CommitChanges(iOperationSet);
+					}
+
+					delete pBatch;
+					break;
+				}
+
+				case MessageVal::Signal:
+					reinterpret_cast<std::promise<void>*>(msg.ptr)->set_value();
+					break;
+
 				case MessageVal::Quit:
-					oMessageQueue.pop(); // remove quit message
 					return; // escape message loop
-				}
 
-				oMessageQueue.pop(); // remove handled message
+				default:
+					break;
+				}
 			}
-			cvMsgLoop.wait(lm);
+
+			iMessageSignal.wait(iSignal, std::memory_order_acquire);
 		}
 	}
 
-	void AudioEngine::ProcessMessages() { cvMsgLoop.notify_one(); }
+	void AudioEngine::ProcessMessages()
+	{
+		iMessageSignal.fetch_add(1, std::memory_order_release);
+		iMessageSignal.notify_one();
+	}
 
 
 
@@ -321,6 +897,54 @@ namespace rl
 		m_bCreated = false;
 	}
 
+	AudioEngine::Metrics AudioEngine::getMetrics()
+	{
+		Metrics result{};
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			result.iVoiceCount[i] = oMetricCounters.iVoiceCount[i].load(std::memory_order_relaxed);
+		}
+
+		result.iStreamBlocks = oMetricCounters.iStreamBlocks.load(std::memory_order_relaxed);
+		result.iStreamUnderruns = oMetricCounters.iStreamUnderruns.load(std::memory_order_relaxed);
+		result.dFillTimeP50 = oMetricCounters.oFillTime.percentile(0.5) / 1e9;
+		result.dFillTimeP99 = oMetricCounters.oFillTime.percentile(0.99) / 1e9;
+		result.fFillRatioP50 = oMetricCounters.oFillRatio.percentile(0.5) / 10000.0f;
+		result.fFillRatioP99 = oMetricCounters.oFillRatio.percentile(0.99) / 10000.0f;
+
+		if (m_bCreated)
+		{
+			XAUDIO2_PERFORMANCE_DATA oPerf{};
+			m_pEngine->GetPerformanceData(&oPerf);
+
+			XAUDIO2_VOICE_DETAILS oDetails{};
+			m_pMasteringVoice->getPtr()->GetVoiceDetails(&oDetails);
+			if (oDetails.InputSampleRate > 0)
+				result.dDeviceLatency =
+					(double)oPerf.CurrentLatencyInSamples / oDetails.InputSampleRate;
+			if (oPerf.TotalCyclesSinceLastQuery > 0)
+				result.fAudioThreadLoad = (float)((double)oPerf.AudioCyclesSinceLastQuery /
+					oPerf.TotalCyclesSinceLastQuery);
+		}
+		result.dMaxStreamQueued = AudioWorkerPool::GetInstance().getMaxQueuedTime();
+		result.dQueuedLatency = result.dDeviceLatency + result.dMaxStreamQueued;
+
+		result.iSoundMemory = oMetricCounters.iSoundMemory.load(std::memory_order_relaxed);
+		result.iSoundMemoryReferenced =
+			oMetricCounters.iSoundMemoryReferenced.load(std::memory_order_relaxed);
+
+		return result;
+	}
+
+	void AudioEngine::resetMetrics()
+	{
+		oMetricCounters.iStreamBlocks = 0;
+		oMetricCounters.iStreamUnderruns = 0;
+		oMetricCounters.oFillTime.reset();
+		oMetricCounters.oFillRatio.reset();
+	}
+
 	HRESULT AudioEngine::createSubmixVoice(SubmixVoice** dest, UINT32 InputChannels,
 		UINT32 InputSampleRate, UINT32 Flags, UINT32 ProcessingStage, const VoiceSends* sends,
 		const XAUDIO2_EFFECT_CHAIN* pEffectChain)
@@ -426,6 +1050,14 @@ namespace rl
 		return hr;
 	}
 
+	HRESULT AudioEngine::commitChanges(UINT32 OperationSet)
+	{
+		if (!m_bCreated)
+			return ERROR_INIT_STATUS_NEEDED;
+
+		return m_pEngine->CommitChanges(OperationSet);
+	}
+
 
 
 
@@ -484,6 +1116,8 @@ namespace rl
 	AudioEngine::Voice::Voice(IXAudio2Voice* ptr, const std::set<SubmixVoice*>& parents,
 		VoiceType type) : m_pVoice(ptr), m_eVoiceType(type)
 	{
+		++oMetricCounters.iVoiceCount[static_cast<size_t>(type)];
+
 		std::unique_lock lm(AudioEngine::GetInstance().m_muxVoices);
 
 		if (parents.size() > 0)
@@ -530,6 +1164,31 @@ namespace rl
 
 		AudioEngine::PostMsg(MessageVal::DestroyVoice, m_pVoice);
 		m_pVoice = nullptr;
+		--oMetricCounters.iVoiceCount[static_cast<size_t>(m_eVoiceType)];
+	}
+
+	void AudioEngine::Voice::destroyAndWait()
+	{
+		if (!m_pVoice)
+			return;
+
+		for (auto p : m_oParents)
+		{
+			p->m_oSubVoices.erase(this);
+		}
+		m_oParents.clear();
+
+		// Parameter batches posted earlier might still reference the voice, so it's destroyed in
+		// order on the engine thread. Waiting for that also waits for the voice's callbacks.
+		if (std::this_thread::get_id() == trdMsgLoop.get_id())
+			m_pVoice->DestroyVoice(); // all earlier messages were already processed
+		else
+		{
+			AudioEngine::PostMsg(MessageVal::DestroyVoice, m_pVoice);
+			AudioEngine::Flush();
+		}
+		m_pVoice = nullptr;
+		--oMetricCounters.iVoiceCount[static_cast<size_t>(m_eVoiceType)];
 	}
 
 
@@ -665,7 +1324,7 @@ namespace rl
 
 
 	/***********************************************************************************************
-	 class Sound
+	 class AudioEngine::ParameterBatch
 	***********************************************************************************************/
 
 	//==============================================================================================
@@ -673,35 +1332,131 @@ namespace rl
 
 
 	//----------------------------------------------------------------------------------------------
-	// CONSTRUCTORS, DESTRUCTORS
+	// PUBLIC METHODS
 
-	Sound::Sound() : m_oWavFmt{}, m_iSampleAlign(0), m_iSampleCount(0), m_iDataSize(0),
-		m_pData(nullptr) {}
+	void AudioEngine::ParameterBatch::setVolume(Voice& voice, float fVolume)
+	{
+		Change oChange{};
+		oChange.eType = ChangeType::Volume;
+		oChange.pVoice = voice.getPtr();
+		oChange.fValue = fVolume;
+		m_oChanges.push_back(oChange);
+	}
 
-	Sound::Sound(const Sound& other) : m_oWavFmt(other.m_oWavFmt),
-		m_iSampleAlign(other.m_iSampleAlign), m_iSampleCount(other.m_iSampleCount),
-		m_iDataSize(other.m_iDataSize), m_pData(nullptr)
+	void AudioEngine::ParameterBatch::setFrequencyRatio(SourceVoice& voice, float fRatio)
 	{
-		if (m_iDataSize == 0)
-			return;
+		Change oChange{};
+		oChange.eType = ChangeType::FrequencyRatio;
+		oChange.pVoice = voice.Voice::getPtr();
+		oChange.fValue = fRatio;
+		m_oChanges.push_back(oChange);
+	}
 
-		m_pData = new uint8_t[m_iDataSize];
-		memcpy_s(m_pData, m_iDataSize, other.m_pData, other.m_iDataSize);
+	void AudioEngine::ParameterBatch::setOutputMatrix(Voice& voice, Voice* pDest,
+		UINT32 iSourceChannels, UINT32 iDestChannels, const float* pLevelMatrix)
+	{
+		Change oChange{};
+		oChange.eType = ChangeType::OutputMatrix;
+		oChange.pVoice = voice.getPtr();
+		oChange.pDest = pDest ? pDest->getPtr() : nullptr;
+		oChange.iSourceChannels = iSourceChannels;
+		oChange.iDestChannels = iDestChannels;
+		oChange.iMatrixOffset = m_oMatrixValues.size();
+		m_oChanges.push_back(oChange);
+
+		m_oMatrixValues.insert(m_oMatrixValues.end(), pLevelMatrix,
+			pLevelMatrix + (size_t)iSourceChannels * iDestChannels);
 	}
 
-	Sound::Sound(Sound&& rval) noexcept : m_oWavFmt(rval.m_oWavFmt),
-		m_iSampleAlign(rval.m_iSampleAlign), m_iSampleCount(rval.m_iSampleCount),
-		m_iDataSize(rval.m_iDataSize), m_pData(rval.m_pData)
+	void AudioEngine::ParameterBatch::clear() noexcept
 	{
-		rval.m_oWavFmt = {};
+		m_oChanges.clear();
+		m_oMatrixValues.clear();
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void AudioEngine::ParameterBatch::apply(UINT32 iOperationSet) const
+	{
+		for (const auto& oChange : m_oChanges)
+		{
+			if (!oChange.pVoice)
+				continue;
+
+			switch (oChange.eType)
+			{
+			case ChangeType::Volume:
+				oChange.pVoice->SetVolume(oChange.fValue, iOperationSet);
+				break;
+
+			case ChangeType::FrequencyRatio:
+				static_cast<IXAudio2SourceVoice*>(oChange.pVoice)->SetFrequencyRatio(
+					oChange.fValue, iOperationSet);
+				break;
+
+			case ChangeType::OutputMatrix:
+				oChange.pVoice->SetOutputMatrix(oChange.pDest, oChange.iSourceChannels,
+					oChange.iDestChannels, m_oMatrixValues.data() + oChange.iMatrixOffset,
+					iOperationSet);
+				break;
+			}
+		}
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class Sound
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	Sound::Sound() : m_oWavFmt{}, m_iSampleAlign(0), m_iSampleCount(0), m_iDataSize(0),
+		m_oCompression{}, m_pData(nullptr), m_bOwnsData(false) {}
+
+	Sound::Sound(const Sound& other) : m_oWavFmt(other.m_oWavFmt),
+		m_iSampleAlign(other.m_iSampleAlign), m_iSampleCount(other.m_iSampleCount),
+		m_iDataSize(other.m_iDataSize), m_oCompression(other.m_oCompression), m_pData(nullptr),
+		m_bOwnsData(false)
+	{
+		*this = other;
+	}
+
+	Sound::Sound(Sound&& rval) noexcept : m_oWavFmt(rval.m_oWavFmt),
+		m_iSampleAlign(rval.m_iSampleAlign), m_iSampleCount(rval.m_iSampleCount),
+		m_iDataSize(rval.m_iDataSize), m_oCompression(rval.m_oCompression),
+		m_pData(rval.m_pData), m_bOwnsData(rval.m_bOwnsData),
+		m_spDataOwner(std::move(rval.m_spDataOwner)), m_spEnvelope(std::move(rval.m_spEnvelope))
+	{
+		rval.m_oWavFmt = {};
 		rval.m_iSampleCount = {};
 		rval.m_iDataSize = 0;
+		rval.m_oCompression = {};
 		rval.m_pData = nullptr;
+		rval.m_bOwnsData = false;
 	}
 
 	Sound::Sound(const WaveFormat& Format, size_t SampleCount) :
 		m_oWavFmt(Format), m_iSampleAlign((size_t)Format.eBitDepth / 8 * Format.iChannelCount),
-		m_iSampleCount(SampleCount), m_iDataSize(m_iSampleAlign* m_iSampleCount), m_pData(nullptr)
+		m_iSampleCount(SampleCount), m_iDataSize(m_iSampleAlign* m_iSampleCount), m_oCompression{},
+		m_pData(nullptr), m_bOwnsData(false)
 	{
 		if (!ValidWaveFormat(Format))
 		{
@@ -709,11 +1464,14 @@ namespace rl
 			return;
 		}
 
-		m_pData = new uint8_t[m_iDataSize];
-		memset(m_pData, 0, m_iDataSize);
+		auto pData = new uint8_t[m_iDataSize];
+		memset(pData, 0, m_iDataSize);
+		m_pData = pData;
+		m_bOwnsData = true;
+		oMetricCounters.iSoundMemory += m_iDataSize;
 	}
 
-	Sound::~Sound() { delete[] m_pData; }
+	Sound::~Sound() { clear(); }
 
 
 
@@ -724,20 +1482,34 @@ namespace rl
 
 	Sound& Sound::operator=(const Sound& other)
 	{
-		delete[] m_pData;
+		if (&other == this)
+			return *this;
+
+		clear();
 
 		m_oWavFmt = other.m_oWavFmt;
 		m_iSampleAlign = other.m_iSampleAlign;
 		m_iSampleCount = other.m_iSampleCount;
 		m_iDataSize = other.m_iDataSize;
+		m_oCompression = other.m_oCompression;
+		m_spEnvelope = other.m_spEnvelope;
 
-		if (m_iDataSize)
+		if (!other.m_bOwnsData)
 		{
-			m_pData = new uint8_t[m_iDataSize];
-			memcpy_s(m_pData, m_iDataSize, other.m_pData, other.m_iDataSize);
+			// referenced data --> reference the same memory
+			m_pData = other.m_pData;
+			m_spDataOwner = other.m_spDataOwner;
+			if (m_pData)
+				oMetricCounters.iSoundMemoryReferenced += m_iDataSize;
+		}
+		else if (m_iDataSize)
+		{
+			auto pData = new uint8_t[m_iDataSize];
+			memcpy_s(pData, m_iDataSize, other.m_pData, other.m_iDataSize);
+			m_pData = pData;
+			m_bOwnsData = true;
+			oMetricCounters.iSoundMemory += m_iDataSize;
 		}
-		else
-			m_pData = nullptr;
 
 		return *this;
 	}
@@ -747,14 +1519,21 @@ namespace rl
 		if (&rval == this)
 			return *this;
 
-		delete[] m_pData;
+		clear();
 
 		m_oWavFmt = rval.m_oWavFmt;
 		m_iSampleAlign = rval.m_iSampleAlign;
 		m_iSampleCount = rval.m_iSampleCount;
 		m_iDataSize = rval.m_iDataSize;
+		m_oCompression = rval.m_oCompression;
 		m_pData = rval.m_pData;
+		m_bOwnsData = rval.m_bOwnsData;
+		m_spDataOwner = std::move(rval.m_spDataOwner);
+		m_spEnvelope = std::move(rval.m_spEnvelope);
 
+		rval.m_pData = nullptr;
+		rval.m_bOwnsData = false;
+		rval.m_oCompression = {}; // the data is still in use
 		rval.clear();
 
 		return *this;
@@ -767,22 +1546,54 @@ namespace rl
 	//----------------------------------------------------------------------------------------------
 	// PUBLIC METHODS
 
-	Sound* Sound::FromFile(const wchar_t* szFileName)
+	Sound* Sound::FromFile(const wchar_t* szFileName, bool bMapFile)
 	{
-		std::ifstream file(szFileName, std::ios::binary | std::ios::ate);
-		if (!file)
+		if (!bMapFile)
+		{
+			std::ifstream file(szFileName, std::ios::binary | std::ios::ate);
+			if (!file)
+				return nullptr; // couldn't open file
+
+			const size_t size = file.tellg();
+			auto up_Data = std::make_unique<char[]>(size);
+			file.seekg(0, std::ios::beg);
+			if (!file.read(up_Data.get(), size))
+				return nullptr; // couldn't read file
+
+			return FromMemory(up_Data.get(), size);
+		}
+
+
+
+		HANDLE hFile = CreateFileW(szFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
 			return nullptr; // couldn't open file
 
-		const size_t size = file.tellg();
-		auto up_Data = std::make_unique<char[]>(size);
-		file.seekg(0, std::ios::beg);
-		if (!file.read(up_Data.get(), size))
-			return nullptr; // couldn't read file
+		LARGE_INTEGER liFileSize{};
+		if (!GetFileSizeEx(hFile, &liFileSize) || liFileSize.QuadPart == 0 ||
+			(uint64_t)liFileSize.QuadPart > SIZE_MAX)
+		{
+			CloseHandle(hFile);
+			return nullptr; // empty or too large file
+		}
+
+		HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(hFile); // the mapping keeps the file open
+		if (hMapping == NULL)
+			return nullptr; // couldn't create file mapping
+
+		const void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(hMapping); // the view keeps the mapping alive
+		if (pView == NULL)
+			return nullptr; // couldn't map file
 
-		return FromMemory(up_Data.get(), size);
+		std::shared_ptr<const void> spView(pView, [](const void* p) { UnmapViewOfFile(p); });
+
+		return FromRIFF(pView, (size_t)liFileSize.QuadPart, false, std::move(spView));
 	}
 
-	Sound* Sound::FromResource(HMODULE hModule, LPCWSTR lpName)
+	Sound* Sound::FromResource(HMODULE hModule, LPCWSTR lpName, bool bCopy)
 	{
 		HRSRC hRsrc = FindResourceW(hModule, lpName, L"WAVE");
 		if (hRsrc == NULL)
@@ -794,77 +1605,166 @@ namespace rl
 		if (lpVoid == NULL)
 			return nullptr; // couldn't lock resource
 
-		return FromMemory(lpVoid, SizeofResource(hModule, hRsrc));
+		return FromMemory(lpVoid, SizeofResource(hModule, hRsrc), bCopy);
 	}
 
-	Sound* Sound::FromMemory(const void* data, size_t size)
+	Sound* Sound::FromMemory(const void* data, size_t size, bool bCopy)
 	{
-		using namespace RIFF;
-
-		constexpr FOURCC fccData = FourCC("data");
+		return FromRIFF(data, size, bCopy, nullptr);
+	}
 
-		const uint8_t* pData = static_cast<const uint8_t*>(data);
-#define OFFSET (pData - data)
-#define REMAINING(cb) (size < OFFSET + cb)
+	Sound* Sound::FromResampled(const Sound& source, uint32_t iSampleRate,
+		ResamplerQuality eQuality)
+	{
+		if (!source.m_pData)
+			return nullptr;
+
+		const auto& oSrcFormat = source.m_oWavFmt;
+		AudioResampler oResampler;
+		if (!oResampler.create(oSrcFormat.iSampleRate, iSampleRate, oSrcFormat.iChannelCount,
+			eQuality))
+			return nullptr;
+
+		// the input is followed by silence, so the filter can output the last samples
+		const size_t iLookahead = oResampler.getLookahead();
+		const size_t iDestSampleCount =
+			oResampler.getOutputSampleCount(source.m_iSampleCount + iLookahead);
+
+		WaveFormat oDestFormat = oSrcFormat;
+		oDestFormat.eBitDepth = AudioBitDepth::Audio32;
+		oDestFormat.iSampleRate = iSampleRate;
+
+		Sound* pResult = new Sound(oDestFormat, iDestSampleCount);
+		if (!pResult->m_pData)
+		{
+			delete pResult;
+			return nullptr; // invalid sample rate
+		}
+		float* pDest = reinterpret_cast<float*>(const_cast<uint8_t*>(pResult->m_pData));
 
-		pData += 0x10; // skip RIFF header, "WAVE" and "fmt "
+		constexpr size_t iBufferValues = 4096;
+		float fBuf[iBufferValues];
+		const size_t iBufferSamples = iBufferValues / oSrcFormat.iChannelCount;
 
+		size_t iSrcPos = 0;
+		size_t iSilence = iLookahead;
+		size_t iDestPos = 0;
+		while (iDestPos < iDestSampleCount)
+		{
+			size_t iInputCount;
+			if (iSrcPos < source.m_iSampleCount)
+			{
+				iInputCount = source.getSamplesAsFloat(fBuf, iSrcPos, iBufferSamples);
+				if (iInputCount == 0)
+					break; // the samples couldn't be read
+			}
+			else
+			{
+				if (iSilence == 0)
+					break; // shouldn't happen
 
-		const DWORD wHeaderSize = *reinterpret_cast<const DWORD*>(pData);
-		pData += sizeof(wHeaderSize);
+				iInputCount = std::min(iSilence, iBufferSamples);
+				memset(fBuf, 0, iInputCount * oSrcFormat.iChannelCount * sizeof(float));
+				iSilence -= iInputCount;
+			}
 
-		const WaveformHeader hdr = *reinterpret_cast<const WaveformHeader*>(pData);
-		pData += sizeof(WaveformHeader);
+			size_t iOffset = 0;
+			while (iOffset < iInputCount && iDestPos < iDestSampleCount)
+			{
+				size_t iUsed;
+				iDestPos += oResampler.process(fBuf + iOffset * oSrcFormat.iChannelCount,
+					iInputCount - iOffset, iUsed, pDest + iDestPos * oSrcFormat.iChannelCount,
+					iDestSampleCount - iDestPos);
+				iOffset += iUsed;
+			}
 
-		WORD wBitsPerSample;
-		switch (hdr.wFormatTag)
-		{
-		case (WAVE_FORMAT_PCM):
-			wBitsPerSample = *reinterpret_cast<const WORD*>(pData);
-			break;
+			iSrcPos += iInputCount;
+		}
 
-		case WAVE_FORMAT_IEEE_FLOAT:
-			wBitsPerSample = sizeof(float) * 8;
-			break;
+		return pResult;
+	}
 
-		default:
-			return nullptr; // unknown format
-		}
+	Sound* Sound::FromCompressed(const Sound& source, AudioCompression eCompression)
+	{
+		if (!source.m_pData || eCompression == AudioCompression::None)
+			return nullptr;
 
-		pData += wHeaderSize - sizeof(WaveformHeader);
+		const uint8_t iChannelCount = source.m_oWavFmt.iChannelCount;
+		const size_t iValueCount = source.m_iSampleCount * iChannelCount;
 
-		ChunkHeader chData = {};
-		while (true)
+		// get the samples as 16-bit PCM
+		std::vector<int16_t> oSamples;
+		const int16_t* pSamples;
+		if (!source.isCompressed() && source.m_oWavFmt.eBitDepth == AudioBitDepth::Audio16)
+			pSamples = reinterpret_cast<const int16_t*>(source.m_pData);
+		else
 		{
-			chData = *reinterpret_cast<const ChunkHeader*>(pData);
-			pData += sizeof(ChunkHeader);
+			oSamples.resize(iValueCount);
 
-			if (chData.ckID != fccData)
-				pData += chData.ckSize;
-			else
-				break;
-		}
+			constexpr size_t iBufferValues = 4096;
+			float fBuf[iBufferValues];
+			const size_t iBufferSamples = iBufferValues / iChannelCount;
+			for (size_t iPos = 0; iPos < source.m_iSampleCount; )
+			{
+				const size_t iCount = source.getSamplesAsFloat(fBuf, iPos, iBufferSamples);
+				if (iCount == 0)
+					return nullptr;
 
-		WaveFormat wf = {};
-		wf.eBitDepth = static_cast<AudioBitDepth>(wBitsPerSample);
-		wf.iChannelCount = (uint8_t)hdr.nChannels;
-		wf.iSampleRate = hdr.nSamplesPerSec;
+				int16_t* pDest = oSamples.data() + iPos * iChannelCount;
+				for (size_t i = 0; i < iCount * iChannelCount; ++i)
+				{
+					pDest[i] =
+						(int16_t)std::clamp(std::lround(fBuf[i] * 32768.0f), -32768L, 32767L);
+				}
+				iPos += iCount;
+			}
+			pSamples = oSamples.data();
+		}
 
-		Sound* result = new Sound(wf, chData.ckSize / hdr.nBlockAlign);
-		memcpy_s(result->m_pData, result->m_iDataSize, pData, chData.ckSize);
+		AudioCompressionFormat oCompression;
+		std::vector<uint8_t> oData;
+		if (!EncodeAudio(eCompression, pSamples, source.m_iSampleCount, iChannelCount, oCompression,
+			oData))
+			return nullptr;
+
+		auto pData = new uint8_t[oData.size()];
+		memcpy(pData, oData.data(), oData.size());
+
+		Sound* result = new Sound();
+		result->m_oWavFmt = source.m_oWavFmt;
+		result->m_oWavFmt.eBitDepth = AudioBitDepth::Audio16;
+		result->m_iSampleAlign = sizeof(int16_t) * iChannelCount;
+		result->m_iSampleCount = source.m_iSampleCount;
+		result->m_iDataSize = oData.size();
+		result->m_oCompression = oCompression;
+		result->m_pData = pData;
+		result->m_bOwnsData = true;
+		oMetricCounters.iSoundMemory += result->m_iDataSize;
 		return result;
-#undef OFFSET
 	}
 
 	void Sound::clear()
 	{
-		delete[] m_pData;
+		if (isCompressed())
+			++iDecodeGeneration;
+
+		if (m_bOwnsData)
+		{
+			delete[] m_pData;
+			oMetricCounters.iSoundMemory -= m_iDataSize;
+		}
+		else if (m_pData)
+			oMetricCounters.iSoundMemoryReferenced -= m_iDataSize;
 		m_pData = nullptr;
+		m_bOwnsData = false;
+		m_spDataOwner.reset();
+		m_spEnvelope.reset();
 
 		m_oWavFmt = {};
 		m_iSampleAlign = 0;
 		m_iSampleCount = 0;
 		m_iDataSize = 0;
+		m_oCompression = {};
 	}
 
 	bool Sound::getSample(MultiChannelAudioSample& dest, size_t iSampleID) const
@@ -872,6 +1772,15 @@ namespace rl
 		if (!m_pData || iSampleID >= m_iSampleCount)
 			return false;
 
+		const uint8_t* pSample = m_pData + iSampleID * m_iSampleAlign;
+		if (isCompressed())
+		{
+			size_t iCount = 0;
+			pSample = reinterpret_cast<const uint8_t*>(decodeSamples(iSampleID, iCount));
+			if (!pSample)
+				return false;
+		}
+
 #define CASE(bits)																\
 		case AudioBitDepth::Audio##bits:										\
 			dest.val.p##bits = new audio##bits##_t[m_oWavFmt.iChannelCount];	\
@@ -888,8 +1797,64 @@ namespace rl
 
 #undef CASE
 
-		memcpy_s(dest.val.p8, m_iSampleAlign, m_pData + iSampleID * m_iSampleAlign, m_iSampleAlign);
+		dest.iBitsPerSample = (uint8_t)m_oWavFmt.eBitDepth;
+		dest.iChannelCount = m_oWavFmt.iChannelCount;
+		memcpy_s(dest.val.p8, m_iSampleAlign, pSample, m_iSampleAlign);
+
+		return true;
+	}
+
+	size_t Sound::getSamplesAsFloat(float* pDest, size_t iFirstSample,
+		size_t iSampleCount) const noexcept
+	{
+		if (!m_pData || iFirstSample >= m_iSampleCount)
+			return 0;
+
+		if (iSampleCount > m_iSampleCount - iFirstSample)
+			iSampleCount = m_iSampleCount - iFirstSample;
+
+		if (!isCompressed())
+		{
+			PCMToFloat(m_pData + iFirstSample * m_iSampleAlign, m_oWavFmt.eBitDepth,
+				iSampleCount * m_oWavFmt.iChannelCount, pDest);
+			return iSampleCount;
+		}
+
+		size_t iDone = 0;
+		while (iDone < iSampleCount)
+		{
+			size_t iCount = 0;
+			const int16_t* pSamples = decodeSamples(iFirstSample + iDone, iCount);
+			if (!pSamples)
+				break; // invalid data
+
+			iCount = std::min(iCount, iSampleCount - iDone);
+			PCMToFloat(reinterpret_cast<const uint8_t*>(pSamples), AudioBitDepth::Audio16,
+				iCount * m_oWavFmt.iChannelCount, pDest + iDone * m_oWavFmt.iChannelCount);
+			iDone += iCount;
+		}
+
+		return iDone;
+	}
+
+	size_t Sound::getBlockCount() const noexcept
+	{
+		return GetCompressedBlockCount(m_oCompression, m_pData, m_iDataSize);
+	}
+
+	size_t Sound::decodeBlock(size_t iBlock, int16_t* pDest) const noexcept
+	{
+		return DecodeAudioBlock(m_oCompression, m_oWavFmt.iChannelCount, m_pData, m_iDataSize,
+			iBlock, pDest);
+	}
+
+	bool Sound::setEnvelope(std::shared_ptr<const AudioEnvelope> spEnvelope) noexcept
+	{
+		if (spEnvelope && (spEnvelope->getSampleCount() != m_iSampleCount ||
+			spEnvelope->getChannelCount() != m_oWavFmt.iChannelCount))
+			return false;
 
+		m_spEnvelope = std::move(spEnvelope);
 		return true;
 	}
 
@@ -901,12 +1866,147 @@ namespace rl
 		return new SoundInstance(*this, volume);
 	}
 
-	SoundInstance3D* Sound::play3D(const Audio3DPos& pos, float volume)
+	SoundInstance3D* Sound::play3D(const Audio3DPos& pos, float volume, bool bVirtual)
 	{
 		if (volume < 0.0f)
 			volume = 0.0f;
 
-		return new SoundInstance3D(*this, volume, pos);
+		return new SoundInstance3D(*this, volume, pos, bVirtual);
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	Sound* Sound::FromRIFF(const void* data, size_t size, bool bCopy,
+		std::shared_ptr<const void> spOwner)
+	{
+		RIFF::WaveInfo oInfo;
+		if (!data || !RIFF::ParseWave(data, size, oInfo))
+			return nullptr; // invalid or unsupported data
+
+		const bool bCompressed = oInfo.oCompression.eCompression != AudioCompression::None;
+		size_t iSampleCount = bCompressed ?
+			GetCompressedSampleCount(oInfo.oCompression, oInfo.oFormat.iChannelCount, oInfo.pData,
+				oInfo.iDataSize) :
+			oInfo.iDataSize / oInfo.wBlockAlign;
+		if (bCompressed && iSampleCount == 0)
+			return nullptr; // no complete block
+		if (bCompressed && oInfo.iSampleCount > 0 && oInfo.iSampleCount < iSampleCount)
+			iSampleCount = oInfo.iSampleCount; // padding in the last block
+
+		if (bCopy && !bCompressed)
+		{
+			Sound* result = new Sound(oInfo.oFormat, iSampleCount);
+			memcpy_s(const_cast<uint8_t*>(result->m_pData), result->m_iDataSize, oInfo.pData,
+				oInfo.iDataSize);
+			return result;
+		}
+
+		Sound* result = new Sound();
+		result->m_oWavFmt = oInfo.oFormat;
+		result->m_iSampleAlign = oInfo.wBlockAlign;
+		result->m_iSampleCount = iSampleCount;
+		result->m_iDataSize = oInfo.iDataSize;
+		result->m_oCompression = oInfo.oCompression;
+
+		if (bCopy)
+		{
+			auto pData = new uint8_t[oInfo.iDataSize];
+			memcpy(pData, oInfo.pData, oInfo.iDataSize);
+			result->m_pData = pData;
+			result->m_bOwnsData = true;
+			oMetricCounters.iSoundMemory += result->m_iDataSize;
+			return result;
+		}
+
+		result->m_pData = oInfo.pData;
+		result->m_bOwnsData = false;
+		result->m_spDataOwner = std::move(spOwner);
+		oMetricCounters.iSoundMemoryReferenced += result->m_iDataSize;
+		return result;
+	}
+
+	bool Sound::reference(const WaveFormat& oFormat, const AudioCompressionFormat& oCompression,
+		size_t iSampleCount, const uint8_t* pData, size_t iDataSize,
+		std::shared_ptr<const void> spOwner)
+	{
+		clear();
+
+		if (!pData || iSampleCount == 0 || !ValidWaveFormat(oFormat))
+			return false;
+
+		switch (oFormat.eBitDepth)
+		{
+		case AudioBitDepth::Audio8:
+		case AudioBitDepth::Audio16:
+		case AudioBitDepth::Audio24:
+		case AudioBitDepth::Audio32:
+			break;
+
+		default:
+			return false; // unsupported bit depth
+		}
+
+		const size_t iSampleAlign = (size_t)oFormat.eBitDepth / 8 * oFormat.iChannelCount;
+		if (oCompression.eCompression == AudioCompression::None)
+		{
+			if (iDataSize / iSampleAlign < iSampleCount)
+				return false; // not enough data
+			iDataSize = iSampleCount * iSampleAlign;
+		}
+		else if (oFormat.eBitDepth != AudioBitDepth::Audio16 ||
+			!ValidCompressionFormat(oCompression, oFormat.iChannelCount) ||
+			GetCompressedSampleCount(oCompression, oFormat.iChannelCount, pData, iDataSize) <
+			iSampleCount)
+			return false; // invalid compressed data
+
+		m_oWavFmt = oFormat;
+		m_iSampleAlign = iSampleAlign;
+		m_iSampleCount = iSampleCount;
+		m_iDataSize = iDataSize;
+		m_oCompression = oCompression;
+		m_pData = pData;
+		m_bOwnsData = false;
+		m_spDataOwner = std::move(spOwner);
+		oMetricCounters.iSoundMemoryReferenced += m_iDataSize;
+		return true;
+	}
+
+	const int16_t* Sound::decodeSamples(size_t iFirstSample, size_t& iSampleCount) const noexcept
+	{
+		iSampleCount = 0;
+		if (!isCompressed() || iFirstSample >= m_iSampleCount)
+			return nullptr;
+
+		auto& oCache = tls_oDecodedBlock;
+		const uint64_t iGeneration = iDecodeGeneration.load(std::memory_order_relaxed);
+		const size_t iBlock = iFirstSample / m_oCompression.iSamplesPerBlock;
+
+		if (oCache.pData != m_pData || oCache.iGeneration != iGeneration ||
+			oCache.iBlock != iBlock)
+		{
+			oCache.pData = nullptr;
+			oCache.oSamples.resize(
+				(size_t)m_oCompression.iSamplesPerBlock * m_oWavFmt.iChannelCount);
+			oCache.iSampleCount = decodeBlock(iBlock, oCache.oSamples.data());
+			if (oCache.iSampleCount == 0)
+				return nullptr;
+
+			oCache.pData = m_pData;
+			oCache.iGeneration = iGeneration;
+			oCache.iBlock = iBlock;
+		}
+
+		const size_t iOffset = iFirstSample - iBlock * m_oCompression.iSamplesPerBlock;
+		if (iOffset >= oCache.iSampleCount)
+			return nullptr;
+
+		iSampleCount = oCache.iSampleCount - iOffset;
+		return oCache.oSamples.data() + iOffset * m_oWavFmt.iChannelCount;
 	}
 
 
@@ -922,6 +2022,31 @@ namespace rl
 	 class SoundInstance
 	***********************************************************************************************/
 
+	//==============================================================================================
+	// TYPES
+
+	/// <summary>
+	/// A ring of PCM buffers a compressed sound is decoded into during playback<para/>
+	/// A buffer is refilled as soon as XAudio2 is done with it (<c>OnBufferEnd</c>), so only a few
+	/// blocks of the sound are decoded at any time.
+	/// </summary>
+	struct SoundInstance::DecodeCache
+	{
+		static constexpr uint8_t BufferCount = 3;
+		static constexpr size_t MinBufferSamples = 2048; // per buffer
+
+		const Sound* pSound;
+		size_t iBlockCount;
+		size_t iBlocksPerBuffer;
+		size_t iNextBlock = 0;
+		size_t iSkipSamples = 0; // samples to skip at the start of the next buffer
+		std::vector<int16_t> oBuffers[BufferCount];
+	};
+
+
+
+
+
 	//==============================================================================================
 	// METHODS
 
@@ -930,7 +2055,7 @@ namespace rl
 	// CONSTRUCTORS, DESTRUCTORS
 
 	SoundInstance::SoundInstance(const Sound& sound, float volume) :
-		m_eType(SoundInstanceType::Default), m_fVolume(volume)
+		m_eType(SoundInstanceType::Default), m_fVolume(volume), m_pSound(&sound)
 	{
 
 		auto wf = CreateWaveFormatEx(sound.getWaveFormat());
@@ -947,7 +2072,11 @@ namespace rl
 		pVoice->Start();
 	}
 
-	SoundInstance::~SoundInstance() { stop(); }
+	SoundInstance::~SoundInstance()
+	{
+		stop();
+		delete m_pDecodeCache;
+	}
 
 
 
@@ -963,6 +2092,13 @@ namespace rl
 		if (!m_bPlaying || m_bPaused)
 			return;
 
+		if (m_bVirtual)
+		{
+			m_iVirtualPos = getVirtualPos();
+			m_bPaused = true;
+			return;
+		}
+
 		m_pSourceVoice->getPtr()->Stop();
 		m_bPaused = true;
 	}
@@ -974,6 +2110,13 @@ namespace rl
 		if (!m_bPlaying || !m_bPaused)
 			return;
 
+		if (m_bVirtual)
+		{
+			m_tpVirtualPos = std::chrono::steady_clock::now();
+			m_bPaused = false;
+			return;
+		}
+
 		m_pSourceVoice->getPtr()->Start();
 		m_bPaused = false;
 	}
@@ -982,15 +2125,24 @@ namespace rl
 	{
 		std::unique_lock lm(m_mux);
 
+		if (m_bVirtual)
+		{
+			m_bVirtual = false;
+			m_bPlaying = false;
+			m_bPaused = false;
+			return;
+		}
+
 		if (!m_bVoiceExists)
 			return;
 
 		m_pSourceVoice->getPtr()->Stop();
 
-		destroyVoices();
-
+		// pause() and resume() return early from now on
 		m_bPlaying = false;
 		m_bPaused = false;
+
+		destroyVoicesAndWait(lm);
 	}
 
 	void SoundInstance::waitForEnd()
@@ -999,6 +2151,19 @@ namespace rl
 			return;
 
 		std::unique_lock lm(m_mux);
+		while (m_bVirtual && m_bPlaying && !m_bPaused)
+		{
+			// no voice that could report the end --> wait until the end of the sound is reached
+			if (checkVirtualEnd())
+				return;
+
+			const double dRemaining = double(m_pSound->getSampleCount() - getVirtualPos()) /
+				m_pSound->getWaveFormat().iSampleRate;
+			m_cv.wait_for(lm, std::chrono::duration<double>(dRemaining));
+		}
+		if (!m_bPlaying || m_bPaused)
+			return;
+
 		m_cv.wait(lm);
 	}
 
@@ -1028,12 +2193,71 @@ namespace rl
 		m_bVoiceExists = false;
 	}
 
-	bool SoundInstance::loadSound(const Sound& sound)
+	void SoundInstance::destroyVoicesAndWait(std::unique_lock<std::mutex>& lm)
+	{
+		m_bVoiceExists = false;
+
+		// The callbacks (OnBufferEnd --> submitDecoded(), OnStreamEnd --> onEnd()) use the source
+		// voice and the decode cache. Voice::destroy() would only post the destruction to the
+		// engine thread, so wait until the voice was destroyed before anything is deleted.
+		lm.unlock();
+		m_pSourceVoice->destroyAndWait();
+		lm.lock();
+
+		delete m_pSourceVoice; // already removed from its parent voices
+		m_pSourceVoice = nullptr;
+		destroyVoices();
+
+		delete m_pDecodeCache;
+		m_pDecodeCache = nullptr;
+	}
+
+	bool SoundInstance::loadSound(const Sound& sound, size_t iFirstSample)
 	{
+		if (iFirstSample >= sound.getSampleCount())
+			return false;
+
+		if (sound.isCompressed())
+		{
+			const auto& oCompression = sound.getCompressionFormat();
+			const size_t iBlockCount = std::min(sound.getBlockCount(),
+				(sound.getSampleCount() + oCompression.iSamplesPerBlock - 1) /
+				oCompression.iSamplesPerBlock);
+			if (iBlockCount == 0)
+				return false;
+
+			m_pDecodeCache = new DecodeCache();
+			m_pDecodeCache->pSound = &sound;
+			m_pDecodeCache->iBlockCount = iBlockCount;
+			m_pDecodeCache->iNextBlock = iFirstSample / oCompression.iSamplesPerBlock;
+			m_pDecodeCache->iSkipSamples = iFirstSample % oCompression.iSamplesPerBlock;
+			m_pDecodeCache->iBlocksPerBuffer =
+				(DecodeCache::MinBufferSamples + oCompression.iSamplesPerBlock - 1) /
+				oCompression.iSamplesPerBlock;
+			for (auto& oBuffer : m_pDecodeCache->oBuffers)
+			{
+				oBuffer.resize(m_pDecodeCache->iBlocksPerBuffer * oCompression.iSamplesPerBlock *
+					sound.getWaveFormat().iChannelCount);
+			}
+
+			m_pSourceVoice->OnBufferEnd = [this](void* pBufferContext)
+			{
+				submitDecoded((uint8_t)reinterpret_cast<uintptr_t>(pBufferContext));
+			};
+
+			for (uint8_t iBuffer = 0; iBuffer < DecodeCache::BufferCount; ++iBuffer)
+			{
+				if (m_pDecodeCache->iNextBlock < iBlockCount && !submitDecoded(iBuffer))
+					return false;
+			}
+			return true;
+		}
+
 		XAUDIO2_BUFFER buf = {};
 		buf.AudioBytes = (UINT32)sound.getDataSize();
 		buf.Flags = XAUDIO2_END_OF_STREAM;
 		buf.pAudioData = (BYTE*)sound.getDataPtr();
+		buf.PlayBegin = (UINT32)iFirstSample;
 
 		auto pVoice = m_pSourceVoice->getPtr();
 		HRESULT hr = pVoice->SubmitSourceBuffer(&buf);
@@ -1050,29 +2274,178 @@ namespace rl
 		m_cv.notify_all();
 	}
 
+	void SoundInstance::startVirtual()
+	{
+		std::unique_lock lm(m_mux);
 
+		m_iVirtualPos = 0;
+		m_tpVirtualPos = std::chrono::steady_clock::now();
+		m_bVirtual = true;
+		m_bPaused = false;
+		m_bPlaying = true;
+	}
 
+	bool SoundInstance::virtualize()
+	{
+		std::unique_lock lm(m_mux);
 
+		if (!m_bVoiceExists || !m_bPlaying)
+			return false;
 
+		auto pVoice = m_pSourceVoice->getPtr();
+		pVoice->Stop();
+		XAUDIO2_VOICE_STATE oState{};
+		pVoice->GetState(&oState);
 
+		// pause() and resume() only use the virtual play position from now on
+		m_iVirtualPos = m_iStartSample + (size_t)oState.SamplesPlayed;
+		m_tpVirtualPos = std::chrono::steady_clock::now();
+		m_bVirtual = true;
 
+		destroyVoicesAndWait(lm);
+		return true;
+	}
 
+	bool SoundInstance::devirtualize()
+	{
+		std::unique_lock lm(m_mux);
 
+		// the voices of a virtualize() call might still be waiting for their callbacks
+		if (!m_bVirtual || m_pSourceVoice || checkVirtualEnd())
+			return false;
 
-	/***********************************************************************************************
-	 class SoundInstance3D
-	***********************************************************************************************/
+		const size_t iPos = getVirtualPos();
+		auto wf = CreateWaveFormatEx(m_pSound->getWaveFormat());
+		if (!createVoices(wf))
+			return false; // stays virtual
+		if (!loadSound(*m_pSound, iPos))
+		{
+			destroyVoices();
+			delete m_pDecodeCache;
+			m_pDecodeCache = nullptr;
+			return false; // stays virtual
+		}
 
-	//==============================================================================================
-	// METHODS
+		m_iStartSample = iPos;
+		m_bVirtual = false;
 
+		auto pVoice = m_pSourceVoice->getPtr();
+		pVoice->SetVolume(m_fVolume);
+		if (!m_bPaused)
+			pVoice->Start();
+		return true;
+	}
 
-	//----------------------------------------------------------------------------------------------
-	// CONSTRUCTORS, DESTRUCTORS
+	void SoundInstance::updateVirtual()
+	{
+		std::unique_lock lm(m_mux);
+
+		if (m_bVirtual)
+			checkVirtualEnd();
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	bool SoundInstance::submitDecoded(uint8_t iBuffer)
+	{
+		auto& oCache = *m_pDecodeCache;
+		if (oCache.iNextBlock >= oCache.iBlockCount)
+			return true; // end of stream already submitted
+
+		const Sound& sound = *oCache.pSound;
+		const size_t iSamplesPerBlock = sound.getCompressionFormat().iSamplesPerBlock;
+		const uint8_t iChannelCount = sound.getWaveFormat().iChannelCount;
+
+		int16_t* pDest = oCache.oBuffers[iBuffer].data();
+		const size_t iFirstSample = oCache.iNextBlock * iSamplesPerBlock;
+		size_t iSampleCount = 0;
+		for (size_t i = 0; i < oCache.iBlocksPerBuffer && oCache.iNextBlock < oCache.iBlockCount;
+			++i, ++oCache.iNextBlock)
+		{
+			int16_t* pBlock = pDest + iSampleCount * iChannelCount;
+			size_t iCount = sound.decodeBlock(oCache.iNextBlock, pBlock);
+			if (iCount == 0)
+			{
+				// invalid block --> silence, so the length of the sound is kept
+				iCount = std::min(iSamplesPerBlock,
+					sound.getSampleCount() - oCache.iNextBlock * iSamplesPerBlock);
+				memset(pBlock, 0, iCount * iChannelCount * sizeof(int16_t));
+			}
+			iSampleCount += iCount;
+		}
+
+		// the last block might contain padding
+		iSampleCount = std::min(iSampleCount, sound.getSampleCount() - iFirstSample);
+
+		XAUDIO2_BUFFER buf = {};
+		buf.AudioBytes = (UINT32)(iSampleCount * iChannelCount * sizeof(int16_t));
+		buf.pAudioData = reinterpret_cast<const BYTE*>(pDest);
+		buf.pContext = reinterpret_cast<void*>(uintptr_t(iBuffer));
+		if (oCache.iNextBlock >= oCache.iBlockCount)
+			buf.Flags = XAUDIO2_END_OF_STREAM;
+		buf.PlayBegin = (UINT32)oCache.iSkipSamples;
+		oCache.iSkipSamples = 0;
+
+		return SUCCEEDED(m_pSourceVoice->getPtr()->SubmitSourceBuffer(&buf));
+	}
+
+	size_t SoundInstance::getVirtualPos() const
+	{
+		if (m_bPaused)
+			return m_iVirtualPos;
+
+		const double dElapsed = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - m_tpVirtualPos).count();
+		return m_iVirtualPos + (size_t)(dElapsed * m_pSound->getWaveFormat().iSampleRate);
+	}
 
-	SoundInstance3D::SoundInstance3D(const Sound& sound, float volume, const Audio3DPos& pos) :
-		SoundInstance(SoundInstanceType::Surround, volume), m_o3DPos(pos)
+	bool SoundInstance::checkVirtualEnd()
 	{
+		if (getVirtualPos() < m_pSound->getSampleCount())
+			return false;
+
+		m_bVirtual = false;
+		m_bPlaying = false;
+		m_bPaused = false;
+		m_cv.notify_all();
+		return true;
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class SoundInstance3D
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	SoundInstance3D::SoundInstance3D(const Sound& sound, float volume, const Audio3DPos& pos,
+		bool bVirtual) :
+		SoundInstance(sound, SoundInstanceType::Surround, volume), m_o3DPos(pos)
+	{
+		if (bVirtual)
+		{
+			startVirtual();
+			return;
+		}
+
 		auto wf = CreateWaveFormatEx(sound.getWaveFormat());
 
 		if (!createVoices(wf) || !loadSound(sound))
@@ -1096,13 +2469,24 @@ namespace rl
 
 	void SoundInstance3D::set3DPos(const Audio3DPos& pos)
 	{
+		m_o3DPos = pos; // virtual instances use it when they get a voice again
 		if (!m_bVoiceExists)
 			return;
 
-		m_o3DPos = pos;
 		applyPos();
 	}
 
+	void SoundInstance3D::set3DPos(const Audio3DPos& pos, AudioEngine::ParameterBatch& batch)
+	{
+		m_o3DPos = pos;
+		if (!m_bVoiceExists)
+			return;
+
+		SurroundStructToFloatMatrix(m_o3DPos, m_fSurroundVolume);
+		batch.setOutputMatrix(*m_pSubmixVoice_Mono, m_pSubmixVoice_Surround, 1, 8,
+			m_fSurroundVolume);
+	}
+
 
 
 
@@ -1174,6 +2558,223 @@ namespace rl
 			m_fSurroundVolume);
 	}
 
+	bool SoundInstance3D::applyMatrix(const float* pMatrix, float fThreshold,
+		UINT32 iOperationSet)
+	{
+		if (!m_bVoiceExists)
+			return false;
+
+		bool bChanged = false;
+		for (uint8_t i = 0; i < 8; ++i)
+		{
+			if (std::fabs(pMatrix[i] - m_fSurroundVolume[i]) >= fThreshold)
+			{
+				bChanged = true;
+				break;
+			}
+		}
+		if (!bChanged)
+			return false;
+
+		memcpy(m_fSurroundVolume, pMatrix, sizeof(m_fSurroundVolume));
+		m_pSubmixVoice_Mono->getPtr()->SetOutputMatrix(m_pSubmixVoice_Surround->getPtr(), 1, 8,
+			m_fSurroundVolume, iOperationSet);
+		return true;
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class AudioWorkerPool
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// STATIC METHODS
+
+	AudioWorkerPool& AudioWorkerPool::GetInstance()
+	{
+		static AudioWorkerPool oInstance;
+		return oInstance;
+	}
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	AudioWorkerPool::AudioWorkerPool()
+	{
+		// audio generation is usually cheap --> a few threads are enough
+		const size_t iHardwareThreads = std::thread::hardware_concurrency();
+		m_iThreadCount = std::clamp<size_t>(iHardwareThreads / 4, 1, 4);
+	}
+
+	AudioWorkerPool::~AudioWorkerPool()
+	{
+		{
+			std::unique_lock lm(m_mux);
+			m_bQuit = true;
+		}
+		m_cvWork.notify_all();
+
+		for (auto& trd : m_oThreads)
+		{
+			trd.join();
+		}
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	bool AudioWorkerPool::setThreadCount(size_t iThreadCount)
+	{
+		if (iThreadCount == 0)
+			return false;
+
+		std::unique_lock lm(m_mux);
+		if (!m_oStreams.empty())
+			return false; // streams are running
+
+		if (iThreadCount == m_iThreadCount)
+			return true;
+
+		// stop the current threads, they're restarted on demand
+		m_bQuit = true;
+		lm.unlock();
+		m_cvWork.notify_all();
+		for (auto& trd : m_oThreads)
+		{
+			trd.join();
+		}
+		lm.lock();
+
+		m_oThreads.clear();
+		m_bQuit = false;
+		m_iThreadCount = iThreadCount;
+		return true;
+	}
+
+	size_t AudioWorkerPool::getThreadCount() const
+	{
+		std::unique_lock lm(m_mux);
+		return m_iThreadCount;
+	}
+
+	double AudioWorkerPool::getMaxQueuedTime() const
+	{
+		std::unique_lock lm(m_mux);
+
+		double dResult = 0.0;
+		for (auto pStream : m_oStreams)
+		{
+			if (pStream->m_bRunning)
+				dResult = std::max(dResult, pStream->getQueuedTime());
+		}
+		return dResult;
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void AudioWorkerPool::add(IAudioStream* pStream)
+	{
+		{
+			std::unique_lock lm(m_mux);
+			m_oStreams.push_back(pStream);
+
+			while (m_oThreads.size() < m_iThreadCount)
+			{
+				m_oThreads.emplace_back(&AudioWorkerPool::workerFunc, this);
+			}
+		}
+		m_cvWork.notify_one();
+	}
+
+	void AudioWorkerPool::remove(IAudioStream* pStream)
+	{
+		std::unique_lock lm(m_mux);
+
+		auto it = std::find(m_oStreams.begin(), m_oStreams.end(), pStream);
+		if (it == m_oStreams.end())
+			return;
+
+		m_cvIdle.wait(lm, [&] { return !pStream->m_bInWork; });
+		m_oStreams.erase(std::find(m_oStreams.begin(), m_oStreams.end(), pStream));
+	}
+
+	void AudioWorkerPool::notify()
+	{
+		// lock so the notification can't get lost between a worker's check and its wait
+		{
+			std::unique_lock lm(m_mux);
+		}
+		m_cvWork.notify_one();
+	}
+
+	void AudioWorkerPool::workerFunc()
+	{
+		std::unique_lock lm(m_mux);
+		while (true)
+		{
+			IAudioStream* pStream = nullptr;
+			m_cvWork.wait(lm, [&] { return m_bQuit || (pStream = nextStream()) != nullptr; });
+			if (m_bQuit)
+				break;
+
+			pStream->m_bInWork = true;
+			lm.unlock();
+
+			pStream->processBlock();
+
+			lm.lock();
+			pStream->m_bInWork = false;
+			m_cvIdle.notify_all();
+		}
+	}
+
+	IAudioStream* AudioWorkerPool::nextStream() const
+	{
+		IAudioStream* pResult = nullptr;
+		double dResultQueued = 0.0;
+
+		for (auto pStream : m_oStreams)
+		{
+			if (pStream->m_bInWork || !pStream->m_bRunning || pStream->m_iFreeBlocks == 0)
+				continue;
+
+			// earliest deadline first
+			const double dQueued = pStream->getQueuedTime();
+			if (!pResult || dQueued < dResultQueued)
+			{
+				pResult = pStream;
+				dResultQueued = dQueued;
+			}
+		}
+
+		return pResult;
+	}
+
 
 
 
@@ -1238,10 +2839,18 @@ namespace rl
 			return;
 
 		m_bRunning = false;
+		AudioWorkerPool::GetInstance().remove(this);
 
-		if (m_trdSampleGeneration.joinable())
-			m_trdSampleGeneration.join();
+		m_bPaused = false;
+		if (m_bVoiceStarted && !m_bEndOfStream) // --> not stopped by XAUDIO2_END_OF_STREAM
+		{
+			auto ptr = m_pSourceVoice->getPtr();
+			ptr->Stop();
+			ptr->FlushSourceBuffers();
+		}
 
+		// OnBufferEnd might still be running, the callback and the buffer must outlive it
+		m_pSourceVoice->destroyAndWait();
 		delete m_pSourceVoice;
 		m_pSourceVoice = nullptr;
 
@@ -1249,6 +2858,27 @@ namespace rl
 		m_pBuffer = nullptr;
 	}
 
+	AudioStreamStats IAudioStream::getStats() const noexcept
+	{
+		AudioStreamStats result{};
+		result.iBlocksGenerated = m_iStatBlocks;
+		result.iUnderruns = m_iStatUnderruns;
+		result.dTotalGenerationTime = m_iStatTotalNS / 1e9;
+		result.dMaxGenerationTime = m_iStatMaxNS / 1e9;
+		result.dLastGenerationTime = m_iStatLastNS / 1e9;
+		return result;
+	}
+
+	uint64_t IAudioStream::getPlayedSamples() const
+	{
+		if (!m_pSourceVoice)
+			return 0;
+
+		XAUDIO2_VOICE_STATE state{};
+		m_pSourceVoice->getPtr()->GetState(&state);
+		return state.SamplesPlayed;
+	}
+
 
 
 
@@ -1274,8 +2904,17 @@ namespace rl
 		m_fVolume = volume;
 		m_iBlockCount = BufferBlockCount;
 		m_iSamplesPerBlock = SamplesPerBufferBlock;
-		m_iBlockSize = m_iSamplesPerBlock * m_iByteDepth;
+		m_iBlockSize = m_iSamplesPerBlock * m_oFormat.iChannelCount * m_iByteDepth;
 		m_iFreeBlocks = m_iBlockCount;
+		m_iCurrentBlock = 0;
+		m_fTimePerSample = 1.0f / m_oFormat.iSampleRate;
+		m_iSampleAlign = m_oFormat.iChannelCount * m_iByteDepth;
+
+		m_iStatBlocks = 0;
+		m_iStatUnderruns = 0;
+		m_iStatTotalNS = 0;
+		m_iStatMaxNS = 0;
+		m_iStatLastNS = 0;
 
 		m_pBuffer = new uint8_t[m_iBlockCount * m_iBlockSize];
 
@@ -1286,51 +2925,73 @@ namespace rl
 		m_pSourceVoice->OnBufferEnd = [&](void* pBufferContext)
 		{
 			++m_iFreeBlocks;
-			m_cv.notify_one();
+			AudioWorkerPool::GetInstance().notify();
 		};
 
-		m_trdSampleGeneration = std::thread(&rl::IAudioStream::threadFunc, this);
+		m_bVoiceStarted = false;
+		m_bEndOfStream = false;
+		m_bPaused = false;
+		m_bRunning = true;
+		AudioWorkerPool::GetInstance().add(this);
 	}
 
+	size_t IAudioStream::nextSamples(uint8_t* pDest, size_t iSampleCount) noexcept
+	{
+		rl::MultiChannelAudioSample sample = {};
+		sample.iBitsPerSample = static_cast<uint8_t>(m_oFormat.eBitDepth);
+		sample.iChannelCount = m_oFormat.iChannelCount;
 
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			if (!m_bRunning)
+				return i;
 
+			sample.val.p8 = pDest + i * m_iSampleAlign;
+			if (!nextSample(m_fTimePerSample, sample))
+				return i;
+		}
 
+		return iSampleCount;
+	}
 
-	//----------------------------------------------------------------------------------------------
-	// PRIVATE METHODS
-
-	void IAudioStream::threadFunc()
-	{
-		m_fTimePerSample = 1.0f / m_oFormat.iSampleRate;
-		m_iSampleAlign = m_oFormat.iChannelCount * m_iByteDepth;
 
-		m_bRunning = true;
-		m_bPaused = false;
 
-		// fill buffers at startup
-		for (size_t i = 0; m_bRunning && i < m_iBlockCount; ++i)
-		{
-			fillBlock();
-		}
 
-		m_pSourceVoice->getPtr()->Start();
 
-		while (m_bRunning)
-		{
-			if (m_iFreeBlocks == 0)
-			{
-				std::unique_lock lm(m_mux);
-				m_cv.wait(lm);
-			}
-			fillBlock();
-		}
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
 
-		m_bPaused = false;
-		auto ptr = m_pSourceVoice->getPtr();
-		if (!m_bEndOfStream) // --> not stopped by XAUDIO2_END_OF_STREAM
+	void IAudioStream::processBlock()
+	{
+		// all buffers played --> the stream couldn't keep up
+		const bool bUnderrun = m_bVoiceStarted && !m_bPaused && m_iFreeBlocks == m_iBlockCount;
+
+		const auto tpStart = std::chrono::steady_clock::now();
+		fillBlock();
+		const uint64_t iNS = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - tpStart).count();
+
+		++m_iStatBlocks;
+		if (bUnderrun)
+			++m_iStatUnderruns;
+
+		oMetricCounters.iStreamBlocks.fetch_add(1, std::memory_order_relaxed);
+		if (bUnderrun)
+			oMetricCounters.iStreamUnderruns.fetch_add(1, std::memory_order_relaxed);
+		oMetricCounters.oFillTime.add(iNS);
+		const double dBlockNS = 1e9 * m_iSamplesPerBlock / m_oFormat.iSampleRate;
+		oMetricCounters.oFillRatio.add((uint64_t)(iNS * 10000.0 / dBlockNS));
+		m_iStatTotalNS += iNS;
+		m_iStatLastNS = iNS;
+		if (iNS > m_iStatMaxNS)
+			m_iStatMaxNS = iNS; // only one worker at a time --> no race
+
+		// start playback as soon as all buffers are filled at startup
+		if (!m_bVoiceStarted && (m_iFreeBlocks == 0 || !m_bRunning))
 		{
-			ptr->Stop();
-			ptr->FlushSourceBuffers();
+			if (!m_bPaused)
+				m_pSourceVoice->getPtr()->Start();
+			m_bVoiceStarted = true;
 		}
 	}
 
@@ -1339,24 +3000,17 @@ namespace rl
 		--m_iFreeBlocks;
 
 		XAUDIO2_BUFFER buf = {};
-		buf.AudioBytes = (UINT32)(m_iSamplesPerBlock * m_oFormat.iChannelCount * m_iByteDepth);
+		buf.AudioBytes = (UINT32)m_iBlockSize;
 		auto pData = &m_pBuffer[m_iCurrentBlock * m_iBlockSize];
 		memset(pData, 0, buf.AudioBytes);
 		buf.pAudioData = pData;
-		for (size_t i = 0; i < m_iSamplesPerBlock; ++i)
-		{
-			rl::MultiChannelAudioSample sample = {};
-			sample.iBitsPerSample = static_cast<uint8_t>(m_oFormat.eBitDepth);
-			sample.iChannelCount = m_oFormat.iChannelCount;
-			sample.val.p8 = pData + i * m_iSampleAlign;
 
-			if (!m_bRunning)
-				break;
-			m_bEndOfStream = !nextSample(m_fTimePerSample, sample);
+		if (m_bRunning)
+		{
+			const size_t iWritten = nextSamples(pData, m_iSamplesPerBlock);
 
+			m_bEndOfStream = m_bRunning && iWritten < m_iSamplesPerBlock;
 			m_bRunning = m_bRunning && !m_bEndOfStream;
-			if (!m_bRunning)
-				break;
 		}
 		if (!m_bRunning)
 			buf.Flags = XAUDIO2_END_OF_STREAM;
@@ -1365,6 +3019,365 @@ namespace rl
 
 		++m_iCurrentBlock;
 		m_iCurrentBlock %= m_iBlockCount;
-	}\
+	}
+
+	double IAudioStream::getQueuedTime() const noexcept
+	{
+		const size_t iQueuedBlocks = m_iBlockCount - m_iFreeBlocks;
+		return (double)iQueuedBlocks * m_iSamplesPerBlock * m_fTimePerSample;
+	}
+
+
+
+
+
+
+
+
+
+
+	/***********************************************************************************************
+	 class WaveFileStream
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	WaveFileStream::~WaveFileStream() { close(); }
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	bool WaveFileStream::open(const wchar_t* szFileName, size_t ReadBlockCount,
+		size_t SamplesPerReadBlock)
+	{
+		close();
+
+		if (ReadBlockCount < 2 || SamplesPerReadBlock == 0)
+			return false;
+
+		HANDLE hFile = CreateFileW(szFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false; // couldn't open file
+
+		WORD wBlockAlign = 0;
+		uint64_t iDataSize = 0;
+		if (!RIFF::ParseWaveFile(hFile, m_oFormat, wBlockAlign, m_iDataOffset, iDataSize) ||
+			iDataSize == 0)
+		{
+			CloseHandle(hFile);
+			m_oFormat = {};
+			return false; // invalid, unsupported or empty waveform
+		}
+
+		m_hFile = hFile;
+		m_iSampleAlign = wBlockAlign;
+		m_iSampleCount = (size_t)(iDataSize / wBlockAlign);
+		m_iSamplesPerBlock = SamplesPerReadBlock;
+
+		m_oBlocks.resize(ReadBlockCount);
+		for (auto& oBlock : m_oBlocks)
+		{
+			oBlock.upData = std::make_unique<uint8_t[]>(m_iSamplesPerBlock * m_iSampleAlign);
+			oBlock.iSampleCount = 0;
+			oBlock.iConsumed = 0;
+		}
+
+		m_iReadyFront = 0;
+		m_iReadyCount = 0;
+		m_iReadPos = 0;
+		m_iPlayPos = 0;
+		m_bReadEnd = false;
+		m_bSeekPending = false;
+		m_bQuitIO = false;
+		m_iUnderruns = 0;
+
+		m_trdIO = std::thread(&rl::WaveFileStream::ioThreadFunc, this);
+
+		return true;
+	}
+
+	void WaveFileStream::close()
+	{
+		stop(); // the audio stream must not access the blocks anymore
+
+		if (m_trdIO.joinable())
+		{
+			std::unique_lock lm(m_muxIO);
+			m_bQuitIO = true;
+			lm.unlock();
+			m_cvIO.notify_all();
+
+			m_trdIO.join();
+		}
+
+		if (m_hFile)
+		{
+			CloseHandle(m_hFile);
+			m_hFile = NULL;
+		}
+
+		m_oBlocks.clear();
+		m_oFormat = {};
+		m_iSampleAlign = 0;
+		m_iSampleCount = 0;
+		m_iDataOffset = 0;
+	}
+
+	void WaveFileStream::play(float volume)
+	{
+		if (!m_hFile)
+			return;
+
+		if (!m_bLoop && getPosition() >= m_iSampleCount)
+			seek(0); // played to the end before --> restart
+
+		// the first buffers are queued immediately, they must not be an underrun
+		std::unique_lock lm(m_muxIO);
+		waitForReadAhead(lm);
+		lm.unlock();
+
+		internalStart(m_oFormat, volume);
+	}
+
+	void WaveFileStream::seek(size_t iSampleID)
+	{
+		if (!m_hFile)
+			return;
+
+		std::unique_lock lm(m_muxIO);
+
+		if (iSampleID > m_iSampleCount)
+			iSampleID = m_iSampleCount;
+
+		// discard all blocks that were read ahead
+		m_iReadyFront = 0;
+		m_iReadyCount = 0;
+
+		m_iReadPos = iSampleID;
+		m_iPlayPos = iSampleID;
+		m_bReadEnd = false;
+		m_bSeekPending = true;
+
+		m_cvIO.notify_all();
+		if (running())
+			waitForReadAhead(lm);
+	}
+
+	size_t WaveFileStream::getPosition() const
+	{
+		std::unique_lock lm(m_muxIO);
+		return m_iPlayPos;
+	}
+
+	size_t WaveFileStream::getBufferedSamples() const
+	{
+		std::unique_lock lm(m_muxIO);
+
+		size_t result = 0;
+		for (size_t i = 0; i < m_iReadyCount; ++i)
+		{
+			const auto& oBlock = m_oBlocks[(m_iReadyFront + i) % m_oBlocks.size()];
+			result += oBlock.iSampleCount - oBlock.iConsumed;
+		}
+		return result;
+	}
+
+	void WaveFileStream::setLoop(bool bLoop, size_t iLoopBegin, size_t iLoopEnd)
+	{
+		std::unique_lock lm(m_muxIO);
+
+		if (iLoopEnd == 0 || iLoopEnd > m_iSampleCount)
+			iLoopEnd = m_iSampleCount;
+		if (iLoopBegin >= iLoopEnd)
+			bLoop = false; // empty loop
+
+		m_iLoopBegin = iLoopBegin;
+		m_iLoopEnd = iLoopEnd;
+		m_bLoop = bLoop;
+
+		// the end of the file might not be the end of the stream anymore
+		if (m_bLoop && m_bReadEnd)
+		{
+			m_bReadEnd = false;
+			if (m_iReadPos >= m_iLoopEnd)
+				m_iReadPos = m_iLoopBegin;
+		}
+
+		lm.unlock();
+		m_cvIO.notify_all();
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PROTECTED METHODS
+
+	bool WaveFileStream::nextSample(float fElapsedTime, MultiChannelAudioSample& dest) noexcept
+	{
+		return nextSamples(dest.val.p8, 1) == 1;
+	}
+
+	size_t WaveFileStream::nextSamples(uint8_t* pDest, size_t iSampleCount) noexcept
+	{
+		size_t iDone = 0;
+
+		std::unique_lock lm(m_muxIO);
+		while (iDone < iSampleCount)
+		{
+			if (m_iReadyCount == 0)
+			{
+				if (m_bReadEnd)
+					break; // end of stream
+
+				// the reading thread is behind --> play silence instead of waiting for it
+				// (8 bit PCM is unsigned). Right after a seek, that's not an underrun.
+				const int iSilence = (m_oFormat.eBitDepth == AudioBitDepth::Audio8) ? 0x80 : 0;
+				memset(pDest + iDone * m_iSampleAlign, iSilence,
+					(iSampleCount - iDone) * m_iSampleAlign);
+				iDone = iSampleCount;
+				if (!m_bWaitingForReadAhead)
+					m_iUnderruns.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+
+			auto& oBlock = m_oBlocks[m_iReadyFront];
+			const size_t iCount = std::min(iSampleCount - iDone,
+				oBlock.iSampleCount - oBlock.iConsumed);
+
+			memcpy(pDest + iDone * m_iSampleAlign,
+				oBlock.upData.get() + oBlock.iConsumed * m_iSampleAlign, iCount * m_iSampleAlign);
+			oBlock.iConsumed += iCount;
+			iDone += iCount;
+
+			m_iPlayPos += iCount;
+			if (m_bLoop && m_iPlayPos >= m_iLoopEnd)
+				m_iPlayPos = m_iLoopBegin + (m_iPlayPos - m_iLoopEnd);
+
+			if (oBlock.iConsumed == oBlock.iSampleCount)
+			{
+				// block was consumed completely --> return to the reading thread
+				m_iReadyFront = (m_iReadyFront + 1) % m_oBlocks.size();
+				--m_iReadyCount;
+				m_cvIO.notify_all();
+			}
+		}
+
+		return iDone;
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void WaveFileStream::ioThreadFunc()
+	{
+		std::unique_lock lm(m_muxIO);
+
+		while (!m_bQuitIO)
+		{
+			m_bSeekPending = false;
+
+			if (m_iReadyCount == m_oBlocks.size() || m_bReadEnd)
+			{
+				m_cvIO.wait(lm);
+				continue;
+			}
+
+			const size_t iBlock = (m_iReadyFront + m_iReadyCount) % m_oBlocks.size();
+			auto& oBlock = m_oBlocks[iBlock];
+			size_t iPos = m_iReadPos;
+			bool bEnd = false;
+			const bool bLoop = m_bLoop;
+			const size_t iLoopBegin = m_iLoopBegin;
+			const size_t iLoopEnd = m_iLoopEnd;
+
+			// read without blocking the audio stream
+			lm.unlock();
+			const size_t iRead = readSamples(oBlock.upData.get(), m_iSamplesPerBlock, iPos, bEnd,
+				bLoop, iLoopBegin, iLoopEnd);
+			lm.lock();
+
+			if (m_bSeekPending)
+				continue; // position changed while reading --> discard block
+
+			oBlock.iSampleCount = iRead;
+			oBlock.iConsumed = 0;
+			if (iRead > 0)
+				++m_iReadyCount;
+
+			m_iReadPos = iPos;
+			m_bReadEnd = bEnd;
+
+			m_cvIO.notify_all();
+		}
+	}
+
+	void WaveFileStream::waitForReadAhead(std::unique_lock<std::mutex>& lm)
+	{
+		m_bWaitingForReadAhead = true;
+		m_cvIO.wait(lm, [&]()
+		{
+			return m_iReadyCount == m_oBlocks.size() || m_bReadEnd || m_bQuitIO;
+		});
+		m_bWaitingForReadAhead = false;
+	}
+
+	size_t WaveFileStream::readSamples(uint8_t* pDest, size_t iSampleCount, size_t& iPos,
+		bool& bEnd, bool bLoop, size_t iLoopBegin, size_t iLoopEnd)
+	{
+		size_t iDone = 0;
+		bEnd = false;
+
+		const size_t iEnd = bLoop ? iLoopEnd : m_iSampleCount;
+		while (iDone < iSampleCount)
+		{
+			if (iPos >= iEnd)
+			{
+				if (!bLoop)
+				{
+					bEnd = true;
+					break;
+				}
+				iPos = iLoopBegin; // seamless loop
+			}
+
+			const size_t iCount = std::min(iSampleCount - iDone, iEnd - iPos);
+
+			LARGE_INTEGER liOffset{};
+			liOffset.QuadPart = (LONGLONG)(m_iDataOffset + (uint64_t)iPos * m_iSampleAlign);
+			DWORD dwRead = 0;
+			const DWORD dwSize = (DWORD)(iCount * m_iSampleAlign);
+			if (!SetFilePointerEx(m_hFile, liOffset, NULL, FILE_BEGIN) ||
+				!ReadFile(m_hFile, pDest + iDone * m_iSampleAlign, dwSize, &dwRead, NULL) ||
+				dwRead != dwSize)
+			{
+				bEnd = true; // read error --> end the stream
+				break;
+			}
+
+			iDone += iCount;
+			iPos += iCount;
+		}
+
+		if (!bEnd && !bLoop && iPos >= m_iSampleCount)
+			bEnd = true;
+
+		return iDone;
+	}
 
 }
\ No newline at end of file
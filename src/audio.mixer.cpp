@@ -0,0 +1,476 @@
+#include "rl/audio.mixer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <xmmintrin.h> // SSE
+
+
+
+
+
+namespace
+{
+
+	constexpr size_t iConvSamples = 1024; // size of the conversion buffer, in samples
+
+	/// <summary>
+	/// pDest[i] += pSrc[i] * fVolume
+	/// </summary>
+	void MixAdd(float* pDest, const float* pSrc, size_t iValueCount, float fVolume) noexcept
+	{
+		const __m128 vVolume = _mm_set1_ps(fVolume);
+
+		size_t i = 0;
+		for (; i + 4 <= iValueCount; i += 4)
+		{
+			const __m128 vSrc = _mm_loadu_ps(pSrc + i);
+			const __m128 vDest = _mm_loadu_ps(pDest + i);
+			_mm_storeu_ps(pDest + i, _mm_add_ps(vDest, _mm_mul_ps(vSrc, vVolume)));
+		}
+		for (; i < iValueCount; ++i)
+		{
+			pDest[i] += pSrc[i] * fVolume;
+		}
+	}
+
+	/// <summary>
+	/// Add interleaved samples to interleaved samples with a (possibly) different channel count
+	/// </summary>
+	void MixChannels(float* pDest, uint8_t iDestChannels, const float* pSrc,
+		uint8_t iSrcChannels, size_t iSampleCount, float fVolume) noexcept
+	{
+		if (iSrcChannels == iDestChannels)
+			MixAdd(pDest, pSrc, iSampleCount * iDestChannels, fVolume);
+		else if (iSrcChannels == 1) // mono --> all channels
+		{
+			for (size_t i = 0; i < iSampleCount; ++i)
+			{
+				const float f = pSrc[i] * fVolume;
+				for (uint8_t iChannel = 0; iChannel < iDestChannels; ++iChannel)
+				{
+					pDest[i * iDestChannels + iChannel] += f;
+				}
+			}
+		}
+		else // map the channels by index, drop the others
+		{
+			const uint8_t iChannels = std::min(iSrcChannels, iDestChannels);
+			for (size_t i = 0; i < iSampleCount; ++i)
+			{
+				for (uint8_t iChannel = 0; iChannel < iChannels; ++iChannel)
+				{
+					pDest[i * iDestChannels + iChannel] +=
+						pSrc[i * iSrcChannels + iChannel] * fVolume;
+				}
+			}
+		}
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	/***********************************************************************************************
+	 class AudioMixer
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// CONSTRUCTORS, DESTRUCTORS
+
+	AudioMixer::~AudioMixer() { stop(); }
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	void AudioMixer::start(uint32_t iSampleRate, uint8_t iChannelCount, float volume,
+		size_t BufferBlockCount, size_t SamplesPerBufferBlock, size_t MaxVoices, size_t MaxEvents,
+		ResamplerQuality eResamplerQuality)
+	{
+		stop();
+
+		m_iSampleRate = iSampleRate;
+		m_iChannelCount = iChannelCount;
+		m_eResamplerQuality = eResamplerQuality;
+
+		// the audio thread is stopped --> this is the only consumer
+		Event ev;
+		while (m_oPending.pop(ev)) {}
+		m_iEventCount = 0;
+
+		// reserve everything the audio thread needs
+		m_iMaxVoices = MaxVoices;
+		m_iMaxEvents = MaxEvents;
+		m_upVoiceSlots = std::make_unique<VoiceSlot[]>(m_iMaxVoices);
+		m_oTimeline.clear();
+		m_oTimeline.reserve(m_iMaxEvents);
+		m_oVoices.clear();
+		m_oVoices.reserve(m_iMaxVoices);
+		m_iGenerated = 0;
+		if (!m_upConvBuf)
+			m_upConvBuf = std::make_unique<float[]>(iConvSamples * XAUDIO2_MAX_AUDIO_CHANNELS);
+		if (!m_upResampleBuf)
+			m_upResampleBuf = std::make_unique<float[]>(iConvSamples * XAUDIO2_MAX_AUDIO_CHANNELS);
+
+		WaveFormat oFormat;
+		oFormat.eBitDepth = AudioBitDepth::Audio32;
+		oFormat.iChannelCount = iChannelCount;
+		oFormat.iSampleRate = iSampleRate;
+		internalStart(oFormat, volume, BufferBlockCount, SamplesPerBufferBlock);
+	}
+
+	AudioMixer::VoiceID AudioMixer::schedulePlay(const Sound& sound, uint64_t iStartSample,
+		float fVolume, bool bLoop)
+	{
+		if (!sound.getDataPtr())
+			return InvalidVoice;
+
+		// claim a free voice slot
+		size_t iSlot = 0;
+		for (; iSlot < m_iMaxVoices; ++iSlot)
+		{
+			bool bUsed = false;
+			if (m_upVoiceSlots[iSlot].bUsed.compare_exchange_strong(bUsed, true,
+				std::memory_order_acquire))
+				break;
+		}
+		if (iSlot == m_iMaxVoices)
+			return InvalidVoice; // all voices are used
+
+		// the slot is unused by the audio thread --> its resampler can be prepared here
+		const auto& oFormat = sound.getWaveFormat();
+		bool bResample = false;
+		if (oFormat.iSampleRate != m_iSampleRate)
+		{
+			auto& oResampler = m_upVoiceSlots[iSlot].oResampler;
+			if (oResampler.isCreated() && oResampler.getInputSampleRate() == oFormat.iSampleRate &&
+				oResampler.getOutputSampleRate() == m_iSampleRate &&
+				oResampler.getChannelCount() == oFormat.iChannelCount &&
+				oResampler.getQuality() == m_eResamplerQuality)
+				oResampler.reset(); // reuse the filter table
+			else if (!oResampler.create(oFormat.iSampleRate, m_iSampleRate, oFormat.iChannelCount,
+				m_eResamplerQuality))
+			{
+				m_upVoiceSlots[iSlot].bUsed.store(false, std::memory_order_release);
+				return InvalidVoice;
+			}
+			bResample = true;
+		}
+
+		if (!reserveEvent())
+		{
+			m_upVoiceSlots[iSlot].bUsed.store(false, std::memory_order_release);
+			return InvalidVoice;
+		}
+
+		const VoiceID id = m_iNextVoiceID.fetch_add(1, std::memory_order_relaxed);
+
+		Event ev{};
+		ev.iSample = iStartSample;
+		ev.eType = EventType::Play;
+		ev.id = id;
+		ev.fVolume = fVolume;
+		ev.pSound = &sound;
+		ev.iSlot = iSlot;
+		ev.bLoop = bLoop;
+		ev.bResample = bResample;
+		addEvent(std::move(ev));
+
+		return id;
+	}
+
+	bool AudioMixer::scheduleStop(VoiceID id, uint64_t iSample)
+	{
+		if (!reserveEvent())
+			return false;
+
+		Event ev{};
+		ev.iSample = iSample;
+		ev.eType = EventType::Stop;
+		ev.id = id;
+
+		addEvent(std::move(ev));
+		return true;
+	}
+
+	bool AudioMixer::scheduleVolume(VoiceID id, uint64_t iSample, float fVolume)
+	{
+		if (!reserveEvent())
+			return false;
+
+		Event ev{};
+		ev.iSample = iSample;
+		ev.eType = EventType::Volume;
+		ev.id = id;
+		ev.fVolume = fVolume;
+
+		addEvent(std::move(ev));
+		return true;
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PROTECTED METHODS
+
+	bool AudioMixer::nextSample(float fElapsedTime, MultiChannelAudioSample& dest) noexcept
+	{
+		return nextSamples(dest.val.p8, 1) == 1;
+	}
+
+	size_t AudioMixer::nextSamples(uint8_t* pDest, size_t iSampleCount) noexcept
+	{
+		float* pOutput = reinterpret_cast<float*>(pDest); // already zeroed
+
+		// move the newly scheduled events into the timeline
+		// (never reallocates: there are at most m_iMaxEvents events)
+		Event ev;
+		while (m_oPending.pop(ev))
+		{
+			// sorted descending --> the next event is at the back
+			auto it = std::upper_bound(m_oTimeline.begin(), m_oTimeline.end(), ev,
+				[](const Event& a, const Event& b)
+				{
+					return a.iSample > b.iSample ||
+						(a.iSample == b.iSample && a.iSequence > b.iSequence);
+				});
+			m_oTimeline.insert(it, ev);
+		}
+
+		const uint64_t iBlockStart = m_iGenerated;
+		const uint64_t iBlockEnd = iBlockStart + iSampleCount;
+		uint64_t iPos = iBlockStart;
+		while (iPos < iBlockEnd)
+		{
+			// events that are due (late events are processed at the start of the block)
+			while (!m_oTimeline.empty() && m_oTimeline.back().iSample <= iPos)
+			{
+				processEvent(m_oTimeline.back());
+				m_oTimeline.pop_back();
+				m_iEventCount.fetch_sub(1, std::memory_order_release);
+			}
+
+			// split the block at the next event
+			uint64_t iSegmentEnd = iBlockEnd;
+			if (!m_oTimeline.empty() && m_oTimeline.back().iSample < iSegmentEnd)
+				iSegmentEnd = m_oTimeline.back().iSample;
+
+			mix(pOutput + (iPos - iBlockStart) * m_iChannelCount, size_t(iSegmentEnd - iPos));
+			iPos = iSegmentEnd;
+		}
+
+		m_iGenerated = iBlockEnd;
+		return iSampleCount;
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	bool AudioMixer::reserveEvent() noexcept
+	{
+		if (m_iEventCount.fetch_add(1, std::memory_order_acquire) >= m_iMaxEvents)
+		{
+			m_iEventCount.fetch_sub(1, std::memory_order_relaxed);
+			return false;
+		}
+		return true;
+	}
+
+	void AudioMixer::addEvent(Event&& ev)
+	{
+		ev.iSequence = m_iNextSequence.fetch_add(1, std::memory_order_relaxed);
+		m_oPending.push(std::move(ev));
+	}
+
+	void AudioMixer::releaseVoice(const Voice& voice) noexcept
+	{
+		m_upVoiceSlots[voice.iSlot].bUsed.store(false, std::memory_order_release);
+	}
+
+	void AudioMixer::processEvent(const Event& ev)
+	{
+		if (ev.eType == EventType::Play)
+		{
+			// never reallocates: every voice has its own slot
+			Voice oVoice{};
+			oVoice.id = ev.id;
+			oVoice.pSound = ev.pSound;
+			oVoice.iSlot = ev.iSlot;
+			oVoice.pResampler = ev.bResample ? &m_upVoiceSlots[ev.iSlot].oResampler : nullptr;
+			oVoice.iPos = 0;
+			oVoice.iTail = 0;
+			oVoice.fVolume = ev.fVolume;
+			oVoice.bLoop = ev.bLoop;
+			m_oVoices.push_back(oVoice);
+			return;
+		}
+
+		auto it = std::find_if(m_oVoices.begin(), m_oVoices.end(),
+			[&](const Voice& v) { return v.id == ev.id; });
+		if (it == m_oVoices.end())
+			return; // voice already ended
+
+		switch (ev.eType)
+		{
+		case EventType::Stop:
+			releaseVoice(*it);
+			m_oVoices.erase(it);
+			break;
+
+		case EventType::Volume:
+			it->fVolume = ev.fVolume;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	size_t AudioMixer::readResampled(Voice& voice, size_t iMaxSampleCount, bool& bEnded) noexcept
+	{
+		auto& oResampler = *voice.pResampler;
+		const auto& oFormat = voice.pSound->getWaveFormat();
+		const uint8_t iChannels = oFormat.iChannelCount;
+		const size_t iTotal = voice.pSound->getSampleCount();
+		float* pOutput = m_upResampleBuf.get();
+
+		bEnded = false;
+		size_t iOutput = 0;
+		while (iOutput < iMaxSampleCount)
+		{
+			const float* pInput;
+			size_t iInputCount;
+			if (voice.iPos < iTotal)
+			{
+				if (oFormat.eBitDepth == AudioBitDepth::Audio32)
+				{
+					pInput = static_cast<const float*>(voice.pSound->getDataPtr()) +
+						voice.iPos * iChannels;
+					iInputCount = iTotal - voice.iPos;
+				}
+				else
+				{
+					// only convert about as many samples as the output needs
+					const size_t iNeeded = size_t(uint64_t(iMaxSampleCount - iOutput) *
+						oFormat.iSampleRate / m_iSampleRate) + 1;
+					iInputCount = voice.pSound->getSamplesAsFloat(m_upConvBuf.get(), voice.iPos,
+						std::min(iNeeded, iConvSamples));
+					if (iInputCount == 0)
+					{
+						bEnded = true; // the samples couldn't be read
+						break;
+					}
+					pInput = m_upConvBuf.get();
+				}
+			}
+			else if (voice.bLoop && iTotal > 0)
+			{
+				voice.iPos = 0; // the filter state carries over for a seamless loop
+				continue;
+			}
+			else if (voice.iTail < oResampler.getLookahead())
+			{
+				// the sound is followed by silence, so the filter can output the last samples
+				iInputCount = std::min(oResampler.getLookahead() - voice.iTail, iConvSamples);
+				memset(m_upConvBuf.get(), 0, iInputCount * iChannels * sizeof(float));
+				pInput = m_upConvBuf.get();
+			}
+			else
+			{
+				bEnded = true;
+				break;
+			}
+
+			size_t iUsed;
+			iOutput += oResampler.process(pInput, iInputCount, iUsed,
+				pOutput + iOutput * iChannels, iMaxSampleCount - iOutput);
+			if (voice.iPos < iTotal)
+				voice.iPos += iUsed;
+			else
+				voice.iTail += iUsed;
+		}
+
+		return iOutput;
+	}
+
+	void AudioMixer::mix(float* pDest, size_t iSampleCount) noexcept
+	{
+		for (auto it = m_oVoices.begin(); it != m_oVoices.end();)
+		{
+			auto& oVoice = *it;
+			const auto& oFormat = oVoice.pSound->getWaveFormat();
+			const uint8_t iSrcChannels = oFormat.iChannelCount;
+			const size_t iTotal = oVoice.pSound->getSampleCount();
+
+			bool bEnded = false;
+			size_t iDone = 0;
+			while (oVoice.pResampler && iDone < iSampleCount)
+			{
+				const size_t iCount =
+					readResampled(oVoice, std::min(iSampleCount - iDone, iConvSamples), bEnded);
+				MixChannels(pDest + iDone * m_iChannelCount, m_iChannelCount,
+					m_upResampleBuf.get(), iSrcChannels, iCount, oVoice.fVolume);
+				iDone += iCount;
+				if (bEnded)
+					break;
+			}
+			while (!oVoice.pResampler && iDone < iSampleCount)
+			{
+				if (oVoice.iPos >= iTotal)
+				{
+					if (!oVoice.bLoop || iTotal == 0)
+					{
+						bEnded = true;
+						break;
+					}
+					oVoice.iPos = 0;
+				}
+
+				size_t iCount = std::min(iSampleCount - iDone, iTotal - oVoice.iPos);
+				const float* pSrc;
+				if (oFormat.eBitDepth == AudioBitDepth::Audio32)
+					pSrc = static_cast<const float*>(oVoice.pSound->getDataPtr()) +
+						oVoice.iPos * iSrcChannels;
+				else
+				{
+					iCount = std::min(iCount, iConvSamples);
+					oVoice.pSound->getSamplesAsFloat(m_upConvBuf.get(), oVoice.iPos, iCount);
+					pSrc = m_upConvBuf.get();
+				}
+
+				MixChannels(pDest + iDone * m_iChannelCount, m_iChannelCount, pSrc, iSrcChannels,
+					iCount, oVoice.fVolume);
+
+				oVoice.iPos += iCount;
+				iDone += iCount;
+			}
+
+			if (bEnded)
+			{
+				releaseVoice(oVoice);
+				it = m_oVoices.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+}
@@ -0,0 +1,297 @@
+#include "rl/audio.resampler.hpp"
+
+#include <cmath>
+#include <cstring> // memset
+#include <numeric> // std::gcd
+#include <xmmintrin.h> // SSE
+
+
+
+
+
+namespace
+{
+
+	constexpr double PI = 3.14159265358979323846;
+
+	/// <summary>
+	/// The filter parameters of a <c>ResamplerQuality</c>
+	/// </summary>
+	struct QualityParams
+	{
+		size_t iTaps; // filter length when upsampling
+		size_t iMaxPhases;
+		double dRolloff; // cutoff frequency, relative to the lower Nyquist frequency
+		double dKaiserBeta; // 0.0 = linear interpolation
+	};
+
+	constexpr QualityParams oQualityParams[] =
+	{
+		{  4, 1024, 1.00, 0.0 }, // Linear
+		{  8,  256, 0.85, 5.0 }, // Low
+		{ 16,  512, 0.90, 7.0 }, // Medium
+		{ 32, 1024, 0.95, 9.0 }  // High
+	};
+
+	constexpr size_t iMaxTaps = 256; // limits the filter length for high downsampling ratios
+
+
+	/// <summary>
+	/// Modified Bessel function of the first kind, order 0
+	/// </summary>
+	double BesselI0(double x) noexcept
+	{
+		double dSum = 1.0;
+		double dTerm = 1.0;
+		const double dHalfSq = x * x / 4.0;
+		for (int k = 1; k < 50; ++k)
+		{
+			dTerm *= dHalfSq / (double(k) * k);
+			dSum += dTerm;
+			if (dTerm < dSum * 1e-12)
+				break;
+		}
+		return dSum;
+	}
+
+	/// <summary>
+	/// Sum of the products of two float arrays<para/>
+	/// <c>iCount</c> must be a multiple of 4
+	/// </summary>
+	inline float DotProduct(const float* pA, const float* pB, size_t iCount) noexcept
+	{
+		__m128 vSum0 = _mm_setzero_ps();
+		__m128 vSum1 = _mm_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 8 <= iCount; i += 8)
+		{
+			vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(_mm_loadu_ps(pA + i), _mm_loadu_ps(pB + i)));
+			vSum1 = _mm_add_ps(vSum1,
+				_mm_mul_ps(_mm_loadu_ps(pA + i + 4), _mm_loadu_ps(pB + i + 4)));
+		}
+		if (i < iCount)
+			vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(_mm_loadu_ps(pA + i), _mm_loadu_ps(pB + i)));
+
+		// horizontal sum
+		__m128 vSum = _mm_add_ps(vSum0, vSum1);
+		vSum = _mm_add_ps(vSum, _mm_movehl_ps(vSum, vSum));
+		vSum = _mm_add_ss(vSum, _mm_shuffle_ps(vSum, vSum, 1));
+		return _mm_cvtss_f32(vSum);
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	/***********************************************************************************************
+	 class AudioResampler
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	bool AudioResampler::create(uint32_t iInputSampleRate, uint32_t iOutputSampleRate,
+		uint8_t iChannelCount, ResamplerQuality eQuality)
+	{
+		destroy();
+
+		if (iInputSampleRate == 0 || iOutputSampleRate == 0 || iChannelCount == 0 ||
+			static_cast<size_t>(eQuality) >= std::size(oQualityParams))
+			return false;
+
+		m_iInputSampleRate = iInputSampleRate;
+		m_iOutputSampleRate = iOutputSampleRate;
+		m_iChannelCount = iChannelCount;
+		m_eQuality = eQuality;
+
+		const uint32_t iGCD = std::gcd(iInputSampleRate, iOutputSampleRate);
+		m_iStep = iInputSampleRate / iGCD;
+		m_iDenominator = iOutputSampleRate / iGCD;
+
+		const auto& oParams = oQualityParams[static_cast<size_t>(eQuality)];
+
+		// when downsampling, the filter must be longer to keep the same transition band
+		m_iTaps = oParams.iTaps;
+		if (oParams.dKaiserBeta != 0.0 && m_iStep > m_iDenominator)
+		{
+			m_iTaps = (size_t)std::ceil(double(m_iTaps) * m_iStep / m_iDenominator);
+			m_iTaps = (m_iTaps + 3) & ~size_t(3);
+			if (m_iTaps > iMaxTaps)
+				m_iTaps = iMaxTaps;
+		}
+		m_iPhaseCount = m_iDenominator < oParams.iMaxPhases ? m_iDenominator : oParams.iMaxPhases;
+
+		calcFilterTable();
+
+		m_upHistory = std::make_unique<float[]>(2 * m_iTaps * m_iChannelCount);
+		reset();
+
+		return true;
+	}
+
+	void AudioResampler::destroy() noexcept
+	{
+		m_iInputSampleRate = 0;
+		m_iOutputSampleRate = 0;
+		m_iChannelCount = 0;
+		m_iStep = 0;
+		m_iDenominator = 0;
+		m_iTaps = 0;
+		m_iPhaseCount = 0;
+		m_upFilter = nullptr;
+		m_upHistory = nullptr;
+		m_iHistoryPos = 0;
+		m_iPhase = 0;
+		m_iPendingInput = 0;
+	}
+
+	void AudioResampler::reset() noexcept
+	{
+		if (!isCreated())
+			return;
+
+		memset(m_upHistory.get(), 0, sizeof(float) * 2 * m_iTaps * m_iChannelCount);
+		m_iHistoryPos = 0;
+		m_iPhase = 0;
+
+		// the first output sample is calculated as soon as the first input sample is at the
+		// center of the filter
+		m_iPendingInput = m_iTaps / 2 + 1;
+	}
+
+	size_t AudioResampler::process(const float* pInput, size_t iInputSampleCount,
+		size_t& iInputUsed, float* pOutput, size_t iMaxOutputSampleCount) noexcept
+	{
+		iInputUsed = 0;
+		if (!isCreated())
+			return 0;
+
+		const size_t iHistoryLen = 2 * m_iTaps;
+		size_t iOutput = 0;
+		while (true)
+		{
+			while (m_iPendingInput > 0)
+			{
+				if (iInputUsed == iInputSampleCount)
+					return iOutput; // input used up
+
+				push(pInput + iInputUsed * m_iChannelCount);
+				++iInputUsed;
+				--m_iPendingInput;
+			}
+
+			if (iOutput == iMaxOutputSampleCount)
+				return iOutput; // output buffer full
+
+			const size_t iRow = (m_iPhaseCount == m_iDenominator) ? m_iPhase :
+				size_t(uint64_t(m_iPhase) * m_iPhaseCount / m_iDenominator);
+			const float* pCoeffs = m_upFilter.get() + iRow * m_iTaps;
+			const float* pHistory = m_upHistory.get() + m_iHistoryPos;
+			float* pDest = pOutput + iOutput * m_iChannelCount;
+			for (uint8_t iChannel = 0; iChannel < m_iChannelCount; ++iChannel)
+			{
+				pDest[iChannel] = DotProduct(pHistory + iChannel * iHistoryLen, pCoeffs, m_iTaps);
+			}
+			++iOutput;
+
+			m_iPhase += m_iStep;
+			m_iPendingInput = m_iPhase / m_iDenominator;
+			m_iPhase %= m_iDenominator;
+		}
+	}
+
+	size_t AudioResampler::getOutputSampleCount(size_t iInputSampleCount) const noexcept
+	{
+		if (!isCreated() || iInputSampleCount <= m_iTaps / 2)
+			return 0;
+
+		// output sample k needs the input sample k * step / denominator + lookahead
+		const uint64_t iLastNeeded = iInputSampleCount - m_iTaps / 2;
+		return size_t((iLastNeeded * m_iDenominator - 1) / m_iStep + 1);
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void AudioResampler::calcFilterTable()
+	{
+		const auto& oParams = oQualityParams[static_cast<size_t>(m_eQuality)];
+
+		m_upFilter = std::make_unique<float[]>(m_iPhaseCount * m_iTaps);
+
+		// cutoff frequency, relative to the input sample rate
+		double dCutoff = 0.5 * oParams.dRolloff;
+		if (m_iStep > m_iDenominator)
+			dCutoff *= double(m_iDenominator) / m_iStep;
+
+		const double dHalfLen = double(m_iTaps / 2);
+		const double dBesselBeta = BesselI0(oParams.dKaiserBeta);
+
+		for (size_t iPhase = 0; iPhase < m_iPhaseCount; ++iPhase)
+		{
+			float* pRow = m_upFilter.get() + iPhase * m_iTaps;
+			const double dFrac = double(iPhase) / m_iPhaseCount;
+
+			double dSum = 0.0;
+			for (size_t iTap = 0; iTap < m_iTaps; ++iTap)
+			{
+				// distance between the tap and the output position, in input samples
+				const double x = double(iTap) - (dHalfLen - 1.0) - dFrac;
+
+				double dCoeff;
+				if (oParams.dKaiserBeta == 0.0) // linear interpolation
+					dCoeff = std::fabs(x) < 1.0 ? 1.0 - std::fabs(x) : 0.0;
+				else
+				{
+					const double dArg = 2.0 * dCutoff * x;
+					const double dSinc = (dArg == 0.0) ? 1.0 : std::sin(PI * dArg) / (PI * dArg);
+
+					const double r = x / dHalfLen;
+					const double dWindow = (r >= 1.0 || r <= -1.0) ? 0.0 :
+						BesselI0(oParams.dKaiserBeta * std::sqrt(1.0 - r * r)) / dBesselBeta;
+
+					dCoeff = 2.0 * dCutoff * dSinc * dWindow;
+				}
+
+				pRow[iTap] = float(dCoeff);
+				dSum += dCoeff;
+			}
+
+			// normalize to unity gain at 0 Hz
+			for (size_t iTap = 0; iTap < m_iTaps; ++iTap)
+			{
+				pRow[iTap] = float(pRow[iTap] / dSum);
+			}
+		}
+	}
+
+	void AudioResampler::push(const float* pSample) noexcept
+	{
+		const size_t iHistoryLen = 2 * m_iTaps;
+		float* pHistory = m_upHistory.get();
+		for (uint8_t iChannel = 0; iChannel < m_iChannelCount; ++iChannel)
+		{
+			float* pChannel = pHistory + iChannel * iHistoryLen;
+			pChannel[m_iHistoryPos] = pSample[iChannel];
+			pChannel[m_iHistoryPos + m_iTaps] = pSample[iChannel];
+		}
+
+		++m_iHistoryPos;
+		if (m_iHistoryPos == m_iTaps)
+			m_iHistoryPos = 0;
+	}
+
+}
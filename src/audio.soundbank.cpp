@@ -0,0 +1,395 @@
+#include "rl/audio.soundbank.hpp"
+#include "rl/audio.analysis.hpp"
+
+// STL
+#include <algorithm>
+#include <fstream>
+#include <new> // std::align_val_t
+
+// Win32
+#include <Windows.h>
+
+
+
+
+
+namespace
+{
+	constexpr char szMagicNumber[]       = "rlSOUNDBANK";
+	constexpr uint8_t iCurrentVersion[2] = { 1, 1 };
+
+	constexpr uint64_t iDataRegionAlignment = 4096; // page size --> the region can be mapped
+	constexpr uint64_t iSoundDataAlignment  = 64; // cache line size
+
+#pragma pack(push, 1)
+
+	struct FileHeader
+	{
+		char     szMagicNo[12];
+		uint8_t  iFormatVersion[2];
+		uint8_t  iReserved[2];
+		uint32_t iSoundCount;
+		uint32_t iNameTableLength; // in characters
+		uint64_t iDataOffset; // from the start of the file, multiple of iDataRegionAlignment
+		uint64_t iDataSize;
+	};
+
+	struct SoundTableEntry
+	{
+		uint32_t iNameOffset; // in characters, from the start of the name table
+		uint32_t iNameLength; // in characters
+		uint32_t iSampleRate;
+		uint8_t  iBitsPerSample;
+		uint8_t  iChannelCount;
+		uint8_t  iCompression; // rl::AudioCompression
+		uint8_t  iReserved;
+		uint32_t iSamplesPerBlock;
+		uint32_t iBlockAlign;
+		uint64_t iSampleCount;
+		uint64_t iDataOffset; // from the start of the data region, multiple of iSoundDataAlignment
+		uint64_t iDataSize;
+	};
+
+	// since version 1.1
+	struct EnvelopeTableEntry
+	{
+		uint64_t iDataOffset; // from the start of the data region, multiple of iSoundDataAlignment
+		uint64_t iDataSize; // 0 = no envelope
+	};
+
+#pragma pack(pop)
+
+	// the name table directly follows the sound table and consists of wchar_t strings without
+	// terminating zeros, sorted by code unit values
+
+	// the envelope table (one entry per sound) directly follows the name table; the envelopes
+	// are stored in the data region, in the format of rl::AudioEnvelope::save()
+
+	constexpr uint64_t AlignUp(uint64_t iValue, uint64_t iAlignment)
+	{
+		return (iValue + iAlignment - 1) / iAlignment * iAlignment;
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	/***********************************************************************************************
+	 class SoundBank
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// STATIC METHODS
+
+	bool SoundBank::Save(const wchar_t* szPath,
+		const std::map<std::wstring, const Sound*>& oSounds)
+	{
+		std::vector<uint8_t> oData;
+		if (!SaveToMemory(oData, oSounds))
+			return false;
+
+		std::ofstream out(szPath, std::ios::binary);
+		if (!out)
+			return false;
+
+		out.write(reinterpret_cast<const char*>(oData.data()), oData.size());
+		return out.good();
+	}
+
+	bool SoundBank::SaveToMemory(std::vector<uint8_t>& oDest,
+		const std::map<std::wstring, const Sound*>& oSounds)
+	{
+		oDest.clear();
+		if (oSounds.size() > UINT32_MAX)
+			return false;
+
+		std::vector<SoundTableEntry> oTable;
+		oTable.reserve(oSounds.size());
+		std::vector<EnvelopeTableEntry> oEnvelopeTable(oSounds.size());
+		std::vector<std::vector<uint8_t>> oEnvelopes(oSounds.size());
+		uint64_t iNameTableLength = 0;
+		uint64_t iDataSize = 0;
+
+		// std::map is sorted by name, as required for the binary search
+		for (const auto& it : oSounds)
+		{
+			const Sound* pSound = it.second;
+			if (!pSound || !pSound->getDataPtr() || it.first.length() > UINT32_MAX)
+				return false;
+
+			const auto& oFormat = pSound->getWaveFormat();
+			const auto& oCompression = pSound->getCompressionFormat();
+
+			SoundTableEntry oEntry{};
+			oEntry.iNameOffset      = (uint32_t)iNameTableLength;
+			oEntry.iNameLength      = (uint32_t)it.first.length();
+			oEntry.iSampleRate      = oFormat.iSampleRate;
+			oEntry.iBitsPerSample   = (uint8_t)oFormat.eBitDepth;
+			oEntry.iChannelCount    = oFormat.iChannelCount;
+			oEntry.iCompression     = (uint8_t)oCompression.eCompression;
+			oEntry.iSamplesPerBlock = oCompression.iSamplesPerBlock;
+			oEntry.iBlockAlign      = oCompression.iBlockAlign;
+			oEntry.iSampleCount     = pSound->getSampleCount();
+			oEntry.iDataOffset      = iDataSize;
+			oEntry.iDataSize        = pSound->getDataSize();
+			oTable.push_back(oEntry);
+
+			iNameTableLength += it.first.length();
+			iDataSize = AlignUp(iDataSize + oEntry.iDataSize, iSoundDataAlignment);
+
+			if (pSound->getEnvelope())
+			{
+				auto& oEnvelope = oEnvelopes[oTable.size() - 1];
+				pSound->getEnvelope()->save(oEnvelope);
+
+				auto& oEnvelopeEntry = oEnvelopeTable[oTable.size() - 1];
+				oEnvelopeEntry.iDataOffset = iDataSize;
+				oEnvelopeEntry.iDataSize   = oEnvelope.size();
+				iDataSize = AlignUp(iDataSize + oEnvelope.size(), iSoundDataAlignment);
+			}
+		}
+		if (iNameTableLength > UINT32_MAX)
+			return false;
+
+		FileHeader oHeader{};
+		memcpy(oHeader.szMagicNo, szMagicNumber, sizeof(oHeader.szMagicNo));
+		memcpy(oHeader.iFormatVersion, iCurrentVersion, sizeof(iCurrentVersion));
+		oHeader.iSoundCount      = (uint32_t)oTable.size();
+		oHeader.iNameTableLength = (uint32_t)iNameTableLength;
+		oHeader.iDataOffset      = AlignUp(sizeof(FileHeader) +
+			oTable.size() * sizeof(SoundTableEntry) + iNameTableLength * sizeof(wchar_t) +
+			oEnvelopeTable.size() * sizeof(EnvelopeTableEntry), iDataRegionAlignment);
+		oHeader.iDataSize        = iDataSize;
+
+		oDest.resize(oHeader.iDataOffset + oHeader.iDataSize);
+		uint8_t* p = oDest.data();
+
+		memcpy(p, &oHeader, sizeof(oHeader));
+		p += sizeof(oHeader);
+		memcpy(p, oTable.data(), oTable.size() * sizeof(SoundTableEntry));
+		p += oTable.size() * sizeof(SoundTableEntry);
+		for (const auto& it : oSounds)
+		{
+			memcpy(p, it.first.c_str(), it.first.length() * sizeof(wchar_t));
+			p += it.first.length() * sizeof(wchar_t);
+		}
+		memcpy(p, oEnvelopeTable.data(), oEnvelopeTable.size() * sizeof(EnvelopeTableEntry));
+
+		uint8_t* const pDataRegion = oDest.data() + oHeader.iDataOffset;
+		size_t iIndex = 0;
+		for (const auto& it : oSounds)
+		{
+			const auto& oEntry = oTable[iIndex];
+			memcpy(pDataRegion + oEntry.iDataOffset, it.second->getDataPtr(), oEntry.iDataSize);
+
+			const auto& oEnvelope = oEnvelopes[iIndex];
+			if (!oEnvelope.empty())
+			{
+				memcpy(pDataRegion + oEnvelopeTable[iIndex].iDataOffset, oEnvelope.data(),
+					oEnvelope.size());
+			}
+			++iIndex;
+		}
+
+		return true;
+	}
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	bool SoundBank::load(const wchar_t* szPath)
+	{
+		clear();
+
+		HANDLE hFile = CreateFileW(szPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false; // couldn't open file
+
+		LARGE_INTEGER liFileSize{};
+		if (!GetFileSizeEx(hFile, &liFileSize) || liFileSize.QuadPart == 0 ||
+			(uint64_t)liFileSize.QuadPart > SIZE_MAX)
+		{
+			CloseHandle(hFile);
+			return false; // empty or too large file
+		}
+
+		HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(hFile); // the mapping keeps the file open
+		if (hMapping == NULL)
+			return false; // couldn't create file mapping
+
+		const void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(hMapping); // the view keeps the mapping alive
+		if (pView == NULL)
+			return false; // couldn't map file
+
+		std::shared_ptr<const void> spView(pView, [](const void* p) { UnmapViewOfFile(p); });
+
+		return parse(static_cast<const uint8_t*>(pView), (size_t)liFileSize.QuadPart,
+			std::move(spView));
+	}
+
+	bool SoundBank::loadFromMemory(const void* data, size_t size, bool bCopy)
+	{
+		clear();
+
+		if (!data)
+			return false;
+
+		if (!bCopy)
+			return parse(static_cast<const uint8_t*>(data), size, nullptr);
+
+		// the copy has the same alignment as a mapped file
+		constexpr std::align_val_t eAlignment = std::align_val_t(iDataRegionAlignment);
+		auto pCopy = new (eAlignment) uint8_t[size];
+		memcpy(pCopy, data, size);
+		std::shared_ptr<const void> spCopy(pCopy,
+			[eAlignment](const void* p)
+			{
+				operator delete[](const_cast<void*>(p), eAlignment);
+			});
+
+		return parse(pCopy, size, std::move(spCopy));
+	}
+
+	void SoundBank::clear() noexcept
+	{
+		m_oNames.clear();
+		m_oSounds.clear();
+		m_spData.reset();
+	}
+
+	size_t SoundBank::find(std::wstring_view sName) const noexcept
+	{
+		const auto it = std::lower_bound(m_oNames.begin(), m_oNames.end(), sName);
+		if (it == m_oNames.end() || *it != sName)
+			return npos;
+
+		return it - m_oNames.begin();
+	}
+
+	const Sound* SoundBank::get(size_t iIndex) const noexcept
+	{
+		if (iIndex >= m_oSounds.size())
+			return nullptr;
+
+		return &m_oSounds[iIndex];
+	}
+
+	std::wstring_view SoundBank::getName(size_t iIndex) const noexcept
+	{
+		if (iIndex >= m_oNames.size())
+			return {};
+
+		return m_oNames[iIndex];
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	bool SoundBank::parse(const uint8_t* pData, size_t iSize, std::shared_ptr<const void> spOwner)
+	{
+		FileHeader oHeader;
+		if (iSize < sizeof(oHeader))
+			return false; // too small for header
+		memcpy(&oHeader, pData, sizeof(oHeader));
+
+		if (memcmp(oHeader.szMagicNo, szMagicNumber, sizeof(oHeader.szMagicNo)) != 0 ||
+			oHeader.iFormatVersion[0] != iCurrentVersion[0])
+			return false; // not a sound bank or incompatible version
+
+		const uint64_t iTableSize = (uint64_t)oHeader.iSoundCount * sizeof(SoundTableEntry);
+		const uint64_t iNameTableOffset = sizeof(FileHeader) + iTableSize;
+		const uint64_t iEnvelopeTableOffset =
+			iNameTableOffset + (uint64_t)oHeader.iNameTableLength * sizeof(wchar_t);
+		const bool bEnvelopes = oHeader.iFormatVersion[1] >= 1;
+		const uint64_t iTablesEnd = iEnvelopeTableOffset +
+			(bEnvelopes ? (uint64_t)oHeader.iSoundCount * sizeof(EnvelopeTableEntry) : 0);
+		if (iTablesEnd > oHeader.iDataOffset || oHeader.iDataOffset > iSize ||
+			oHeader.iDataSize > iSize - oHeader.iDataOffset)
+			return false; // tables or data region exceed the data
+
+		// the name table is aligned for wchar_t if the data is
+		static_assert(sizeof(FileHeader) % sizeof(wchar_t) == 0 &&
+			sizeof(SoundTableEntry) % sizeof(wchar_t) == 0);
+		const wchar_t* pNameTable = reinterpret_cast<const wchar_t*>(pData + iNameTableOffset);
+		const uint8_t* pDataRegion = pData + oHeader.iDataOffset;
+
+		std::vector<Sound> oSounds(oHeader.iSoundCount);
+		std::vector<std::wstring_view> oNames;
+		oNames.reserve(oHeader.iSoundCount);
+
+		for (uint32_t i = 0; i < oHeader.iSoundCount; ++i)
+		{
+			SoundTableEntry oEntry;
+			memcpy(&oEntry, pData + sizeof(FileHeader) + i * sizeof(SoundTableEntry),
+				sizeof(oEntry));
+
+			if ((uint64_t)oEntry.iNameOffset + oEntry.iNameLength > oHeader.iNameTableLength)
+				return false; // name exceeds the name table
+			const std::wstring_view sName(pNameTable + oEntry.iNameOffset, oEntry.iNameLength);
+			if (!oNames.empty() && !(oNames.back() < sName))
+				return false; // names must be unique and sorted
+			oNames.push_back(sName);
+
+			if (oEntry.iDataOffset > oHeader.iDataSize ||
+				oEntry.iDataSize > oHeader.iDataSize - oEntry.iDataOffset ||
+				oEntry.iSampleCount > SIZE_MAX)
+				return false; // data exceeds the data region
+
+			WaveFormat oFormat;
+			oFormat.eBitDepth     = static_cast<AudioBitDepth>(oEntry.iBitsPerSample);
+			oFormat.iChannelCount = oEntry.iChannelCount;
+			oFormat.iSampleRate   = oEntry.iSampleRate;
+
+			AudioCompressionFormat oCompression;
+			oCompression.eCompression     = static_cast<AudioCompression>(oEntry.iCompression);
+			oCompression.iSamplesPerBlock = oEntry.iSamplesPerBlock;
+			oCompression.iBlockAlign      = oEntry.iBlockAlign;
+
+			if (!oSounds[i].reference(oFormat, oCompression, (size_t)oEntry.iSampleCount,
+				pDataRegion + oEntry.iDataOffset, (size_t)oEntry.iDataSize, spOwner))
+				return false; // invalid sound
+
+			if (!bEnvelopes)
+				continue;
+
+			EnvelopeTableEntry oEnvelopeEntry;
+			memcpy(&oEnvelopeEntry, pData + iEnvelopeTableOffset + i * sizeof(EnvelopeTableEntry),
+				sizeof(oEnvelopeEntry));
+			if (oEnvelopeEntry.iDataSize == 0)
+				continue; // no envelope
+
+			if (oEnvelopeEntry.iDataOffset > oHeader.iDataSize ||
+				oEnvelopeEntry.iDataSize > oHeader.iDataSize - oEnvelopeEntry.iDataOffset ||
+				!oSounds[i].setEnvelope(AudioEnvelope::FromMemory(
+					pDataRegion + oEnvelopeEntry.iDataOffset, (size_t)oEnvelopeEntry.iDataSize)) ||
+				!oSounds[i].getEnvelope())
+				return false; // invalid envelope
+		}
+
+		m_spData = std::move(spOwner);
+		m_oSounds = std::move(oSounds);
+		m_oNames = std::move(oNames);
+		return true;
+	}
+
+}
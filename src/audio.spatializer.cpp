@@ -0,0 +1,412 @@
+#include "rl/audio.spatializer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h> // SSE
+
+
+
+
+
+namespace
+{
+
+	constexpr size_t iMatrixSize = 8; // 7.1 surround
+
+	// the smoothing factor is the share of the difference that's applied per 1 / fSmoothingRate
+	// seconds
+	constexpr float fSmoothingRate = 60.0f;
+
+	// minimum change of a matrix value for the matrix to be applied again
+	constexpr float fApplyThreshold = 1.0f / 4096.0f;
+
+	// real voices stay real down to 1 / fVoiceHysteresis of the audibility needed to get a voice,
+	// so emitters near the threshold don't switch back and forth on every update
+	constexpr float fVoiceHysteresis = 1.5f;
+
+	inline size_t PaddedCount(size_t iCount) noexcept { return (iCount + 3) & ~size_t(3); }
+
+	/// <summary>
+	/// 1.0f - min(1.0f, |vDiff| / vRadius)
+	/// </summary>
+	inline __m128 RelativeVolume(__m128 vDiff, __m128 vRadius) noexcept
+	{
+		const __m128 vOne = _mm_set1_ps(1.0f);
+		const __m128 vAbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+		const __m128 vAbs = _mm_and_ps(vDiff, vAbsMask);
+		return _mm_sub_ps(vOne, _mm_min_ps(vOne, _mm_div_ps(vAbs, vRadius)));
+	}
+
+}
+
+
+
+
+
+namespace rl
+{
+
+	/***********************************************************************************************
+	 class AudioSpatializer
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// STATIC METHODS
+
+	void AudioSpatializer::CalcMatrices(const float* pX, const float* pZ, const float* pRadius,
+		const float* pGain, size_t iCount, float* pMatrices) noexcept
+	{
+		const __m128 vOne = _mm_set1_ps(1.0f);
+		const __m128 vTwo = _mm_set1_ps(2.0f);
+		const __m128 vZero = _mm_setzero_ps();
+
+		// same formula as the one used by SoundInstance3D::set3DPos(), 4 positions at once
+		auto fnCalc = [&](const float* x, const float* z, const float* r, const float* g,
+			float* pDest)
+		{
+			const __m128 vX = _mm_loadu_ps(x);
+			const __m128 vZ = _mm_loadu_ps(z);
+			const __m128 vRadius = _mm_loadu_ps(r);
+			const __m128 vGain = g ? _mm_loadu_ps(g) : vOne;
+
+			const __m128 vRelLeft   = RelativeVolume(_mm_add_ps(vX, vOne), vRadius);
+			const __m128 vRelCenter = RelativeVolume(vX, vRadius);
+			const __m128 vRelRight  = RelativeVolume(_mm_sub_ps(vX, vOne), vRadius);
+			const __m128 vRelFront  = _mm_mul_ps(RelativeVolume(vZ, vRadius), vGain);
+			const __m128 vRelSide   = _mm_mul_ps(RelativeVolume(_mm_sub_ps(vZ, vOne), vRadius),
+				vGain);
+			const __m128 vRelBack   = _mm_mul_ps(RelativeVolume(_mm_sub_ps(vZ, vTwo), vRadius),
+				vGain);
+
+			// one register per speaker, one lane per position
+			__m128 vFrontLeft   = _mm_mul_ps(vRelFront, vRelLeft);
+			__m128 vFrontRight  = _mm_mul_ps(vRelFront, vRelRight);
+			__m128 vFrontCenter = _mm_mul_ps(vRelFront, vRelCenter);
+			__m128 vLFE         = vZero;
+			__m128 vBackLeft    = _mm_mul_ps(vRelBack, vRelLeft);
+			__m128 vBackRight   = _mm_mul_ps(vRelBack, vRelRight);
+			__m128 vSideLeft    = _mm_mul_ps(vRelSide, vRelLeft);
+			__m128 vSideRight   = _mm_mul_ps(vRelSide, vRelRight);
+
+			// --> one matrix per position
+			_MM_TRANSPOSE4_PS(vFrontLeft, vFrontRight, vFrontCenter, vLFE);
+			_MM_TRANSPOSE4_PS(vBackLeft, vBackRight, vSideLeft, vSideRight);
+
+			_mm_storeu_ps(pDest +  0, vFrontLeft);
+			_mm_storeu_ps(pDest +  4, vBackLeft);
+			_mm_storeu_ps(pDest +  8, vFrontRight);
+			_mm_storeu_ps(pDest + 12, vBackRight);
+			_mm_storeu_ps(pDest + 16, vFrontCenter);
+			_mm_storeu_ps(pDest + 20, vSideLeft);
+			_mm_storeu_ps(pDest + 24, vLFE);
+			_mm_storeu_ps(pDest + 28, vSideRight);
+		};
+
+		size_t i = 0;
+		for (; i + 4 <= iCount; i += 4)
+		{
+			fnCalc(pX + i, pZ + i, pRadius + i, pGain ? pGain + i : nullptr,
+				pMatrices + i * iMatrixSize);
+		}
+
+		// remaining positions --> padded copy
+		if (i < iCount)
+		{
+			const size_t iRemaining = iCount - i;
+
+			float x[4] = {}, z[4] = {}, r[4] = { 1.0f, 1.0f, 1.0f, 1.0f }, g[4] = {};
+			float fDest[4 * iMatrixSize];
+			for (size_t j = 0; j < iRemaining; ++j)
+			{
+				x[j] = pX[i + j];
+				z[j] = pZ[i + j];
+				r[j] = pRadius[i + j];
+				g[j] = pGain ? pGain[i + j] : 1.0f;
+			}
+
+			fnCalc(x, z, r, g, fDest);
+			std::copy(fDest, fDest + iRemaining * iMatrixSize, pMatrices + i * iMatrixSize);
+		}
+	}
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	AudioSpatializer::EmitterID AudioSpatializer::add(SoundInstance3D& instance,
+		const Audio3DPos& pos, float fDistance)
+	{
+		EmitterID id;
+		if (!m_oFreeIDs.empty())
+		{
+			id = m_oFreeIDs.back();
+			m_oFreeIDs.pop_back();
+		}
+		else
+		{
+			id = m_oSlotOfID.size();
+			m_oSlotOfID.push_back(InvalidEmitter);
+		}
+
+		const size_t iSlot = m_oInstances.size();
+		m_oSlotOfID[id] = iSlot;
+		m_oIDOfSlot.push_back(id);
+		m_oInstances.push_back(&instance);
+		m_oSnap.push_back(true);
+		m_oVirtualized.push_back(false);
+		resizeArrays(iSlot + 1);
+
+		m_oX[iSlot] = pos.x;
+		m_oZ[iSlot] = pos.z;
+		m_oRadius[iSlot] = pos.radius;
+		m_oDistance[iSlot] = fDistance;
+		instance.m_o3DPos = pos;
+
+		return id;
+	}
+
+	void AudioSpatializer::remove(EmitterID id)
+	{
+		if (id >= m_oSlotOfID.size() || m_oSlotOfID[id] == InvalidEmitter)
+			return;
+
+		const size_t iSlot = m_oSlotOfID[id];
+		SoundInstance3D& instance = *m_oInstances[iSlot];
+		if (instance.isVirtual() && m_iVirtualCount > 0)
+			--m_iVirtualCount;
+		if (m_oVirtualized[iSlot])
+			instance.devirtualize(); // the voice was only taken away by the spatializer
+
+		// move the last slot into the removed one
+		const size_t iLast = m_oInstances.size() - 1;
+		if (iSlot != iLast)
+		{
+			m_oX[iSlot] = m_oX[iLast];
+			m_oZ[iSlot] = m_oZ[iLast];
+			m_oRadius[iSlot] = m_oRadius[iLast];
+			m_oDistance[iSlot] = m_oDistance[iLast];
+			std::copy_n(m_oTarget.begin() + iLast * iMatrixSize, iMatrixSize,
+				m_oTarget.begin() + iSlot * iMatrixSize);
+			std::copy_n(m_oCurrent.begin() + iLast * iMatrixSize, iMatrixSize,
+				m_oCurrent.begin() + iSlot * iMatrixSize);
+			m_oInstances[iSlot] = m_oInstances[iLast];
+			m_oSnap[iSlot] = m_oSnap[iLast];
+			m_oVirtualized[iSlot] = m_oVirtualized[iLast];
+			m_oIDOfSlot[iSlot] = m_oIDOfSlot[iLast];
+			m_oSlotOfID[m_oIDOfSlot[iSlot]] = iSlot;
+		}
+
+		m_oInstances.pop_back();
+		m_oSnap.pop_back();
+		m_oVirtualized.pop_back();
+		m_oIDOfSlot.pop_back();
+		resizeArrays(iLast);
+
+		m_oSlotOfID[id] = InvalidEmitter;
+		m_oFreeIDs.push_back(id);
+	}
+
+	void AudioSpatializer::clear()
+	{
+		for (size_t iSlot = 0; iSlot < m_oInstances.size(); ++iSlot)
+		{
+			if (m_oVirtualized[iSlot])
+				m_oInstances[iSlot]->devirtualize();
+		}
+
+		m_oInstances.clear();
+		m_oSnap.clear();
+		m_oVirtualized.clear();
+		m_oIDOfSlot.clear();
+		m_oSlotOfID.clear();
+		m_oFreeIDs.clear();
+		resizeArrays(0);
+		m_iVirtualCount = 0;
+	}
+
+	void AudioSpatializer::setPos(EmitterID id, const Audio3DPos& pos) noexcept
+	{
+		if (id >= m_oSlotOfID.size() || m_oSlotOfID[id] == InvalidEmitter)
+			return;
+
+		const size_t iSlot = m_oSlotOfID[id];
+		m_oX[iSlot] = pos.x;
+		m_oZ[iSlot] = pos.z;
+		m_oRadius[iSlot] = pos.radius;
+		m_oInstances[iSlot]->m_o3DPos = pos;
+	}
+
+	void AudioSpatializer::setDistance(EmitterID id, float fDistance) noexcept
+	{
+		if (id >= m_oSlotOfID.size() || m_oSlotOfID[id] == InvalidEmitter)
+			return;
+
+		m_oDistance[m_oSlotOfID[id]] = fDistance;
+	}
+
+	const float* AudioSpatializer::getMatrix(EmitterID id) const noexcept
+	{
+		if (id >= m_oSlotOfID.size() || m_oSlotOfID[id] == InvalidEmitter)
+			return nullptr;
+
+		return m_oCurrent.data() + m_oSlotOfID[id] * iMatrixSize;
+	}
+
+	void AudioSpatializer::setSmoothing(float fFactor) noexcept
+	{
+		m_fSmoothing = std::clamp(fFactor, 0.01f, 1.0f);
+	}
+
+	void AudioSpatializer::update()
+	{
+		const auto tpNow = std::chrono::steady_clock::now();
+		float fElapsedTime = 1.0f / fSmoothingRate; // first update
+		if (m_tpLastUpdate != std::chrono::steady_clock::time_point{})
+			fElapsedTime = std::chrono::duration<float>(tpNow - m_tpLastUpdate).count();
+		m_tpLastUpdate = tpNow;
+
+		update(fElapsedTime);
+	}
+
+	void AudioSpatializer::update(float fElapsedTime)
+	{
+		const size_t iCount = m_oInstances.size();
+		if (iCount == 0)
+			return;
+
+		// 1. distance attenuation
+		const float fMin = std::max(m_oAttenuation.fMinDistance, 0.0001f);
+		const float fMax = std::max(m_oAttenuation.fMaxDistance, fMin);
+		for (size_t i = 0; i < iCount; ++i)
+		{
+			const float fDist = std::clamp(m_oDistance[i], fMin, fMax);
+			m_oGain[i] = fMin / (fMin + m_oAttenuation.fRolloff * (fDist - fMin));
+		}
+
+		// 2. voice management
+		updateVoices(iCount);
+
+		// 3. target matrices
+		CalcMatrices(m_oX.data(), m_oZ.data(), m_oRadius.data(), m_oGain.data(), iCount,
+			m_oTarget.data());
+
+		// 4. smoothing, scaled by the elapsed time: n steps of 1 / fSmoothingRate seconds each
+		//    leave (1 - factor)^n of the difference
+		float fFactor = 1.0f;
+		if (m_fSmoothing < 1.0f)
+			fFactor = 1.0f - std::pow(1.0f - m_fSmoothing,
+				std::max(fElapsedTime, 0.0f) * fSmoothingRate);
+		const __m128 vFactor = _mm_set1_ps(fFactor);
+		for (size_t i = 0; i < iCount * iMatrixSize; i += 4)
+		{
+			const __m128 vCurrent = _mm_loadu_ps(m_oCurrent.data() + i);
+			const __m128 vTarget = _mm_loadu_ps(m_oTarget.data() + i);
+			_mm_storeu_ps(m_oCurrent.data() + i, _mm_add_ps(vCurrent,
+				_mm_mul_ps(_mm_sub_ps(vTarget, vCurrent), vFactor)));
+		}
+
+		// 5. apply all changes at once
+		const UINT32 iOperationSet = AudioEngine::AllocateOperationSet();
+		bool bChanged = false;
+		for (size_t iSlot = 0; iSlot < iCount; ++iSlot)
+		{
+			float* pCurrent = m_oCurrent.data() + iSlot * iMatrixSize;
+			const float* pTarget = m_oTarget.data() + iSlot * iMatrixSize;
+
+			if (m_oSnap[iSlot])
+			{
+				std::copy_n(pTarget, iMatrixSize, pCurrent);
+				m_oSnap[iSlot] = false;
+			}
+
+			if (m_oInstances[iSlot]->applyMatrix(pCurrent, fApplyThreshold, iOperationSet))
+				bChanged = true;
+		}
+
+		if (bChanged)
+			AudioEngine::GetInstance().commitChanges(iOperationSet);
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void AudioSpatializer::resizeArrays(size_t iCount)
+	{
+		const size_t iPadded = PaddedCount(iCount);
+
+		m_oX.resize(iPadded);
+		m_oZ.resize(iPadded);
+		m_oRadius.resize(iPadded, 1.0f);
+		m_oDistance.resize(iPadded);
+		m_oGain.resize(iPadded);
+		m_oTarget.resize(iPadded * iMatrixSize);
+		m_oCurrent.resize(iPadded * iMatrixSize);
+	}
+
+	void AudioSpatializer::updateVoices(size_t iCount)
+	{
+		// 1. audibility of all playing emitters
+		m_oRanking.clear();
+		for (size_t iSlot = 0; iSlot < iCount; ++iSlot)
+		{
+			SoundInstance3D& instance = *m_oInstances[iSlot];
+			if (instance.isVirtual())
+				instance.updateVirtual();
+			if (!instance.getPlaying())
+				continue;
+
+			float fAudibility = instance.m_fVolume * m_oGain[iSlot];
+			if (!instance.isVirtual())
+				fAudibility *= fVoiceHysteresis;
+			if (fAudibility >= m_fAudibilityThreshold)
+				m_oRanking.push_back({ fAudibility, iSlot });
+		}
+
+		// 2. the most audible emitters get a voice
+		const size_t iVoiceCount = std::min(m_oRanking.size(), m_iVoiceLimit);
+		if (iVoiceCount < m_oRanking.size())
+		{
+			std::nth_element(m_oRanking.begin(), m_oRanking.begin() + iVoiceCount,
+				m_oRanking.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+		}
+		m_oAudible.assign(iCount, false);
+		for (size_t i = 0; i < iVoiceCount; ++i)
+		{
+			m_oAudible[m_oRanking[i].second] = true;
+		}
+
+		// 3. virtualize first, so the voice count never exceeds the limit
+		for (size_t iSlot = 0; iSlot < iCount; ++iSlot)
+		{
+			SoundInstance3D& instance = *m_oInstances[iSlot];
+			if (!m_oAudible[iSlot] && !instance.isVirtual() && instance.virtualize())
+				m_oVirtualized[iSlot] = true;
+		}
+
+		m_iVirtualCount = 0;
+		for (size_t iSlot = 0; iSlot < iCount; ++iSlot)
+		{
+			SoundInstance3D& instance = *m_oInstances[iSlot];
+			if (m_oAudible[iSlot] && instance.isVirtual() && instance.devirtualize())
+			{
+				m_oSnap[iSlot] = true; // new voice --> no smoothing from the old matrix
+				m_oVirtualized[iSlot] = false;
+			}
+
+			if (instance.isVirtual())
+				++m_iVirtualCount;
+		}
+	}
+
+}
@@ -3,6 +3,7 @@
 #include "rl/unicode.hpp"
 
 #include <memory>
+#include <vector>
 #include <Windows.h>
 
 
@@ -490,6 +491,16 @@ namespace rl
 
 	BitmapFontFaceCreator& BitmapFontFaceCreator::operator=(const FontFaceClass& other)
 	{
+		if (other.hasData())
+		{
+			// check all characters at once, before the current data is discarded
+			std::vector<char32_t> oCodepoints;
+			oCodepoints.reserve(other.getCharCount());
+			for (const auto& o : other)
+				oCodepoints.push_back(o.iCodepoint);
+			checkNoncharacters(oCodepoints.data(), oCodepoints.size());
+		}
+
 		clear();
 		if (!other.hasData())
 			return *this;
@@ -559,6 +570,13 @@ namespace rl
 				"value");
 	}
 
+	void BitmapFontFaceCreator::checkNoncharacters(const char32_t* p, size_t iCount)
+	{
+		if (Unicode::FindNoncharacter(p, iCount) < iCount)
+			throw std::exception("rl::BitmapFontFaceCreator: Tried to work with a noncharacter "
+				"value");
+	}
+
 
 
 
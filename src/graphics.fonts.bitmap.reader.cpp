@@ -1,8 +1,10 @@
 #include "rl/graphics.fonts.bitmap.reader.hpp"
 
+#include <algorithm> // std::lower_bound
 #include <math.h>
 #include <memory> // smart pointers
 #include <stdint.h>
+#include <vector>
 #include <Windows.h>
 
 
@@ -12,6 +14,98 @@
 namespace rl
 {
 
+	//==============================================================================================
+	// CHARACTER INDEX
+
+	// The codepoints are grouped into pages of 256 codepoints.
+	// Densely populated pages (like ASCII or the CJK blocks) get a table with the position of
+	// every codepoint, all other pages are searched binary (only within the page).
+
+	struct FontFaceIndex
+	{
+		std::vector<uint32_t> oPageStart; // per page (+ end): index of the first character info
+		std::vector<uint32_t> oDensePage; // per page: index of the dense page or iNoDensePage
+		std::vector<uint16_t> oDenseOffsets; // per codepoint of the dense pages: offset or iNoChar
+	};
+
+	namespace
+	{
+
+		constexpr uint32_t iPageBits = 8;
+		constexpr uint32_t iPageSize = 1 << iPageBits;
+		constexpr uint32_t iDensePageMinChars = 32; // a dense page takes 512 bytes
+		constexpr uint32_t iMaxIndexedCodepoint = 0x10FFFF;
+		constexpr uint32_t iNoDensePage = UINT32_MAX;
+		constexpr uint16_t iNoChar = UINT16_MAX;
+
+		/// <summary>
+		/// Create the lookup index of a font face that was just loaded
+		/// </summary>
+		/// <param name="cb">= the size, in bytes, of the data of the font face</param>
+		/// <returns>Was the character table valid?</returns>
+		bool FontFaceCreateIndex(FontFace* face, size_t cb)
+		{
+			face->pIndex = nullptr;
+			if (cb < sizeof(FontFaceHeader) ||
+				(cb - sizeof(FontFaceHeader)) / sizeof(FontFaceCharInfo) <
+				face->pHeader->iCharCount)
+				return false; // character table out of bounds
+
+			const uint32_t iCharCount = face->pHeader->iCharCount;
+			const FontFaceCharInfo* pInfos = face->pInfos;
+			for (uint32_t i = 1; i < iCharCount; ++i)
+			{
+				if (pInfos[i - 1].iCodepoint >= pInfos[i].iCodepoint)
+					return true; // not sorted --> no index, characters can't be found reliably
+			}
+
+			uint32_t iPageCount = 0;
+			if (iCharCount > 0)
+				iPageCount =
+					(std::min(pInfos[iCharCount - 1].iCodepoint, iMaxIndexedCodepoint) >> iPageBits)
+					+ 1;
+
+			auto upIndex = std::make_unique<FontFaceIndex>();
+			upIndex->oPageStart.resize((size_t)iPageCount + 1);
+			upIndex->oDensePage.resize(iPageCount, iNoDensePage);
+
+			uint32_t iChar = 0;
+			for (uint32_t iPage = 0; iPage <= iPageCount; ++iPage)
+			{
+				while (iChar < iCharCount && (pInfos[iChar].iCodepoint >> iPageBits) < iPage)
+				{
+					++iChar;
+				}
+				upIndex->oPageStart[iPage] = iChar;
+			}
+
+			for (uint32_t iPage = 0; iPage < iPageCount; ++iPage)
+			{
+				const uint32_t iStart = upIndex->oPageStart[iPage];
+				const uint32_t iEnd = upIndex->oPageStart[(size_t)iPage + 1];
+				if (iEnd - iStart < iDensePageMinChars)
+					continue;
+
+				const size_t iDenseOffset = upIndex->oDenseOffsets.size();
+				upIndex->oDensePage[iPage] = uint32_t(iDenseOffset / iPageSize);
+				upIndex->oDenseOffsets.resize(iDenseOffset + iPageSize, iNoChar);
+				uint16_t* pOffsets = upIndex->oDenseOffsets.data() + iDenseOffset;
+				for (uint32_t i = iStart; i < iEnd; ++i)
+				{
+					pOffsets[pInfos[i].iCodepoint & (iPageSize - 1)] = uint16_t(i - iStart);
+				}
+			}
+
+			face->pIndex = upIndex.release();
+			return true;
+		}
+
+	}
+
+
+
+
+
 	bool FontFaceCreate(FontFace* dest, const uint8_t* buf, size_t cb, const uint8_t(&typever)[2])
 	{
 		if (cb > UINT32_MAX)
@@ -36,6 +130,12 @@ namespace rl
 				dest->pHeader = (FontFaceHeader*)dest->pData;
 				dest->pInfos = (FontFaceCharInfo*)(dest->pData + sizeof(FontFaceHeader));
 
+				if (!FontFaceCreateIndex(dest, cb))
+				{
+					FontFaceFree(dest);
+					return false;
+				}
+
 				return true;
 
 				//----------------------------------------------------------------------------------
@@ -81,33 +181,50 @@ namespace rl
 		memcpy_s(dest->pData, size, src->pData, size);
 		dest->pHeader = (FontFaceHeader*)dest->pData;
 		dest->pInfos = (FontFaceCharInfo*)(dest->pData + sizeof(FontFaceHeader));
+		dest->pIndex = src->pIndex ? new FontFaceIndex(*src->pIndex) : nullptr;
 	}
 
 	void FontFaceFree(FontFace* data)
 	{
 		if (data->pData)
 			delete[] data->pData;
+		delete data->pIndex;
 
 		*data = {};
 	}
 
 	const FontFaceCharInfo* FontFaceFindChar(const FontFace* face, uint32_t ch)
 	{
-		for (size_t i = 0; i < face->pHeader->iCharCount; i++)
-		{
-			const FontFaceCharInfo* pInfos = face->pInfos + i;
+		const FontFaceCharInfo* pBegin = face->pInfos;
+		const FontFaceCharInfo* pEnd = face->pInfos + face->pHeader->iCharCount;
+
+		// it's assumed that all characters are sorted in ascending order
 
-			// it's assumed that all characters are sorted in ascending order
+		const FontFaceIndex* pIndex = face->pIndex;
+		if (pIndex)
+		{
+			const size_t iPage = std::min<size_t>(ch >> iPageBits, pIndex->oDensePage.size());
+			if (iPage < pIndex->oDensePage.size() && pIndex->oDensePage[iPage] != iNoDensePage)
+			{
+				const uint16_t iOffset = pIndex->oDenseOffsets[
+					(size_t)pIndex->oDensePage[iPage] * iPageSize + (ch & (iPageSize - 1))];
+				if (iOffset == iNoChar)
+					return nullptr;
+				return pBegin + pIndex->oPageStart[iPage] + iOffset;
+			}
 
-			if (pInfos->iCodepoint < ch)
-				continue;
-			if (pInfos->iCodepoint == ch)
-				return pInfos;
-			if (pInfos->iCodepoint > ch)
-				return nullptr;
+			// only search the page (or all characters after the last page)
+			if (iPage < pIndex->oDensePage.size())
+				pEnd = pBegin + pIndex->oPageStart[iPage + 1];
+			pBegin += pIndex->oPageStart[iPage];
 		}
 
-		return nullptr;
+		const FontFaceCharInfo* pInfo = std::lower_bound(pBegin, pEnd, ch,
+			[](const FontFaceCharInfo& info, uint32_t ch) { return info.iCodepoint < ch; });
+		if (pInfo == pEnd || pInfo->iCodepoint != ch)
+			return nullptr;
+
+		return pInfo;
 	}
 
 	// ToDo: Check for correct functionality
@@ -246,11 +363,7 @@ namespace rl
 
 		clear();
 		if (other.hasData())
-		{
-			m_oData.pData = new uint8_t[other.m_oData.pHeader->iDataSize];
-			m_oData.pHeader = (FontFaceHeader*)m_oData.pData;
-			m_oData.pInfos = (FontFaceCharInfo*)(m_oData.pData + sizeof(FontFaceHeader));
-		}
+			FontFaceCopy(&m_oData, &other.m_oData);
 
 		return *this;
 	}
@@ -0,0 +1,416 @@
+#include "rl/text.codepages.hpp"
+
+#include <algorithm>
+#include <emmintrin.h> // SSE2
+#include <map>
+#include <memory>
+#include <mutex>
+#include <Windows.h>
+
+
+
+
+
+
+
+namespace rl
+{
+
+	namespace
+	{
+
+		//==========================================================================================
+		// DOS GLYPHS
+
+		// the symbols that DOS displayed for the control characters 0x00 to 0x1F
+		constexpr char16_t cDOS[] =
+		{
+			// 0x00..0x0F
+			u'\u0000', u'\u263A', u'\u263B', u'\u2665', u'\u2666', u'\u2663', u'\u2660', u'\u2022',
+			u'\u25D8', u'\u25CB', u'\u25D9', u'\u2642', u'\u2640', u'\u266A', u'\u266B', u'\u263C',
+
+			// 0x10..0x1F
+			u'\u25BA', u'\u25C4', u'\u2195', u'\u203C', u'\u00B6', u'\u00A7', u'\u25AC', u'\u21A8',
+			u'\u2191', u'\u2193', u'\u2192', u'\u2190', u'\u221F', u'\u2194', u'\u25B2', u'\u25BC'
+		};
+		constexpr char16_t cIBM[] = // codepage 864
+		{
+			// 0x00..0x0F
+			u'\u0000', u'\u263A', u'\u266A', u'\u266B', u'\u263C', u'\u2550', u'\u2551', u'\u256C',
+			u'\u2563', u'\u2566', u'\u2560', u'\u2569', u'\u2557', u'\u2554', u'\u255A', u'\u255D',
+
+			// 0x10..0x1F
+			u'\u25BA', u'\u25C4', u'\u2195', u'\u203C', u'\u00B6', u'\u00A7', u'\u25AC', u'\u21A8',
+			u'\u2191', u'\u2193', u'\u2192', u'\u2190', u'\u221F', u'\u2194', u'\u25B2', u'\u25BC'
+		};
+		constexpr char16_t cHouse = u'\u2302'; // displayed for 0x7F
+
+		/// <summary>
+		/// Get the symbols DOS displayed for the control characters of a codepage
+		/// </summary>
+		/// <returns><c>nullptr</c> if the codepage is no DOS codepage</returns>
+		const char16_t* GetDOSGlyphs(uint16_t iCodepage) noexcept
+		{
+			switch (iCodepage)
+			{
+			case 437:
+			case 708:
+			case 720:
+			case 737:
+			case 775:
+			case 850:
+			case 852:
+			case 855:
+			case 857:
+			case 860:
+			case 861:
+			case 862:
+			case 863:
+			case 865:
+			case 866:
+			case 869:
+				return cDOS;
+
+			case 864:
+				return cIBM;
+
+			default:
+				return nullptr;
+			}
+		}
+
+
+
+
+
+		//==========================================================================================
+		// VECTORIZED BLOCKS
+
+		// Store 16 UTF-16 code units
+
+		inline void Store(__m128i v1, __m128i v2, char16_t* p) noexcept
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p + 8), v2);
+		}
+
+		inline void Store(__m128i v1, __m128i v2, char32_t* p) noexcept
+		{
+			const __m128i vZero = _mm_setzero_si128();
+			auto pv = reinterpret_cast<__m128i*>(p);
+			_mm_storeu_si128(pv, _mm_unpacklo_epi16(v1, vZero));
+			_mm_storeu_si128(pv + 1, _mm_unpackhi_epi16(v1, vZero));
+			_mm_storeu_si128(pv + 2, _mm_unpacklo_epi16(v2, vZero));
+			_mm_storeu_si128(pv + 3, _mm_unpackhi_epi16(v2, vZero));
+		}
+
+		// Encode as many ASCII blocks as possible
+		// Return the count of code units encoded
+
+		size_t EncodeASCII(const char16_t* pSrc, size_t iLen, char* pDest) noexcept
+		{
+			const __m128i vNonASCII = _mm_set1_epi16((short)0xFF80);
+
+			size_t i = 0;
+			for (; i + 8 <= iLen; i += 8)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, vNonASCII),
+					_mm_setzero_si128())) != 0xFFFF)
+					break;
+
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(pDest + i), _mm_packus_epi16(v, v));
+			}
+			return i;
+		}
+
+		size_t EncodeASCII(const char32_t* pSrc, size_t iLen, char* pDest) noexcept
+		{
+			const __m128i vNonASCII = _mm_set1_epi32((int)0xFFFFFF80);
+			const __m128i vZero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 16 <= iLen; i += 16)
+			{
+				auto p = reinterpret_cast<const __m128i*>(pSrc + i);
+				const __m128i v1 = _mm_loadu_si128(p);
+				const __m128i v2 = _mm_loadu_si128(p + 1);
+				const __m128i v3 = _mm_loadu_si128(p + 2);
+				const __m128i v4 = _mm_loadu_si128(p + 3);
+				const __m128i vAll = _mm_or_si128(_mm_or_si128(v1, v2), _mm_or_si128(v3, v4));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(vAll, vNonASCII), vZero)) !=
+					0xFFFF)
+					break;
+
+				const __m128i v16 = _mm_packus_epi16(_mm_packs_epi32(v1, v2),
+					_mm_packs_epi32(v3, v4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + i), v16);
+			}
+			return i;
+		}
+
+
+
+
+
+		//==========================================================================================
+		// STRINGS
+
+		/// <summary>
+		/// Decode a string via the decoding table of a codepage
+		/// </summary>
+		/// <param name="bASCII">= are bytes 0x00 to 0x7F the same as in ASCII?</param>
+		template <typename TDest>
+		Unicode::TranscodeResult Decode(const CodepageTable& oTable, bool bASCII, const char* pSrc,
+			size_t iSrcLen, TDest* pDest, size_t iDestLen) noexcept
+		{
+			const size_t iLen = std::min(iSrcLen, iDestLen);
+			auto pBytes = reinterpret_cast<const uint8_t*>(pSrc);
+			const __m128i vZero = _mm_setzero_si128();
+			const __m128i vUndefined = _mm_set1_epi16((short)CodepageTable::Undefined);
+
+			size_t i = 0;
+			for (; i + 16 <= iLen; i += 16)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				if (bASCII && _mm_movemask_epi8(v) == 0)
+				{
+					Store(_mm_unpacklo_epi8(v, vZero), _mm_unpackhi_epi8(v, vZero), pDest + i);
+					continue;
+				}
+
+				// SSE2 has no gather instruction; the table lookup is scalar but branch-free
+				alignas(16) char16_t cBlock[16];
+				for (size_t iChar = 0; iChar < 16; ++iChar)
+				{
+					cBlock[iChar] = oTable.decode(pBytes[i + iChar]);
+				}
+				const __m128i v1 = _mm_load_si128(reinterpret_cast<const __m128i*>(cBlock));
+				const __m128i v2 = _mm_load_si128(reinterpret_cast<const __m128i*>(cBlock + 8));
+				if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi16(v1, vUndefined),
+					_mm_cmpeq_epi16(v2, vUndefined))) != 0)
+					break; // the position of the undefined byte is searched for below
+
+				Store(v1, v2, pDest + i);
+			}
+
+			Unicode::TranscodeResult result = { Unicode::TranscodeStatus::OK, 0, 0 };
+			for (; i < iLen; ++i)
+			{
+				const char16_t ch = oTable.decode(pBytes[i]);
+				if (ch == CodepageTable::Undefined)
+				{
+					result.eStatus = Unicode::TranscodeStatus::InvalidInput;
+					break;
+				}
+				pDest[i] = ch;
+			}
+
+			result.iRead = i;
+			result.iWritten = i;
+			if (result.eStatus == Unicode::TranscodeStatus::OK && i < iSrcLen)
+				result.eStatus = Unicode::TranscodeStatus::BufferTooSmall;
+			return result;
+		}
+
+		/// <summary>
+		/// Encode a string via the encoding table of a codepage
+		/// </summary>
+		/// <param name="bASCII">= are bytes 0x00 to 0x7F the same as in ASCII?</param>
+		template <typename TSrc>
+		Unicode::TranscodeResult Encode(const CodepageTable& oTable, bool bASCII, const TSrc* pSrc,
+			size_t iSrcLen, char* pDest, size_t iDestLen) noexcept
+		{
+			constexpr size_t iBlockSize = 16; // characters encoded before the next vector try
+
+			const size_t iLen = std::min(iSrcLen, iDestLen);
+			Unicode::TranscodeResult result = { Unicode::TranscodeStatus::OK, 0, 0 };
+
+			size_t i = 0;
+			while (i < iLen)
+			{
+				if (bASCII)
+					i += EncodeASCII(pSrc + i, iLen - i, pDest + i);
+
+				// the lookup is branch-free, invalid characters are only searched for on failure
+				const size_t iBlockEnd = std::min(iLen, i + iBlockSize);
+				bool bValid = true;
+				for (size_t iChar = i; iChar < iBlockEnd; ++iChar)
+				{
+					uint8_t c = 0;
+					bValid &= oTable.encode(pSrc[iChar], c);
+					pDest[iChar] = (char)c;
+				}
+
+				if (!bValid)
+				{
+					uint8_t c;
+					while (oTable.encode(pSrc[i], c))
+					{
+						++i;
+					}
+					result.eStatus = Unicode::TranscodeStatus::InvalidInput;
+					result.iRead = i;
+					result.iWritten = i;
+					return result;
+				}
+				i = iBlockEnd;
+			}
+
+			result.iRead = i;
+			result.iWritten = i;
+			if (i < iSrcLen)
+				result.eStatus = Unicode::TranscodeStatus::BufferTooSmall;
+			return result;
+		}
+	}
+
+
+
+
+
+	/***********************************************************************************************
+	 class CodepageTable
+	***********************************************************************************************/
+
+	//==============================================================================================
+	// STATIC METHODS
+
+	const CodepageTable* CodepageTable::Get(uint16_t iCodepage, bool bGlyphs)
+	{
+		static std::mutex mux;
+		static std::map<uint32_t, std::unique_ptr<CodepageTable>> oTables;
+
+		const uint32_t iKey = iCodepage | (uint32_t(bGlyphs) << 16);
+		std::unique_lock lock(mux);
+		const auto it = oTables.find(iKey);
+		if (it != oTables.end())
+			return it->second.get();
+
+		if (!IsValidCodePage(iCodepage))
+			return nullptr;
+
+		std::unique_ptr<CodepageTable> up(new CodepageTable());
+		up->m_iCodepage = iCodepage;
+		bool bDefined = false;
+		for (size_t i = 0; i < 256; ++i)
+		{
+			const char c = (char)i;
+			wchar_t sz[2] = {};
+			if (MultiByteToWideChar(iCodepage, MB_ERR_INVALID_CHARS, &c, 1, sz, 2) == 1 &&
+				(sz[0] & 0xF800) != 0xD800)
+			{
+				up->m_cDecode[i] = sz[0];
+				bDefined = true;
+			}
+			else
+				up->m_cDecode[i] = Undefined;
+		}
+		if (!bDefined)
+			return nullptr; // conversion not supported
+
+		// DOS displayed symbols instead of control characters
+		const char16_t* pGlyphs = bGlyphs ? GetDOSGlyphs(iCodepage) : nullptr;
+		if (pGlyphs)
+		{
+			for (auto& ch : up->m_cDecode)
+			{
+				if (ch <= 0x1F)
+					ch = pGlyphs[ch];
+				else if (ch == 0x7F)
+					ch = cHouse;
+			}
+		}
+
+		up->createReverseTable();
+
+		const CodepageTable* result = up.get();
+		oTables.emplace(iKey, std::move(up));
+		return result;
+	}
+
+
+
+
+
+	//==============================================================================================
+	// METHODS
+
+	//----------------------------------------------------------------------------------------------
+	// PUBLIC METHODS
+
+	bool CodepageTable::encode(char32_t ch, uint8_t& iDest) const noexcept
+	{
+		// characters outside the BMP are never part of a codepage; the empty page rejects them
+		const size_t iPage = (ch <= 0xFFFF) ? m_iEncodePage[ch >> 8] : 0;
+		const uint8_t c = m_oEncode[iPage * 256 + (ch & 0xFF)];
+		if (m_cDecode[c] != ch || ch == Undefined)
+			return false;
+
+		iDest = c;
+		return true;
+	}
+
+	Unicode::TranscodeResult CodepageTable::decode(const char* pSrc, size_t iSrcLen,
+		char16_t* pDest, size_t iDestLen) const noexcept
+	{
+		return Decode(*this, m_bASCII, pSrc, iSrcLen, pDest, iDestLen);
+	}
+
+	Unicode::TranscodeResult CodepageTable::decode(const char* pSrc, size_t iSrcLen,
+		char32_t* pDest, size_t iDestLen) const noexcept
+	{
+		return Decode(*this, m_bASCII, pSrc, iSrcLen, pDest, iDestLen);
+	}
+
+	Unicode::TranscodeResult CodepageTable::encode(const char16_t* pSrc, size_t iSrcLen,
+		char* pDest, size_t iDestLen) const noexcept
+	{
+		return Encode(*this, m_bASCII, pSrc, iSrcLen, pDest, iDestLen);
+	}
+
+	Unicode::TranscodeResult CodepageTable::encode(const char32_t* pSrc, size_t iSrcLen,
+		char* pDest, size_t iDestLen) const noexcept
+	{
+		return Encode(*this, m_bASCII, pSrc, iSrcLen, pDest, iDestLen);
+	}
+
+
+
+
+
+	//----------------------------------------------------------------------------------------------
+	// PRIVATE METHODS
+
+	void CodepageTable::createReverseTable()
+	{
+		m_bASCII = true;
+		for (char16_t i = 0; i < 0x80; ++i)
+		{
+			if (m_cDecode[i] != i)
+			{
+				m_bASCII = false;
+				break;
+			}
+		}
+
+		m_oEncode.assign(256, 0); // the empty page
+		std::fill(std::begin(m_iEncodePage), std::end(m_iEncodePage), uint16_t(0));
+		for (size_t i = 256; i > 0; --i) // backwards, so the first byte of a character is kept
+		{
+			const uint8_t c = uint8_t(i - 1);
+			const char16_t ch = m_cDecode[c];
+			if (ch == Undefined)
+				continue;
+
+			uint16_t& iPage = m_iEncodePage[ch >> 8];
+			if (iPage == 0)
+			{
+				iPage = uint16_t(m_oEncode.size() / 256);
+				m_oEncode.resize(m_oEncode.size() + 256, 0);
+			}
+			m_oEncode[iPage * 256 + (ch & 0xFF)] = c;
+		}
+	}
+
+}
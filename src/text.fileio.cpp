@@ -1,6 +1,7 @@
 #include "rl/text.fileio.hpp"
 
 #include "rl/data.endian.hpp"
+#include "rl/text.codepages.hpp"
 #include "rl/unicode.hpp"
 
 #include <codecvt>
@@ -14,16 +15,137 @@
 namespace rl
 {
 
-	/// <summary>
-	/// A table of the Unicode values of values 0x80 through 0x9F of Codepage 1252
-	/// </summary>
-	const wchar_t cCP1252_Table[] =
+	namespace
 	{
-		L'\u20AC', L'\u0000', L'\u201A', L'\u0192', L'\u201E', L'\u2026', L'\u2020', L'\u2021',
-		L'\u02C6', L'\u2030', L'\u0160', L'\u2039', L'\u0152', L'\u0000', L'\u017D', L'\u0000',
-		L'\u0000', L'\u2018', L'\u2019', L'\u201C', L'\u201D', L'\u2022', L'\u2013', L'\u2014',
-		L'\u02DC', L'\u2122', L'\u0161', L'\u203A', L'\u0153', L'\u0000', L'\u017E', L'\u0178'
-	};
+
+		static_assert(sizeof(wchar_t) == sizeof(char16_t), "wchar_t is expected to be UTF-16");
+
+		/// <summary>
+		/// Get the codepage tables for a <c>TextFileInfo</c> with <c>TextEncoding::Codepage</c>
+		/// </summary>
+		const CodepageTable* GetCodepage(const TextFileInfo& oEncoding)
+		{
+			return CodepageTable::Get(oEncoding.iCodepage ? oEncoding.iCodepage : 1252);
+		}
+
+		/// <summary>
+		/// Decode codepage text; undefined bytes are decoded to <c>'?'</c>
+		/// </summary>
+		void DecodeCodepage(const CodepageTable& oTable, const char* pSrc, size_t len,
+			std::wstring& sDest)
+		{
+			sDest.resize(len);
+			auto pDest = reinterpret_cast<char16_t*>(sDest.data());
+
+			size_t i = 0;
+			while (i < len)
+			{
+				const auto oResult = oTable.decode(pSrc + i, len - i, pDest + i, len - i);
+				i += oResult.iRead;
+				if (oResult.eStatus == Unicode::TranscodeStatus::InvalidInput)
+					pDest[i++] = u'?';
+			}
+		}
+
+		/// <summary>
+		/// Encode UTF-16 text to a codepage; unknown characters are encoded as <c>'?'</c>
+		/// </summary>
+		std::string EncodeCodepage(const CodepageTable& oTable, const char16_t* pSrc, size_t len)
+		{
+			std::string result(len, 0);
+
+			size_t iRead = 0;
+			size_t iWritten = 0;
+			while (iRead < len)
+			{
+				const auto oResult = oTable.encode(pSrc + iRead, len - iRead,
+					result.data() + iWritten, len - iWritten);
+				iRead += oResult.iRead;
+				iWritten += oResult.iWritten;
+				if (oResult.eStatus == Unicode::TranscodeStatus::InvalidInput)
+				{
+					// a single '?' for surrogate pairs
+					if (UTF16::IsHighSurrogate(pSrc[iRead]) && iRead + 1 < len &&
+						UTF16::IsLowSurrogate(pSrc[iRead + 1]))
+						++iRead;
+					++iRead;
+					result[iWritten++] = '?';
+				}
+			}
+			result.resize(iWritten);
+
+			return result;
+		}
+
+		/// <summary>
+		/// Check the UTF-16 or UTF-32 contents of a file for noncharacters, chunk by chunk<para/>
+		/// The file must be positioned behind the BOM.
+		/// </summary>
+		/// <param name="fnLinebreak">
+		/// = a function that is called with the <c>rl::LineBreak</c> value of every linebreak
+		/// (until a noncharacter is found)
+		/// </param>
+		/// <returns>Did the file contain a noncharacter?</returns>
+		template <typename TChar, typename TFn>
+		bool ContainsNoncharacters(std::basic_ifstream<uint8_t>& file, bool bSwapEndian,
+			TFn&& fnLinebreak)
+		{
+			constexpr size_t iChunkLen = 4096;
+			TChar oChunk[iChunkLen];
+			size_t iCarry = 0; // code units carried over from the previous chunk
+
+			while (true)
+			{
+				file.read(reinterpret_cast<uint8_t*>(oChunk + iCarry),
+					(iChunkLen - iCarry) * sizeof(TChar));
+				const size_t iLen = iCarry + size_t(file.gcount()) / sizeof(TChar);
+				if (iLen == 0)
+					return false;
+				if (bSwapEndian)
+				{
+					for (size_t i = iCarry; i < iLen; ++i)
+						oChunk[i] = Endian::Swap(oChunk[i]);
+				}
+				const bool bLastChunk = iLen < iChunkLen;
+
+				// surrogate pairs and Windows linebreaks might be split between two chunks
+				size_t iCheckLen = iLen;
+				if (!bLastChunk && (oChunk[iLen - 1] == '\r' ||
+					(sizeof(TChar) == 2 && UTF16::IsHighSurrogate(char16_t(oChunk[iLen - 1])))))
+					--iCheckLen;
+
+				if (Unicode::FindNoncharacter(oChunk, iCheckLen) < iCheckLen)
+					return true;
+
+				for (size_t i = 0; i < iCheckLen; ++i)
+				{
+					switch (oChunk[i])
+					{
+					case '\n': // UNIX linebreak
+						fnLinebreak(LineBreak::UNIX);
+						break;
+
+					case '\r': // Macintosh/Windows linebreak
+						if (i + 1 < iLen && oChunk[i + 1] == '\n')
+						{
+							fnLinebreak(LineBreak::Windows);
+							++i;
+						}
+						else
+							fnLinebreak(LineBreak::Macintosh);
+						break;
+					}
+				}
+
+				if (bLastChunk)
+					return false;
+				iCarry = iLen - iCheckLen;
+				if (iCarry)
+					oChunk[0] = oChunk[iLen - 1];
+			}
+		}
+
+	}
 
 
 	bool GetTextFileInfo(const wchar_t* szFilePath, TextFileInfo& oDest, TextFileInfo_Get& oDestEx,
@@ -341,26 +463,8 @@ namespace rl
 			if (oDest.iFlags & flags::BigEndian)
 				break; // only check little endian
 
-			{
-				bool bError = false;
-				uint32_t iBuf = 0;
-
-				while (!FILE_EOF())
-				{
-					file.read(reinterpret_cast<uint8_t*>(&iBuf), 4);
-					if constexpr (BigEndian) // only little endian is checked
-						iBuf = Endian::Swap(iBuf);
-
-					if (Unicode::IsNoncharacter(iBuf))
-					{
-						bError = true;
-						break; // while
-					}
-				}
-
-				if (!bError)
-					break;
-			}
+			if (!ContainsNoncharacters<char32_t>(file, BigEndian /* swap LE */, [](LineBreak) {}))
+				break;
 
 			file.clear();
 			file.seekg(lenBOM);
@@ -492,139 +596,25 @@ namespace rl
 		}
 
 		case TextEncoding::UTF16:
-		{
-			uint16_t iBuf = 0;
-			while (!FILE_EOF() && file.peek() != EOF)
-			{
-				file.read(reinterpret_cast<uint8_t*>(&iBuf), 2);
-				if (bSwapEndian)
-					iBuf = Endian::Swap(iBuf);
-				if ((iBuf & 0xFC00) == 0b1101'1000'0000'0000) // high surrogate
-				{
-					char32_t cRaw = char32_t(iBuf & 0x03FF) << 10;
-					file.read(reinterpret_cast<uint8_t*>(&iBuf), 2);
-					if (bSwapEndian)
-						iBuf = Endian::Swap(iBuf);
-					cRaw |= iBuf & 0x03FF;
-
-					if (Unicode::IsNoncharacter(cRaw))
-					{
-						oDest.eEncoding = TextEncoding::Codepage;
-						break; // while
-					}
-				}
-				else // BMP value --> check linebreaks
-				{
-					switch (iBuf)
-					{
-					case '\n': // UNIX linebreak
-						lb = LineBreak::UNIX;
-						break; // switch
-
-					case '\r': // Macintosh/Windows linebreak
-						if (!FILE_EOF())
-						{
-							const auto pos = file.tellg();
-							file.read(reinterpret_cast<uint8_t*>(&iBuf), 2);
-							if (bSwapEndian)
-								iBuf = Endian::Swap(iBuf);
-
-							if (iBuf == '\n')
-								lb = LineBreak::Windows;
-							else
-							{
-								file.clear();
-								file.seekg(pos);
-							}
-						}
-						else
-							lb = LineBreak::Macintosh;
-
-						break; // switch
-
-					default:
-						if (Unicode::IsNoncharacter(iBuf))
-						{
-							oDest.eEncoding = TextEncoding::Codepage;
-							break; // switch
-						}
-						continue;
-					}
-
-					if (oDest.eEncoding == TextEncoding::Codepage)
-						break; // while
-
-					if (bConsequentLinebreaks && bLinebreakRead && lb != oDest.eLineBreaks)
-						bConsequentLinebreaks = false;
-
-					oDest.eLineBreaks = lb;
-					bLinebreakRead = true;
-				}
-			}
-			break;
-		}
-
 		case TextEncoding::UTF32:
 		{
-			char32_t cRaw = 0;
-			while (!FILE_EOF())
+			auto fnLinebreak = [&](LineBreak lbRead)
 			{
-				file.read(reinterpret_cast<uint8_t*>(&cRaw), 4);
-				if (bSwapEndian)
-					cRaw = Endian::Swap((uint32_t)cRaw);
-
-				switch (cRaw)
-				{
-				case '\n': // UNIX linebreak
-					lb = LineBreak::UNIX;
-					break;
-
-				case '\r': // Macintosh/Windows linebreak
-					if (!FILE_EOF())
-					{
-						char32_t cRaw2 = 0;
-						const auto pos = file.tellg();
-						file.read(reinterpret_cast<uint8_t*>(&cRaw2), 4);
-						if (bSwapEndian)
-							cRaw2 = Endian::Swap((uint32_t)cRaw2);
-						if (cRaw2 == '\n')
-							lb = LineBreak::Windows;
-						else
-						{
-							if (Unicode::IsNoncharacter(cRaw2))
-							{
-								oDest.eEncoding = TextEncoding::Codepage;
-								break; // switch
-							}
-							else
-								lb = LineBreak::Macintosh;
-
-							file.clear();
-							file.seekg(pos);
-						}
-					}
-					else
-						lb = LineBreak::Macintosh;
-					break;
-
-				default:
-					if (Unicode::IsNoncharacter(cRaw))
-					{
-						oDest.eEncoding = TextEncoding::Codepage;
-						break; // switch
-					}
-					continue; // no linebreak
-				}
-
-				if (oDest.eEncoding == TextEncoding::Codepage)
-					break; // while
-
-				if (bConsequentLinebreaks && bLinebreakRead && lb != oDest.eLineBreaks)
+				if (bConsequentLinebreaks && bLinebreakRead && lbRead != oDest.eLineBreaks)
 					bConsequentLinebreaks = false;
 
-				oDest.eLineBreaks = lb;
+				oDest.eLineBreaks = lbRead;
 				bLinebreakRead = true;
-			}
+			};
+
+			bool bNoncharacters;
+			if (oDest.eEncoding == TextEncoding::UTF16)
+				bNoncharacters = ContainsNoncharacters<char16_t>(file, bSwapEndian, fnLinebreak);
+			else
+				bNoncharacters = ContainsNoncharacters<char32_t>(file, bSwapEndian, fnLinebreak);
+
+			if (bNoncharacters)
+				oDest.eEncoding = TextEncoding::Codepage;
 			break;
 		}
 
@@ -761,6 +751,15 @@ namespace rl
 	void TextFileReader::open(const wchar_t* szFilePath, const TextFileInfo& oEncoding)
 	{
 		close();
+
+		m_pCodepage = nullptr;
+		if (oEncoding.eEncoding == TextEncoding::Codepage)
+		{
+			m_pCodepage = GetCodepage(oEncoding);
+			if (!m_pCodepage)
+				return; // codepage not available
+		}
+
 		m_oFile.open(szFilePath, std::ios::binary);
 		if (!m_oFile)
 			return; // couldn't open the file
@@ -817,14 +816,9 @@ namespace rl
 		{
 			uint8_t cEnc = 0;
 			m_oFile.read(&cEnc, 1);
-			if (cEnc >= 0x80 && cEnc <= 0x9F)
-			{
-				cDest = cCP1252_Table[cEnc - 0x80];
-				if (cDest == 0)
-					cDest = '?';
-			}
-			else
-				cDest = cEnc;
+			cDest = m_pCodepage->decode(cEnc);
+			if (cDest == CodepageTable::Undefined)
+				cDest = '?';
 
 			break;
 		}
@@ -907,6 +901,15 @@ namespace rl
 		if (eof() || len == 0)
 			return;
 
+		if (m_oEncoding.eEncoding == TextEncoding::Codepage)
+		{
+			// one byte per character --> bulk conversion
+			std::string sEncoded(len, 0);
+			m_oFile.read(reinterpret_cast<uint8_t*>(sEncoded.data()), len);
+			DecodeCodepage(*m_pCodepage, sEncoded.data(), size_t(m_oFile.gcount()), sDest);
+			return;
+		}
+
 		sDest.reserve(len);
 
 		while (!eof() && sDest.length() < len)
@@ -1041,6 +1044,14 @@ namespace rl
 	{
 		close();
 
+		m_pCodepage = nullptr;
+		if (oEncoding.eEncoding == TextEncoding::Codepage)
+		{
+			m_pCodepage = GetCodepage(oEncoding);
+			if (!m_pCodepage)
+				return; // codepage not available
+		}
+
 		m_oEncoding = oEncoding;
 		m_oFile.open(szFilePath, std::ios::out | std::ios::binary);
 
@@ -1124,27 +1135,10 @@ namespace rl
 
 		case TextEncoding::Codepage:
 		{
-			constexpr uint8_t iUnknown = (uint8_t)'?';
-			if (c >= 0x80 && c <= 0x9F)
-				m_oFile.write(&iUnknown, 1);
-
-			else if (c > 0xFF)
-			{
-				for (uint8_t i = 0; i < 0x2F; ++i)
-				{
-					if (cCP1252_Table[i] == c)
-					{
-						m_oFile.write(&i, 1);
-						return;
-					}
-				}
-				m_oFile.write(&iUnknown, 1);
-			}
-			else
-			{
-				uint8_t cOutput = (uint8_t)c;
-				m_oFile.write(&cOutput, 1);
-			}
+			uint8_t cEncoded = 0;
+			if (!m_pCodepage->encode(c, cEncoded))
+				cEncoded = (uint8_t)'?';
+			m_oFile.write(&cEncoded, 1);
 
 			break;
 		}
@@ -1254,6 +1248,21 @@ namespace rl
 		if (len == 0)
 			len = wcslen(szText);
 
+		if (m_oEncoding.eEncoding == TextEncoding::Codepage)
+		{
+			if (!isOpen())
+				return;
+
+			// one byte per character --> bulk conversion
+			auto pText = reinterpret_cast<const char16_t*>(szText);
+			if (Unicode::FindNoncharacter(pText, len) < len)
+				throw "Tried to write a noncharacter value to a file";
+
+			const std::string sEncoded = EncodeCodepage(*m_pCodepage, pText, len);
+			m_oFile.write(reinterpret_cast<const uint8_t*>(sEncoded.data()), sEncoded.length());
+			return;
+		}
+
 		for (size_t i = 0; i < len; ++i)
 		{
 			char32_t cRaw;
@@ -1,5 +1,9 @@
 #include "rl/unicode.hpp"
 
+#include <algorithm>
+#include <emmintrin.h> // SSE2
+#include <string> // std::char_traits
+
 
 
 
@@ -9,6 +13,463 @@
 namespace rl
 {
 
+	namespace
+	{
+
+		//==========================================================================================
+		// SINGLE CODE POINTS
+
+		// Decode one code point
+		// Return the count of code units read, 0 if the input is invalid or incomplete
+
+		inline size_t DecodeOne(const char* p, size_t iLen, char32_t& ch) noexcept
+		{
+			const uint8_t c = (uint8_t)p[0];
+			if (c < 0x80)
+			{
+				ch = c;
+				return 1;
+			}
+
+			size_t iCount;
+			uint8_t iMin = 0x80; // the valid range of the second byte
+			uint8_t iMax = 0xBF;
+			if (c < 0xC2) // continuation byte or overlong 2-byte form
+				return 0;
+			else if (c < 0xE0)
+			{
+				iCount = 2;
+				ch = c & 0x1F;
+			}
+			else if (c < 0xF0)
+			{
+				iCount = 3;
+				ch = c & 0x0F;
+				if (c == 0xE0)
+					iMin = 0xA0; // overlong
+				else if (c == 0xED)
+					iMax = 0x9F; // surrogates
+			}
+			else if (c < 0xF5)
+			{
+				iCount = 4;
+				ch = c & 0x07;
+				if (c == 0xF0)
+					iMin = 0x90; // overlong
+				else if (c == 0xF4)
+					iMax = 0x8F; // above 0x10FFFF
+			}
+			else
+				return 0;
+
+			if (iLen < iCount)
+				return 0;
+			for (size_t i = 1; i < iCount; ++i)
+			{
+				const uint8_t cNext = (uint8_t)p[i];
+				if (cNext < ((i == 1) ? iMin : 0x80) || cNext > ((i == 1) ? iMax : 0xBF))
+					return 0;
+				ch = (ch << 6) | (cNext & 0x3F);
+			}
+			return iCount;
+		}
+
+		inline size_t DecodeOne(const char16_t* p, size_t iLen, char32_t& ch) noexcept
+		{
+			if (UTF16::IsLowSurrogate(p[0]))
+				return 0;
+			if (!UTF16::IsHighSurrogate(p[0]))
+			{
+				ch = p[0];
+				return 1;
+			}
+
+			if (iLen < 2 || !UTF16::IsLowSurrogate(p[1]))
+				return 0;
+			ch = UTF16::Decode(p[0], p[1]);
+			return 2;
+		}
+
+		inline size_t DecodeOne(const char32_t* p, size_t, char32_t& ch) noexcept
+		{
+			ch = p[0];
+			return (ch < 0x110000 && (ch & 0xFFFFF800) != 0xD800) ? 1 : 0;
+		}
+
+		// Encode one (valid) code point
+		// Return the count of code units written, 0 if the buffer is too small
+
+		inline size_t EncodeOne(char32_t ch, char* p, size_t iLen) noexcept
+		{
+			if (ch < 0x80)
+			{
+				if (iLen < 1)
+					return 0;
+				p[0] = (char)ch;
+				return 1;
+			}
+			if (ch < 0x800)
+			{
+				if (iLen < 2)
+					return 0;
+				p[0] = char(0xC0 | (ch >> 6));
+				p[1] = char(0x80 | (ch & 0x3F));
+				return 2;
+			}
+			if (ch < 0x10000)
+			{
+				if (iLen < 3)
+					return 0;
+				p[0] = char(0xE0 | (ch >> 12));
+				p[1] = char(0x80 | ((ch >> 6) & 0x3F));
+				p[2] = char(0x80 | (ch & 0x3F));
+				return 3;
+			}
+
+			if (iLen < 4)
+				return 0;
+			p[0] = char(0xF0 | (ch >> 18));
+			p[1] = char(0x80 | ((ch >> 12) & 0x3F));
+			p[2] = char(0x80 | ((ch >> 6) & 0x3F));
+			p[3] = char(0x80 | (ch & 0x3F));
+			return 4;
+		}
+
+		inline size_t EncodeOne(char32_t ch, char16_t* p, size_t iLen) noexcept
+		{
+			if (ch < 0x10000)
+			{
+				if (iLen < 1)
+					return 0;
+				p[0] = (char16_t)ch;
+				return 1;
+			}
+
+			if (iLen < 2)
+				return 0;
+			ch -= 0x10000;
+			p[0] = char16_t(0xD800 | (ch >> 10));
+			p[1] = char16_t(0xDC00 | (ch & 0x03FF));
+			return 2;
+		}
+
+		inline size_t EncodeOne(char32_t ch, char32_t* p, size_t iLen) noexcept
+		{
+			if (iLen < 1)
+				return 0;
+			p[0] = ch;
+			return 1;
+		}
+
+
+
+
+
+		//==========================================================================================
+		// VECTORIZED BLOCKS
+
+		// Convert as many blocks as possible that can be copied code unit by code unit
+		// (ASCII for UTF-8, the BMP without surrogates for UTF-16/UTF-32)
+		// Return the count of code units converted (= read = written)
+
+		size_t ConvertBlocks(const char16_t* pSrc, size_t iLen, char32_t* pDest) noexcept
+		{
+			const __m128i vSurrogateMask = _mm_set1_epi16((short)0xF800);
+			const __m128i vSurrogate = _mm_set1_epi16((short)0xD800);
+			const __m128i vZero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 8 <= iLen; i += 8)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				const __m128i vIsSurrogate =
+					_mm_cmpeq_epi16(_mm_and_si128(v, vSurrogateMask), vSurrogate);
+				if (_mm_movemask_epi8(vIsSurrogate) != 0)
+					break;
+
+				auto p = reinterpret_cast<__m128i*>(pDest + i);
+				_mm_storeu_si128(p, _mm_unpacklo_epi16(v, vZero));
+				_mm_storeu_si128(p + 1, _mm_unpackhi_epi16(v, vZero));
+			}
+			return i;
+		}
+
+		size_t ConvertBlocks(const char32_t* pSrc, size_t iLen, char16_t* pDest) noexcept
+		{
+			const __m128i vHighMask = _mm_set1_epi32((int)0xFFFF0000);
+			const __m128i vSurrogateMask = _mm_set1_epi32(0xF800);
+			const __m128i vSurrogate = _mm_set1_epi32(0xD800);
+			const __m128i vBias32 = _mm_set1_epi32(0x8000);
+			const __m128i vBias16 = _mm_set1_epi16((short)0x8000);
+			const __m128i vZero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 8 <= iLen; i += 8)
+			{
+				const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i + 4));
+
+				// all values must be in the BMP, but not surrogates
+				const __m128i vHigh = _mm_and_si128(_mm_or_si128(v1, v2), vHighMask);
+				const __m128i vIsSurrogate = _mm_or_si128(
+					_mm_cmpeq_epi32(_mm_and_si128(v1, vSurrogateMask), vSurrogate),
+					_mm_cmpeq_epi32(_mm_and_si128(v2, vSurrogateMask), vSurrogate));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(vHigh, vZero)) != 0xFFFF ||
+					_mm_movemask_epi8(vIsSurrogate) != 0)
+					break;
+
+				// the signed saturation of packs doesn't change values in [-0x8000, 0x7FFF]
+				const __m128i vPacked = _mm_packs_epi32(_mm_sub_epi32(v1, vBias32),
+					_mm_sub_epi32(v2, vBias32));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + i),
+					_mm_add_epi16(vPacked, vBias16));
+			}
+			return i;
+		}
+
+		size_t ConvertBlocks(const char* pSrc, size_t iLen, char32_t* pDest) noexcept
+		{
+			const __m128i vZero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 16 <= iLen; i += 16)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				if (_mm_movemask_epi8(v) != 0) // not ASCII
+					break;
+
+				const __m128i vLo = _mm_unpacklo_epi8(v, vZero);
+				const __m128i vHi = _mm_unpackhi_epi8(v, vZero);
+				auto p = reinterpret_cast<__m128i*>(pDest + i);
+				_mm_storeu_si128(p, _mm_unpacklo_epi16(vLo, vZero));
+				_mm_storeu_si128(p + 1, _mm_unpackhi_epi16(vLo, vZero));
+				_mm_storeu_si128(p + 2, _mm_unpacklo_epi16(vHi, vZero));
+				_mm_storeu_si128(p + 3, _mm_unpackhi_epi16(vHi, vZero));
+			}
+			return i;
+		}
+
+		size_t ConvertBlocks(const char* pSrc, size_t iLen, char16_t* pDest) noexcept
+		{
+			const __m128i vZero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 16 <= iLen; i += 16)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				if (_mm_movemask_epi8(v) != 0) // not ASCII
+					break;
+
+				auto p = reinterpret_cast<__m128i*>(pDest + i);
+				_mm_storeu_si128(p, _mm_unpacklo_epi8(v, vZero));
+				_mm_storeu_si128(p + 1, _mm_unpackhi_epi8(v, vZero));
+			}
+			return i;
+		}
+
+		size_t ConvertBlocks(const char16_t* pSrc, size_t iLen, char* pDest) noexcept
+		{
+			const __m128i vNonASCII = _mm_set1_epi16((short)0xFF80);
+
+			size_t i = 0;
+			for (; i + 8 <= iLen; i += 8)
+			{
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, vNonASCII),
+					_mm_setzero_si128())) != 0xFFFF)
+					break;
+
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(pDest + i), _mm_packus_epi16(v, v));
+			}
+			return i;
+		}
+
+		size_t ConvertBlocks(const char32_t* pSrc, size_t iLen, char* pDest) noexcept
+		{
+			const __m128i vNonASCII = _mm_set1_epi32((int)0xFFFFFF80);
+			const __m128i vZero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 16 <= iLen; i += 16)
+			{
+				auto p = reinterpret_cast<const __m128i*>(pSrc + i);
+				const __m128i v1 = _mm_loadu_si128(p);
+				const __m128i v2 = _mm_loadu_si128(p + 1);
+				const __m128i v3 = _mm_loadu_si128(p + 2);
+				const __m128i v4 = _mm_loadu_si128(p + 3);
+				const __m128i vAll = _mm_or_si128(_mm_or_si128(v1, v2), _mm_or_si128(v3, v4));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(vAll, vNonASCII), vZero)) !=
+					0xFFFF)
+					break;
+
+				const __m128i v16 = _mm_packus_epi16(_mm_packs_epi32(v1, v2),
+					_mm_packs_epi32(v3, v4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + i), v16);
+			}
+			return i;
+		}
+
+
+
+
+
+		//==========================================================================================
+		// CLASSIFICATION
+
+		// Unsigned range compares (SSE2 only compares signed values: the range is moved to start
+		// at the smallest signed value)
+
+		inline __m128i InRange(__m128i v, uint32_t iFirst, uint32_t iLast, char32_t) noexcept
+		{
+			const __m128i vBiased = _mm_sub_epi32(v, _mm_set1_epi32(int(iFirst + 0x80000000u)));
+			return _mm_cmplt_epi32(vBiased,
+				_mm_set1_epi32(int(iLast - iFirst + 1 + 0x80000000u)));
+		}
+
+		inline __m128i InRange(__m128i v, uint32_t iFirst, uint32_t iLast, char16_t) noexcept
+		{
+			const __m128i vBiased = _mm_sub_epi16(v, _mm_set1_epi16(short(iFirst + 0x8000u)));
+			return _mm_cmplt_epi16(vBiased, _mm_set1_epi16(short(iLast - iFirst + 1 + 0x8000u)));
+		}
+
+		// Mark the lanes that might contain (or start) a character of a class
+		// For UTF-16, high surrogates are only candidates, the low surrogate must be checked too
+
+		inline __m128i MatchNoncharacters(__m128i v, char32_t) noexcept
+		{
+			const __m128i vPlaneEnd = _mm_set1_epi32(0xFFFE);
+			return _mm_or_si128(InRange(v, 0xFDD0, 0xFDEF, char32_t()),
+				_mm_cmpeq_epi32(_mm_and_si128(v, vPlaneEnd), vPlaneEnd));
+		}
+
+		inline __m128i MatchNoncharacters(__m128i v, char16_t) noexcept
+		{
+			// the high surrogates of the last two code points of the planes 1 to 16
+			const __m128i vHighSurrogate = _mm_cmpeq_epi16(
+				_mm_and_si128(v, _mm_set1_epi16((short)0xFC3F)), _mm_set1_epi16((short)0xD83F));
+			return _mm_or_si128(_mm_or_si128(InRange(v, 0xFDD0, 0xFDEF, char16_t()),
+				InRange(v, 0xFFFE, 0xFFFF, char16_t())), vHighSurrogate);
+		}
+
+		inline __m128i MatchPrivateUse(__m128i v, char32_t) noexcept
+		{
+			return _mm_or_si128(InRange(v, 0xE000, 0xF8FF, char32_t()),
+				InRange(v, 0xF0000, 0x10FFFF, char32_t()));
+		}
+
+		inline __m128i MatchPrivateUse(__m128i v, char16_t) noexcept
+		{
+			// the high surrogates of the planes 15 and 16
+			return _mm_or_si128(InRange(v, 0xE000, 0xF8FF, char16_t()),
+				InRange(v, 0xDB80, 0xDBFF, char16_t()));
+		}
+
+		// Get the code point starting at a position (unpaired surrogates are returned as they are)
+
+		inline char32_t CodePointAt(const char32_t* p, size_t, size_t i) noexcept { return p[i]; }
+
+		inline char32_t CodePointAt(const char16_t* p, size_t iLen, size_t i) noexcept
+		{
+			if (!UTF16::IsHighSurrogate(p[i]) || i + 1 == iLen || !UTF16::IsLowSurrogate(p[i + 1]))
+				return p[i];
+			return UTF16::Decode(p[i], p[i + 1]);
+		}
+
+		/// <summary>
+		/// Find the first character of a class in a string
+		/// </summary>
+		/// <returns>The index of the character, <c>iLen</c> if there is none</returns>
+		template <typename TChar, __m128i(*fnMatch)(__m128i, TChar), bool(*fnIs)(char32_t)>
+		size_t FindFirst(const TChar* p, size_t iLen) noexcept
+		{
+			constexpr size_t iBlockLen = 4 * sizeof(__m128i) / sizeof(TChar);
+
+			size_t i = 0;
+			for (; i + iBlockLen <= iLen; i += iBlockLen)
+			{
+				auto pv = reinterpret_cast<const __m128i*>(p + i);
+				const __m128i vMatch = _mm_or_si128(
+					_mm_or_si128(fnMatch(_mm_loadu_si128(pv), TChar()),
+						fnMatch(_mm_loadu_si128(pv + 1), TChar())),
+					_mm_or_si128(fnMatch(_mm_loadu_si128(pv + 2), TChar()),
+						fnMatch(_mm_loadu_si128(pv + 3), TChar())));
+				if (_mm_movemask_epi8(vMatch) == 0)
+					continue;
+
+				// only candidates were found
+				for (size_t iChar = i; iChar < i + iBlockLen; ++iChar)
+				{
+					if (fnIs(CodePointAt(p, iLen, iChar)))
+						return iChar;
+				}
+			}
+
+			for (; i < iLen; ++i)
+			{
+				if (fnIs(CodePointAt(p, iLen, i)))
+					return i;
+			}
+			return iLen;
+		}
+
+
+
+
+
+		//==========================================================================================
+		// STRINGS
+
+		/// <summary>
+		/// Convert a string between two Unicode encoding forms
+		/// </summary>
+		template <typename TSrc, typename TDest>
+		Unicode::TranscodeResult Transcode(const TSrc* pSrc, size_t iSrcLen, TDest* pDest,
+			size_t iDestLen) noexcept
+		{
+			constexpr size_t iScalarRun = 16; // code units converted before the next vector try
+
+			Unicode::TranscodeResult result = { Unicode::TranscodeStatus::OK, 0, 0 };
+			size_t& iRead = result.iRead;
+			size_t& iWritten = result.iWritten;
+			while (iRead < iSrcLen)
+			{
+				const size_t iBlocks = ConvertBlocks(pSrc + iRead,
+					std::min(iSrcLen - iRead, iDestLen - iWritten), pDest + iWritten);
+				iRead += iBlocks;
+				iWritten += iBlocks;
+
+				// the block containing non-trivial characters (or the rest of the string)
+				const size_t iScalarEnd = std::min(iSrcLen, iRead + iScalarRun);
+				while (iRead < iScalarEnd)
+				{
+					char32_t ch;
+					const size_t iCount = DecodeOne(pSrc + iRead, iSrcLen - iRead, ch);
+					if (iCount == 0)
+					{
+						result.eStatus = Unicode::TranscodeStatus::InvalidInput;
+						return result;
+					}
+
+					const size_t iCountWritten =
+						EncodeOne(ch, pDest + iWritten, iDestLen - iWritten);
+					if (iCountWritten == 0)
+					{
+						result.eStatus = Unicode::TranscodeStatus::BufferTooSmall;
+						return result;
+					}
+
+					iRead += iCount;
+					iWritten += iCountWritten;
+				}
+			}
+
+			return result;
+		}
+
+	}
+
+
+
 	namespace Unicode
 	{
 
@@ -24,6 +485,26 @@ namespace rl
 				(ch & 0xFFFF) >= 0xFFFE /* last two code points of each plane */);
 		}
 
+		size_t FindPrivateUse(const char32_t* p, size_t iLen) noexcept
+		{
+			return FindFirst<char32_t, MatchPrivateUse, IsPrivateUse>(p, iLen);
+		}
+
+		size_t FindPrivateUse(const char16_t* p, size_t iLen) noexcept
+		{
+			return FindFirst<char16_t, MatchPrivateUse, IsPrivateUse>(p, iLen);
+		}
+
+		size_t FindNoncharacter(const char32_t* p, size_t iLen) noexcept
+		{
+			return FindFirst<char32_t, MatchNoncharacters, IsNoncharacter>(p, iLen);
+		}
+
+		size_t FindNoncharacter(const char16_t* p, size_t iLen) noexcept
+		{
+			return FindFirst<char16_t, MatchNoncharacters, IsNoncharacter>(p, iLen);
+		}
+
 	}
 
 	namespace UTF16
@@ -37,61 +518,74 @@ namespace rl
 
 			return result;
 		}
-		
-		
+
+		Unicode::TranscodeResult ToUTF32(const char16_t* pSrc, size_t iSrcLen, char32_t* pDest,
+			size_t iDestLen) noexcept
+		{
+			return Transcode(pSrc, iSrcLen, pDest, iDestLen);
+		}
+
+		Unicode::TranscodeResult ToUTF8(const char16_t* pSrc, size_t iSrcLen, char* pDest,
+			size_t iDestLen) noexcept
+		{
+			return Transcode(pSrc, iSrcLen, pDest, iDestLen);
+		}
+
+
 #if __cplusplus > 201703L
 
 		std::shared_ptr<char32_t[]> DecodeString(const char16_t* sz, size_t* len)
 		{
-			size_t idx = 0;
+			// the UTF-32 string can't be longer than the UTF-16 string
+			const size_t iSrcLen = std::char_traits<char16_t>::length(sz);
+			std::shared_ptr<char32_t[]> result(new char32_t[iSrcLen + 1]);
 
-			// get string length
-			size_t dif = 0;
-			while (sz[idx] != 0)
-			{
-				if (IsHighSurrogate(sz[idx]))
-				{
-					++idx; // go to low surrogate
-					if (!IsLowSurrogate(sz[idx]))
-						throw std::exception("rl::UTF16::DecodeString failed: Invalid input");
-					++dif;
-				}
+			const auto oResult = ToUTF32(sz, iSrcLen, result.get(), iSrcLen);
+			if (oResult.eStatus != Unicode::TranscodeStatus::OK)
+				throw std::exception("rl::UTF16::DecodeString failed: Invalid input");
 
-				++idx;
-			}
-			const size_t lenVal = idx - dif;
+			result[oResult.iWritten] = 0;
 			if (len)
-				*len = lenVal;
+				*len = oResult.iWritten;
 
-			// create and initialize the shared pointer
-			auto result = std::make_shared<char32_t[]>(lenVal + 1);
-			memset(result.get(), 0, sizeof(char32_t) * (lenVal + 1));
+			return result;
+		}
+		
+#endif // C++17
 
-			// decode the input
-			idx = 0;
-			dif = 0;
-			while (sz[idx] != 0)
-			{
-				if (IsHighSurrogate(sz[idx]))
-				{
-					++dif;
+	}
 
-					const auto cHi = sz[idx];
-					++idx;
-					const auto cLo = sz[idx];
+	namespace UTF8
+	{
 
-					result[idx - dif] = Decode(cHi, cLo);
-				}
-				else
-					result[idx - dif] = sz[idx];
+		Unicode::TranscodeResult ToUTF16(const char* pSrc, size_t iSrcLen, char16_t* pDest,
+			size_t iDestLen) noexcept
+		{
+			return Transcode(pSrc, iSrcLen, pDest, iDestLen);
+		}
 
-				++idx;
-			}
+		Unicode::TranscodeResult ToUTF32(const char* pSrc, size_t iSrcLen, char32_t* pDest,
+			size_t iDestLen) noexcept
+		{
+			return Transcode(pSrc, iSrcLen, pDest, iDestLen);
+		}
 
-			return result;
+	}
+
+	namespace UTF32
+	{
+
+		Unicode::TranscodeResult ToUTF8(const char32_t* pSrc, size_t iSrcLen, char* pDest,
+			size_t iDestLen) noexcept
+		{
+			return Transcode(pSrc, iSrcLen, pDest, iDestLen);
+		}
+
+		Unicode::TranscodeResult ToUTF16(const char32_t* pSrc, size_t iSrcLen, char16_t* pDest,
+			size_t iDestLen) noexcept
+		{
+			return Transcode(pSrc, iSrcLen, pDest, iDestLen);
 		}
-		
-#endif // C++17
 
 	}
 
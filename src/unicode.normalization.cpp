@@ -0,0 +1,503 @@
+#include "rl/unicode.normalization.hpp"
+
+#include <algorithm>
+#include <emmintrin.h> // SSE2
+#include <iterator>
+
+
+
+
+
+
+
+namespace rl
+{
+
+	namespace
+	{
+
+		using Unicode::NormalizationForm;
+		using Unicode::QuickCheckResult;
+
+		constexpr size_t iScalarRun = 16; // code units checked before the next vector try
+
+
+
+		//==========================================================================================
+		// HANGUL SYLLABLES (algorithmic, see chapter 3.12 of the Unicode standard)
+
+		constexpr char32_t chSBase = 0xAC00;
+		constexpr char32_t chLBase = 0x1100;
+		constexpr char32_t chVBase = 0x1161;
+		constexpr char32_t chTBase = 0x11A7;
+		constexpr char32_t iLCount = 19;
+		constexpr char32_t iVCount = 21;
+		constexpr char32_t iTCount = 28;
+		constexpr char32_t iNCount = iVCount * iTCount;
+		constexpr char32_t iSCount = iLCount * iNCount;
+
+
+
+
+
+		//==========================================================================================
+		// CODE POINTS
+
+		inline uint8_t CombiningClassOf(uint16_t iProperties) noexcept
+		{
+			return uint8_t(iProperties & Unicode::Tables::NormalizationCombiningClassMask);
+		}
+
+		// Get the code point starting at a position and move to the next one
+		// (unpaired surrogates are returned as they are)
+
+		inline char32_t NextCodePoint(const char32_t* p, size_t, size_t& i) noexcept
+		{
+			return p[i++];
+		}
+
+		inline char32_t NextCodePoint(const char16_t* p, size_t iLen, size_t& i) noexcept
+		{
+			const char16_t ch = p[i++];
+			if (!UTF16::IsHighSurrogate(ch) || i == iLen || !UTF16::IsLowSurrogate(p[i]))
+				return ch;
+			return UTF16::Decode(ch, p[i++]);
+		}
+
+		// Get the code point ending before a position and move to its start
+
+		inline char32_t PrevCodePoint(const char32_t* p, size_t& i) noexcept
+		{
+			return p[--i];
+		}
+
+		inline char32_t PrevCodePoint(const char16_t* p, size_t& i) noexcept
+		{
+			const char16_t ch = p[--i];
+			if (!UTF16::IsLowSurrogate(ch) || i == 0 || !UTF16::IsHighSurrogate(p[i - 1]))
+				return ch;
+			--i;
+			return UTF16::Decode(p[i], ch);
+		}
+
+		// Append a code point (unpaired surrogates are kept)
+
+		inline void Append(std::u32string& s, char32_t ch) { s += ch; }
+
+		inline void Append(std::u16string& s, char32_t ch)
+		{
+			if (ch < 0x10000)
+				s += char16_t(ch);
+			else
+			{
+				ch -= 0x10000;
+				s += char16_t(0xD800 | (ch >> 10));
+				s += char16_t(0xDC00 | (ch & 0x03FF));
+			}
+		}
+
+
+
+
+
+		//==========================================================================================
+		// VECTORIZED BLOCKS
+
+		// Skip as many blocks as possible that only contain code units below a limit
+		// (all code points below the limit are normalized starters)
+		// Return the count of code units skipped
+
+		size_t SkipBlocks(const char16_t* p, size_t iLen, char16_t chLimit) noexcept
+		{
+			constexpr size_t iBlockLen = 4 * sizeof(__m128i) / sizeof(char16_t);
+			// saturated subtraction: zero for all code units below the limit
+			const __m128i vMax = _mm_set1_epi16(short(chLimit - 1));
+
+			size_t i = 0;
+			for (; i + iBlockLen <= iLen; i += iBlockLen)
+			{
+				auto pv = reinterpret_cast<const __m128i*>(p + i);
+				const __m128i vAbove = _mm_or_si128(
+					_mm_or_si128(_mm_subs_epu16(_mm_loadu_si128(pv), vMax),
+						_mm_subs_epu16(_mm_loadu_si128(pv + 1), vMax)),
+					_mm_or_si128(_mm_subs_epu16(_mm_loadu_si128(pv + 2), vMax),
+						_mm_subs_epu16(_mm_loadu_si128(pv + 3), vMax)));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(vAbove, _mm_setzero_si128())) != 0xFFFF)
+					break;
+			}
+			return i;
+		}
+
+		size_t SkipBlocks(const char32_t* p, size_t iLen, char32_t chLimit) noexcept
+		{
+			constexpr size_t iBlockLen = 4 * sizeof(__m128i) / sizeof(char32_t);
+			// SSE2 only compares signed values
+			const __m128i vBias = _mm_set1_epi32(int(0x80000000u));
+			const __m128i vMax = _mm_set1_epi32(int((chLimit - 1) ^ 0x80000000u));
+			auto fnAbove = [&](const __m128i* pv)
+			{
+				return _mm_cmpgt_epi32(_mm_xor_si128(_mm_loadu_si128(pv), vBias), vMax);
+			};
+
+			size_t i = 0;
+			for (; i + iBlockLen <= iLen; i += iBlockLen)
+			{
+				auto pv = reinterpret_cast<const __m128i*>(p + i);
+				const __m128i vAbove = _mm_or_si128(_mm_or_si128(fnAbove(pv), fnAbove(pv + 1)),
+					_mm_or_si128(fnAbove(pv + 2), fnAbove(pv + 3)));
+				if (_mm_movemask_epi8(vAbove) != 0)
+					break;
+			}
+			return i;
+		}
+
+
+
+
+
+		//==========================================================================================
+		// QUICK CHECK
+
+		struct FormProperties
+		{
+			char32_t chMin; // all code points below are normalized starters
+			uint16_t iNo; // the flag of the value "No"
+			uint16_t iMaybe; // the flag of the value "Maybe"
+			uint16_t iBoundary; // the flags that prevent a code point from being a boundary
+		};
+
+		constexpr FormProperties GetFormProperties(NormalizationForm eForm) noexcept
+		{
+			using namespace Unicode::Tables;
+
+			if (eForm == NormalizationForm::NFC)
+				return { 0x0300, NormalizationNFCNo, NormalizationNFCMaybe,
+					NormalizationCombiningClassMask | NormalizationNFCNo | NormalizationNFCMaybe };
+			else
+				return { 0x00C0, NormalizationNFDNo, 0,
+					NormalizationCombiningClassMask | NormalizationNFDNo };
+		}
+
+		/// <summary>
+		/// Check if a string is normalized (UAX #15)
+		/// </summary>
+		/// <param name="iStop">
+		/// = receives the index of the first code point that might have to be changed
+		/// (<c>iLen</c> if the result is <c>Yes</c>)
+		/// </param>
+		template <typename TChar>
+		QuickCheckResult QuickCheck(NormalizationForm eForm, const TChar* p, size_t iLen,
+			size_t& iStop) noexcept
+		{
+			const FormProperties oForm = GetFormProperties(eForm);
+
+			iStop = iLen;
+			uint8_t iLastCCC = 0;
+			size_t i = 0;
+			while (i < iLen)
+			{
+				const size_t iBlocks = SkipBlocks(p + i, iLen - i, TChar(oForm.chMin));
+				if (iBlocks > 0)
+				{
+					i += iBlocks;
+					iLastCCC = 0;
+				}
+
+				const size_t iScalarEnd = std::min(iLen, i + iScalarRun);
+				while (i < iScalarEnd)
+				{
+					const size_t iChar = i;
+					const char32_t ch = NextCodePoint(p, iLen, i);
+					if (ch < oForm.chMin)
+					{
+						iLastCCC = 0;
+						continue;
+					}
+
+					const uint16_t iProperties = Unicode::Tables::GetNormalizationProperties(ch);
+					const uint8_t iCCC = CombiningClassOf(iProperties);
+					if ((iCCC != 0 && iLastCCC > iCCC) || (iProperties & oForm.iNo))
+					{
+						iStop = std::min(iStop, iChar);
+						return QuickCheckResult::No;
+					}
+					if ((iProperties & oForm.iMaybe) && iStop == iLen)
+						iStop = iChar; // a later "No" is still possible
+					iLastCCC = iCCC;
+				}
+			}
+
+			return (iStop == iLen) ? QuickCheckResult::Yes : QuickCheckResult::Maybe;
+		}
+
+		/// <summary>
+		/// Find the start of the part of a string that has to be normalized, given the first code
+		/// point that might have to be changed<para/>
+		/// The part before doesn't interact with the rest of the string: it ends before a starter
+		/// that is normalized and can't be combined with a preceding character.
+		/// </summary>
+		template <typename TChar>
+		size_t FindBoundary(NormalizationForm eForm, const TChar* p, size_t iStop) noexcept
+		{
+			const FormProperties oForm = GetFormProperties(eForm);
+
+			size_t i = iStop;
+			while (i > 0)
+			{
+				const char32_t ch = PrevCodePoint(p, i);
+				if (ch < oForm.chMin ||
+					(Unicode::Tables::GetNormalizationProperties(ch) & oForm.iBoundary) == 0)
+					break;
+			}
+			return i;
+		}
+
+
+
+
+
+		//==========================================================================================
+		// NORMALIZATION
+
+		// Append the full canonical decomposition of a code point
+
+		void AppendDecomposition(std::u32string& s, char32_t ch)
+		{
+			if (ch >= chSBase && ch < chSBase + iSCount)
+			{
+				const char32_t iS = ch - chSBase;
+				s += chLBase + iS / iNCount;
+				s += chVBase + (iS % iNCount) / iTCount;
+				if (iS % iTCount != 0)
+					s += chTBase + iS % iTCount;
+				return;
+			}
+
+			const auto oDecomposition = Unicode::GetDecomposition(ch);
+			if (oDecomposition.eType != Unicode::DecompositionType::Canonical)
+			{
+				s += ch;
+				return;
+			}
+			for (size_t i = 0; i < oDecomposition.iLength; ++i)
+			{
+				AppendDecomposition(s, oDecomposition.pMapping[i]);
+			}
+		}
+
+		// Sort all sequences of non-starters by their canonical combining class (stable)
+
+		void SortCanonically(std::u32string& s) noexcept
+		{
+			for (size_t i = 1; i < s.length(); ++i)
+			{
+				const char32_t ch = s[i];
+				const uint8_t iCCC =
+					CombiningClassOf(Unicode::Tables::GetNormalizationProperties(ch));
+				if (iCCC == 0)
+					continue;
+
+				size_t iDest = i;
+				while (iDest > 0 &&
+					CombiningClassOf(Unicode::Tables::GetNormalizationProperties(s[iDest - 1])) >
+					iCCC)
+				{
+					s[iDest] = s[iDest - 1];
+					--iDest;
+				}
+				s[iDest] = ch;
+			}
+		}
+
+		// Apply the canonical composition algorithm to a decomposed, sorted string
+
+		void Compose(std::u32string& s) noexcept
+		{
+			constexpr size_t iNoStarter = ~size_t(0);
+
+			size_t iStarter = iNoStarter;
+			uint8_t iLastCCC = 0;
+			size_t iDest = 0;
+			for (size_t i = 0; i < s.length(); ++i)
+			{
+				const char32_t ch = s[i];
+				const uint8_t iCCC =
+					CombiningClassOf(Unicode::Tables::GetNormalizationProperties(ch));
+
+				// a character is blocked from the starter by any character in between with a
+				// combining class that is zero or not lower than its own
+				if (iStarter != iNoStarter &&
+					(iDest == iStarter + 1 || (iLastCCC != 0 && iLastCCC < iCCC)))
+				{
+					const char32_t chComposite = Unicode::GetComposition(s[iStarter], ch);
+					if (chComposite != 0)
+					{
+						s[iStarter] = chComposite;
+						continue;
+					}
+				}
+
+				if (iCCC == 0)
+					iStarter = iDest;
+				iLastCCC = iCCC;
+				s[iDest++] = ch;
+			}
+			s.resize(iDest);
+		}
+
+		/// <summary>
+		/// Normalize the end of a string, starting at a boundary
+		/// </summary>
+		/// <returns>Did the normalization change the end of the string?</returns>
+		template <typename TChar>
+		bool NormalizeEnd(NormalizationForm eForm, const TChar* p, size_t iLen, size_t iStart,
+			std::basic_string<TChar>& sResult)
+		{
+			std::u32string sDecomposed;
+			sDecomposed.reserve(iLen - iStart);
+			for (size_t i = iStart; i < iLen;)
+			{
+				AppendDecomposition(sDecomposed, NextCodePoint(p, iLen, i));
+			}
+			SortCanonically(sDecomposed);
+			if (eForm == NormalizationForm::NFC)
+				Compose(sDecomposed);
+
+			sResult.clear();
+			sResult.reserve(iLen - iStart);
+			for (char32_t ch : sDecomposed)
+			{
+				Append(sResult, ch);
+			}
+			return sResult.compare(0, sResult.length(), p + iStart, iLen - iStart) != 0;
+		}
+
+		template <typename TChar>
+		bool IsNormalized(NormalizationForm eForm, const TChar* p, size_t iLen)
+		{
+			size_t iStop;
+			switch (QuickCheck(eForm, p, iLen, iStop))
+			{
+			case QuickCheckResult::Yes:
+				return true;
+			case QuickCheckResult::No:
+				return false;
+			default:
+				break;
+			}
+
+			std::basic_string<TChar> sEnd;
+			return !NormalizeEnd(eForm, p, iLen, FindBoundary(eForm, p, iStop), sEnd);
+		}
+
+		template <typename TChar>
+		bool Normalize(NormalizationForm eForm, std::basic_string<TChar>& s)
+		{
+			size_t iStop;
+			if (QuickCheck(eForm, s.c_str(), s.length(), iStop) == QuickCheckResult::Yes)
+				return false;
+
+			const size_t iStart = FindBoundary(eForm, s.c_str(), iStop);
+			std::basic_string<TChar> sEnd;
+			if (!NormalizeEnd(eForm, s.c_str(), s.length(), iStart, sEnd))
+				return false;
+
+			s.replace(iStart, s.length() - iStart, sEnd);
+			return true;
+		}
+
+	}
+
+
+
+
+
+	namespace Unicode
+	{
+
+		char32_t GetComposition(char32_t chFirst, char32_t chSecond) noexcept
+		{
+			// Hangul: L + V = LV, LV + T = LVT
+			if (chFirst >= chLBase && chFirst < chLBase + iLCount &&
+				chSecond >= chVBase && chSecond < chVBase + iVCount)
+				return chSBase + ((chFirst - chLBase) * iVCount + chSecond - chVBase) * iTCount;
+			if (chFirst >= chSBase && chFirst < chSBase + iSCount &&
+				(chFirst - chSBase) % iTCount == 0 &&
+				chSecond > chTBase && chSecond < chTBase + iTCount)
+				return chFirst + (chSecond - chTBase);
+
+			// binary search over the (first, second, composite) triples
+			size_t iLow = 0;
+			size_t iHigh = std::size(Tables::Compositions) / 3;
+			while (iLow < iHigh)
+			{
+				const size_t iMid = (iLow + iHigh) / 2;
+				const char32_t* pTriple = Tables::Compositions + iMid * 3;
+				if (pTriple[0] < chFirst || (pTriple[0] == chFirst && pTriple[1] < chSecond))
+					iLow = iMid + 1;
+				else
+					iHigh = iMid;
+			}
+
+			const char32_t* pTriple = Tables::Compositions + iLow * 3;
+			if (iLow < std::size(Tables::Compositions) / 3 &&
+				pTriple[0] == chFirst && pTriple[1] == chSecond)
+				return pTriple[2];
+			return 0;
+		}
+
+		QuickCheckResult QuickCheck(NormalizationForm eForm, const char32_t* p,
+			size_t iLen) noexcept
+		{
+			size_t iStop;
+			return rl::QuickCheck(eForm, p, iLen, iStop);
+		}
+
+		QuickCheckResult QuickCheck(NormalizationForm eForm, const char16_t* p,
+			size_t iLen) noexcept
+		{
+			size_t iStop;
+			return rl::QuickCheck(eForm, p, iLen, iStop);
+		}
+
+		bool IsNormalized(NormalizationForm eForm, const char32_t* p, size_t iLen)
+		{
+			return rl::IsNormalized(eForm, p, iLen);
+		}
+
+		bool IsNormalized(NormalizationForm eForm, const char16_t* p, size_t iLen)
+		{
+			return rl::IsNormalized(eForm, p, iLen);
+		}
+
+		bool Normalize(NormalizationForm eForm, std::u32string& s)
+		{
+			return rl::Normalize(eForm, s);
+		}
+
+		bool Normalize(NormalizationForm eForm, std::u16string& s)
+		{
+			return rl::Normalize(eForm, s);
+		}
+
+#ifdef _WIN32
+		bool Normalize(NormalizationForm eForm, std::wstring& s)
+		{
+			static_assert(sizeof(wchar_t) == sizeof(char16_t), "wchar_t is expected to be UTF-16");
+
+			const auto p = reinterpret_cast<const char16_t*>(s.c_str());
+			if (QuickCheck(eForm, p, s.length()) == QuickCheckResult::Yes)
+				return false; // no copy needed
+
+			std::u16string s16(p, s.length());
+			if (!rl::Normalize(eForm, s16))
+				return false;
+
+			s.assign(reinterpret_cast<const wchar_t*>(s16.c_str()), s16.length());
+			return true;
+		}
+#endif // _WIN32
+
+	}
+
+}
@@ -0,0 +1,456 @@
+#include "rl/unicode.segmentation.hpp"
+
+#include <initializer_list>
+
+
+
+
+
+
+
+namespace rl
+{
+
+	namespace
+	{
+
+		using GCB = Unicode::GraphemeClusterBreak;
+		using LBC = Unicode::LineBreakClass;
+
+		constexpr size_t iGraphemeClusterBreakCount = size_t(GCB::LVT) + 1;
+		constexpr size_t iLineBreakClassCount = size_t(LBC::Unknown) + 1;
+
+
+
+		//==========================================================================================
+		// GRAPHEME CLUSTER BOUNDARIES
+
+		enum class GraphemeRule : uint8_t
+		{
+			Break,
+			NoBreak,
+			Pictographic, // GB11: no break if preceded by "Extended_Pictographic Extend* ZWJ"
+			RegionalIndicator // GB12/GB13: no break if preceded by an odd count of RIs
+		};
+
+		// Get the result of the rules GB3 to GB999 for a pair of code points
+		constexpr GraphemeRule GetGraphemeRule(GCB ePrev, GCB eNext) noexcept
+		{
+			auto fnIsControl = [](GCB e)
+			{
+				return e == GCB::CR || e == GCB::LF || e == GCB::Control;
+			};
+
+			if (ePrev == GCB::CR && eNext == GCB::LF)
+				return GraphemeRule::NoBreak; // GB3
+			if (fnIsControl(ePrev) || fnIsControl(eNext))
+				return GraphemeRule::Break; // GB4, GB5
+
+			// GB6 to GB8: Hangul syllables
+			if (ePrev == GCB::L &&
+				(eNext == GCB::L || eNext == GCB::V || eNext == GCB::LV || eNext == GCB::LVT))
+				return GraphemeRule::NoBreak;
+			if ((ePrev == GCB::LV || ePrev == GCB::V) && (eNext == GCB::V || eNext == GCB::T))
+				return GraphemeRule::NoBreak;
+			if ((ePrev == GCB::LVT || ePrev == GCB::T) && eNext == GCB::T)
+				return GraphemeRule::NoBreak;
+
+			if (eNext == GCB::Extend || eNext == GCB::ZWJ || eNext == GCB::SpacingMark ||
+				ePrev == GCB::Prepend)
+				return GraphemeRule::NoBreak; // GB9, GB9a, GB9b
+
+			if (ePrev == GCB::ZWJ)
+				return GraphemeRule::Pictographic; // GB11
+			if (ePrev == GCB::RegionalIndicator && eNext == GCB::RegionalIndicator)
+				return GraphemeRule::RegionalIndicator; // GB12, GB13
+
+			return GraphemeRule::Break; // GB999
+		}
+
+		struct GraphemeRuleTable
+		{
+			GraphemeRule e[iGraphemeClusterBreakCount][iGraphemeClusterBreakCount];
+		};
+
+		constexpr GraphemeRuleTable CreateGraphemeRuleTable() noexcept
+		{
+			GraphemeRuleTable result = {};
+			for (size_t iPrev = 0; iPrev < iGraphemeClusterBreakCount; ++iPrev)
+			{
+				for (size_t iNext = 0; iNext < iGraphemeClusterBreakCount; ++iNext)
+				{
+					result.e[iPrev][iNext] = GetGraphemeRule(GCB(iPrev), GCB(iNext));
+				}
+			}
+			return result;
+		}
+
+		constexpr GraphemeRuleTable oGraphemeRules = CreateGraphemeRuleTable();
+
+
+
+		//==========================================================================================
+		// LINE BREAK OPPORTUNITIES
+
+		// The pair table of the rules LB11 to LB31 (see the example implementation in UAX #14)
+		// The rules LB21a, LB30, LB30a and LB30b need more context and are checked separately,
+		// they only ever prevent a direct break.
+		enum class LinePair : uint8_t
+		{
+			Direct, // break allowed, even without spaces in between
+			Indirect, // break only allowed if there are spaces in between
+			Prohibited // no break, even with spaces in between
+		};
+
+		// Is a break allowed between two classes, according to the context-free rules from LB11
+		// on? If bSpaces is true, eBefore is the class before a sequence of spaces.
+		constexpr bool IsLineBreak(LBC eBefore, LBC eNext, bool bSpaces) noexcept
+		{
+			auto fnIsAny = [](LBC e, std::initializer_list<LBC> oClasses)
+			{
+				for (LBC eClass : oClasses)
+				{
+					if (e == eClass)
+						return true;
+				}
+				return false;
+			};
+
+			// LB11 to LB17: apply with and without spaces in between
+			if (eNext == LBC::WordJoiner || (!bSpaces && eBefore == LBC::WordJoiner))
+				return false; // LB11
+			if (!bSpaces && eBefore == LBC::NonBreaking)
+				return false; // LB12
+			if (eNext == LBC::NonBreaking && !bSpaces &&
+				!fnIsAny(eBefore, { LBC::BreakAfter, LBC::Hyphen }))
+				return false; // LB12a
+			if (fnIsAny(eNext, { LBC::ClosePunctuation, LBC::CloseParenthesis, LBC::Exclamation,
+				LBC::InfixSeparator, LBC::SymbolsAllowingBreakAfter }))
+				return false; // LB13
+			if (eBefore == LBC::OpenPunctuation)
+				return false; // LB14
+			if (eBefore == LBC::Quotation && eNext == LBC::OpenPunctuation)
+				return false; // LB15
+			if (fnIsAny(eBefore, { LBC::ClosePunctuation, LBC::CloseParenthesis }) &&
+				eNext == LBC::Nonstarter)
+				return false; // LB16
+			if (eBefore == LBC::BreakOpportunityBeforeAndAfter &&
+				eNext == LBC::BreakOpportunityBeforeAndAfter)
+				return false; // LB17
+			if (bSpaces)
+				return true; // LB18
+
+			if (eNext == LBC::Quotation || eBefore == LBC::Quotation)
+				return false; // LB19
+			if (eNext == LBC::ContingentBreak || eBefore == LBC::ContingentBreak)
+				return true; // LB20
+			if (fnIsAny(eNext, { LBC::BreakAfter, LBC::Hyphen, LBC::Nonstarter }) ||
+				eBefore == LBC::BreakBefore)
+				return false; // LB21
+			if (eBefore == LBC::SymbolsAllowingBreakAfter && eNext == LBC::HebrewLetter)
+				return false; // LB21b
+			if (eNext == LBC::Inseparable)
+				return false; // LB22
+
+			const bool bBeforeLetter = fnIsAny(eBefore, { LBC::Alphabetic, LBC::HebrewLetter });
+			const bool bNextLetter = fnIsAny(eNext, { LBC::Alphabetic, LBC::HebrewLetter });
+			if ((bBeforeLetter && eNext == LBC::Numeric) ||
+				(eBefore == LBC::Numeric && bNextLetter))
+				return false; // LB23
+			if ((eBefore == LBC::PrefixNumeric &&
+					fnIsAny(eNext, { LBC::Ideographic, LBC::EmojiBase, LBC::EmojiModifier })) ||
+				(fnIsAny(eBefore, { LBC::Ideographic, LBC::EmojiBase, LBC::EmojiModifier }) &&
+					eNext == LBC::PostfixNumeric))
+				return false; // LB23a
+			if ((fnIsAny(eBefore, { LBC::PrefixNumeric, LBC::PostfixNumeric }) && bNextLetter) ||
+				(bBeforeLetter && fnIsAny(eNext, { LBC::PrefixNumeric, LBC::PostfixNumeric })))
+				return false; // LB24
+
+			// LB25 (the pairs listed in UAX #14)
+			if (fnIsAny(eBefore, { LBC::ClosePunctuation, LBC::CloseParenthesis, LBC::Numeric }) &&
+				fnIsAny(eNext, { LBC::PostfixNumeric, LBC::PrefixNumeric }))
+				return false;
+			if (fnIsAny(eBefore, { LBC::PostfixNumeric, LBC::PrefixNumeric }) &&
+				fnIsAny(eNext, { LBC::OpenPunctuation, LBC::Numeric }))
+				return false;
+			if (fnIsAny(eBefore, { LBC::Hyphen, LBC::InfixSeparator, LBC::Numeric,
+				LBC::SymbolsAllowingBreakAfter }) && eNext == LBC::Numeric)
+				return false;
+
+			// LB26, LB27: Korean syllable blocks
+			const bool bBeforeHangul = fnIsAny(eBefore, { LBC::HangulLJamo, LBC::HangulVJamo,
+				LBC::HangulTJamo, LBC::HangulLVSyllable, LBC::HangulLVTSyllable });
+			const bool bNextHangul = fnIsAny(eNext, { LBC::HangulLJamo, LBC::HangulVJamo,
+				LBC::HangulTJamo, LBC::HangulLVSyllable, LBC::HangulLVTSyllable });
+			if (eBefore == LBC::HangulLJamo && fnIsAny(eNext, { LBC::HangulLJamo,
+				LBC::HangulVJamo, LBC::HangulLVSyllable, LBC::HangulLVTSyllable }))
+				return false;
+			if (fnIsAny(eBefore, { LBC::HangulVJamo, LBC::HangulLVSyllable }) &&
+				fnIsAny(eNext, { LBC::HangulVJamo, LBC::HangulTJamo }))
+				return false;
+			if (fnIsAny(eBefore, { LBC::HangulTJamo, LBC::HangulLVTSyllable }) &&
+				eNext == LBC::HangulTJamo)
+				return false;
+			if ((bBeforeHangul && eNext == LBC::PostfixNumeric) ||
+				(eBefore == LBC::PrefixNumeric && bNextHangul))
+				return false;
+
+			if (bBeforeLetter && bNextLetter)
+				return false; // LB28
+			if (eBefore == LBC::InfixSeparator && bNextLetter)
+				return false; // LB29
+			if (eBefore == LBC::EmojiBase && eNext == LBC::EmojiModifier)
+				return false; // LB30b (first part)
+
+			return true; // LB31
+		}
+
+		struct LinePairTable
+		{
+			LinePair e[iLineBreakClassCount][iLineBreakClassCount];
+		};
+
+		constexpr LinePairTable CreateLinePairTable() noexcept
+		{
+			LinePairTable result = {};
+			for (size_t iBefore = 0; iBefore < iLineBreakClassCount; ++iBefore)
+			{
+				for (size_t iNext = 0; iNext < iLineBreakClassCount; ++iNext)
+				{
+					const LBC eBefore = LBC(iBefore);
+					const LBC eNext = LBC(iNext);
+					if (!IsLineBreak(eBefore, eNext, true))
+						result.e[iBefore][iNext] = LinePair::Prohibited;
+					else if (!IsLineBreak(eBefore, eNext, false))
+						result.e[iBefore][iNext] = LinePair::Indirect;
+					else
+						result.e[iBefore][iNext] = LinePair::Direct;
+				}
+			}
+			return result;
+		}
+
+		constexpr LinePairTable oLinePairs = CreateLinePairTable();
+
+		// LB1: the resolution of the classes AI, SG, XX and CJ (SA depends on the general category)
+		struct ResolvedLineBreakClasses
+		{
+			LBC e[iLineBreakClassCount];
+		};
+
+		constexpr ResolvedLineBreakClasses CreateResolvedLineBreakClasses() noexcept
+		{
+			ResolvedLineBreakClasses result = {};
+			for (size_t i = 0; i < iLineBreakClassCount; ++i)
+			{
+				switch (LBC(i))
+				{
+				case LBC::Ambiguous:
+				case LBC::Surrogate:
+				case LBC::Unknown:
+					result.e[i] = LBC::Alphabetic;
+					break;
+				case LBC::ConditionalJapaneseStarter:
+					result.e[i] = LBC::Nonstarter;
+					break;
+				default:
+					result.e[i] = LBC(i);
+				}
+			}
+			return result;
+		}
+
+		constexpr ResolvedLineBreakClasses oResolvedLineBreakClasses =
+			CreateResolvedLineBreakClasses();
+
+	}
+
+
+
+
+
+	namespace Unicode
+	{
+
+		/*******************************************************************************************
+		 class GraphemeBreaker
+		*******************************************************************************************/
+
+		//==========================================================================================
+		// METHODS
+
+		//------------------------------------------------------------------------------------------
+		// PUBLIC METHODS
+
+		void GraphemeBreaker::reset() noexcept
+		{
+			*this = GraphemeBreaker();
+		}
+
+		bool GraphemeBreaker::next(char32_t ch) noexcept
+		{
+			const uint16_t iProperties = Tables::GetBreakProperties(ch);
+			const auto e =
+				GCB((iProperties & Tables::BreakGraphemeMask) >> Tables::BreakGraphemeShift);
+			const bool bPictographic = iProperties & Tables::BreakExtendedPictographic;
+
+			bool result = true; // GB1
+			if (!m_bStart)
+			{
+				switch (oGraphemeRules.e[size_t(m_ePrev)][size_t(e)])
+				{
+				case GraphemeRule::NoBreak:
+					result = false;
+					break;
+				case GraphemeRule::Pictographic:
+					result = !(m_bPictographicZWJ && bPictographic);
+					break;
+				case GraphemeRule::RegionalIndicator:
+					result = !m_bOddRI;
+					break;
+				default:
+					break;
+				}
+			}
+
+			m_bStart = false;
+			m_bPictographicZWJ = (e == GCB::ZWJ) && m_bPictographic;
+			m_bPictographic = bPictographic || (e == GCB::Extend && m_bPictographic);
+			m_bOddRI = (e == GCB::RegionalIndicator) && !m_bOddRI;
+			m_ePrev = e;
+			return result;
+		}
+
+		void GraphemeBreaker::next(const char32_t* p, size_t iLen, bool* pDest) noexcept
+		{
+			for (size_t i = 0; i < iLen; ++i)
+			{
+				pDest[i] = next(p[i]);
+			}
+		}
+
+
+
+
+
+		/*******************************************************************************************
+		 class LineBreaker
+		*******************************************************************************************/
+
+		//==========================================================================================
+		// METHODS
+
+		//------------------------------------------------------------------------------------------
+		// PUBLIC METHODS
+
+		void LineBreaker::reset() noexcept
+		{
+			*this = LineBreaker();
+		}
+
+		LineBreakOpportunity LineBreaker::next(char32_t ch) noexcept
+		{
+			const uint16_t iProperties = Tables::GetBreakProperties(ch);
+			LBC eNext = LBC(iProperties & Tables::BreakLineMask);
+			if (eNext == LBC::ComplexContext) // LB1
+				eNext = (iProperties & Tables::BreakCombiningMark) ?
+					LBC::CombiningMark : LBC::Alphabetic;
+			else
+				eNext = oResolvedLineBreakClasses.e[size_t(eNext)];
+
+			// LB9: combining marks and ZWJ take the class of the code point they follow
+			const bool bCombining = eNext == LBC::CombiningMark || eNext == LBC::ZeroWidthJoiner;
+			if (bCombining && !m_bStart)
+			{
+				switch (m_ePrev)
+				{
+				case LBC::MandatoryBreak:
+				case LBC::CarriageReturn:
+				case LBC::LineFeed:
+				case LBC::NextLine:
+				case LBC::Space:
+				case LBC::ZeroWidthSpace:
+					break;
+
+				default:
+					m_bPrevZWJ = eNext == LBC::ZeroWidthJoiner;
+					return LineBreakOpportunity::None;
+				}
+			}
+			const bool bZWJ = eNext == LBC::ZeroWidthJoiner;
+			if (bCombining)
+				eNext = LBC::Alphabetic; // LB10
+
+			auto result = LineBreakOpportunity::None;
+			if (m_bStart)
+			{
+				// LB2
+			}
+			else if (m_ePrev == LBC::MandatoryBreak || m_ePrev == LBC::LineFeed ||
+				m_ePrev == LBC::NextLine ||
+				(m_ePrev == LBC::CarriageReturn && eNext != LBC::LineFeed))
+				result = LineBreakOpportunity::Mandatory; // LB4, LB5
+			else if (eNext == LBC::MandatoryBreak || eNext == LBC::CarriageReturn ||
+				eNext == LBC::LineFeed || eNext == LBC::NextLine || eNext == LBC::Space ||
+				eNext == LBC::ZeroWidthSpace)
+			{
+				// LB6, LB7
+			}
+			else if (m_eBeforeSpaces == LBC::ZeroWidthSpace)
+				result = LineBreakOpportunity::Allowed; // LB8
+			else if (m_bPrevZWJ)
+			{
+				// LB8a
+			}
+			else if (m_ePrev == LBC::Space)
+			{
+				if (oLinePairs.e[size_t(m_eBeforeSpaces)][size_t(eNext)] != LinePair::Prohibited)
+					result = LineBreakOpportunity::Allowed;
+			}
+			else if (oLinePairs.e[size_t(m_ePrev)][size_t(eNext)] == LinePair::Direct)
+			{
+				const bool bNextNumericOrLetter = eNext == LBC::Alphabetic ||
+					eNext == LBC::HebrewLetter || eNext == LBC::Numeric;
+				const bool bNoBreak =
+					// LB21a
+					((m_ePrev == LBC::Hyphen || m_ePrev == LBC::BreakAfter) &&
+						m_ePrevPrev == LBC::HebrewLetter && eNext != LBC::ContingentBreak) ||
+					// LB30
+					((m_ePrev == LBC::Alphabetic || m_ePrev == LBC::HebrewLetter ||
+						m_ePrev == LBC::Numeric) && eNext == LBC::OpenPunctuation &&
+						!(iProperties & Tables::BreakEastAsianWide)) ||
+					(m_ePrev == LBC::CloseParenthesis && !m_bPrevWide && bNextNumericOrLetter) ||
+					// LB30a
+					(m_ePrev == LBC::RegionalIndicator && eNext == LBC::RegionalIndicator &&
+						m_bOddRI) ||
+					// LB30b
+					(eNext == LBC::EmojiModifier && m_bPrevUnassignedPictographic);
+				if (!bNoBreak)
+					result = LineBreakOpportunity::Allowed;
+			}
+
+			m_bStart = false;
+			m_bOddRI = eNext == LBC::RegionalIndicator &&
+				!(m_ePrev == LBC::RegionalIndicator && m_bOddRI);
+			m_ePrevPrev = m_ePrev;
+			m_ePrev = eNext;
+			if (eNext != LBC::Space)
+				m_eBeforeSpaces = eNext;
+			m_bPrevZWJ = bZWJ;
+			m_bPrevWide = iProperties & Tables::BreakEastAsianWide;
+			m_bPrevUnassignedPictographic = (iProperties & Tables::BreakExtendedPictographic) &&
+				GetGeneralCategory(ch) == GeneralCategory::Unassigned;
+			return result;
+		}
+
+		void LineBreaker::next(const char32_t* p, size_t iLen, LineBreakOpportunity* pDest) noexcept
+		{
+			for (size_t i = 0; i < iLen; ++i)
+			{
+				pDest[i] = next(p[i]);
+			}
+		}
+
+	}
+
+}
@@ -6,14 +6,28 @@
 
 std::vector<UnitTest> UnitTestCollection::s_oUnitTests(
 	{
-		{ "[global]",               UnitTest_global                 },
-		{ "audio.engine",           UnitTest_audio_engine           },
-		{ "data.filecontainer",     UnitTest_data_filecontainer     },
-		{ "data.online",            UnitTest_data_online            },
-		{ "data.registry.settings", UnitTest_data_registry_settings },
-		{ "graphics.opengl.window", UnitTest_graphics_opengl_window },
-		{ "input.keyboard",         UnitTest_input_keyboard         },
-		{ "runasadmin",             UnitTest_runasadmin             },
-		{ "splashscreen",           UnitTest_splashscreen           },
-		{ "text.fileio",            UnitTest_text_fileio            }
+		{ "[global]",                     UnitTest_global                       },
+		{ "audio.analysis",               UnitTest_audio_analysis               },
+		{ "audio.codec",                  UnitTest_audio_codec                  },
+		{ "audio.effects",                UnitTest_audio_effects                },
+		{ "audio.engine",                 UnitTest_audio_engine                 },
+		{ "audio.mixer",                  UnitTest_audio_mixer                  },
+		{ "audio.resampler",              UnitTest_audio_resampler              },
+		{ "audio.soundbank",              UnitTest_audio_soundbank              },
+		{ "audio.spatializer",            UnitTest_audio_spatializer            },
+		{ "data.filecontainer",           UnitTest_data_filecontainer           },
+		{ "data.online",                  UnitTest_data_online                  },
+		{ "data.registry.settings",       UnitTest_data_registry_settings       },
+		{ "graphics.fonts.bitmap.reader", UnitTest_graphics_fonts_bitmap_reader },
+		{ "graphics.opengl.window",       UnitTest_graphics_opengl_window       },
+		{ "input.keyboard",               UnitTest_input_keyboard               },
+		{ "runasadmin",                   UnitTest_runasadmin                   },
+		{ "splashscreen",                 UnitTest_splashscreen                 },
+		{ "text.codepages",               UnitTest_text_codepages               },
+		{ "text.fileio",                  UnitTest_text_fileio                  },
+		{ "tools.mpscqueue",              UnitTest_tools_mpscqueue              },
+		{ "tools.publishedptr",           UnitTest_tools_publishedptr           },
+		{ "unicode",                      UnitTest_unicode                      },
+		{ "unicode.normalization",        UnitTest_unicode_normalization        },
+		{ "unicode.segmentation",         UnitTest_unicode_segmentation         }
 	});
@@ -0,0 +1,215 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.analysis.hpp>
+#include <rl/audio.engine.hpp>
+#include <rl/audio.soundbank.hpp>
+
+// STL
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+
+	constexpr uint32_t iSampleRate = 44100;
+	constexpr size_t iMinutes = 10;
+	constexpr size_t iPixels = 1920; // width of the drawn waveform
+
+	/// <summary>
+	/// A stereo sound with a slowly changing volume, plus some noise
+	/// </summary>
+	std::unique_ptr<rl::Sound> CreateSound(size_t iSampleCount)
+	{
+		rl::WaveFormat oFormat;
+		oFormat.eBitDepth = rl::AudioBitDepth::Audio16;
+		oFormat.iChannelCount = 2;
+		oFormat.iSampleRate = iSampleRate;
+
+		auto upSound = std::make_unique<rl::Sound>(oFormat, iSampleCount);
+		auto p = static_cast<int16_t*>(const_cast<void*>(upSound->getDataPtr()));
+
+		std::mt19937 oRNG(42);
+		std::uniform_int_distribution<int> oNoise(-500, 500);
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			const double t = double(i) / iSampleRate;
+			const double dVolume = 0.5 + 0.4 * std::sin(2.0 * 3.14159265358979 * t / 60.0);
+			const double d = dVolume * std::sin(2.0 * 3.14159265358979 * 440.0 * t);
+			p[i * 2]     = (int16_t)std::lround(d * 30000.0 + oNoise(oRNG));
+			p[i * 2 + 1] = (int16_t)std::lround(d * 15000.0);
+		}
+
+		return upSound;
+	}
+
+	bool SameLevel(const rl::AudioLevel& a, const rl::AudioLevel& b)
+	{
+		return a.fMin == b.fMin && a.fMax == b.fMax &&
+			std::fabs(a.fRMS - b.fRMS) <= 0.0001f * std::max(a.fRMS, 0.001f);
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+}
+
+
+
+bool UnitTest_audio_analysis()
+{
+	const size_t iSampleCount = iSampleRate * 60 * iMinutes + 1234; // incomplete last block
+	const auto upSound = CreateSound(iSampleCount);
+	const uint8_t iChannelCount = upSound->getWaveFormat().iChannelCount;
+
+	auto tpStart = std::chrono::steady_clock::now();
+	const rl::AudioEnvelope* pEnvelope = rl::GetEnvelope(*upSound);
+	const double dCreationTime = MillisecondsSince(tpStart);
+	if (!pEnvelope || upSound->getEnvelope() != pEnvelope)
+	{
+		printf("Couldn't create the envelope\n");
+		return false;
+	}
+
+
+
+	// TEST 1: ACCURACY
+	{
+		printf("Test 1: Accuracy (%zu minutes, %zu levels, created in %.1f ms)\n", iMinutes,
+			pEnvelope->getLevelCount(), dCreationTime);
+
+		std::mt19937 oRNG(1);
+		const size_t iBlockCount = pEnvelope->getBucketCount(0);
+		std::uniform_int_distribution<size_t> oBlock(0, iBlockCount - 1);
+		rl::AudioLevel oExpected[2], oActual[2];
+		for (size_t iTest = 0; iTest < 100; ++iTest)
+		{
+			// ranges of whole blocks must give the same result as an analysis of the sound
+			size_t iFirst = oBlock(oRNG);
+			size_t iLast = oBlock(oRNG);
+			if (iFirst > iLast)
+				std::swap(iFirst, iLast);
+			const size_t iFirstSample = iFirst * pEnvelope->getBlockSize();
+			const size_t iCount = (iLast + 1 - iFirst) * pEnvelope->getBlockSize();
+
+			rl::AnalyzeSound(*upSound, oExpected, iFirstSample, iCount);
+			pEnvelope->analyze(oActual, iFirstSample, iCount);
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				if (!SameLevel(oExpected[iChannel], oActual[iChannel]))
+				{
+					printf("  Wrong result for blocks %zu to %zu\n", iFirst, iLast);
+					return false;
+				}
+			}
+
+			// any other range is extended to whole blocks
+			const size_t iOffset = iTest % pEnvelope->getBlockSize();
+			rl::AnalyzeSound(*upSound, oExpected, iFirstSample + iOffset, iCount - iOffset);
+			pEnvelope->analyze(oActual, iFirstSample + iOffset, iCount - iOffset);
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				if (oActual[iChannel].fMin > oExpected[iChannel].fMin ||
+					oActual[iChannel].fMax < oExpected[iChannel].fMax)
+				{
+					printf("  Peaks missing for samples %zu to %zu\n", iFirstSample + iOffset,
+						iFirstSample + iCount - 1);
+					return false;
+				}
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: DRAWING A WAVEFORM
+	{
+		printf("Test 2: Waveform summary (%zu pixels)\n", iPixels);
+
+		std::vector<rl::AudioLevel> oExpected(iPixels * iChannelCount);
+		std::vector<rl::AudioLevel> oActual(iPixels * iChannelCount);
+
+		tpStart = std::chrono::steady_clock::now();
+		rl::GetWaveformSummary(*upSound, oExpected.data(), iPixels);
+		printf("  GetWaveformSummary():             %10.3f ms\n", MillisecondsSince(tpStart));
+
+		tpStart = std::chrono::steady_clock::now();
+		pEnvelope->getWaveformSummary(oActual.data(), iPixels);
+		printf("  AudioEnvelope::getWaveformSummary(): %7.3f ms\n", MillisecondsSince(tpStart));
+
+		for (size_t i = 0; i < oExpected.size(); ++i)
+		{
+			if (std::fabs(oExpected[i].fRMS - oActual[i].fRMS) > 0.01f * oExpected[i].fRMS ||
+				oActual[i].peak() < oExpected[i].peak())
+			{
+				printf("  Pixel %zu differs\n", i / iChannelCount);
+				return false;
+			}
+		}
+
+		// the loudness of a short window
+		rl::AudioLevel oWindow[2];
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < 10000; ++i)
+		{
+			pEnvelope->analyze(oWindow, i * 997, iSampleRate);
+		}
+		printf("  AudioEnvelope::analyze() (1 s window): %5.3f us\n",
+			MillisecondsSince(tpStart) * 1000.0 / 10000);
+
+		printf("\n");
+	}
+
+
+
+	// TEST 3: SERIALIZATION
+	{
+		printf("Test 3: Serialization\n");
+
+		std::vector<uint8_t> oData;
+		pEnvelope->save(oData);
+		const auto spLoaded = rl::AudioEnvelope::FromMemory(oData.data(), oData.size());
+		printf("  %zu bytes for %zu bytes of sample data\n", oData.size(), upSound->getDataSize());
+		if (!spLoaded || spLoaded->getLevelCount() != pEnvelope->getLevelCount() ||
+			memcmp(spLoaded->getLevelData(spLoaded->getLevelCount() - 1),
+				pEnvelope->getLevelData(pEnvelope->getLevelCount() - 1),
+				iChannelCount * sizeof(rl::AudioLevel)) != 0)
+		{
+			printf("  The loaded envelope differs from the original\n");
+			return false;
+		}
+
+		oData.pop_back();
+		if (rl::AudioEnvelope::FromMemory(oData.data(), oData.size()))
+		{
+			printf("  Truncated envelope was loaded\n");
+			return false;
+		}
+
+		// sound banks keep the envelopes of their sounds
+		std::vector<uint8_t> oBankData;
+		rl::SoundBank oBank;
+		if (!rl::SoundBank::SaveToMemory(oBankData, { { L"music", upSound.get() } }) ||
+			!oBank.loadFromMemory(oBankData.data(), oBankData.size(), false) ||
+			!oBank.get(L"music")->getEnvelope() ||
+			oBank.get(L"music")->getEnvelope()->getBucketCount(0) != pEnvelope->getBucketCount(0))
+		{
+			printf("  The envelope wasn't stored in the sound bank\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,234 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.codec.hpp>
+#include <rl/audio.engine.hpp>
+
+// STL
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+namespace
+{
+
+	constexpr uint32_t iSampleRate = 48000;
+	constexpr uint32_t iBlockSize = 480; // XAudio2 processing quantum (10 ms)
+
+	/// <summary>
+	/// A music-like test signal: a few harmonics with a slow envelope, plus some noise
+	/// </summary>
+	std::vector<int16_t> TestSignal(size_t iSampleCount, uint8_t iChannelCount)
+	{
+		std::mt19937 oRNG(7);
+		std::normal_distribution<double> oNoise(0.0, 0.01);
+
+		std::vector<int16_t> oResult(iSampleCount * iChannelCount);
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			const double t = double(i) / iSampleRate;
+			const double dEnvelope = 0.6 + 0.3 * std::sin(2.0 * 3.14159265358979 * 0.5 * t);
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				const double dFrequency = 220.0 * (1 + iChannel);
+				double d = 0.0;
+				for (int iHarmonic = 1; iHarmonic <= 4; ++iHarmonic)
+				{
+					d += std::sin(2.0 * 3.14159265358979 * dFrequency * iHarmonic * t) / iHarmonic;
+				}
+				d = d * 0.4 * dEnvelope + oNoise(oRNG);
+				oResult[i * iChannelCount + iChannel] =
+					(int16_t)std::clamp(std::lround(d * 32767.0), -32768L, 32767L);
+			}
+		}
+		return oResult;
+	}
+
+	/// <summary>
+	/// Signal-to-noise ratio of a decoded signal, in dB
+	/// </summary>
+	double SNR(const int16_t* pOriginal, const int16_t* pDecoded, size_t iValueCount)
+	{
+		double dSignal = 0.0;
+		double dNoise = 0.0;
+		for (size_t i = 0; i < iValueCount; ++i)
+		{
+			const double dDiff = double(pOriginal[i]) - pDecoded[i];
+			dSignal += double(pOriginal[i]) * pOriginal[i];
+			dNoise += dDiff * dDiff;
+		}
+		return (dNoise == 0.0) ? INFINITY : 10.0 * std::log10(dSignal / dNoise);
+	}
+
+	const char* CompressionName(rl::AudioCompression eCompression)
+	{
+		switch (eCompression)
+		{
+		case rl::AudioCompression::IMA_ADPCM: return "IMA ADPCM";
+		case rl::AudioCompression::MS_ADPCM:  return "MS ADPCM";
+		case rl::AudioCompression::Lossless:  return "Lossless";
+		default:                              return "PCM (16 bit)";
+		}
+	}
+
+}
+
+
+
+bool UnitTest_audio_codec()
+{
+	constexpr uint8_t iChannelCount = 2;
+	constexpr size_t iSeconds = 10;
+	constexpr size_t iSampleCount = iSampleRate * iSeconds + 123; // incomplete last block
+	const auto oSignal = TestSignal(iSampleCount, iChannelCount);
+
+	const rl::AudioCompression eCompressions[] =
+	{
+		rl::AudioCompression::IMA_ADPCM,
+		rl::AudioCompression::MS_ADPCM,
+		rl::AudioCompression::Lossless
+	};
+
+
+
+	// TEST 1: ROUND TRIP
+	{
+		printf("Test 1: Round trip (%zu s, %u channels)\n", iSeconds, (unsigned)iChannelCount);
+		printf("  %-12s  %10s  %6s  %9s\n", "", "bytes", "ratio", "SNR");
+
+		for (auto eCompression : eCompressions)
+		{
+			rl::AudioCompressionFormat oFormat;
+			std::vector<uint8_t> oData;
+			if (!rl::EncodeAudio(eCompression, oSignal.data(), iSampleCount, iChannelCount, oFormat,
+				oData))
+			{
+				printf("  %s: Couldn't encode\n", CompressionName(eCompression));
+				return false;
+			}
+
+			// IMA ADPCM pads the last block to a multiple of 8 samples
+			const size_t iDecodedCount = rl::GetCompressedSampleCount(oFormat, iChannelCount,
+				oData.data(), oData.size());
+			if (iDecodedCount < iSampleCount || iDecodedCount >= iSampleCount + 8)
+			{
+				printf("  %s: Wrong sample count (%zu instead of %zu)\n",
+					CompressionName(eCompression), iDecodedCount, iSampleCount);
+				return false;
+			}
+
+			std::vector<int16_t> oDecoded(iDecodedCount * iChannelCount);
+			std::vector<int16_t> oBlock((size_t)oFormat.iSamplesPerBlock * iChannelCount);
+			const size_t iBlockCount =
+				rl::GetCompressedBlockCount(oFormat, oData.data(), oData.size());
+			size_t iPos = 0;
+			for (size_t iBlock = 0; iBlock < iBlockCount; ++iBlock)
+			{
+				const size_t iCount = rl::DecodeAudioBlock(oFormat, iChannelCount, oData.data(),
+					oData.size(), iBlock, oBlock.data());
+				if (iCount == 0 || iPos + iCount > iDecodedCount)
+				{
+					printf("  %s: Couldn't decode block %zu\n", CompressionName(eCompression),
+						iBlock);
+					return false;
+				}
+				memcpy(oDecoded.data() + iPos * iChannelCount, oBlock.data(),
+					iCount * iChannelCount * sizeof(int16_t));
+				iPos += iCount;
+			}
+
+			const double dRatio = double(oSignal.size() * sizeof(int16_t)) / oData.size();
+			const double dSNR = SNR(oSignal.data(), oDecoded.data(), oSignal.size());
+			printf("  %-12s  %10zu  %5.2fx  %6.1f dB\n", CompressionName(eCompression),
+				oData.size(), dRatio, dSNR);
+
+			const bool bLossless = eCompression == rl::AudioCompression::Lossless;
+			if ((bLossless && dSNR != INFINITY) || (!bLossless && (dSNR < 25.0 || dRatio < 3.5)))
+			{
+				printf("  Unexpected quality or ratio\n");
+				return false;
+			}
+		}
+
+		printf("\n");
+	}
+
+
+
+	// TEST 2: SOUND MEMORY AND DECODING COST
+	{
+		printf("Test 2: Sound memory and decoding cost (blocks of %u samples)\n", iBlockSize);
+
+		rl::WaveFormat oFormat{};
+		oFormat.eBitDepth = rl::AudioBitDepth::Audio16;
+		oFormat.iChannelCount = iChannelCount;
+		oFormat.iSampleRate = iSampleRate;
+
+		rl::Sound oPCM(oFormat, iSampleCount);
+		memcpy(const_cast<void*>(oPCM.getDataPtr()), oSignal.data(), oPCM.getDataSize());
+
+		std::vector<float> oBuffer(iBlockSize * iChannelCount);
+		auto fnMeasure = [&](const rl::Sound& sound)
+		{
+			const auto tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iSampleCount; i += iBlockSize)
+			{
+				sound.getSamplesAsFloat(oBuffer.data(), i, iBlockSize);
+			}
+			const double dSeconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - tpStart).count();
+			return dSeconds * 1000000.0 / iSeconds; // microseconds per second of audio
+		};
+
+		printf("  %-12s  %10s  %10s  %9s\n", "", "memory", "us/s", "realtime");
+		const double dPCMCost = fnMeasure(oPCM);
+		printf("  %-12s  %10zu  %10.1f  %8.0fx\n", CompressionName(rl::AudioCompression::None),
+			oPCM.getDataSize(), dPCMCost, 1000000.0 / dPCMCost);
+
+		std::vector<float> oExpected(iSampleCount * iChannelCount);
+		std::vector<float> oActual(iSampleCount * iChannelCount);
+		for (auto eCompression : eCompressions)
+		{
+			std::unique_ptr<rl::Sound> upSound(rl::Sound::FromCompressed(oPCM, eCompression));
+			if (!upSound || !upSound->isCompressed() ||
+				upSound->getSampleCount() != oPCM.getSampleCount())
+			{
+				printf("  %s: Couldn't create a compressed sound\n", CompressionName(eCompression));
+				return false;
+			}
+
+			const double dCost = fnMeasure(*upSound);
+			printf("  %-12s  %10zu  %10.1f  %8.0fx\n", CompressionName(eCompression),
+				upSound->getDataSize(), dCost, 1000000.0 / dCost);
+
+			// reading in odd-sized chunks must give the same result as reading at once
+			oPCM.getSamplesAsFloat(oExpected.data(), 0, iSampleCount);
+			for (size_t i = 0; i < iSampleCount; i += 777)
+			{
+				upSound->getSamplesAsFloat(oActual.data() + i * iChannelCount, i, 777);
+			}
+			if (eCompression == rl::AudioCompression::Lossless && oActual != oExpected)
+			{
+				printf("  Lossless sound differs from the original\n");
+				return false;
+			}
+
+			rl::MultiChannelAudioSample oSample{};
+			if (!upSound->getSample(oSample, iSampleCount - 1) ||
+				oSample.val.p16[0] != (int16_t)std::lround(oActual[oActual.size() - 2] * 32768.0f))
+			{
+				printf("  getSample() doesn't match getSamplesAsFloat()\n");
+				return false;
+			}
+			oSample.free();
+		}
+
+		printf("\n");
+	}
+
+	return true;
+}
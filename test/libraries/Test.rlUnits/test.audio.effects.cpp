@@ -0,0 +1,347 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.effects.hpp>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+
+	constexpr uint32_t iSampleRate = 48000;
+	constexpr uint32_t iBlockSize = 480; // XAudio2 processing quantum (10 ms)
+
+	/// <summary>
+	/// Process a signal by an effect chain, in blocks of <c>iBlockSize</c> samples
+	/// </summary>
+	void ProcessBlocks(rl::AudioEffectChain& oChain, float* pData, size_t iSampleCount)
+	{
+		const uint8_t iChannelCount = oChain.getChannelCount();
+		for (size_t i = 0; i < iSampleCount; i += iBlockSize)
+		{
+			const size_t iCount = std::min<size_t>(iBlockSize, iSampleCount - i);
+			oChain.process(pData + i * iChannelCount, (uint32_t)iCount);
+		}
+	}
+
+	double RMS(const float* pData, size_t iSampleCount, uint8_t iChannelCount, uint8_t iChannel)
+	{
+		double dSum = 0.0;
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			const double d = pData[i * iChannelCount + iChannel];
+			dSum += d * d;
+		}
+		return std::sqrt(dSum / iSampleCount);
+	}
+
+	/// <summary>
+	/// A constant gain, so the output shows whether a block was processed
+	/// </summary>
+	class Gain final : public rl::IAudioEffect
+	{
+	public: // methods
+
+		explicit Gain(float fGain) noexcept : m_vGain(_mm_set1_ps(fGain)) {}
+
+		void prepare(uint32_t, uint8_t, uint32_t) override {}
+		void reset() noexcept override {}
+		void process(rl::AudioEffectBlock& oBlock) noexcept override
+		{
+			const size_t iCount = size_t(oBlock.iSampleCount) * oBlock.iGroupCount;
+			for (size_t i = 0; i < iCount; ++i)
+			{
+				oBlock.pData[i] = _mm_mul_ps(oBlock.pData[i], m_vGain);
+			}
+		}
+
+
+	private: // variables
+
+		const __m128 m_vGain;
+
+	};
+
+	std::vector<float> Sine(double dFrequency, float fAmplitude, size_t iSampleCount,
+		uint8_t iChannelCount)
+	{
+		std::vector<float> oResult(iSampleCount * iChannelCount);
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			const float f = fAmplitude *
+				(float)std::sin(2.0 * 3.14159265358979 * dFrequency * i / iSampleRate);
+			for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+			{
+				oResult[i * iChannelCount + iChannel] = f;
+			}
+		}
+		return oResult;
+	}
+
+}
+
+
+
+bool UnitTest_audio_effects()
+{
+	// TEST 1: CORRECTNESS
+	{
+		printf("Test 1: Correctness\n");
+		constexpr size_t iSampleCount = iSampleRate;
+
+		// low pass filter: 100 Hz passes, 10 kHz is attenuated
+		{
+			rl::AudioEffectChain oChain;
+			oChain.add<rl::BiquadFilter>(rl::BiquadFilter::Type::LowPass, 1000.0f);
+			oChain.prepare(iSampleRate, 2, iBlockSize);
+
+			auto oLow = Sine(100.0, 0.5f, iSampleCount, 2);
+			auto oHigh = Sine(10000.0, 0.5f, iSampleCount, 2);
+			ProcessBlocks(oChain, oLow.data(), iSampleCount);
+			oChain.reset();
+			ProcessBlocks(oChain, oHigh.data(), iSampleCount);
+
+			const double dLowDB = 20.0 * std::log10(RMS(oLow.data(), iSampleCount, 2, 1) /
+				(0.5 / std::sqrt(2.0)));
+			const double dHighDB = 20.0 * std::log10(RMS(oHigh.data(), iSampleCount, 2, 1) /
+				(0.5 / std::sqrt(2.0)));
+			printf("  Low pass (1 kHz): 100 Hz %+.2f dB, 10 kHz %+.2f dB\n", dLowDB, dHighDB);
+			if (std::abs(dLowDB) > 0.1 || dHighDB > -35.0)
+			{
+				printf("  Unexpected filter response\n");
+				return false;
+			}
+		}
+
+		// compressor: a -6 dBFS sine is reduced by (6 + 20 * 0.75) dB above the threshold
+		{
+			rl::AudioEffectChain oChain;
+			auto spCompressor = oChain.add<rl::Compressor>(-20.0f, 4.0f, 0.001f, 0.1f, 0.0f);
+			oChain.prepare(iSampleRate, 2, iBlockSize);
+
+			auto oSignal = Sine(1000.0, 0.5f, iSampleCount, 2);
+			ProcessBlocks(oChain, oSignal.data(), iSampleCount);
+
+			printf("  Compressor (-20 dB, 4:1): gain reduction %.2f dB (expected %.2f dB)\n",
+				spCompressor->getGainReduction(), (20.0 - 6.02) * 0.75);
+			if (std::abs(spCompressor->getGainReduction() - (20.0 - 6.02) * 0.75) > 0.5)
+			{
+				printf("  Unexpected gain reduction\n");
+				return false;
+			}
+		}
+
+		// delay: an impulse is repeated after the delay time, scaled by the mix/feedback
+		{
+			rl::AudioEffectChain oChain;
+			oChain.add<rl::Delay>(0.1f, 0.5f, 0.5f);
+			oChain.prepare(iSampleRate, 1, iBlockSize);
+
+			std::vector<float> oSignal(iSampleCount);
+			oSignal[0] = 1.0f;
+			ProcessBlocks(oChain, oSignal.data(), iSampleCount);
+
+			const size_t iDelay = iSampleRate / 10;
+			printf("  Delay (100 ms): %.3f, %.3f, %.3f\n", oSignal[0], oSignal[iDelay],
+				oSignal[2 * iDelay]);
+			if (std::abs(oSignal[0] - 0.5f) > 1e-5f || std::abs(oSignal[iDelay] - 0.5f) > 1e-3f ||
+				std::abs(oSignal[2 * iDelay] - 0.25f) > 1e-3f)
+			{
+				printf("  Unexpected delay output\n");
+				return false;
+			}
+		}
+
+		// convolution: compare to a direct convolution
+		{
+			constexpr size_t iIRLength = 3000;
+			constexpr size_t iLength = 4 * iBlockSize;
+			std::mt19937 oRNG(42);
+			std::uniform_real_distribution<float> oDist(-1.0f, 1.0f);
+
+			std::vector<float> oIR(iIRLength);
+			for (auto& f : oIR)
+				f = oDist(oRNG) * 0.05f;
+
+			std::vector<float> oInput(iLength * 3);
+			for (auto& f : oInput)
+				f = oDist(oRNG);
+
+			rl::AudioEffectChain oChain;
+			auto spReverb = oChain.add<rl::ConvolutionReverb>(1.0f, 0.0f);
+			spReverb->setImpulseResponse(oIR.data(), oIR.size(), 1);
+			oChain.prepare(iSampleRate, 3, iBlockSize);
+
+			std::vector<float> oOutput = oInput;
+			ProcessBlocks(oChain, oOutput.data(), iLength);
+
+			double dMaxError = 0.0;
+			constexpr size_t iLatency = rl::ConvolutionReverb::PartitionSize;
+			for (uint8_t iChannel = 0; iChannel < 3; ++iChannel)
+			{
+				for (size_t i = iLatency; i < iLength; ++i)
+				{
+					double dExpected = 0.0;
+					for (size_t j = 0; j < iIRLength && j <= i - iLatency; ++j)
+					{
+						dExpected += (double)oIR[j] * oInput[(i - iLatency - j) * 3 + iChannel];
+					}
+					dMaxError =
+						std::max(dMaxError, std::abs(dExpected - oOutput[i * 3 + iChannel]));
+				}
+			}
+
+			printf("  Convolution (%zu samples): max. error %.1e\n", iIRLength, dMaxError);
+			if (dMaxError > 1e-4)
+			{
+				printf("  Unexpected convolution output\n");
+				return false;
+			}
+		}
+
+		printf("\n");
+	}
+
+
+
+	// TEST 2: CPU COST
+	{
+		printf("Test 2: CPU cost per channel (%u Hz, blocks of %u samples)\n", iSampleRate,
+			iBlockSize);
+		constexpr size_t iSeconds = 5;
+		constexpr size_t iSampleCount = iSampleRate * iSeconds;
+
+		std::vector<float> oIR(iSampleRate * 2); // 2 seconds, exponential decay
+		std::mt19937 oRNG(1);
+		std::uniform_real_distribution<float> oDist(-1.0f, 1.0f);
+		for (size_t i = 0; i < oIR.size(); ++i)
+		{
+			oIR[i] = oDist(oRNG) * (float)std::exp(-3.0 * i / iSampleRate) * 0.1f;
+		}
+
+		struct Effect
+		{
+			const char* szName;
+			std::function<std::shared_ptr<rl::IAudioEffect>()> fnCreate;
+		};
+		const Effect oEffects[] =
+		{
+			{ "Biquad (peak)", []() { return std::make_shared<rl::BiquadFilter>(
+				rl::BiquadFilter::Type::Peak, 2000.0f, 1.0f, 6.0f); } },
+			{ "Compressor", []() { return std::make_shared<rl::Compressor>(); } },
+			{ "Limiter", []() { return std::make_shared<rl::Limiter>(); } },
+			{ "Delay", []() { return std::make_shared<rl::Delay>(); } },
+			{ "Reverb (2 s)", [&]()
+				{
+					auto sp = std::make_shared<rl::ConvolutionReverb>();
+					sp->setImpulseResponse(oIR.data(), oIR.size(), 1);
+					return sp;
+				}
+			}
+		};
+		const uint8_t iChannelCounts[] = { 1, 2, 6, 8 };
+
+		printf("  %-14s", "");
+		for (auto iChannelCount : iChannelCounts)
+		{
+			printf("  %u ch: us/s  %%core", (unsigned)iChannelCount);
+		}
+		printf("\n");
+
+		for (const auto& oEffect : oEffects)
+		{
+			printf("  %-14s", oEffect.szName);
+			for (auto iChannelCount : iChannelCounts)
+			{
+				rl::AudioEffectChain oChain;
+				auto spEffect = oEffect.fnCreate();
+				oChain.add(spEffect);
+				oChain.prepare(iSampleRate, iChannelCount, iBlockSize);
+
+				std::vector<float> oSignal(iSampleCount * iChannelCount);
+				for (auto& f : oSignal)
+					f = oDist(oRNG) * 0.5f;
+
+				const auto tpStart = std::chrono::steady_clock::now();
+				ProcessBlocks(oChain, oSignal.data(), iSampleCount);
+				const double dSeconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - tpStart).count();
+
+				// processing time per second of audio and channel
+				const double dMicroseconds = dSeconds * 1000000.0 / iSeconds / iChannelCount;
+				printf("  %9.1f %6.3f", dMicroseconds, dMicroseconds / 10000.0);
+			}
+			printf("\n");
+		}
+
+		printf("\n");
+	}
+
+
+
+	// TEST 3: MODIFICATION WHILE PROCESSING
+	{
+		printf("Test 3: Modifying the chain while it's processed\n");
+		constexpr size_t iBlockCount = 5000;
+
+		rl::AudioEffectChain oChain;
+		oChain.add<Gain>(0.5f);
+		auto spReverb = oChain.add<rl::ConvolutionReverb>(0.0f, 1.0f); // dry signal only
+		oChain.prepare(iSampleRate, 2, iBlockSize);
+
+		// add and remove effects (preparing a reverb takes a while), replace an impulse response
+		std::atomic<bool> bStop = false;
+		size_t iModifications = 0;
+		std::thread trdControl([&]()
+		{
+			std::vector<float> oIR(iSampleRate / 4 * 2, 0.0f);
+			oIR[0] = oIR[1] = 1.0f;
+			while (!bStop)
+			{
+				auto spEffect = std::make_shared<rl::ConvolutionReverb>(0.0f, 1.0f);
+				spEffect->setImpulseResponse(oIR.data(), oIR.size() / 2, 2);
+				oChain.add(spEffect);
+				if (oChain.size() != 3)
+					break;
+				oChain.remove(spEffect.get());
+				if (++iModifications % 4 == 0)
+					spReverb->setImpulseResponse(oIR.data(), oIR.size() / 2, 2);
+			}
+		});
+
+		// every block must be processed, no matter how often the chain is changed
+		std::vector<float> oBlock(iBlockSize * 2);
+		size_t iUnprocessed = 0;
+		for (size_t iBlock = 0; iBlock < iBlockCount; ++iBlock)
+		{
+			std::fill(oBlock.begin(), oBlock.end(), 1.0f);
+			oChain.process(oBlock.data(), iBlockSize);
+			if (std::any_of(oBlock.begin(), oBlock.end(), [](float f) { return f != 0.5f; }))
+				++iUnprocessed;
+		}
+		bStop = true;
+		trdControl.join();
+
+		printf("  %zu blocks, %zu modifications\n", iBlockCount, iModifications);
+		if (iUnprocessed > 0 || oChain.size() != 2)
+		{
+			printf("  %zu blocks weren't processed correctly\n", iUnprocessed);
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+	return true;
+}
@@ -4,7 +4,25 @@
 #include "resource.h"
 
 // rl
+#include <rl/audio.analysis.hpp>
 #include <rl/audio.engine.hpp>
+#include <rl/audio.mixer.hpp>
+#include <rl/audio.spatializer.hpp>
+
+// STL
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
 
 
 
@@ -36,6 +54,190 @@ protected: // methods
 
 
 
+class TestFileStream : public rl::WaveFileStream
+{
+public: // methods
+
+	using rl::WaveFileStream::nextSamples;
+
+	/// <summary>
+	/// Wait until the reading thread has read ahead at least a count of samples
+	/// </summary>
+	bool waitForBuffer(size_t iSampleCount)
+	{
+		for (int i = 0; i < 2000 && getBufferedSamples() < iSampleCount; ++i)
+		{
+			Sleep(1);
+		}
+		return getBufferedSamples() >= iSampleCount;
+	}
+};
+
+
+
+namespace
+{
+
+	constexpr const wchar_t szStreamPath[] = LR"(E:\[TempDel]\test.stream.wav)";
+
+	/// <summary>
+	/// A chunk of a test WAV image
+	/// </summary>
+	struct Chunk
+	{
+		const char* szID;
+		std::vector<uint8_t> oData;
+		uint32_t iDeclaredSize = UINT32_MAX; // size in the chunk header, UINT32_MAX = real size
+	};
+
+	/// <summary>
+	/// Create a RIFF waveform image, chunks of an odd size are followed by a pad byte
+	/// </summary>
+	std::vector<uint8_t> CreateWAV(const std::vector<Chunk>& oChunks)
+	{
+		std::vector<uint8_t> result;
+		auto fnWrite = [&](const void* p, size_t iSize)
+		{
+			result.insert(result.end(), static_cast<const uint8_t*>(p),
+				static_cast<const uint8_t*>(p) + iSize);
+		};
+		auto fnWrite32 = [&](uint32_t i) { fnWrite(&i, sizeof(i)); };
+
+		fnWrite("RIFF", 4);
+		fnWrite32(0); // size is set at the end
+		fnWrite("WAVE", 4);
+		for (const auto& o : oChunks)
+		{
+			fnWrite(o.szID, 4);
+			fnWrite32(o.iDeclaredSize != UINT32_MAX ? o.iDeclaredSize : (uint32_t)o.oData.size());
+			fnWrite(o.oData.data(), o.oData.size());
+			if (o.oData.size() & 1)
+				result.push_back(0);
+		}
+
+		const uint32_t iRIFFSize = uint32_t(result.size() - 8);
+		memcpy(result.data() + 4, &iRIFFSize, sizeof(iRIFFSize));
+		return result;
+	}
+
+	/// <summary>
+	/// The contents of a <c>"fmt "</c> chunk: 16 bit PCM, mono, 48 kHz
+	/// </summary>
+	std::vector<uint8_t> CreatePCMFormat()
+	{
+		const uint16_t iFormat[8] = { 1, 1, 48000 & 0xFFFF, 48000 >> 16,
+			(48000 * 2) & 0xFFFF, (48000 * 2) >> 16, 2, 16 };
+		return std::vector<uint8_t>(reinterpret_cast<const uint8_t*>(iFormat),
+			reinterpret_cast<const uint8_t*>(iFormat) + sizeof(iFormat));
+	}
+
+	/// <summary>
+	/// The contents of a <c>"data"</c> chunk: 16 bit mono, sample <c>i</c> has the value
+	/// <c>i + 1</c>
+	/// </summary>
+	std::vector<uint8_t> CreateRampData(uint16_t iSampleCount)
+	{
+		std::vector<uint8_t> result(iSampleCount * sizeof(int16_t));
+		for (uint16_t i = 0; i < iSampleCount; ++i)
+		{
+			const uint16_t iValue = uint16_t(i + 1);
+			memcpy(result.data() + i * sizeof(int16_t), &iValue, sizeof(iValue));
+		}
+		return result;
+	}
+
+	bool WriteFile(const wchar_t* szPath, const std::vector<uint8_t>& oData)
+	{
+		std::ofstream out(szPath, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(oData.data()), (std::streamsize)oData.size());
+		return out.good();
+	}
+
+	/// <summary>
+	/// An XAudio2 voice that only records the values and operation sets of the parameter changes
+	/// </summary>
+	class RecordingVoice : public IXAudio2Voice
+	{
+	public: // methods
+
+		HRESULT __stdcall SetVolume(float Volume, UINT32 OperationSet) override
+		{
+			record(Volume, OperationSet);
+			return S_OK;
+		}
+		HRESULT __stdcall SetOutputMatrix(IXAudio2Voice*, UINT32, UINT32, const float* pLevelMatrix,
+			UINT32 OperationSet) override
+		{
+			record(pLevelMatrix[0], OperationSet);
+			return S_OK;
+		}
+		void __stdcall DestroyVoice() override { m_bDestroyed = true; }
+
+		void __stdcall GetVoiceDetails(XAUDIO2_VOICE_DETAILS* pVoiceDetails) override
+		{
+			*pVoiceDetails = {};
+		}
+		HRESULT __stdcall SetOutputVoices(const XAUDIO2_VOICE_SENDS*) override { return S_OK; }
+		HRESULT __stdcall SetEffectChain(const XAUDIO2_EFFECT_CHAIN*) override { return S_OK; }
+		HRESULT __stdcall EnableEffect(UINT32, UINT32) override { return S_OK; }
+		HRESULT __stdcall DisableEffect(UINT32, UINT32) override { return S_OK; }
+		void __stdcall GetEffectState(UINT32, BOOL* pEnabled) override { *pEnabled = FALSE; }
+		HRESULT __stdcall SetEffectParameters(UINT32, const void*, UINT32, UINT32) override
+		{
+			return S_OK;
+		}
+		HRESULT __stdcall GetEffectParameters(UINT32, void*, UINT32) override { return S_OK; }
+		HRESULT __stdcall SetFilterParameters(const XAUDIO2_FILTER_PARAMETERS*, UINT32) override
+		{
+			return S_OK;
+		}
+		void __stdcall GetFilterParameters(XAUDIO2_FILTER_PARAMETERS*) override {}
+		HRESULT __stdcall SetOutputFilterParameters(IXAudio2Voice*,
+			const XAUDIO2_FILTER_PARAMETERS*, UINT32) override
+		{
+			return S_OK;
+		}
+		void __stdcall GetOutputFilterParameters(IXAudio2Voice*,
+			XAUDIO2_FILTER_PARAMETERS*) override {}
+		void __stdcall GetVolume(float* pVolume) override { *pVolume = 1.0f; }
+		HRESULT __stdcall SetChannelVolumes(UINT32, const float*, UINT32) override { return S_OK; }
+		void __stdcall GetChannelVolumes(UINT32, float*) override {}
+		void __stdcall GetOutputMatrix(IXAudio2Voice*, UINT32, UINT32, float*) override {}
+
+		size_t getChangeCount()
+		{
+			std::unique_lock lock(m_mux);
+			return m_oChanges.size();
+		}
+		std::vector<std::pair<float, UINT32>> getChanges()
+		{
+			std::unique_lock lock(m_mux);
+			return m_oChanges;
+		}
+		bool destroyed() const { return m_bDestroyed; }
+
+
+	private: // methods
+
+		void record(float fValue, UINT32 iOperationSet)
+		{
+			std::unique_lock lock(m_mux);
+			m_oChanges.push_back({ fValue, iOperationSet });
+		}
+
+
+	private: // variables
+
+		std::mutex m_mux;
+		std::vector<std::pair<float, UINT32>> m_oChanges; // value, operation set
+		std::atomic<bool> m_bDestroyed = false;
+
+	};
+
+}
+
+
+
 bool UnitTest_audio_engine()
 {
 	auto &engine = rl::AudioEngine::GetInstance();
@@ -56,6 +258,14 @@ bool UnitTest_audio_engine()
 	stream.start(wfmt, 0.125f);
 	Sleep(1000);
 	stream.stop();
+	{
+		const auto stats = stream.getStats();
+		const double dAvg = stats.iBlocksGenerated ?
+			stats.dTotalGenerationTime / stats.iBlocksGenerated : 0.0;
+		printf("%llu blocks generated (%llu underruns), avg. %.1f us, max. %.1f us per block\n",
+			(unsigned long long)stats.iBlocksGenerated, (unsigned long long)stats.iUnderruns,
+			dAvg * 1e6, stats.dMaxGenerationTime * 1e6);
+	}
 	printf("\n\n");
 
 
@@ -104,7 +314,578 @@ bool UnitTest_audio_engine()
 	printf("\b \n\n");
 	delete pInstance;
 
+
+	// 2b2: Batched 3D audio
+	printf("\nTest 2b2: Batched 3D audio (moving from left to right)\n");
+	{
+		rl::AudioSpatializer oSpatializer;
+		pInstance = pSound->play3D(rl::Audio3DPos::Left, fVolumeWAV);
+		const auto id = oSpatializer.add(*pInstance, rl::Audio3DPos::Left);
+		for (int i = 0; i <= 100; ++i)
+		{
+			oSpatializer.setPos(id, { -1.0f + i / 50.0f, 0.0f });
+			oSpatializer.update();
+			Sleep(30);
+		}
+		oSpatializer.remove(id);
+		pInstance->stop();
+		delete pInstance;
+	}
+
+
+	// 2b3: Voice virtualization
+	printf("\nTest 2b3: Voice virtualization (1000 emitters, 64 voices)\n");
+	{
+		constexpr size_t iEmitterCount = 1000;
+		constexpr size_t iVoiceLimit = 64;
+
+		const size_t iSourceVoicesBefore = engine.getMetrics().iVoiceCount[
+			(size_t)rl::AudioEngine::VoiceType::SourceVoice];
+
+		rl::AudioSpatializer oSpatializer;
+		oSpatializer.setVoiceLimit(iVoiceLimit);
+		oSpatializer.setAttenuation({ 1.0f, 1000.0f, 1.0f });
+
+		std::vector<rl::SoundInstance3D*> oInstances;
+		std::vector<rl::AudioSpatializer::EmitterID> oIDs;
+		for (size_t i = 0; i < iEmitterCount; ++i)
+		{
+			// all emitters far away, except for a few
+			const float fDistance = (i % 100 == 0) ? 1.0f : 200.0f + i;
+			oInstances.push_back(pSound->play3D(rl::Audio3DPos::Center, fVolumeWAV / 8, true));
+			oIDs.push_back(oSpatializer.add(*oInstances.back(), rl::Audio3DPos::Center,
+				fDistance));
+		}
+
+		auto tpStart = std::chrono::steady_clock::now();
+		oSpatializer.update();
+		const double dUpdateTime = std::chrono::duration<double, std::micro>(
+			std::chrono::steady_clock::now() - tpStart).count();
+
+		const size_t iSourceVoices = engine.getMetrics().iVoiceCount[
+			(size_t)rl::AudioEngine::VoiceType::SourceVoice] - iSourceVoicesBefore;
+		printf("%zu real voices, %zu virtual emitters, update() took %.1f us\n", iSourceVoices,
+			oSpatializer.getVirtualCount(), dUpdateTime);
+		if (iSourceVoices > iVoiceLimit || oInstances[0]->isVirtual() ||
+			oSpatializer.getVirtualCount() != iEmitterCount - iSourceVoices)
+		{
+			printf("Voice limit exceeded or audible emitter was virtualized\n");
+			return false;
+		}
+		Sleep(500);
+
+		// swap the audible emitters with far away ones
+		for (size_t i = 0; i < iEmitterCount; i += 100)
+		{
+			oSpatializer.setDistance(oIDs[i], 1000.0f);
+			oSpatializer.setDistance(oIDs[i + 1], 1.0f);
+		}
+		oSpatializer.update();
+		if (!oInstances[0]->isVirtual() || oInstances[1]->isVirtual())
+		{
+			printf("Emitters weren't virtualized/promoted according to their audibility\n");
+			return false;
+		}
+		Sleep(500);
+
+		// virtual emitters keep playing until the end of the sound
+		oInstances[0]->waitForEnd();
+		if (oInstances[0]->getPlaying())
+		{
+			printf("Virtual emitter didn't end\n");
+			return false;
+		}
+
+		for (size_t i = 0; i < iEmitterCount; ++i)
+		{
+			oSpatializer.remove(oIDs[i]);
+			delete oInstances[i];
+		}
+	}
+
+	delete pSound;
+
+
+	// 2c: Referenced sample data
+	printf("\nTest 2c: Referenced sample data\n");
+	pSound = rl::Sound::FromResource(NULL, MAKEINTRESOURCE(IDW_TEST), false);
+	if (!pSound || pSound->ownsData())
+	{
+		printf("Couldn't reference WAV resource\n");
+		delete pSound;
+		return false;
+	}
+	{
+		auto pInstance = pSound->play(fVolumeWAV);
+		pInstance->waitForEnd();
+		delete pInstance;
+	}
+
+
+	// 2d: Level analysis
+	printf("\nTest 2d: Level analysis\n");
+	{
+		rl::AudioLevel oLevels[XAUDIO2_MAX_AUDIO_CHANNELS];
+		if (!rl::AnalyzeSound(*pSound, oLevels))
+		{
+			printf("Couldn't analyze WAV data\n");
+			delete pSound;
+			return false;
+		}
+		for (uint8_t iChannel = 0; iChannel < pSound->getWaveFormat().iChannelCount; ++iChannel)
+		{
+			printf("Channel %u: Peak %.3f, RMS %.3f\n", iChannel, oLevels[iChannel].peak(),
+				oLevels[iChannel].fRMS);
+		}
+	}
+
+
+	// 2e: Scheduled playback
+	printf("\nTest 2e: Scheduled playback (4 beats, 0.5 seconds apart)\n");
+	{
+		constexpr uint32_t iMixerRate = 48000;
+		rl::Sound* pResampled = rl::Sound::FromResampled(*pSound, iMixerRate);
+		if (!pResampled)
+		{
+			printf("Couldn't resample WAV data\n");
+			delete pSound;
+			return false;
+		}
+
+		rl::AudioMixer oMixer;
+		oMixer.start(iMixerRate, 2, fVolumeWAV);
+
+		const uint64_t iFirstBeat = oMixer.getGeneratedSamples() + iMixerRate / 10;
+		for (uint64_t iBeat = 0; iBeat < 4; ++iBeat)
+		{
+			const auto id = oMixer.schedulePlay(*pResampled, iFirstBeat + iBeat * iMixerRate / 2);
+			oMixer.scheduleStop(id, iFirstBeat + iBeat * iMixerRate / 2 + iMixerRate / 4);
+		}
+		while (oMixer.getPlayedSamples() < iFirstBeat + 2 * iMixerRate)
+		{
+			Sleep(10);
+		}
+
+		oMixer.stop();
+		delete pResampled;
+	}
 	delete pSound;
+	printf("\n");
+
+	// 3: Metrics
+	printf("Test 3: Metrics\n");
+	{
+		const auto oMetrics = engine.getMetrics();
+		printf("Voices: %zu mastering, %zu submix, %zu source\n",
+			oMetrics.iVoiceCount[(size_t)rl::AudioEngine::VoiceType::MasteringVoice],
+			oMetrics.iVoiceCount[(size_t)rl::AudioEngine::VoiceType::SubmixVoice],
+			oMetrics.iVoiceCount[(size_t)rl::AudioEngine::VoiceType::SourceVoice]);
+		printf("Stream blocks: %llu (%llu underruns)\n",
+			(unsigned long long)oMetrics.iStreamBlocks,
+			(unsigned long long)oMetrics.iStreamUnderruns);
+		printf("Fill time: p50 %.1f us (%.2f %%), p99 %.1f us (%.2f %%)\n",
+			oMetrics.dFillTimeP50 * 1e6, oMetrics.fFillRatioP50 * 100.0f,
+			oMetrics.dFillTimeP99 * 1e6, oMetrics.fFillRatioP99 * 100.0f);
+		printf("Device latency: %.1f ms\n", oMetrics.dDeviceLatency * 1e3);
+		printf("Sound memory: %zu bytes (+ %zu bytes referenced)\n", oMetrics.iSoundMemory,
+			oMetrics.iSoundMemoryReferenced);
+	}
+	printf("\n");
+
+	// 4: Parameter batches
+	printf("Test 4: Parameter batches (posted from 4 threads)\n");
+	{
+		using Voice = rl::AudioEngine::Voice;
+
+		constexpr size_t iVoiceCount = 8;
+		constexpr size_t iThreadCount = 4;
+		constexpr size_t iBatchesPerThread = 250;
+
+		std::vector<std::unique_ptr<RecordingVoice>> oRecorders;
+		std::vector<std::unique_ptr<Voice>> oVoices;
+		for (size_t i = 0; i < iVoiceCount; ++i)
+		{
+			oRecorders.push_back(std::make_unique<RecordingVoice>());
+			oVoices.push_back(std::make_unique<Voice>(oRecorders.back().get(),
+				std::set<rl::AudioEngine::SubmixVoice*>{},
+				rl::AudioEngine::VoiceType::SubmixVoice));
+		}
+
+		// every value identifies a batch; other operation sets are allocated at the same time
+		std::vector<std::vector<UINT32>> oAllocated(iThreadCount);
+		std::vector<std::thread> oThreads;
+		for (size_t iThread = 0; iThread < iThreadCount; ++iThread)
+		{
+			oThreads.emplace_back([&, iThread]()
+			{
+				for (size_t iBatch = 0; iBatch < iBatchesPerThread; ++iBatch)
+				{
+					const float fValue = float(iThread * iBatchesPerThread + iBatch + 1);
+					const float oMatrix[2] = { fValue, fValue };
+
+					rl::AudioEngine::ParameterBatch oBatch;
+					for (auto& up : oVoices)
+					{
+						oBatch.setVolume(*up, fValue);
+						oBatch.setOutputMatrix(*up, nullptr, 1, 2, oMatrix);
+					}
+					rl::AudioEngine::PostBatch(std::move(oBatch));
+
+					oAllocated[iThread].push_back(rl::AudioEngine::AllocateOperationSet());
+				}
+			});
+		}
+		for (auto& trd : oThreads)
+		{
+			trd.join();
+		}
+
+		const size_t iExpectedChanges = iThreadCount * iBatchesPerThread * 2;
+		const auto tpStart = std::chrono::steady_clock::now();
+		while (oRecorders.back()->getChangeCount() < iExpectedChanges &&
+			std::chrono::steady_clock::now() - tpStart < std::chrono::seconds(5))
+		{
+			Sleep(10);
+		}
+
+		// all changes of a batch share one operation set that isn't used for anything else
+		std::map<float, UINT32> oOperationSetOfBatch;
+		std::set<UINT32> oUsedOperationSets;
+		for (const auto& oAlloc : oAllocated)
+		{
+			oUsedOperationSets.insert(oAlloc.begin(), oAlloc.end());
+		}
+		const size_t iAllocatedCount = oUsedOperationSets.size();
+		bool bAtomic = iAllocatedCount == iThreadCount * iBatchesPerThread;
+		for (auto& up : oRecorders)
+		{
+			const auto oChanges = up->getChanges();
+			if (oChanges.size() != iExpectedChanges)
+				bAtomic = false;
+
+			for (const auto& [fValue, iOperationSet] : oChanges)
+			{
+				if (iOperationSet == XAUDIO2_COMMIT_NOW || iOperationSet == XAUDIO2_COMMIT_ALL)
+					bAtomic = false;
+
+				const auto [it, bNew] = oOperationSetOfBatch.insert({ fValue, iOperationSet });
+				if (it->second != iOperationSet)
+					bAtomic = false;
+				if (bNew && !oUsedOperationSets.insert(iOperationSet).second)
+					bAtomic = false;
+			}
+		}
+
+		for (size_t i = 0; i < iVoiceCount; ++i)
+		{
+			oVoices[i]->destroy();
+			while (!oRecorders[i]->destroyed())
+			{
+				Sleep(1);
+			}
+		}
+
+		printf("%zu batches applied with %zu operation sets (+ %zu allocated concurrently)\n",
+			oOperationSetOfBatch.size(), oUsedOperationSets.size() - iAllocatedCount,
+			iAllocatedCount);
+		if (!bAtomic || oOperationSetOfBatch.size() != iThreadCount * iBatchesPerThread)
+		{
+			printf("A batch wasn't applied in exactly one unique operation set\n");
+			return false;
+		}
+
+		// Flush() waits until the batches were applied
+		RecordingVoice oRecorder;
+		Voice oVoice(&oRecorder, {}, rl::AudioEngine::VoiceType::SubmixVoice);
+		for (size_t i = 0; i < 100; ++i)
+		{
+			rl::AudioEngine::ParameterBatch oBatch;
+			oBatch.setVolume(oVoice, float(i));
+			rl::AudioEngine::PostBatch(std::move(oBatch));
+		}
+		rl::AudioEngine::Flush();
+		const size_t iFlushed = oRecorder.getChangeCount();
+
+		// a voice destroyed right after posting a batch is destroyed after the batch was applied
+		rl::AudioEngine::ParameterBatch oBatch;
+		oBatch.setVolume(oVoice, 1.0f);
+		rl::AudioEngine::PostBatch(std::move(oBatch));
+		oVoice.destroyAndWait();
+		if (iFlushed != 100 || !oRecorder.destroyed() || oRecorder.getChangeCount() != 101)
+		{
+			printf("A batch wasn't applied before Flush() or the destruction of its voice\n");
+			return false;
+		}
+	}
+	printf("\n");
+
+	// 5: Stopping decoded sounds
+	printf("Test 5: Stopping and virtualizing compressed sounds while they're decoded\n");
+	{
+		const size_t iSourceVoicesBefore = engine.getMetrics().iVoiceCount[
+			(size_t)rl::AudioEngine::VoiceType::SourceVoice];
+
+		rl::WaveFormat oFormat{};
+		oFormat.eBitDepth = rl::AudioBitDepth::Audio16;
+		oFormat.iChannelCount = 1;
+		oFormat.iSampleRate = 44100;
+		rl::Sound oPCM(oFormat, oFormat.iSampleRate * 2);
+		auto pSamples = reinterpret_cast<int16_t*>(const_cast<void*>(oPCM.getDataPtr()));
+		for (size_t i = 0; i < oPCM.getSampleCount(); ++i)
+		{
+			pSamples[i] = int16_t((rand() % 2048) - 1024);
+		}
+		std::unique_ptr<rl::Sound> upSound(rl::Sound::FromCompressed(oPCM,
+			rl::AudioCompression::IMA_ADPCM));
+		if (!upSound)
+		{
+			printf("Couldn't compress the sound\n");
+			return false;
+		}
+
+		// the decode cache must outlive the OnBufferEnd callbacks that refill it
+		for (int i = 0; i < 200; ++i)
+		{
+			std::unique_ptr<rl::SoundInstance> upInstance(upSound->play(fVolumeWAV / 8));
+			Sleep(i % 5);
+			upInstance->stop();
+		}
+
+		rl::AudioSpatializer oSpatializer;
+		oSpatializer.setVoiceLimit(1);
+		oSpatializer.setAttenuation({ 1.0f, 1000.0f, 1.0f });
+		std::unique_ptr<rl::SoundInstance3D> upNear(
+			upSound->play3D(rl::Audio3DPos::Center, fVolumeWAV / 8));
+		std::unique_ptr<rl::SoundInstance3D> upFar(
+			upSound->play3D(rl::Audio3DPos::Center, fVolumeWAV / 8));
+		const auto idNear = oSpatializer.add(*upNear, rl::Audio3DPos::Center, 1.0f);
+		const auto idFar = oSpatializer.add(*upFar, rl::Audio3DPos::Center, 2.0f);
+		for (int i = 0; i < 100; ++i)
+		{
+			// swap the voice between the emitters on every update
+			oSpatializer.setDistance(idNear, (i % 2) ? 1.0f : 4.0f);
+			oSpatializer.update();
+			Sleep(i % 3);
+		}
+		oSpatializer.remove(idNear);
+		oSpatializer.remove(idFar);
+		upNear.reset();
+		upFar.reset();
+
+		const size_t iSourceVoices = engine.getMetrics().iVoiceCount[
+			(size_t)rl::AudioEngine::VoiceType::SourceVoice];
+		if (iSourceVoices != iSourceVoicesBefore)
+		{
+			printf("%zu source voices weren't destroyed\n", iSourceVoices - iSourceVoicesBefore);
+			return false;
+		}
+	}
+	printf("\n");
+
+	// 6: Streaming a WAV file
+	printf("Test 6: Streaming a WAV file (seeking, looping, underruns)\n");
+	{
+		constexpr uint16_t iSampleCount = 20000;
+		constexpr size_t iBlockCount = 4;
+		constexpr size_t iSamplesPerBlock = 1000;
+		constexpr size_t iReadAhead = iBlockCount * iSamplesPerBlock;
+
+		TestFileStream oStream;
+		const auto oWAV =
+			CreateWAV({ { "fmt ", CreatePCMFormat() }, { "data", CreateRampData(iSampleCount) } });
+		if (!WriteFile(szStreamPath, oWAV) ||
+			!oStream.open(szStreamPath, iBlockCount, iSamplesPerBlock) ||
+			oStream.getSampleCount() != iSampleCount)
+		{
+			printf("Couldn't open the WAV file\n");
+			return false;
+		}
+
+		// read samples that were already buffered, compare them to the expected positions
+		std::vector<int16_t> oSamples(iReadAhead * 2);
+		auto fnCheck = [&](size_t iCount, size_t iPos, size_t iLoopBegin, size_t iLoopEnd)
+		{
+			if (!oStream.waitForBuffer(iCount) ||
+				oStream.nextSamples(reinterpret_cast<uint8_t*>(oSamples.data()), iCount) != iCount)
+				return false;
+
+			for (size_t i = 0; i < iCount; ++i, ++iPos)
+			{
+				if (iPos == iLoopEnd)
+					iPos = iLoopBegin;
+				if (oSamples[i] != int16_t(iPos + 1))
+					return false;
+			}
+			return true;
+		};
+
+		// 6a: Seek
+		oStream.seek(12345);
+		if (!fnCheck(3000, 12345, 0, iSampleCount) || oStream.getPosition() != 15345)
+		{
+			printf("Wrong samples after seeking\n");
+			return false;
+		}
+
+		// 6b: Loop point wrap
+		oStream.setLoop(true, 1000, 5000);
+		oStream.seek(4000);
+		if (!fnCheck(3000, 4000, 1000, 5000) || oStream.getPosition() != 3000 ||
+			!fnCheck(iReadAhead, 3000, 1000, 5000) || oStream.getPosition() != 3000)
+		{
+			printf("Wrong samples at the loop point\n");
+			return false;
+		}
+
+		// 6c: Underrun --> silence instead of waiting, no samples are lost
+		oStream.setLoop(false);
+		oStream.seek(0);
+		if (!oStream.waitForBuffer(iReadAhead) || oStream.getUnderruns() != 0)
+		{
+			printf("The reading thread didn't fill the buffer\n");
+			return false;
+		}
+		const size_t iRequested = iReadAhead + 500; // more than was read ahead
+		const auto tpStart = std::chrono::steady_clock::now();
+		const size_t iWritten =
+			oStream.nextSamples(reinterpret_cast<uint8_t*>(oSamples.data()), iRequested);
+		const double dMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+		bool bSilence = true;
+		for (size_t i = iReadAhead; i < iRequested; ++i)
+		{
+			bSilence &= (oSamples[i] == 0);
+		}
+		printf("Underrun handled in %.3f ms\n", dMilliseconds);
+		if (iWritten != iRequested || oSamples[iReadAhead - 1] != int16_t(iReadAhead) ||
+			!bSilence || oStream.getUnderruns() != 1 || oStream.getPosition() != iReadAhead ||
+			!fnCheck(iSamplesPerBlock, iReadAhead, 0, iSampleCount))
+		{
+			printf("The underrun wasn't replaced with silence\n");
+			return false;
+		}
+
+		// 6d: End of the file
+		oStream.seek(iSampleCount - 100);
+		if (!oStream.waitForBuffer(100) ||
+			oStream.nextSamples(reinterpret_cast<uint8_t*>(oSamples.data()), 1000) != 100 ||
+			oSamples[99] != int16_t(iSampleCount) || oStream.getUnderruns() != 1)
+		{
+			printf("The end of the file wasn't detected\n");
+			return false;
+		}
+
+		// 6e: Playback --> starting and seeking wait for the file instead of playing silence
+		if (!oStream.open(szStreamPath))
+		{
+			printf("Couldn't reopen the WAV file\n");
+			return false;
+		}
+		for (size_t i = 0; i < 10; ++i)
+		{
+			oStream.play(0.0f);
+			Sleep(5);
+			oStream.seek(i * 1999);
+			Sleep(5);
+			oStream.stop();
+		}
+		if (oStream.getUnderruns() != 0)
+		{
+			printf("%llu underruns after starting or seeking\n",
+				(unsigned long long)oStream.getUnderruns());
+			return false;
+		}
+
+		oStream.close();
+	}
+	printf("\n");
+
+	// 7: Malformed WAV data
+	printf("Test 7: Malformed WAV data\n");
+	{
+		const auto oFmt = CreatePCMFormat();
+		const auto oData = CreateRampData(100);
+		const auto oValid = CreateWAV({ { "fmt ", oFmt }, { "data", oData } });
+		auto fnTruncate = [](std::vector<uint8_t> o, size_t iSize)
+		{
+			o.resize(iSize);
+			o.shrink_to_fit(); // reads past the end must leave the allocation
+			return o;
+		};
+		auto fnSetRIFFSize = [](std::vector<uint8_t> o, uint32_t iSize)
+		{
+			memcpy(o.data() + 4, &iSize, sizeof(iSize));
+			return o;
+		};
+
+		struct WAVImage
+		{
+			const char* szDescription;
+			std::vector<uint8_t> oData;
+			size_t iSampleCount; // 0 = must be rejected
+		};
+		std::vector<WAVImage> oImages =
+		{
+			{ "valid", oValid, 100 },
+			{ "odd chunk size with pad byte",
+				CreateWAV({ { "fmt ", oFmt }, { "LIST", std::vector<uint8_t>(5, 0xFF) },
+					{ "data", oData } }), 100 },
+			{ "odd data size", CreateWAV({ { "fmt ", oFmt }, { "data", fnTruncate(oData, 199) } }),
+				99 },
+			{ "truncated chunk", fnTruncate(CreateWAV({ { "fmt ", oFmt },
+				{ "LIST", std::vector<uint8_t>(1000) }, { "data", oData } }), 44 + 500), 0 },
+			{ "truncated chunk header", fnTruncate(oValid, 40), 0 },
+			{ "truncated \"fmt \" chunk", fnTruncate(oValid, 30), 0 },
+			{ "\"data\" size past the end",
+				CreateWAV({ { "fmt ", oFmt }, { "data", oData, 100000 } }), 100 },
+			{ "\"data\" size past the end, partial sample", fnTruncate(oValid, 44 + 151), 75 },
+			{ "missing \"fmt \"", CreateWAV({ { "data", oData } }), 0 },
+			{ "\"fmt \" after \"data\"", CreateWAV({ { "data", oData }, { "fmt ", oFmt } }), 0 },
+			{ "missing \"data\"", CreateWAV({ { "fmt ", oFmt } }), 0 },
+			{ "\"fmt \" too short",
+				CreateWAV({ { "fmt ", fnTruncate(oFmt, 14) }, { "data", oData } }), 0 },
+			{ "\"fmt \" shorter than its header",
+				CreateWAV({ { "fmt ", fnTruncate(oFmt, 8) }, { "data", oData } }), 0 },
+		};
+		// a RIFF chunk too small for its form type, with and without data after it
+		for (uint32_t iRIFFSize = 0; iRIFFSize < 4; ++iRIFFSize)
+		{
+			oImages.push_back({ "RIFF size below 4",
+				fnSetRIFFSize(fnTruncate(oValid, 12), iRIFFSize), 0 });
+			oImages.push_back({ "RIFF size below 4, followed by chunks",
+				fnSetRIFFSize(oValid, iRIFFSize), 0 });
+		}
+
+		for (const auto& o : oImages)
+		{
+			// in memory: the referenced sample data must lie inside the image
+			std::unique_ptr<rl::Sound> upSound(
+				rl::Sound::FromMemory(o.oData.data(), o.oData.size(), false));
+			bool bOK = (upSound != nullptr) == (o.iSampleCount > 0);
+			if (bOK && upSound)
+			{
+				const auto p = static_cast<const uint8_t*>(upSound->getDataPtr());
+				bOK = upSound->getSampleCount() == o.iSampleCount &&
+					p >= o.oData.data() &&
+					p + upSound->getDataSize() <= o.oData.data() + o.oData.size() &&
+					*reinterpret_cast<const int16_t*>(p) == 1;
+			}
+
+			// the same image as a file
+			TestFileStream oStream;
+			const bool bOpened = WriteFile(szStreamPath, o.oData) && oStream.open(szStreamPath);
+			bOK &= bOpened == (o.iSampleCount > 0) &&
+				(!bOpened || oStream.getSampleCount() == o.iSampleCount);
+
+			if (!bOK)
+			{
+				printf("Wrong result for WAV data: %s\n", o.szDescription);
+				return false;
+			}
+		}
+		printf("%zu WAV images checked\n", oImages.size());
+	}
+	printf("\n");
 
 	printf("All tests done.\n");
 
@@ -0,0 +1,258 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.mixer.hpp>
+
+// STL
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+
+	constexpr uint32_t iMixerRate = 48000;
+
+	/// <summary>
+	/// A mono mixer whose samples are generated by the test instead of the audio thread
+	/// </summary>
+	class TestMixer : public rl::AudioMixer
+	{
+	public: // methods
+
+		void prepare(size_t iMaxVoices = 64, size_t iMaxEvents = 1024)
+		{
+			start(iMixerRate, 1, 1.0f, 4, 256, iMaxVoices, iMaxEvents);
+			stop(); // the timeline and the voices are kept
+		}
+
+		std::vector<float> generate(size_t iSampleCount)
+		{
+			std::vector<float> result(iSampleCount, 0.0f);
+			nextSamples(reinterpret_cast<uint8_t*>(result.data()), iSampleCount);
+			return result;
+		}
+	};
+
+	/// <summary>
+	/// A mono 32-bit float sound where every sample is 1.0
+	/// </summary>
+	rl::Sound CreateConstantSound(uint32_t iSampleRate, size_t iSampleCount)
+	{
+		rl::WaveFormat oFormat;
+		oFormat.eBitDepth = rl::AudioBitDepth::Audio32;
+		oFormat.iChannelCount = 1;
+		oFormat.iSampleRate = iSampleRate;
+		rl::Sound result(oFormat, iSampleCount);
+		auto pSamples = static_cast<float*>(const_cast<void*>(result.getDataPtr()));
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			pSamples[i] = 1.0f;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// A mono 16-bit sound with a 1 kHz sine wave
+	/// </summary>
+	rl::Sound CreateSineSound(uint32_t iSampleRate, size_t iSampleCount)
+	{
+		rl::WaveFormat oFormat;
+		oFormat.eBitDepth = rl::AudioBitDepth::Audio16;
+		oFormat.iChannelCount = 1;
+		oFormat.iSampleRate = iSampleRate;
+		rl::Sound result(oFormat, iSampleCount);
+		auto pSamples = static_cast<int16_t*>(const_cast<void*>(result.getDataPtr()));
+		for (size_t i = 0; i < iSampleCount; ++i)
+		{
+			pSamples[i] =
+				int16_t(16000.0 * std::sin(2.0 * 3.14159265358979 * 1000.0 * i / iSampleRate));
+		}
+		return result;
+	}
+
+}
+
+
+
+bool UnitTest_audio_mixer()
+{
+	auto& oEngine = rl::AudioEngine::GetInstance();
+	if (!oEngine && !oEngine.create())
+	{
+		printf("Couldn't create the audio engine\n");
+		return false;
+	}
+
+	const rl::Sound oSound = CreateConstantSound(iMixerRate, iMixerRate);
+
+
+
+	// TEST 1: TIMELINE
+	{
+		printf("Test 1: Sample-accurate events\n");
+
+		TestMixer oMixer;
+		oMixer.prepare();
+		const uint64_t iBase = oMixer.getGeneratedSamples();
+
+		const auto id = oMixer.schedulePlay(oSound, iBase + 10, 0.5f);
+		if (id == rl::AudioMixer::InvalidVoice || !oMixer.scheduleVolume(id, iBase + 20, 0.25f) ||
+			!oMixer.scheduleStop(id, iBase + 30))
+		{
+			printf("  Couldn't schedule the events\n");
+			return false;
+		}
+
+		const auto oSamples = oMixer.generate(64);
+		for (size_t i = 0; i < oSamples.size(); ++i)
+		{
+			const float fExpected = (i < 10) ? 0.0f : (i < 20) ? 0.5f : (i < 30) ? 0.25f : 0.0f;
+			if (oSamples[i] != fExpected)
+			{
+				printf("  Wrong value at sample %zu\n", i);
+				return false;
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: CAPACITY
+	{
+		printf("Test 2: Voice and event limits\n");
+
+		TestMixer oMixer;
+		oMixer.prepare(2, 4);
+		const uint64_t iBase = oMixer.getGeneratedSamples();
+
+		const auto id1 = oMixer.schedulePlay(oSound, iBase);
+		const auto id2 = oMixer.schedulePlay(oSound, iBase);
+		const bool bVoicesUsedUp =
+			oMixer.schedulePlay(oSound, iBase) == rl::AudioMixer::InvalidVoice;
+		const bool bStopped = oMixer.scheduleStop(id1, iBase + 1) &&
+			oMixer.scheduleStop(id2, iBase + 1);
+		const bool bEventsUsedUp = !oMixer.scheduleVolume(id1, iBase, 0.5f);
+		if (id1 == rl::AudioMixer::InvalidVoice || id2 == rl::AudioMixer::InvalidVoice ||
+			!bVoicesUsedUp || !bStopped || !bEventsUsedUp)
+		{
+			printf("  The limits weren't applied\n");
+			return false;
+		}
+
+		// processed events and ended voices are available again
+		const auto oSamples = oMixer.generate(2);
+		const auto id3 = oMixer.schedulePlay(oSound, iBase + 2);
+		if (oSamples[0] != 2.0f || oSamples[1] != 0.0f || id3 == rl::AudioMixer::InvalidVoice ||
+			oMixer.generate(1)[0] != 1.0f)
+		{
+			printf("  The voices or events weren't released\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 3: CONCURRENT SCHEDULING
+	{
+		constexpr size_t iThreadCount = 4;
+		constexpr size_t iVoicesPerThread = 200;
+		printf("Test 3: Scheduling from %zu threads while mixing\n", iThreadCount);
+
+		TestMixer oMixer;
+		oMixer.prepare(iThreadCount * iVoicesPerThread, 2 * iThreadCount * iVoicesPerThread);
+		const uint64_t iFirst = oMixer.getGeneratedSamples() + 100000;
+
+		// every voice plays exactly one sample, all of them after the mixing below
+		std::vector<std::thread> oThreads;
+		for (size_t iThread = 0; iThread < iThreadCount; ++iThread)
+		{
+			oThreads.emplace_back([&, iThread]()
+			{
+				for (size_t i = 0; i < iVoicesPerThread; ++i)
+				{
+					const uint64_t iSample = iFirst + 2 * (iThread * iVoicesPerThread + i);
+					oMixer.scheduleStop(oMixer.schedulePlay(oSound, iSample), iSample + 1);
+				}
+			});
+		}
+		for (size_t i = 0; i < 100; ++i)
+		{
+			oMixer.generate(256);
+		}
+		for (auto& trd : oThreads)
+		{
+			trd.join();
+		}
+
+		const size_t iVoiceCount = iThreadCount * iVoicesPerThread;
+		const auto oSamples =
+			oMixer.generate(size_t(iFirst - oMixer.getGeneratedSamples()) + 2 * iVoiceCount);
+		const float fSum = std::accumulate(oSamples.begin(), oSamples.end(), 0.0f);
+		if (fSum != float(iVoiceCount))
+		{
+			printf("  %.0f of %zu voices were played\n", fSum, iVoiceCount);
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 4: RESAMPLING
+	{
+		printf("Test 4: Sounds with a different sample rate\n");
+
+		const rl::Sound oSine = CreateSineSound(44100, 4410);
+		std::unique_ptr<rl::Sound> upExpected(rl::Sound::FromResampled(oSine, iMixerRate));
+		if (!upExpected)
+		{
+			printf("  Couldn't resample the sound\n");
+			return false;
+		}
+		const size_t iExpectedCount = upExpected->getSampleCount();
+		auto pExpected = static_cast<const float*>(upExpected->getDataPtr());
+
+		TestMixer oMixer;
+		oMixer.prepare();
+		const uint64_t iBase = oMixer.getGeneratedSamples();
+		if (oMixer.schedulePlay(oSine, iBase + 5) == rl::AudioMixer::InvalidVoice)
+		{
+			printf("  Couldn't schedule the sound\n");
+			return false;
+		}
+
+		// small blocks, so the resampler is interrupted often
+		std::vector<float> oSamples;
+		while (oSamples.size() < 5 + iExpectedCount + 100)
+		{
+			const auto oBlock = oMixer.generate(100);
+			oSamples.insert(oSamples.end(), oBlock.begin(), oBlock.end());
+		}
+		for (size_t i = 0; i < oSamples.size(); ++i)
+		{
+			const float fExpected =
+				(i < 5 || i >= 5 + iExpectedCount) ? 0.0f : pExpected[i - 5];
+			if (std::abs(oSamples[i] - fExpected) > 1e-6f)
+			{
+				printf("  Wrong value at sample %zu\n", i);
+				return false;
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,86 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.resampler.hpp>
+
+// STL
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+
+
+bool UnitTest_audio_resampler()
+{
+	constexpr uint32_t iInputRate = 44100;
+	constexpr uint32_t iOutputRate = 48000;
+	constexpr uint8_t iChannelCount = 2;
+	constexpr size_t iInputSampleCount = iInputRate * 10; // 10 seconds
+	constexpr size_t iRepetitions = 5;
+
+	const char* szQualityNames[] = { "Linear", "Low", "Medium", "High" };
+	const double dMaxErrors[] = { 5e-3, 4e-3, 5e-4, 1e-4 }; // about twice the measured error
+
+	// 1 kHz sine wave on both channels
+	auto upInput = std::make_unique<float[]>(iInputSampleCount * iChannelCount);
+	for (size_t i = 0; i < iInputSampleCount; ++i)
+	{
+		const float f = (float)std::sin(2.0 * 3.14159265358979 * 1000.0 * i / iInputRate);
+		for (uint8_t iChannel = 0; iChannel < iChannelCount; ++iChannel)
+		{
+			upInput[i * iChannelCount + iChannel] = f;
+		}
+	}
+
+	printf("Resampling %u Hz --> %u Hz, %u channels, %zu samples\n\n", iInputRate, iOutputRate,
+		(unsigned)iChannelCount, iInputSampleCount);
+
+	for (uint8_t iQuality = 0; iQuality < 4; ++iQuality)
+	{
+		rl::AudioResampler oResampler;
+		if (!oResampler.create(iInputRate, iOutputRate, iChannelCount,
+			static_cast<rl::ResamplerQuality>(iQuality)))
+		{
+			printf("Couldn't create the resampler\n");
+			return false;
+		}
+
+		const size_t iOutputSampleCount = oResampler.getOutputSampleCount(iInputSampleCount);
+		auto upOutput = std::make_unique<float[]>(iOutputSampleCount * iChannelCount);
+
+		size_t iTotalFrames = 0;
+		const auto tpStart = std::chrono::steady_clock::now();
+		for (size_t iRep = 0; iRep < iRepetitions; ++iRep)
+		{
+			oResampler.reset();
+			size_t iUsed;
+			iTotalFrames += oResampler.process(upInput.get(), iInputSampleCount, iUsed,
+				upOutput.get(), iOutputSampleCount);
+		}
+		const double dSeconds =
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - tpStart).count();
+
+		// maximum deviation from the ideal sine wave (ignoring the start)
+		double dMaxError = 0.0;
+		for (size_t i = 100; i < iOutputSampleCount; ++i)
+		{
+			const double dIdeal = std::sin(2.0 * 3.14159265358979 * 1000.0 * i / iOutputRate);
+			const double dError = std::abs(upOutput[i * iChannelCount] - dIdeal);
+			if (dError > dMaxError)
+				dMaxError = dError;
+		}
+
+		printf("%-6s (%2zu taps, %4zu phases): %8.2f M frames/s, %6.1f x realtime, "
+			"max. error %.1e\n", szQualityNames[iQuality], oResampler.getTapCount(),
+			oResampler.getPhaseCount(), iTotalFrames / dSeconds / 1000000.0,
+			iTotalFrames / dSeconds / iOutputRate, dMaxError);
+		if (dMaxError > dMaxErrors[iQuality])
+		{
+			printf("  The error is above the maximum of %.1e\n", dMaxErrors[iQuality]);
+			return false;
+		}
+	}
+
+	printf("\n");
+	return true;
+}
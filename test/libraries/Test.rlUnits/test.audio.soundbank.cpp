@@ -0,0 +1,256 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.soundbank.hpp>
+
+// STL
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+
+namespace
+{
+
+	constexpr const wchar_t szBankPath[] = LR"(E:\[TempDel]\test.rlSBK)";
+
+	constexpr size_t iSoundCount = 2000;
+
+	/// <summary>
+	/// Create a RIFF waveform image of a sound, as it would be stored in a WAV file
+	/// </summary>
+	std::vector<uint8_t> CreateRIFF(const rl::Sound& sound)
+	{
+		const auto& oFormat = sound.getWaveFormat();
+		const uint32_t iDataSize = (uint32_t)sound.getDataSize();
+		const uint16_t iBlockAlign =
+			uint16_t((uint16_t)oFormat.eBitDepth / 8 * oFormat.iChannelCount);
+
+		std::vector<uint8_t> oResult(44 + iDataSize);
+		uint8_t* p = oResult.data();
+		auto fnWrite = [&](const void* pSrc, size_t iSize) { memcpy(p, pSrc, iSize); p += iSize; };
+		auto fnWrite16 = [&](uint16_t i) { fnWrite(&i, sizeof(i)); };
+		auto fnWrite32 = [&](uint32_t i) { fnWrite(&i, sizeof(i)); };
+
+		fnWrite("RIFF", 4);
+		fnWrite32(36 + iDataSize);
+		fnWrite("WAVEfmt ", 8);
+		fnWrite32(16);
+		fnWrite16(oFormat.eBitDepth == rl::AudioBitDepth::Audio32 ? 3 : 1); // float/PCM
+		fnWrite16(oFormat.iChannelCount);
+		fnWrite32(oFormat.iSampleRate);
+		fnWrite32(oFormat.iSampleRate * iBlockAlign);
+		fnWrite16(iBlockAlign);
+		fnWrite16((uint16_t)oFormat.eBitDepth);
+		fnWrite("data", 4);
+		fnWrite32(iDataSize);
+		fnWrite(sound.getDataPtr(), iDataSize);
+
+		return oResult;
+	}
+
+	/// <summary>
+	/// Create a short sound (20 to 500 ms) with a sine of a frequency depending on the index
+	/// </summary>
+	std::unique_ptr<rl::Sound> CreateSound(size_t iIndex)
+	{
+		rl::WaveFormat oFormat;
+		oFormat.eBitDepth =
+			(iIndex % 4 == 3) ? rl::AudioBitDepth::Audio32 : rl::AudioBitDepth::Audio16;
+		oFormat.iChannelCount = uint8_t(1 + iIndex % 2);
+		oFormat.iSampleRate = 48000;
+
+		const size_t iSampleCount = 960 + (iIndex * 7919) % 23040;
+		auto upSound = std::make_unique<rl::Sound>(oFormat, iSampleCount);
+		auto p = static_cast<uint8_t*>(const_cast<void*>(upSound->getDataPtr()));
+
+		const double dFrequency = 100.0 + iIndex;
+		for (size_t i = 0; i < iSampleCount * oFormat.iChannelCount; ++i)
+		{
+			const double d = 0.5 * std::sin(2.0 * 3.14159265358979 * dFrequency *
+				(i / oFormat.iChannelCount) / oFormat.iSampleRate);
+			if (oFormat.eBitDepth == rl::AudioBitDepth::Audio32)
+				reinterpret_cast<float*>(p)[i] = (float)d;
+			else
+				reinterpret_cast<int16_t*>(p)[i] = (int16_t)std::lround(d * 32767.0);
+		}
+
+		return upSound;
+	}
+
+	std::wstring SoundName(size_t iIndex)
+	{
+		wchar_t szName[32];
+		swprintf(szName, std::size(szName), L"sfx/%04zu", iIndex);
+		return szName;
+	}
+
+	bool SameSound(const rl::Sound& a, const rl::Sound& b)
+	{
+		return a.getSampleCount() == b.getSampleCount() && a.getDataSize() == b.getDataSize() &&
+			a.getWaveFormat().eBitDepth == b.getWaveFormat().eBitDepth &&
+			a.getWaveFormat().iChannelCount == b.getWaveFormat().iChannelCount &&
+			a.getWaveFormat().iSampleRate == b.getWaveFormat().iSampleRate &&
+			a.isCompressed() == b.isCompressed() &&
+			memcmp(a.getDataPtr(), b.getDataPtr(), a.getDataSize()) == 0;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+}
+
+
+
+bool UnitTest_audio_soundbank()
+{
+	std::vector<std::unique_ptr<rl::Sound>> oSources;
+	std::map<std::wstring, const rl::Sound*> oBankContents;
+	for (size_t i = 0; i < iSoundCount; ++i)
+	{
+		oSources.push_back(CreateSound(i));
+		if (i % 100 == 0) // some compressed sounds
+			oSources.back().reset(rl::Sound::FromCompressed(*oSources.back(),
+				rl::AudioCompression::IMA_ADPCM));
+		oBankContents[SoundName(i)] = oSources.back().get();
+	}
+
+	std::vector<uint8_t> oBankData;
+	if (!rl::SoundBank::SaveToMemory(oBankData, oBankContents))
+	{
+		printf("Couldn't create the sound bank\n");
+		return false;
+	}
+
+
+
+	// TEST 1: CONTENTS
+	{
+		printf("Test 1: Contents (%zu sounds, %zu bytes)\n", iSoundCount, oBankData.size());
+
+		rl::SoundBank oBank;
+		if (!oBank.loadFromMemory(oBankData.data(), oBankData.size(), false) ||
+			oBank.size() != iSoundCount)
+		{
+			printf("  Couldn't load the sound bank\n");
+			return false;
+		}
+
+		for (size_t i = 0; i < iSoundCount; ++i)
+		{
+			const std::wstring sName = SoundName(i);
+			const size_t iIndex = oBank.find(sName);
+			if (iIndex != i || oBank.getName(iIndex) != sName) // names are sorted like indices
+			{
+				printf("  Lookup of sound %zu failed\n", i);
+				return false;
+			}
+
+			const rl::Sound* pSound = oBank.get(iIndex);
+			if (!pSound || pSound->ownsData() || !SameSound(*pSound, *oSources[i]) ||
+				(static_cast<const uint8_t*>(pSound->getDataPtr()) - oBankData.data()) % 64 != 0)
+			{
+				printf("  Sound %zu differs from the original or isn't aligned\n", i);
+				return false;
+			}
+		}
+
+		if (oBank.find(L"sfx/9999") != rl::SoundBank::npos || oBank.get(L"") != nullptr)
+		{
+			printf("  Found a sound that doesn't exist\n");
+			return false;
+		}
+
+		// copies of the sounds keep the bank's data alive
+		rl::Sound oCopy;
+		{
+			rl::SoundBank oCopiedBank;
+			oCopiedBank.loadFromMemory(oBankData.data(), oBankData.size(), true);
+			oCopy = *oCopiedBank.get(L"sfx/0001");
+		}
+		if (!SameSound(oCopy, *oSources[1]))
+		{
+			printf("  The copy of a sound is invalid after unloading the bank\n");
+			return false;
+		}
+
+		// corrupted data must be rejected
+		std::vector<uint8_t> oCorrupted = oBankData;
+		oCorrupted.resize(oCorrupted.size() / 2);
+		if (oBank.loadFromMemory(oCorrupted.data(), oCorrupted.size(), false) || oBank.size() != 0)
+		{
+			printf("  Truncated sound bank was loaded\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: LOADING TIME
+	{
+		printf("Test 2: Loading time of %zu sounds\n", iSoundCount);
+
+		std::vector<std::vector<uint8_t>> oRIFFs;
+		for (size_t i = 0; i < iSoundCount; ++i)
+		{
+			if (!oSources[i]->isCompressed())
+				oRIFFs.push_back(CreateRIFF(*oSources[i]));
+		}
+
+		auto tpStart = std::chrono::steady_clock::now();
+		{
+			std::vector<std::unique_ptr<rl::Sound>> oSounds;
+			for (const auto& oRIFF : oRIFFs)
+			{
+				oSounds.emplace_back(rl::Sound::FromMemory(oRIFF.data(), oRIFF.size()));
+				if (!oSounds.back())
+				{
+					printf("  Couldn't load RIFF data\n");
+					return false;
+				}
+			}
+		}
+		printf("  Sound::FromMemory (%zu WAV images): %8.3f ms\n", oRIFFs.size(),
+			MillisecondsSince(tpStart));
+
+		rl::SoundBank oBank;
+		tpStart = std::chrono::steady_clock::now();
+		oBank.loadFromMemory(oBankData.data(), oBankData.size(), true);
+		printf("  SoundBank::loadFromMemory (copy):      %8.3f ms\n", MillisecondsSince(tpStart));
+
+		tpStart = std::chrono::steady_clock::now();
+		oBank.loadFromMemory(oBankData.data(), oBankData.size(), false);
+		printf("  SoundBank::loadFromMemory (reference): %8.3f ms\n", MillisecondsSince(tpStart));
+
+		if (!rl::SoundBank::Save(szBankPath, oBankContents))
+		{
+			printf("  Couldn't write the sound bank file\n");
+			return false;
+		}
+		tpStart = std::chrono::steady_clock::now();
+		if (!oBank.load(szBankPath) || oBank.size() != iSoundCount)
+		{
+			printf("  Couldn't load the sound bank file\n");
+			return false;
+		}
+		printf("  SoundBank::load (mapped file):         %8.3f ms\n", MillisecondsSince(tpStart));
+
+		if (!SameSound(*oBank.get(iSoundCount - 1), *oSources[iSoundCount - 1]))
+		{
+			printf("  The sound bank file differs from the original\n");
+			return false;
+		}
+
+		printf("\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,220 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/audio.spatializer.hpp>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+
+
+
+namespace
+{
+
+	constexpr size_t iMatrixSize = 8; // FL, FR, FC, LFE, BL, BR, SL, SR
+
+	struct ExpectedMatrix
+	{
+		float x, z, fRadius, fGain;
+		float fMatrix[iMatrixSize];
+	};
+
+	// 6 positions: one group of 4 and a padded remainder
+	constexpr ExpectedMatrix oExpectedMatrices[] =
+	{
+		{ 0.0f, 0.0f, 1.0f, 1.0f, { 0, 0, 1, 0, 0, 0, 0, 0 } }, // front center
+		{ -1.0f, 0.0f, 1.0f, 1.0f, { 1, 0, 0, 0, 0, 0, 0, 0 } }, // front left
+		{ 1.0f, 2.0f, 1.0f, 1.0f, { 0, 0, 0, 0, 0, 1, 0, 0 } }, // back right
+		{ -0.5f, 1.0f, 1.0f, 0.5f, { 0, 0, 0, 0, 0, 0, 0.25f, 0 } }, // side, half left
+		{ 0.5f, 0.5f, 2.0f, 1.0f, // between front and side, wide radius
+			{ 0.1875f, 0.5625f, 0.5625f, 0, 0.0625f, 0.1875f, 0.1875f, 0.5625f } },
+		{ 0.0f, 0.0f, 1.0f, 0.25f, { 0, 0, 0.25f, 0, 0, 0, 0, 0 } }, // attenuated
+	};
+
+	bool MatrixEquals(const float* pMatrix, const float* pExpected, float fTolerance = 1e-5f)
+	{
+		for (size_t i = 0; i < iMatrixSize; ++i)
+		{
+			if (std::fabs(pMatrix[i] - pExpected[i]) > fTolerance)
+				return false;
+		}
+		return true;
+	}
+
+}
+
+
+
+bool UnitTest_audio_spatializer()
+{
+	// TEST 1: MATRICES
+	{
+		printf("Test 1: Output matrices of known positions\n");
+
+		constexpr size_t iCount = std::size(oExpectedMatrices);
+		float fX[iCount], fZ[iCount], fRadius[iCount], fGain[iCount];
+		for (size_t i = 0; i < iCount; ++i)
+		{
+			fX[i] = oExpectedMatrices[i].x;
+			fZ[i] = oExpectedMatrices[i].z;
+			fRadius[i] = oExpectedMatrices[i].fRadius;
+			fGain[i] = oExpectedMatrices[i].fGain;
+		}
+
+		float fMatrices[iCount * iMatrixSize];
+		rl::AudioSpatializer::CalcMatrices(fX, fZ, fRadius, fGain, iCount, fMatrices);
+		for (size_t i = 0; i < iCount; ++i)
+		{
+			if (!MatrixEquals(fMatrices + i * iMatrixSize, oExpectedMatrices[i].fMatrix))
+			{
+				printf("  Wrong matrix for position %zu\n", i);
+				return false;
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// the emitters stay virtual, so no audio device is needed
+	rl::WaveFormat oFormat;
+	oFormat.iChannelCount = 1;
+	rl::Sound oSound(oFormat, oFormat.iSampleRate * 10);
+	auto fnCreateInstance = [&]()
+	{
+		return std::make_unique<rl::SoundInstance3D>(oSound, 1.0f, rl::Audio3DPos::Center, true);
+	};
+
+
+
+	// TEST 2: DISTANCE ATTENUATION
+	{
+		printf("Test 2: Distance attenuation\n");
+
+		auto upInstance = fnCreateInstance();
+		rl::AudioSpatializer oSpatializer;
+		oSpatializer.setVoiceLimit(0);
+		oSpatializer.setAttenuation({ 1.0f, 10.0f, 1.0f });
+
+		// gain = 1 / (1 + (4 - 1)) = 0.25, clamped at the maximum distance: 1 / (1 + 9) = 0.1
+		const float fNear[iMatrixSize] = { 0, 0, 0.25f, 0, 0, 0, 0, 0 };
+		const float fFar[iMatrixSize] = { 0, 0, 0.1f, 0, 0, 0, 0, 0 };
+		const auto id = oSpatializer.add(*upInstance, { 0.0f, 0.0f, 1.0f }, 4.0f);
+		oSpatializer.update(1.0f / 60);
+		const bool bNear = MatrixEquals(oSpatializer.getMatrix(id), fNear);
+		oSpatializer.setDistance(id, 1000.0f);
+		oSpatializer.update(10.0f); // long enough to reach the target
+		const bool bFar = MatrixEquals(oSpatializer.getMatrix(id), fFar);
+		oSpatializer.remove(id);
+
+		if (!bNear || !bFar || oSpatializer.getMatrix(id) != nullptr)
+		{
+			printf("  Wrong attenuation\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 3: SMOOTHING
+	{
+		printf("Test 3: Smoothing (independent of the update rate)\n");
+
+		auto fnMove = [&](float fSmoothing, size_t iUpdates, float fElapsedTime,
+			float(&fMatrix)[iMatrixSize])
+		{
+			auto upInstance = fnCreateInstance();
+			rl::AudioSpatializer oSpatializer;
+			oSpatializer.setVoiceLimit(0);
+			oSpatializer.setSmoothing(fSmoothing);
+
+			// new emitters start at the target matrix, later changes are smoothed
+			const auto id = oSpatializer.add(*upInstance, rl::Audio3DPos::Left);
+			oSpatializer.update(1.0f / 60);
+			oSpatializer.setPos(id, rl::Audio3DPos::Right);
+			for (size_t i = 0; i < iUpdates; ++i)
+			{
+				oSpatializer.update(fElapsedTime);
+			}
+			std::copy_n(oSpatializer.getMatrix(id), iMatrixSize, fMatrix);
+		};
+
+		float fLeft[iMatrixSize], fRight[iMatrixSize];
+		fnMove(1.0f, 0, 0.0f, fLeft);
+		fnMove(1.0f, 1, 0.0f, fRight); // no smoothing --> immediately at the target
+
+		// 1/60 s at the default smoothing: 35% of the way
+		float fExpected[iMatrixSize];
+		for (size_t i = 0; i < iMatrixSize; ++i)
+		{
+			fExpected[i] = fLeft[i] + (fRight[i] - fLeft[i]) * 0.35f;
+		}
+
+		float f60Hz[iMatrixSize], f240Hz[iMatrixSize], fNoTime[iMatrixSize];
+		fnMove(0.35f, 1, 1.0f / 60, f60Hz);
+		fnMove(0.35f, 4, 1.0f / 240, f240Hz);
+		fnMove(0.35f, 10, 0.0f, fNoTime);
+		if (MatrixEquals(fLeft, fRight) || !MatrixEquals(f60Hz, fExpected) ||
+			!MatrixEquals(f240Hz, fExpected) || !MatrixEquals(fNoTime, fLeft))
+		{
+			printf("  The smoothing depends on the update rate\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 4: REMOVING VIRTUALIZED EMITTERS
+	{
+		printf("Test 4: Removed emitters get their voice back\n");
+
+		auto& oEngine = rl::AudioEngine::GetInstance();
+		if (!oEngine && !oEngine.create())
+		{
+			printf("  Couldn't create the audio engine\n");
+			return false;
+		}
+
+		auto upRemoved = std::make_unique<rl::SoundInstance3D>(oSound, 1.0f,
+			rl::Audio3DPos::Center);
+		auto upCleared = std::make_unique<rl::SoundInstance3D>(oSound, 1.0f,
+			rl::Audio3DPos::Center);
+		auto upVirtual = fnCreateInstance(); // virtual from the start, stays virtual
+
+		rl::AudioSpatializer oSpatializer;
+		oSpatializer.setVoiceLimit(0);
+		const auto idRemoved = oSpatializer.add(*upRemoved, rl::Audio3DPos::Center);
+		oSpatializer.add(*upCleared, rl::Audio3DPos::Center);
+		const auto idVirtual = oSpatializer.add(*upVirtual, rl::Audio3DPos::Center);
+		oSpatializer.update(1.0f / 60);
+		const bool bVirtualized = upRemoved->isVirtual() && upCleared->isVirtual() &&
+			oSpatializer.getVirtualCount() == 3;
+
+		oSpatializer.remove(idRemoved);
+		oSpatializer.remove(idVirtual);
+		const bool bRemoved = !upRemoved->isVirtual() && upVirtual->isVirtual() &&
+			oSpatializer.getVirtualCount() == 1;
+
+		oSpatializer.clear();
+		const bool bCleared = !upCleared->isVirtual() && oSpatializer.getVirtualCount() == 0;
+
+		if (!bVirtualized || !bRemoved || !bCleared)
+		{
+			printf("  The voices weren't given back\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,318 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/graphics.fonts.bitmap.reader.hpp>
+
+// STL
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+
+namespace
+{
+
+	using namespace rl;
+
+	constexpr uint16_t iCharWidth = 8;
+	constexpr uint16_t iCharHeight = 16;
+	constexpr uint32_t iBytesPerColumn = iCharHeight / 8; // 1 bit per pixel
+	constexpr uint32_t iBytesPerChar = iCharWidth * iBytesPerColumn;
+
+	bool GetExpectedPixel(char32_t ch, uint16_t x, uint16_t y)
+	{
+		return (ch >> ((x + y) % 21)) & 1;
+	}
+
+	/// <summary>
+	/// Create the data of a rlFNT v2.0 font face (1 bit per pixel, without file overhead)
+	/// </summary>
+	std::vector<uint8_t> CreateFontData(const std::vector<char32_t>& oCodepoints)
+	{
+		const char szStrings[] = "Test\0Regular\0Public domain";
+
+		const uint32_t iCharCount = (uint32_t)oCodepoints.size();
+		const uint32_t iOffsetCharTable = sizeof(FontFaceHeader);
+		const uint32_t iOffsetData = iOffsetCharTable + iCharCount * sizeof(FontFaceCharInfo);
+		const uint32_t iOffsetStringTable = iOffsetData + iCharCount * iBytesPerChar;
+		std::vector<uint8_t> result(iOffsetStringTable + sizeof(szStrings));
+
+		FontFaceHeader hdr = {};
+		hdr.iDataSize = (uint32_t)result.size();
+		hdr.iCharCount = iCharCount;
+		hdr.iFallbackChar = oCodepoints[0];
+		hdr.iOffsetFontFamName = iOffsetStringTable;
+		hdr.iOffsetFontFaceName = iOffsetStringTable + 5;
+		hdr.iOffsetCopyright = iOffsetStringTable + 13;
+		hdr.iOffsetCharTable = iOffsetCharTable;
+		hdr.iBytesPerColumn = iBytesPerColumn;
+		hdr.iFormatExtra = iBytesPerColumn;
+		hdr.iGlobalCharWidth = iCharWidth;
+		hdr.iCharHeight = iCharHeight;
+		hdr.iWeight = 400;
+		hdr.iBitsPerPixel = 1;
+		hdr.iBinaryFormat = static_cast<uint8_t>(FontFaceBinaryFormat::BitPlanes);
+		memcpy(result.data(), &hdr, sizeof(hdr));
+		memcpy(result.data() + iOffsetStringTable, szStrings, sizeof(szStrings));
+
+		for (uint32_t i = 0; i < iCharCount; ++i)
+		{
+			FontFaceCharInfo info = {};
+			info.iCodepoint = oCodepoints[i];
+			info.iSize = iBytesPerChar;
+			info.iOffset = iOffsetData + i * iBytesPerChar;
+			info.iWidth = iCharWidth;
+			memcpy(result.data() + iOffsetCharTable + i * sizeof(FontFaceCharInfo), &info,
+				sizeof(info));
+
+			uint8_t* pChar = result.data() + info.iOffset;
+			for (uint16_t x = 0; x < iCharWidth; ++x)
+			{
+				for (uint16_t y = 0; y < iCharHeight; ++y)
+				{
+					if (GetExpectedPixel(oCodepoints[i], x, y))
+						pChar[x * iBytesPerColumn + y / 8] |= 0x80 >> (y % 8);
+				}
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<char32_t> CreateSmallFontCodepoints()
+	{
+		std::vector<char32_t> result;
+		for (char32_t ch = 0x20; ch < 0x7F; ++ch)
+		{
+			result.push_back(ch);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// The codepoints of a font face with about 76,000 characters, mostly CJK and Hangul
+	/// </summary>
+	std::vector<char32_t> CreateHugeFontCodepoints()
+	{
+		std::vector<char32_t> result;
+		auto fnAdd = [&](char32_t chFirst, char32_t chLast, char32_t iStep = 1)
+		{
+			for (char32_t ch = chFirst; ch <= chLast; ch += iStep)
+			{
+				result.push_back(ch);
+			}
+		};
+
+		fnAdd(0x0020, 0x007E); // ASCII
+		fnAdd(0x00A0, 0x024F); // Latin
+		fnAdd(0x0370, 0x04FF); // Greek, Cyrillic
+		fnAdd(0x2000, 0x2BFF, 11); // symbols (sparse, searched binary)
+		fnAdd(0x3000, 0x30FF); // CJK punctuation, kana
+		fnAdd(0x4E00, 0x9FFF); // CJK unified ideographs
+		fnAdd(0xAC00, 0xD7A3); // Hangul syllables
+		fnAdd(0x1F300, 0x1F64F, 3); // emoji (sparse)
+		fnAdd(0x20000, 0x2A6DF); // CJK unified ideographs extension B
+		return result;
+	}
+
+	// The lookup of the original implementation
+	const FontFaceCharInfo* FindCharLinear(const FontFace* face, uint32_t ch)
+	{
+		for (size_t i = 0; i < face->pHeader->iCharCount; i++)
+		{
+			const FontFaceCharInfo* pInfos = face->pInfos + i;
+			if (pInfos->iCodepoint < ch)
+				continue;
+			if (pInfos->iCodepoint == ch)
+				return pInfos;
+			return nullptr;
+		}
+		return nullptr;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+}
+
+
+
+bool UnitTest_graphics_fonts_bitmap_reader()
+{
+	const std::vector<char32_t> oSmallCodepoints = CreateSmallFontCodepoints();
+	const std::vector<char32_t> oHugeCodepoints = CreateHugeFontCodepoints();
+	uint8_t iTypeVer[2] = { 2, 0 };
+
+	FontFaceClass oSmallFont;
+	FontFaceClass oHugeFont;
+	{
+		const auto oSmallData = CreateFontData(oSmallCodepoints);
+		const auto oHugeData = CreateFontData(oHugeCodepoints);
+		if (!oSmallFont.loadFromData(oSmallData.data(), oSmallData.size(), iTypeVer) ||
+			!oHugeFont.loadFromData(oHugeData.data(), oHugeData.size(), iTypeVer))
+		{
+			printf("Couldn't load the font faces\n");
+			return false;
+		}
+	}
+
+
+
+	// TEST 1: LOOKUP
+	{
+		printf("Test 1: Character lookup\n");
+
+		// a truncated character table must be rejected
+		{
+			const auto oData = CreateFontData(oSmallCodepoints);
+			FontFaceClass oTruncated;
+			if (oTruncated.loadFromData(oData.data(), sizeof(FontFaceHeader) + 10, iTypeVer))
+			{
+				printf("  A truncated character table was accepted\n");
+				return false;
+			}
+		}
+
+		const FontFaceClass oCopy = oHugeFont; // the index must be copied too
+		const std::pair<const FontFaceClass*, const std::vector<char32_t>*> oFonts[] =
+		{
+			{ &oSmallFont, &oSmallCodepoints },
+			{ &oHugeFont, &oHugeCodepoints },
+			{ &oCopy, &oHugeCodepoints }
+		};
+		for (const auto& [pFont, pCodepoints] : oFonts)
+		{
+			// check every codepoint up to the end of the last populated block
+			size_t iExpected = 0;
+			for (char32_t ch = 0; ch < 0x2B000; ++ch)
+			{
+				if (iExpected < pCodepoints->size() && (*pCodepoints)[iExpected] < ch)
+					++iExpected;
+				const FontFaceCharInfo* pExpected = nullptr;
+				if (iExpected < pCodepoints->size() && (*pCodepoints)[iExpected] == ch)
+					pExpected = pFont->begin() + iExpected;
+
+				if (pFont->findChar(ch) != pExpected)
+				{
+					printf("  Wrong result for U+%04X\n", (unsigned)ch);
+					return false;
+				}
+			}
+			if (pFont->findChar(0xFFFFFFFF) != nullptr)
+			{
+				printf("  Wrong result for an invalid codepoint\n");
+				return false;
+			}
+
+			// the pixel data of the found characters
+			for (const auto& info : *pFont)
+			{
+				for (uint16_t x = 0; x < iCharWidth; ++x)
+				{
+					for (uint16_t y = 0; y < iCharHeight; ++y)
+					{
+						if (pFont->getPixel(info.iCodepoint, x, y) !=
+							(uint32_t)GetExpectedPixel(info.iCodepoint, x, y))
+						{
+							printf("  Wrong pixel data for U+%04X\n", (unsigned)info.iCodepoint);
+							return false;
+						}
+					}
+				}
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: SPEED
+	{
+		printf("Test 2: Speed (ns per lookup, text of random characters of the font)\n");
+
+		constexpr size_t iLookups = 1 << 20;
+		constexpr size_t iLinearLookups = 1 << 12; // the linear search is too slow for more
+
+		auto fnBenchmark = [&](const char* szFontName, const FontFaceClass& oFont,
+			const std::vector<char32_t>& oCodepoints)
+		{
+			std::mt19937 oRNG(50);
+			std::vector<char32_t> oText(iLookups);
+			for (auto& ch : oText)
+			{
+				ch = oCodepoints[oRNG() % oCodepoints.size()];
+			}
+
+			// the same font face without the index
+			FontFace oUnindexed = *oFont.getData();
+			oUnindexed.pIndex = nullptr;
+
+			size_t iFound[3] = {};
+			auto tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iLinearLookups; ++i)
+			{
+				iFound[0] += FindCharLinear(oFont.getData(), oText[i]) != nullptr;
+			}
+			const double dLinear = MillisecondsSince(tpStart) * 1e6 / iLinearLookups;
+
+			tpStart = std::chrono::steady_clock::now();
+			for (char32_t ch : oText)
+			{
+				iFound[1] += FontFaceFindChar(&oUnindexed, ch) != nullptr;
+			}
+			const double dBinary = MillisecondsSince(tpStart) * 1e6 / iLookups;
+
+			tpStart = std::chrono::steady_clock::now();
+			for (char32_t ch : oText)
+			{
+				iFound[2] += oFont.findChar(ch) != nullptr;
+			}
+			const double dIndexed = MillisecondsSince(tpStart) * 1e6 / iLookups;
+
+			printf("  %-20s linear %9.1f  binary %6.1f  indexed %6.1f\n", szFontName,
+				dLinear, dBinary, dIndexed);
+			return iFound[0] == iLinearLookups && iFound[1] == iLookups && iFound[2] == iLookups;
+		};
+
+		char szName[32];
+		snprintf(szName, sizeof(szName), "%zu characters", oSmallCodepoints.size());
+		const bool bSmall = fnBenchmark(szName, oSmallFont, oSmallCodepoints);
+		snprintf(szName, sizeof(szName), "%zu characters", oHugeCodepoints.size());
+		const bool bHuge = fnBenchmark(szName, oHugeFont, oHugeCodepoints);
+		if (!bSmall || !bHuge)
+		{
+			printf("  Not all characters were found\n");
+			return false;
+		}
+
+		// rendering: every pixel is looked up separately
+		constexpr size_t iRenderedChars = 4096;
+		uint32_t iPixels = 0;
+		const auto tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRenderedChars; ++i)
+		{
+			const char32_t ch = oHugeCodepoints[(i * 7919) % oHugeCodepoints.size()];
+			for (uint16_t x = 0; x < iCharWidth; ++x)
+			{
+				for (uint16_t y = 0; y < iCharHeight; ++y)
+				{
+					iPixels += oHugeFont.getPixel(ch, x, y);
+				}
+			}
+		}
+		const double dMilliseconds = MillisecondsSince(tpStart);
+		printf("  getPixel (huge font)     %.1f million pixels/s (%u set)\n\n",
+			iRenderedChars * iCharWidth * iCharHeight / (dMilliseconds / 1000.0) / 1e6,
+			(unsigned)iPixels);
+	}
+
+	return true;
+}
@@ -0,0 +1,252 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/text.codepages.hpp>
+
+// Win32
+#include <Windows.h>
+
+// STL
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+
+
+namespace
+{
+
+	using rl::CodepageTable;
+	using rl::Unicode::TranscodeStatus;
+
+	struct ExpectedChar
+	{
+		uint16_t iCodepage;
+		bool bGlyphs;
+		uint8_t iByte;
+		char16_t ch;
+	};
+
+	constexpr ExpectedChar oExpectedChars[] =
+	{
+		{ 1252, false, 0x41, u'A' },
+		{ 1252, false, 0x80, u'\u20AC' }, // euro sign
+		{ 1252, false, 0x9F, u'\u0178' },
+		{ 1252, false, 0xE4, u'\u00E4' },
+		{ 1251, false, 0xC0, u'\u0410' }, // Cyrillic A
+		{ 866, false, 0x80, u'\u0410' },
+		{ 437, false, 0x01, u'\x01' },
+		{ 437, false, 0xB0, u'\u2591' },
+		{ 437, true, 0x01, u'\u263A' }, // DOS glyphs
+		{ 437, true, 0x7F, u'\u2302' },
+		{ 437, true, 0xB0, u'\u2591' },
+		{ 1252, true, 0x01, u'\x01' }, // no DOS codepage
+	};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+	/// <summary>
+	/// Random Windows-1251 text (Russian text with some ASCII)
+	/// </summary>
+	std::string CreateText(size_t iLength)
+	{
+		std::mt19937 oRNG(1251);
+		std::string result;
+		result.reserve(iLength);
+		while (result.length() < iLength)
+		{
+			const size_t iWordLength = 1 + oRNG() % 10;
+			const bool bCyrillic = oRNG() % 4 != 0;
+			for (size_t i = 0; i < iWordLength && result.length() < iLength; ++i)
+			{
+				result += bCyrillic ? char(0xC0 + oRNG() % 0x40) : char('a' + oRNG() % 26);
+			}
+			if (result.length() < iLength)
+				result += ' ';
+		}
+		return result;
+	}
+
+}
+
+
+
+bool UnitTest_text_codepages()
+{
+	// TEST 1: TABLES
+	{
+		printf("Test 1: Tables\n");
+
+		for (const auto& o : oExpectedChars)
+		{
+			const CodepageTable* pTable = CodepageTable::Get(o.iCodepage, o.bGlyphs);
+			if (!pTable)
+			{
+				printf("  Codepage %u isn't available\n", o.iCodepage);
+				return false;
+			}
+
+			uint8_t iByte = 0;
+			if (pTable->decode(o.iByte) != o.ch || !pTable->encode(o.ch, iByte) ||
+				iByte != o.iByte)
+			{
+				printf("  Codepage %u: byte 0x%02X isn't U+%04X\n", o.iCodepage, o.iByte,
+					(unsigned)o.ch);
+				return false;
+			}
+		}
+		if (CodepageTable::Get(1252) != CodepageTable::Get(1252))
+		{
+			printf("  The tables are created twice\n");
+			return false;
+		}
+		if (CodepageTable::Get(1) != nullptr)
+		{
+			printf("  Invalid codepage was accepted\n");
+			return false;
+		}
+
+		std::string sAllBytes(256, 0);
+		for (size_t i = 0; i < sAllBytes.length(); ++i)
+		{
+			sAllBytes[i] = (char)i;
+		}
+		for (uint16_t iCodepage : { 437, 850, 866, 932, 1251, 1252 })
+		{
+			const CodepageTable* pTable = CodepageTable::Get(iCodepage);
+			if (!pTable)
+				continue;
+
+			// the bulk conversion must be the same as the single characters
+			std::u16string sExpected;
+			for (size_t i = 0; i < 256; ++i)
+			{
+				if (pTable->decode((uint8_t)i) == CodepageTable::Undefined)
+					break;
+				sExpected += pTable->decode((uint8_t)i);
+			}
+
+			std::u16string s16(256, 0);
+			auto oResult = pTable->decode(sAllBytes.data(), sAllBytes.length(), s16.data(),
+				s16.length());
+			s16.resize(oResult.iWritten);
+			const bool bUndefined = sExpected.length() < 256;
+			if (s16 != sExpected || oResult.iRead != sExpected.length() ||
+				(oResult.eStatus == TranscodeStatus::InvalidInput) != bUndefined)
+			{
+				printf("  Codepage %u: wrong bulk decoding\n", iCodepage);
+				return false;
+			}
+
+			std::u32string s32(256, 0);
+			oResult = pTable->decode(sAllBytes.data(), s16.length(), s32.data(), s32.length());
+			if (oResult.eStatus != TranscodeStatus::OK ||
+				!std::equal(s16.begin(), s16.end(), s32.begin()))
+			{
+				printf("  Codepage %u: wrong bulk decoding to UTF-32\n", iCodepage);
+				return false;
+			}
+
+			// every character must be encoded to its byte (or the first one with the same value)
+			std::string sEncoded(s16.length(), 0);
+			oResult = pTable->encode(s16.data(), s16.length(), sEncoded.data(),
+				sEncoded.length());
+			for (size_t i = 0; i < sEncoded.length(); ++i)
+			{
+				if (oResult.eStatus != TranscodeStatus::OK ||
+					pTable->decode((uint8_t)sEncoded[i]) != s16[i] || (uint8_t)sEncoded[i] > i)
+				{
+					printf("  Codepage %u: wrong encoding of U+%04X\n", iCodepage,
+						(unsigned)s16[i]);
+					return false;
+				}
+			}
+		}
+
+		// characters that aren't part of the codepage
+		const std::u16string sUnknown = u"Text with \u4E00 (CJK)";
+		std::string sEncoded(sUnknown.length(), 0);
+		const auto oResult = CodepageTable::Get(1252)->encode(sUnknown.data(),
+			sUnknown.length(), sEncoded.data(), sEncoded.length());
+		if (oResult.eStatus != TranscodeStatus::InvalidInput || oResult.iRead != 10)
+		{
+			printf("  U+4E00 was encoded in Windows-1252\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: SPEED
+	{
+		constexpr size_t iLength = 16 * 1024 * 1024;
+		constexpr size_t iRepeat = 10;
+		printf("Test 2: Speed (%zu MB of Windows-1251 text, GB/s of input)\n",
+			iLength / 1024 / 1024);
+
+		auto fnPrint = [](const char* szName, double dMilliseconds)
+		{
+			printf("  %-30s %6.2f GB/s\n", szName, iLength * iRepeat / (dMilliseconds / 1000.0) /
+				1e9);
+		};
+
+		const CodepageTable* pTable = CodepageTable::Get(1251);
+		if (!pTable)
+		{
+			printf("  Codepage 1251 isn't available\n\n");
+			return true;
+		}
+		const std::string sText = CreateText(iLength);
+
+		std::vector<wchar_t> oOS(iLength);
+		auto tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			MultiByteToWideChar(1251, 0, sText.data(), (int)sText.length(), oOS.data(),
+				(int)oOS.size());
+		}
+		fnPrint("MultiByteToWideChar()", MillisecondsSince(tpStart));
+
+		std::u16string s16(iLength, 0);
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			pTable->decode(sText.data(), sText.length(), s16.data(), s16.length());
+		}
+		fnPrint("CodepageTable::decode()", MillisecondsSince(tpStart));
+
+		for (size_t i = 0; i < iLength; ++i)
+		{
+			if (s16[i] != (char16_t)oOS[i])
+			{
+				printf("  Different result at byte %zu\n", i);
+				return false;
+			}
+		}
+
+		std::string sEncoded(iLength, 0);
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			pTable->encode(s16.data(), s16.length(), sEncoded.data(), sEncoded.length());
+		}
+		fnPrint("CodepageTable::encode()", MillisecondsSince(tpStart));
+		if (sEncoded != sText)
+		{
+			printf("  The encoded text differs\n");
+			return false;
+		}
+
+		printf("\n");
+	}
+
+	return true;
+}
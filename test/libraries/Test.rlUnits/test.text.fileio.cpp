@@ -118,6 +118,8 @@ bool UnitTest_text_fileio()
 		rl::ReadAllLines(LR"(E:\[Temp]\test.txt)", oLines);
 		rl::WriteTextFile(LR"(E:\[TempDel]\output_ascii.txt)", oLines, rl::TextFileInfo_ASCII());
 		rl::WriteTextFile(LR"(E:\[TempDel]\output_codepage.txt)", oLines, rl::TextFileInfo_Codepage());
+		rl::WriteTextFile(LR"(E:\[TempDel]\output_cp866.txt)", oLines,
+			rl::TextFileInfo_Codepage(rl::LineBreak::OS, 866));
 		rl::WriteTextFile(LR"(E:\[TempDel]\output_utf8.txt)", oLines, rl::TextFileInfo_UTF8());
 		rl::WriteTextFile(LR"(E:\[TempDel]\output_utf8bom.txt)", oLines, rl::TextFileInfo_UTF8BOM());
 		rl::WriteTextFile(LR"(E:\[TempDel]\output_utf16le.txt)", oLines, rl::TextFileInfo_UTF16LE());
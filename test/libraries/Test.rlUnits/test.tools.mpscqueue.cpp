@@ -0,0 +1,141 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/tools.mpscqueue.hpp>
+
+// STL
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+
+namespace
+{
+
+	struct Element
+	{
+		uint32_t iProducer;
+		uint32_t iSequence;
+	};
+
+}
+
+
+
+bool UnitTest_tools_mpscqueue()
+{
+	// TEST 1: MULTIPLE PRODUCERS
+	{
+		constexpr uint32_t iProducerCount = 8;
+		constexpr uint32_t iElementsPerProducer = 250000;
+		printf("Test 1: %u producers, %u elements each, one concurrent consumer\n",
+			iProducerCount, iElementsPerProducer);
+
+		rl::MPSCQueue<Element> oQueue;
+		std::atomic<bool> bStart = false;
+
+		std::vector<std::thread> oProducers;
+		for (uint32_t iProducer = 0; iProducer < iProducerCount; ++iProducer)
+		{
+			oProducers.emplace_back([&, iProducer]()
+			{
+				while (!bStart.load(std::memory_order_acquire)) {}
+
+				for (uint32_t i = 0; i < iElementsPerProducer; ++i)
+				{
+					oQueue.push({ iProducer, i });
+				}
+			});
+		}
+
+		// the next expected sequence number of each producer
+		std::vector<uint32_t> oExpected(iProducerCount, 0);
+		size_t iReceived = 0;
+		bool bOrdered = true;
+
+		const auto tpStart = std::chrono::steady_clock::now();
+		bStart.store(true, std::memory_order_release);
+
+		Element e{};
+		while (iReceived < (size_t)iProducerCount * iElementsPerProducer && bOrdered)
+		{
+			if (!oQueue.pop(e))
+				continue;
+
+			// every element exactly once, in the order of its producer
+			if (e.iProducer >= iProducerCount || e.iSequence != oExpected[e.iProducer])
+				bOrdered = false;
+			else
+				++oExpected[e.iProducer];
+			++iReceived;
+		}
+		const double dSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - tpStart).count();
+
+		for (auto& trd : oProducers)
+		{
+			trd.join();
+		}
+
+		if (!bOrdered)
+		{
+			printf("  Element %u of producer %u arrived out of order or twice\n",
+				(unsigned)e.iSequence, (unsigned)e.iProducer);
+			return false;
+		}
+		if (!oQueue.empty() || oQueue.pop(e))
+		{
+			printf("  The queue contains more elements than were pushed\n");
+			return false;
+		}
+		for (uint32_t iProducer = 0; iProducer < iProducerCount; ++iProducer)
+		{
+			if (oExpected[iProducer] != iElementsPerProducer)
+			{
+				printf("  Elements of producer %u were lost\n", (unsigned)iProducer);
+				return false;
+			}
+		}
+
+		printf("  %.1f million elements/s\n", iReceived / dSeconds / 1e6);
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: DESTRUCTION
+	{
+		printf("Test 2: Remaining elements are destroyed with the queue\n");
+
+		auto pShared = std::make_shared<int>(0);
+		{
+			rl::MPSCQueue<std::shared_ptr<int>> oQueue;
+			for (int i = 0; i < 100; ++i)
+			{
+				oQueue.push(pShared);
+			}
+
+			std::shared_ptr<int> pPopped;
+			oQueue.pop(pPopped);
+			if (pPopped != pShared || pShared.use_count() != 101)
+			{
+				printf("  Wrong element count\n");
+				return false;
+			}
+		}
+		if (pShared.use_count() != 1)
+		{
+			printf("  %ld references weren't released\n", (long)pShared.use_count() - 1);
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,126 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/tools.publishedptr.hpp>
+
+// STL
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+
+
+namespace
+{
+
+	std::atomic<int> iLiveValues = 0;
+
+	/// <summary>
+	/// A value that detects being read after it was destroyed
+	/// </summary>
+	struct Value
+	{
+		static constexpr uint32_t Magic = 0x600DF00D;
+
+		uint32_t iMagic = Magic;
+		uint32_t iNumber;
+
+		Value(uint32_t iNumber) : iNumber(iNumber) { ++iLiveValues; }
+		~Value()
+		{
+			iMagic = 0;
+			--iLiveValues;
+		}
+	};
+
+}
+
+
+
+bool UnitTest_tools_publishedptr()
+{
+	// TEST 1: RETIREMENT
+	{
+		printf("Test 1: Replaced values are kept while they're read\n");
+
+		rl::PublishedPtr<Value> oPtr;
+		oPtr.publish(std::make_shared<Value>(1));
+		oPtr.publish(std::make_shared<Value>(2)); // not read --> released immediately
+		const bool bReleasedUnread = oPtr.getRetiredCount() == 0 && iLiveValues == 1;
+
+		bool bKept;
+		{
+			rl::PublishedPtr<Value>::ReadGuard oGuard(oPtr);
+			oPtr.publish(std::make_shared<Value>(3));
+			bKept = oPtr.getRetiredCount() == 1 && oGuard->iMagic == Value::Magic &&
+				oGuard->iNumber == 2;
+		}
+		oPtr.releaseRetired();
+		const bool bReleased = oPtr.getRetiredCount() == 0 && iLiveValues == 1;
+
+		if (!bReleasedUnread || !bKept || !bReleased)
+		{
+			printf("  The replaced values weren't handled correctly\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: CONCURRENT READER
+	{
+		constexpr uint32_t iPublishCount = 100000;
+		printf("Test 2: %u values published while they're read\n", iPublishCount);
+
+		{
+			rl::PublishedPtr<Value> oPtr;
+			oPtr.publish(std::make_shared<Value>(0));
+			std::atomic<bool> bDone = false;
+			bool bValid = true;
+			size_t iReads = 0;
+
+			std::thread trdReader([&]()
+			{
+				uint32_t iLast = 0;
+				while (!bDone.load(std::memory_order_acquire))
+				{
+					rl::PublishedPtr<Value>::ReadGuard oGuard(oPtr);
+
+					// values are never destroyed while they're read, the order is kept
+					if (oGuard->iMagic != Value::Magic || oGuard->iNumber < iLast)
+						bValid = false;
+					iLast = oGuard->iNumber;
+					++iReads;
+				}
+			});
+
+			for (uint32_t i = 1; i <= iPublishCount; ++i)
+			{
+				oPtr.publish(std::make_shared<Value>(i));
+			}
+			bDone.store(true, std::memory_order_release);
+			trdReader.join();
+
+			oPtr.releaseRetired();
+			if (!bValid || oPtr.getRetiredCount() != 0 || iLiveValues != 1)
+			{
+				printf("  A value was read after it was released or wasn't released\n");
+				return false;
+			}
+			printf("  %zu reads\n", iReads);
+		}
+		if (iLiveValues != 0)
+		{
+			printf("  %d values weren't released\n", (int)iLiveValues);
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,614 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/unicode.hpp>
+
+// Win32
+#include <Windows.h>
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+
+namespace
+{
+
+	using namespace rl::Unicode;
+
+	// the properties are available at compile time
+	static_assert(GetGeneralCategory(U'A') == GeneralCategory::UppercaseLetter);
+	static_assert(ToLower(U'A') == U'a' && ToUpper(U'a') == U'A' && ToUpper(U'1') == U'1');
+	static_assert(GetCombiningClass(0x0301) == 230);
+	static_assert(GetDecomposition(0x00E9).eType == DecompositionType::Canonical);
+
+	struct ExpectedProperties
+	{
+		char32_t ch;
+		GeneralCategory eCategory;
+		uint8_t iCombiningClass;
+		BidiClass eBidiClass;
+		char32_t chUpper;
+		char32_t chLower;
+		char32_t chTitle;
+	};
+
+	constexpr ExpectedProperties oExpectedProperties[] =
+	{
+		{ 0x0041, GeneralCategory::UppercaseLetter, 0, BidiClass::LeftToRight,
+			0x0041, 0x0061, 0x0041 },
+		{ 0x0061, GeneralCategory::LowercaseLetter, 0, BidiClass::LeftToRight,
+			0x0041, 0x0061, 0x0041 },
+		{ 0x01C5, GeneralCategory::TitlecaseLetter, 0, BidiClass::LeftToRight,
+			0x01C4, 0x01C6, 0x01C5 },
+		{ 0x01C6, GeneralCategory::LowercaseLetter, 0, BidiClass::LeftToRight,
+			0x01C4, 0x01C6, 0x01C5 },
+		{ 0x03A3, GeneralCategory::UppercaseLetter, 0, BidiClass::LeftToRight,
+			0x03A3, 0x03C3, 0x03A3 },
+		{ 0x1E9E, GeneralCategory::UppercaseLetter, 0, BidiClass::LeftToRight,
+			0x1E9E, 0x00DF, 0x1E9E },
+		{ 0x0030, GeneralCategory::DecimalNumber, 0, BidiClass::EuropeanNumber,
+			0x0030, 0x0030, 0x0030 },
+		{ 0x0301, GeneralCategory::NonspacingMark, 230, BidiClass::NonspacingMark,
+			0x0301, 0x0301, 0x0301 },
+		{ 0x00A0, GeneralCategory::SpaceSeparator, 0, BidiClass::CommonSeparator,
+			0x00A0, 0x00A0, 0x00A0 },
+		{ 0x05D0, GeneralCategory::OtherLetter, 0, BidiClass::RightToLeft,
+			0x05D0, 0x05D0, 0x05D0 },
+		{ 0x0627, GeneralCategory::OtherLetter, 0, BidiClass::ArabicLetter,
+			0x0627, 0x0627, 0x0627 },
+		{ 0x4E01, GeneralCategory::OtherLetter, 0, BidiClass::LeftToRight, // inside a range
+			0x4E01, 0x4E01, 0x4E01 },
+		{ 0xAC01, GeneralCategory::OtherLetter, 0, BidiClass::LeftToRight,
+			0xAC01, 0xAC01, 0xAC01 },
+		{ 0xD800, GeneralCategory::Surrogate, 0, BidiClass::LeftToRight,
+			0xD800, 0xD800, 0xD800 },
+		{ 0xE000, GeneralCategory::PrivateUse, 0, BidiClass::LeftToRight,
+			0xE000, 0xE000, 0xE000 },
+		{ 0x0378, GeneralCategory::Unassigned, 0, BidiClass::LeftToRight, // unassigned
+			0x0378, 0x0378, 0x0378 },
+		{ 0x110000, GeneralCategory::Unassigned, 0, BidiClass::LeftToRight, // invalid
+			0x110000, 0x110000, 0x110000 },
+	};
+
+	struct ExpectedDecomposition
+	{
+		char32_t ch;
+		DecompositionType eType;
+		std::vector<char32_t> oMapping;
+	};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+	/// <summary>
+	/// A text in all three encoding forms
+	/// </summary>
+	struct EncodedText
+	{
+		std::u32string s32;
+		std::u16string s16;
+		std::string s8;
+
+		void append(char32_t ch)
+		{
+			s32 += ch;
+
+			if (ch < 0x10000)
+				s16 += (char16_t)ch;
+			else
+			{
+				s16 += char16_t(0xD800 | ((ch - 0x10000) >> 10));
+				s16 += char16_t(0xDC00 | (ch & 0x3FF));
+			}
+
+			if (ch < 0x80)
+				s8 += (char)ch;
+			else if (ch < 0x800)
+			{
+				s8 += char(0xC0 | (ch >> 6));
+				s8 += char(0x80 | (ch & 0x3F));
+			}
+			else if (ch < 0x10000)
+			{
+				s8 += char(0xE0 | (ch >> 12));
+				s8 += char(0x80 | ((ch >> 6) & 0x3F));
+				s8 += char(0x80 | (ch & 0x3F));
+			}
+			else
+			{
+				s8 += char(0xF0 | (ch >> 18));
+				s8 += char(0x80 | ((ch >> 12) & 0x3F));
+				s8 += char(0x80 | ((ch >> 6) & 0x3F));
+				s8 += char(0x80 | (ch & 0x3F));
+			}
+		}
+	};
+
+	/// <summary>
+	/// Random text with runs of ASCII, Latin/Greek/CJK and supplementary characters
+	/// </summary>
+	/// <param name="iSupplementaryPercent">= the share of supplementary runs</param>
+	EncodedText CreateText(size_t iLength, unsigned iSupplementaryPercent, uint32_t iSeed)
+	{
+		std::mt19937 oRNG(iSeed);
+		EncodedText result;
+		while (result.s32.length() < iLength)
+		{
+			const size_t iRunLength = 1 + oRNG() % 40;
+			const unsigned iKind = oRNG() % 100;
+			for (size_t i = 0; i < iRunLength && result.s32.length() < iLength; ++i)
+			{
+				if (iKind < iSupplementaryPercent)
+					result.append(char32_t(0x10000 + oRNG() % 0x100000));
+				else if (iKind < 50)
+					result.append(char32_t(0x20 + oRNG() % 0x5F));
+				else if (iKind < 75)
+					result.append(char32_t(0xA0 + oRNG() % 0x330));
+				else
+					result.append(char32_t(0x4E00 + oRNG() % 0x5000));
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// The implementation of <c>rl::UTF16::DecodeString</c> before the vectorized transcoders
+	/// (two passes over the input, zero-initialized result)
+	/// </summary>
+	std::shared_ptr<char32_t[]> PreviousDecodeString(const char16_t* sz, size_t* len)
+	{
+		size_t idx = 0;
+		size_t dif = 0;
+		while (sz[idx] != 0)
+		{
+			if (rl::UTF16::IsHighSurrogate(sz[idx]))
+			{
+				++idx;
+				if (!rl::UTF16::IsLowSurrogate(sz[idx]))
+					return nullptr;
+				++dif;
+			}
+			++idx;
+		}
+		const size_t lenVal = idx - dif;
+		*len = lenVal;
+
+		auto result = std::make_shared<char32_t[]>(lenVal + 1);
+		memset(result.get(), 0, sizeof(char32_t) * (lenVal + 1));
+
+		idx = 0;
+		dif = 0;
+		while (sz[idx] != 0)
+		{
+			if (rl::UTF16::IsHighSurrogate(sz[idx]))
+			{
+				++dif;
+				const auto cHi = sz[idx];
+				++idx;
+				result[idx - dif] = rl::UTF16::Decode(cHi, sz[idx]);
+			}
+			else
+				result[idx - dif] = sz[idx];
+			++idx;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Check the conversion of a complete string
+	/// </summary>
+	template <typename TSrc, typename TDest, typename TFn>
+	bool CheckTranscode(const char* szName, const std::basic_string<TSrc>& sSrc,
+		const std::basic_string<TDest>& sExpected, TFn fnTranscode)
+	{
+		std::basic_string<TDest> sResult(sSrc.length() * 4, TDest(0));
+		const auto oResult = fnTranscode(sSrc.data(), sSrc.length(), sResult.data(),
+			sResult.length());
+		sResult.resize(oResult.iWritten);
+		if (oResult.eStatus != TranscodeStatus::OK || oResult.iRead != sSrc.length() ||
+			sResult != sExpected)
+		{
+			printf("  %s: wrong result\n", szName);
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Check that a conversion fails at the expected position
+	/// </summary>
+	template <typename TSrc, typename TDest>
+	bool CheckInvalid(const char* szName, const std::basic_string<TSrc>& sSrc, size_t iPos,
+		TranscodeResult(*fnTranscode)(const TSrc*, size_t, TDest*, size_t) noexcept)
+	{
+		std::vector<TDest> oBuffer(sSrc.length() * 4);
+		const auto oResult = fnTranscode(sSrc.data(), sSrc.length(), oBuffer.data(),
+			oBuffer.size());
+		if (oResult.eStatus != TranscodeStatus::InvalidInput || oResult.iRead != iPos)
+		{
+			printf("  %s: invalid input at %zu wasn't reported\n", szName, iPos);
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Reference implementation of the classification of whole strings
+	/// </summary>
+	/// <param name="pIndex16">= receives the index in the UTF-16 form of the string</param>
+	size_t FindFirstScalar(const std::u32string& s, bool(*fnIs)(char32_t) noexcept,
+		size_t* pIndex16 = nullptr)
+	{
+		size_t iIndex16 = 0;
+		size_t i = 0;
+		for (; i < s.length(); ++i)
+		{
+			if (fnIs(s[i]))
+				break;
+			iIndex16 += (s[i] < 0x10000) ? 1 : 2;
+		}
+		if (pIndex16)
+			*pIndex16 = iIndex16;
+		return i;
+	}
+
+}
+
+
+
+bool UnitTest_unicode()
+{
+	// TEST 1: PROPERTIES
+	{
+		printf("Test 1: Properties\n");
+
+		for (const auto& o : oExpectedProperties)
+		{
+			if (GetGeneralCategory(o.ch) != o.eCategory ||
+				GetCombiningClass(o.ch) != o.iCombiningClass ||
+				GetBidiClass(o.ch) != o.eBidiClass ||
+				ToUpper(o.ch) != o.chUpper || ToLower(o.ch) != o.chLower ||
+				ToTitle(o.ch) != o.chTitle)
+			{
+				printf("  Wrong properties for U+%04X\n", (unsigned)o.ch);
+				return false;
+			}
+		}
+
+		const ExpectedDecomposition oExpectedDecompositions[] =
+		{
+			{ 0x00E9, DecompositionType::Canonical, { 0x0065, 0x0301 } },
+			{ 0x00A0, DecompositionType::NoBreak, { 0x0020 } },
+			{ 0x00BD, DecompositionType::Fraction, { 0x0031, 0x2044, 0x0032 } },
+			{ 0xFB01, DecompositionType::Compat, { 0x0066, 0x0069 } },
+			{ 0x0041, DecompositionType::None, {} },
+			{ 0xAC00, DecompositionType::None, {} }, // algorithmic
+		};
+		for (const auto& o : oExpectedDecompositions)
+		{
+			const auto oDecomposition = GetDecomposition(o.ch);
+			if (oDecomposition.eType != o.eType || oDecomposition.iLength != o.oMapping.size() ||
+				!std::equal(o.oMapping.begin(), o.oMapping.end(), oDecomposition.pMapping))
+			{
+				printf("  Wrong decomposition for U+%04X\n", (unsigned)o.ch);
+				return false;
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: SPEED COMPARED TO THE OS
+	{
+		constexpr size_t iLength = 1000000;
+		printf("Test 2: Speed (%zu characters)\n", iLength);
+
+		std::mt19937 oRNG(42);
+		std::uniform_int_distribution<int> oBlock(0, 3);
+		std::vector<wchar_t> oText(iLength);
+		for (auto& c : oText)
+		{
+			switch (oBlock(oRNG))
+			{
+			case 0: c = wchar_t(0x20 + oRNG() % 0x5F); break; // ASCII
+			case 1: c = wchar_t(0xC0 + oRNG() % 0x180); break; // Latin
+			case 2: c = wchar_t(0x391 + oRNG() % 0x70); break; // Greek
+			default: c = wchar_t(0x4E00 + oRNG() % 0x5000); break; // CJK
+			}
+		}
+
+		// classification
+		std::vector<WORD> oTypes(iLength);
+		auto tpStart = std::chrono::steady_clock::now();
+		GetStringTypeW(CT_CTYPE1, oText.data(), (int)iLength, oTypes.data());
+		printf("  GetStringTypeW(CT_CTYPE1): %8.3f ms\n", MillisecondsSince(tpStart));
+
+		std::vector<GeneralCategory> oCategories(iLength);
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iLength; ++i)
+		{
+			oCategories[i] = GetGeneralCategory(oText[i]);
+		}
+		printf("  GetGeneralCategory():      %8.3f ms\n", MillisecondsSince(tpStart));
+
+		// case mapping
+		std::vector<wchar_t> oUpperOS = oText;
+		tpStart = std::chrono::steady_clock::now();
+		CharUpperBuffW(oUpperOS.data(), (DWORD)iLength);
+		printf("  CharUpperBuffW():          %8.3f ms\n", MillisecondsSince(tpStart));
+
+		std::vector<wchar_t> oUpper = oText;
+		tpStart = std::chrono::steady_clock::now();
+		for (auto& c : oUpper)
+		{
+			c = (wchar_t)ToUpper(c);
+		}
+		printf("  ToUpper():                 %8.3f ms\n", MillisecondsSince(tpStart));
+
+		printf("\n");
+	}
+
+
+
+	// TEST 3: TRANSCODING
+	{
+		printf("Test 3: Transcoding\n");
+
+		for (unsigned iSupplementaryPercent : { 0u, 10u })
+		{
+			const auto o = CreateText(100003, iSupplementaryPercent, iSupplementaryPercent);
+			if (!CheckTranscode("UTF-16 -> UTF-32", o.s16, o.s32, rl::UTF16::ToUTF32) ||
+				!CheckTranscode("UTF-16 -> UTF-8", o.s16, o.s8, rl::UTF16::ToUTF8) ||
+				!CheckTranscode("UTF-8 -> UTF-16", o.s8, o.s16, rl::UTF8::ToUTF16) ||
+				!CheckTranscode("UTF-8 -> UTF-32", o.s8, o.s32, rl::UTF8::ToUTF32) ||
+				!CheckTranscode("UTF-32 -> UTF-8", o.s32, o.s8, rl::UTF32::ToUTF8) ||
+				!CheckTranscode("UTF-32 -> UTF-16", o.s32, o.s16, rl::UTF32::ToUTF16))
+				return false;
+
+			size_t iLen = 0;
+			const auto sp = rl::UTF16::DecodeString(o.s16.c_str(), &iLen);
+			if (std::u32string(sp.get(), iLen) != o.s32 || sp[iLen] != 0)
+			{
+				printf("  UTF16::DecodeString(): wrong result\n");
+				return false;
+			}
+		}
+
+		// invalid input, also inside of blocks that would otherwise be vectorized
+		const std::u16string s16(40, u'a');
+		const std::string s8(40, 'a');
+		const std::u32string s32(40, U'a');
+		if (!CheckInvalid("lone high surrogate", s16 + u'\xD800' + s16, 40,
+				rl::UTF16::ToUTF32) ||
+			!CheckInvalid("lone low surrogate", s16 + u'\xDC00' + u"\xD800\xDC00", 40,
+				rl::UTF16::ToUTF8) ||
+			!CheckInvalid("high surrogate at the end", s16 + u'\xD800', 40,
+				rl::UTF16::ToUTF32) ||
+			!CheckInvalid("overlong UTF-8", s8 + "\xC0\xAF" + s8, 40, rl::UTF8::ToUTF32) ||
+			!CheckInvalid("overlong UTF-8 (3 bytes)", s8 + "\xE0\x80\xAF", 40,
+				rl::UTF8::ToUTF16) ||
+			!CheckInvalid("UTF-8 surrogate", s8 + "\xED\xA0\x80" + s8, 40,
+				rl::UTF8::ToUTF32) ||
+			!CheckInvalid("UTF-8 above U+10FFFF", s8 + "\xF4\x90\x80\x80", 40,
+				rl::UTF8::ToUTF16) ||
+			!CheckInvalid("truncated UTF-8", s8 + "\xE2\x82", 40, rl::UTF8::ToUTF32) ||
+			!CheckInvalid("UTF-8 continuation byte", s8 + "\x80" + s8, 40,
+				rl::UTF8::ToUTF16) ||
+			!CheckInvalid("UTF-32 surrogate", s32 + U'\xDFFF' + s32, 40, rl::UTF32::ToUTF16) ||
+			!CheckInvalid("UTF-32 above U+10FFFF", s32 + char32_t(0x110000) + s32, 40,
+				rl::UTF32::ToUTF8))
+			return false;
+
+		// buffer too small: the complete characters before are written
+		char szBuffer[5];
+		const char32_t szEuro[] = U"a\u20AC\u20AC";
+		const auto oResult = rl::UTF32::ToUTF8(szEuro, 3, szBuffer, sizeof(szBuffer));
+		if (oResult.eStatus != TranscodeStatus::BufferTooSmall || oResult.iRead != 2 ||
+			oResult.iWritten != 4)
+		{
+			printf("  The full buffer wasn't reported\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 4: TRANSCODING SPEED
+	{
+		constexpr size_t iLength = 4000000;
+		constexpr size_t iRepeat = 10;
+		printf("Test 4: Transcoding speed (%zu characters, GB/s of input)\n", iLength);
+
+		auto fnPrint = [](const char* szName, size_t iBytes, double dMilliseconds)
+		{
+			printf("    %-36s %6.2f GB/s\n", szName,
+				iBytes * iRepeat / (dMilliseconds / 1000.0) / 1e9);
+		};
+
+		for (unsigned iSupplementaryPercent : { 0u, 10u })
+		{
+			const auto o = CreateText(iLength, iSupplementaryPercent, 1);
+			printf("  %s:\n", iSupplementaryPercent ? "With supplementary characters" :
+				"BMP only");
+			const size_t iBytes16 = o.s16.length() * sizeof(char16_t);
+
+			size_t iLen = 0;
+			auto tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				PreviousDecodeString(o.s16.c_str(), &iLen);
+			}
+			fnPrint("UTF-16 -> UTF-32 (previous)", iBytes16, MillisecondsSince(tpStart));
+
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				rl::UTF16::DecodeString(o.s16.c_str(), &iLen);
+			}
+			fnPrint("UTF-16 -> UTF-32 (DecodeString)", iBytes16, MillisecondsSince(tpStart));
+
+			std::vector<char32_t> o32(o.s16.length());
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				rl::UTF16::ToUTF32(o.s16.data(), o.s16.length(), o32.data(), o32.size());
+			}
+			fnPrint("UTF-16 -> UTF-32 (ToUTF32)", iBytes16, MillisecondsSince(tpStart));
+
+			std::vector<char16_t> o16(o.s32.length() * 2);
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				rl::UTF32::ToUTF16(o.s32.data(), o.s32.length(), o16.data(), o16.size());
+			}
+			fnPrint("UTF-32 -> UTF-16", o.s32.length() * sizeof(char32_t),
+				MillisecondsSince(tpStart));
+
+			std::vector<char> o8(o.s16.length() * 3);
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				rl::UTF16::ToUTF8(o.s16.data(), o.s16.length(), o8.data(), o8.size());
+			}
+			fnPrint("UTF-16 -> UTF-8", iBytes16, MillisecondsSince(tpStart));
+
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				rl::UTF8::ToUTF16(o.s8.data(), o.s8.length(), o16.data(), o16.size());
+			}
+			fnPrint("UTF-8 -> UTF-16", o.s8.length(), MillisecondsSince(tpStart));
+		}
+
+		printf("\n");
+	}
+
+
+
+	// TEST 5: CLASSIFICATION OF WHOLE STRINGS
+	{
+		constexpr size_t iLength = 4000000;
+		constexpr size_t iRepeat = 10;
+		printf("Test 5: Classification of whole strings (%zu characters)\n", iLength);
+
+		struct CharClass
+		{
+			const char* szName;
+			bool(*fnIs)(char32_t) noexcept;
+			size_t(*fnFind32)(const char32_t*, size_t) noexcept;
+			size_t(*fnFind16)(const char16_t*, size_t) noexcept;
+			char32_t oSamples[4];
+		};
+		const CharClass oClasses[] =
+		{
+			{ "Noncharacters", IsNoncharacter, FindNoncharacter, FindNoncharacter,
+				{ 0xFDD0, 0xFFFF, 0x1FFFE, 0x10FFFF } },
+			{ "Private use", IsPrivateUse, FindPrivateUse, FindPrivateUse,
+				{ 0xE000, 0xF8FF, 0xF0000, 0x10FFFD } },
+		};
+
+		// unpaired surrogates are no characters at all
+		const std::u16string sUnpaired = { 0xDBFF, u'A', 0xDFFF, 0xDBBF };
+
+		const auto oClean = CreateText(200, 0, 3); // BMP only --> no matches
+		const auto oRandom = CreateText(100000, 10, 4);
+		const auto oSpeed = CreateText(iLength, 0, 5);
+		for (const auto& oClass : oClasses)
+		{
+			printf("  %s:\n", oClass.szName);
+
+			if (oClass.fnFind32(oClean.s32.data(), oClean.s32.length()) != oClean.s32.length() ||
+				oClass.fnFind16(oClean.s16.data(), oClean.s16.length()) != oClean.s16.length() ||
+				oClass.fnFind16(sUnpaired.data(), sUnpaired.length()) != sUnpaired.length())
+			{
+				printf("    False positive\n");
+				return false;
+			}
+
+			// every position in (and across the borders of) the vectorized blocks
+			for (char32_t ch : oClass.oSamples)
+			{
+				for (size_t iPos = 0; iPos < oClean.s32.length(); ++iPos)
+				{
+					EncodedText o;
+					for (size_t i = 0; i < oClean.s32.length(); ++i)
+					{
+						o.append((i == iPos) ? ch : oClean.s32[i]);
+					}
+
+					size_t iExpected16 = 0;
+					const size_t iExpected32 = FindFirstScalar(o.s32, oClass.fnIs, &iExpected16);
+					if (iExpected32 != iPos ||
+						oClass.fnFind32(o.s32.data(), o.s32.length()) != iExpected32 ||
+						oClass.fnFind16(o.s16.data(), o.s16.length()) != iExpected16)
+					{
+						printf("    U+%04X wasn't found at index %zu\n", (unsigned)ch, iPos);
+						return false;
+					}
+				}
+			}
+
+			size_t iExpected16 = 0;
+			const size_t iExpected32 = FindFirstScalar(oRandom.s32, oClass.fnIs, &iExpected16);
+			if (oClass.fnFind32(oRandom.s32.data(), oRandom.s32.length()) != iExpected32 ||
+				oClass.fnFind16(oRandom.s16.data(), oRandom.s16.length()) != iExpected16)
+			{
+				printf("    Wrong result for random text\n");
+				return false;
+			}
+
+			// speed
+			auto fnPrint = [](const char* szName, double dMilliseconds)
+			{
+				printf("    %-20s %8.1f M code points/ms\n", szName,
+					iLength * iRepeat / dMilliseconds / 1e6);
+			};
+
+			size_t iResult = 0;
+			auto tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				iResult += FindFirstScalar(oSpeed.s32, oClass.fnIs);
+			}
+			fnPrint("Single code points", MillisecondsSince(tpStart));
+
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				iResult += oClass.fnFind32(oSpeed.s32.data(), oSpeed.s32.length());
+			}
+			fnPrint("UTF-32 string", MillisecondsSince(tpStart));
+
+			tpStart = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iRepeat; ++i)
+			{
+				iResult += oClass.fnFind16(oSpeed.s16.data(), oSpeed.s16.length());
+			}
+			fnPrint("UTF-16 string", MillisecondsSince(tpStart));
+
+			if (iResult != 3 * iRepeat * iLength)
+			{
+				printf("    Wrong result\n");
+				return false;
+			}
+		}
+
+		printf("\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,227 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/unicode.normalization.hpp>
+
+// STL
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+
+
+
+namespace
+{
+
+	using namespace rl::Unicode;
+
+	// the quick check properties are available at compile time
+	static_assert(GetNFCQuickCheck(U'A') == QuickCheckResult::Yes);
+	static_assert(GetNFCQuickCheck(0x0301) == QuickCheckResult::Maybe);
+	static_assert(GetNFDQuickCheck(0x00E9) == QuickCheckResult::No);
+
+	struct ExpectedNormalization
+	{
+		const char32_t* sz;
+		const char32_t* szNFC;
+		const char32_t* szNFD;
+	};
+
+	constexpr ExpectedNormalization oExpectedNormalizations[] =
+	{
+		{ U"Text", U"Text", U"Text" },
+		{ U"e\u0301t\u00E9", U"\u00E9t\u00E9", U"e\u0301te\u0301" },
+		{ U"\u212B", U"\u00C5", U"A\u030A" }, // singleton decomposition
+		{ U"\u1E0B\u0323", U"\u1E0D\u0307", U"d\u0323\u0307" }, // canonical ordering
+		{ U"q\u0307\u0323", U"q\u0323\u0307", U"q\u0323\u0307" }, // no composite exists
+		{ U"\u0958", U"\u0915\u093C", U"\u0915\u093C" }, // composition exclusion
+		{ U"\u1100\u1161\u11A8", U"\uAC01", U"\u1100\u1161\u11A8" }, // Hangul L V T
+		{ U"\uAC00\u11A8", U"\uAC01", U"\u1100\u1161\u11A8" }, // Hangul LV T
+		{ U"a\u0308\u0301\u0304", U"\u00E4\u0301\u0304", U"a\u0308\u0301\u0304" }, // blocked
+		{ U"a\u0300\u05AEb", U"\u00E0\u05AEb", U"a\u05AE\u0300b" }, // not blocked
+		{ U"\U0001D15E", U"\U0001D157\U0001D165", U"\U0001D157\U0001D165" }, // outside BMP
+	};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+	std::u16string ToUTF16(const std::u32string& s)
+	{
+		std::u16string result(s.length() * 2, 0);
+		const auto oResult = rl::UTF32::ToUTF16(s.data(), s.length(), result.data(),
+			result.length());
+		result.resize(oResult.iWritten);
+		return result;
+	}
+
+	/// <summary>
+	/// Random NFC text, mostly Latin and other scripts without decompositions
+	/// </summary>
+	std::u32string CreateText(size_t iMinLength)
+	{
+		const std::u32string oWords[] =
+		{
+			U"The", U"quick", U"brown", U"fox,", U"jumps", U"over", U"the", U"lazy", U"dog.",
+			U"caf\u00E9", U"na\u00EFve", U"\u00FCber", U"Stra\u00DFe", U"\u00C5ngstr\u00F6m",
+			U"\u0431\u044B\u0441\u0442\u0440\u0430\u044F", U"\u4E00\u4E8C\u4E09\u3002",
+			U"\uD55C\uAD6D\uC5B4", U"\U0001F44B", U"\r\n"
+		};
+
+		std::mt19937 oRNG(15);
+		std::u32string result;
+		while (result.length() < iMinLength)
+		{
+			result += oWords[oRNG() % std::size(oWords)];
+			result += U' ';
+		}
+		return result;
+	}
+
+}
+
+
+
+bool UnitTest_unicode_normalization()
+{
+	// TEST 1: NORMALIZATION
+	{
+		printf("Test 1: Normalization\n");
+
+		for (const auto& o : oExpectedNormalizations)
+		{
+			const size_t iIndex = size_t(&o - oExpectedNormalizations);
+			for (const auto eForm : { NormalizationForm::NFC, NormalizationForm::NFD })
+			{
+				const std::u32string sExpected =
+					(eForm == NormalizationForm::NFC) ? o.szNFC : o.szNFD;
+
+				std::u32string s32 = o.sz;
+				Normalize(eForm, s32);
+				std::u16string s16 = ToUTF16(o.sz);
+				Normalize(eForm, s16);
+				if (s32 != sExpected || s16 != ToUTF16(sExpected))
+				{
+					printf("  Wrong %s of test string %zu\n",
+						(eForm == NormalizationForm::NFC) ? "NFC" : "NFD", iIndex);
+					return false;
+				}
+
+				const bool bNormalized = (sExpected == o.sz);
+				if (IsNormalized(eForm, o.sz, std::char_traits<char32_t>::length(o.sz)) !=
+					bNormalized ||
+					IsNormalized(eForm, sExpected.c_str(), sExpected.length()) != true ||
+					(!bNormalized &&
+						QuickCheck(eForm, o.sz, std::char_traits<char32_t>::length(o.sz)) ==
+						QuickCheckResult::Yes))
+				{
+					printf("  Wrong %s check of test string %zu\n",
+						(eForm == NormalizationForm::NFC) ? "NFC" : "NFD", iIndex);
+					return false;
+				}
+			}
+		}
+
+		// the quick check can't decide everything
+		const std::u32string sMaybeNo = U"a\u0300\u0301\u00E9";
+		const std::u32string sMaybeYes = U"\u00E0\u0301";
+		if (QuickCheck(NormalizationForm::NFC, sMaybeNo.c_str(), sMaybeNo.length()) !=
+			QuickCheckResult::Maybe ||
+			QuickCheck(NormalizationForm::NFC, sMaybeYes.c_str(), sMaybeYes.length()) !=
+			QuickCheckResult::Maybe ||
+			IsNormalized(NormalizationForm::NFC, sMaybeNo.c_str(), sMaybeNo.length()) ||
+			!IsNormalized(NormalizationForm::NFC, sMaybeYes.c_str(), sMaybeYes.length()))
+		{
+			printf("  Wrong result for a \"Maybe\" quick check\n");
+			return false;
+		}
+
+		// unpaired surrogates are kept
+		std::u16string sSurrogates = u"\xDC00" u"e\u0301\xD800";
+		if (!Normalize(NormalizationForm::NFC, sSurrogates) ||
+			sSurrogates != u"\xDC00\u00E9\xD800")
+		{
+			printf("  Unpaired surrogates were changed\n");
+			return false;
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: SPEED
+	{
+		constexpr size_t iLength = 4 * 1024 * 1024; // code points
+		constexpr size_t iRepeat = 5;
+		const std::u32string sNFC32 = CreateText(iLength);
+		const std::u16string sNFC16 = ToUTF16(sNFC32);
+		printf("Test 2: Speed (%.1f million code points, MB/s of the input)\n",
+			sNFC32.length() / 1e6);
+
+		auto fnPrint = [&](const char* szName, size_t iBytes, double dMilliseconds)
+		{
+			printf("  %-30s %8.1f MB/s\n", szName,
+				iBytes * iRepeat / (dMilliseconds / 1000.0) / 1e6);
+		};
+
+		// already normalized text: one scan, no memory allocation
+		bool bNormalized = true;
+		auto tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			bNormalized &= QuickCheck(NormalizationForm::NFC, sNFC16.c_str(),
+				sNFC16.length()) == QuickCheckResult::Yes;
+		}
+		fnPrint("NFC quick check (UTF-16)", sNFC16.length() * sizeof(char16_t),
+			MillisecondsSince(tpStart));
+
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			bNormalized &= QuickCheck(NormalizationForm::NFC, sNFC32.c_str(),
+				sNFC32.length()) == QuickCheckResult::Yes;
+		}
+		fnPrint("NFC quick check (UTF-32)", sNFC32.length() * sizeof(char32_t),
+			MillisecondsSince(tpStart));
+
+		if (!bNormalized)
+		{
+			printf("  The text wasn't recognized as NFC\n");
+			return false;
+		}
+
+		// decomposition and composition of the whole text
+		std::u16string sNFD16;
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			sNFD16 = sNFC16;
+			Normalize(NormalizationForm::NFD, sNFD16);
+		}
+		fnPrint("NFD (UTF-16)", sNFC16.length() * sizeof(char16_t), MillisecondsSince(tpStart));
+
+		std::u16string sRoundTrip;
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			sRoundTrip = sNFD16;
+			Normalize(NormalizationForm::NFC, sRoundTrip);
+		}
+		fnPrint("NFD to NFC (UTF-16)", sNFD16.length() * sizeof(char16_t),
+			MillisecondsSince(tpStart));
+
+		if (sRoundTrip != sNFC16)
+		{
+			printf("  NFC(NFD(text)) != text\n");
+			return false;
+		}
+		printf("\n");
+	}
+
+	return true;
+}
@@ -0,0 +1,284 @@
+#include "tests.hpp"
+
+// rl
+#include <rl/unicode.segmentation.hpp>
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+
+namespace
+{
+
+	using namespace rl::Unicode;
+
+	// the break properties are available at compile time
+	static_assert(GetLineBreakClass(U' ') == LineBreakClass::Space);
+	static_assert(GetGraphemeClusterBreak(0x0301) == GraphemeClusterBreak::Extend);
+	static_assert(IsExtendedPictographic(0x1F600) && !IsExtendedPictographic(U'A'));
+
+	struct ExpectedBreaks
+	{
+		const char32_t* sz;
+		const char* szExpected; // one character per code point: '|' = break before, '-' = none
+	};
+
+	constexpr ExpectedBreaks oExpectedGraphemes[] =
+	{
+		{ U"abc", "|||" },
+		{ U"e\u0301x", "|-|" }, // combining mark
+		{ U"\r\n\n\r", "|-||" },
+		{ U"\u1100\u1161\u11A8\uAC00\u11A8", "|--|-" }, // Hangul L V T, LV T
+		{ U"\U0001F469\u200D\U0001F467\U0001F3FD", "|---" }, // emoji ZWJ sequence + modifier
+		{ U"a\u200D\U0001F467", "|-|" }, // no emoji before the ZWJ
+		{ U"\U0001F1E9\U0001F1EA\U0001F1EB\U0001F1F7\U0001F1EE", "|-|-|" }, // regional indicators
+		{ U"\u0600a", "|-" }, // prepended concatenation mark
+		{ U"\u0E01\u0E33", "|-" }, // spacing mark
+	};
+
+	constexpr ExpectedBreaks oExpectedLineBreaks[] =
+	{
+		// '/' = break allowed, '!' = mandatory break
+		{ U"Hello world", "------/----" },
+		{ U"a\r\nb\nc", "---!-!" },
+		{ U"(a) [b]", "----/--" },
+		{ U"3.14 kg", "-----/-" },
+		{ U"well-known", "-----/----" },
+		{ U"\u05D0-\u05D1", "---" }, // Hebrew letter + hyphen (LB21a)
+		{ U"a\u00A0b x\u2060y", "----/--" }, // no-break space, word joiner
+		{ U"a\u200Bb", "--/" }, // zero width space
+		{ U"e\u0301 \u0301x", "---/-" }, // combining marks (LB9, LB10)
+		{ U"\u4E00\u4E8C\u3002\u4E09", "-/-/" }, // ideographs, ideographic full stop
+		{ U"\uAC00\uAC01 \uAC02", "-/-/" }, // Hangul syllables
+		{ U"\U0001F44B\U0001F3FD\U0001F44B", "--/" }, // emoji base + modifier
+		{ U"\U0001F1E9\U0001F1EA\U0001F1EB\U0001F1F7", "--/-" }, // regional indicators
+		{ U"a(b)\uFF08c", "----/-" }, // LB30: East Asian parentheses allow breaks
+	};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+	/// <summary>
+	/// Random text in UTF-8, mixing words of several scripts, combining marks and emoji
+	/// </summary>
+	std::string CreateMixedText(size_t iMinLength)
+	{
+		const std::u32string oWords[] =
+		{
+			U"The", U"quick", U"brown", U"fox,", U"(jumps)", U"over", U"3.14159", U"\"lazy\"",
+			U"\u0431\u044B\u0441\u0442\u0440\u0430\u044F", U"\u03B1\u03BB\u03B5\u03C0\u03BF\u03CD",
+			U"\u0645\u0631\u062D\u0628\u0627", U"\u05E9\u05DC\u05D5\u05DD",
+			U"\u0928\u092E\u0938\u094D\u0924\u0947", U"\u4E00\u4E8C\u4E09\u3002",
+			U"\u3053\u3093\u306B\u3061\u306F", U"\uD55C\uAD6D\uC5B4", U"e\u0301te\u0301",
+			U"\U0001F469\u200D\U0001F467", U"\U0001F44B\U0001F3FD", U"\U0001F1E9\U0001F1EA",
+			U"well-known", U"\r\n"
+		};
+
+		std::mt19937 oRNG(14);
+		std::u32string s;
+		while (s.length() < iMinLength)
+		{
+			s += oWords[oRNG() % std::size(oWords)];
+			s += U' ';
+		}
+
+		std::string result(s.length() * 4, 0);
+		const auto oResult = rl::UTF32::ToUTF8(s.data(), s.length(), result.data(),
+			result.length());
+		result.resize(oResult.iWritten);
+		return result;
+	}
+
+	/// <summary>
+	/// Process UTF-8 text in chunks, the way a large file would be processed
+	/// </summary>
+	/// <param name="fnProcess">
+	/// = the function to call for every decoded chunk (parameters: UTF-32 string, length)
+	/// </param>
+	/// <returns>Was the text valid?</returns>
+	template <typename TFn>
+	bool ProcessChunks(const std::string& sText, std::u32string& sBuffer, TFn&& fnProcess)
+	{
+		size_t iPos = 0;
+		while (iPos < sText.length())
+		{
+			// don't split characters
+			size_t iEnd = std::min(iPos + sBuffer.length(), sText.length());
+			while (iEnd < sText.length() && (sText[iEnd] & 0xC0) == 0x80)
+			{
+				--iEnd;
+			}
+
+			const auto oResult = rl::UTF8::ToUTF32(sText.data() + iPos, iEnd - iPos,
+				sBuffer.data(), sBuffer.length());
+			if (oResult.eStatus != TranscodeStatus::OK)
+				return false;
+			fnProcess(sBuffer.data(), oResult.iWritten);
+			iPos = iEnd;
+		}
+		return true;
+	}
+
+}
+
+
+
+bool UnitTest_unicode_segmentation()
+{
+	// TEST 1: GRAPHEME CLUSTERS
+	{
+		printf("Test 1: Grapheme clusters\n");
+
+		GraphemeBreaker oBreaker;
+		for (const auto& o : oExpectedGraphemes)
+		{
+			oBreaker.reset();
+			std::string sResult;
+			for (const char32_t* p = o.sz; *p; ++p)
+			{
+				sResult += oBreaker.next(*p) ? '|' : '-';
+			}
+			if (sResult != o.szExpected)
+			{
+				printf("  Wrong boundaries for test string %zu: \"%s\" instead of \"%s\"\n",
+					size_t(&o - oExpectedGraphemes), sResult.c_str(), o.szExpected);
+				return false;
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 2: LINE BREAKS
+	{
+		printf("Test 2: Line breaks\n");
+
+		LineBreaker oBreaker;
+		for (const auto& o : oExpectedLineBreaks)
+		{
+			oBreaker.reset();
+			std::string sResult;
+			for (const char32_t* p = o.sz; *p; ++p)
+			{
+				switch (oBreaker.next(*p))
+				{
+				case LineBreakOpportunity::Allowed:
+					sResult += '/';
+					break;
+				case LineBreakOpportunity::Mandatory:
+					sResult += '!';
+					break;
+				default:
+					sResult += '-';
+				}
+			}
+			if (sResult != o.szExpected)
+			{
+				printf("  Wrong break opportunities for test string %zu: \"%s\" instead of "
+					"\"%s\"\n", size_t(&o - oExpectedLineBreaks), sResult.c_str(), o.szExpected);
+				return false;
+			}
+		}
+
+		printf("  OK\n\n");
+	}
+
+
+
+	// TEST 3: SPEED
+	{
+		constexpr size_t iLength = 4 * 1024 * 1024; // code points
+		constexpr size_t iRepeat = 5;
+		const std::string sText = CreateMixedText(iLength);
+		printf("Test 3: Speed (%.1f MB of mixed-script UTF-8 text in chunks of 64 KB, "
+			"MB/s)\n", sText.length() / 1e6);
+
+		auto fnPrint = [&](const char* szName, double dMilliseconds)
+		{
+			printf("  %-30s %8.1f MB/s\n", szName,
+				sText.length() * iRepeat / (dMilliseconds / 1000.0) / 1e6);
+		};
+
+		// the breakers don't allocate memory, only the chunk buffers are needed
+		std::u32string sBuffer(64 * 1024, 0);
+		std::unique_ptr<bool[]> upGraphemes(new bool[sBuffer.length()]);
+		std::vector<LineBreakOpportunity> oLineBreaks(sBuffer.length());
+
+		size_t iClusters = 0;
+		auto tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			GraphemeBreaker oBreaker;
+			iClusters = 0;
+			ProcessChunks(sText, sBuffer, [&](const char32_t* p, size_t iLen)
+				{
+					oBreaker.next(p, iLen, upGraphemes.get());
+					for (size_t iChar = 0; iChar < iLen; ++iChar)
+					{
+						iClusters += upGraphemes[iChar];
+					}
+				});
+		}
+		fnPrint("GraphemeBreaker", MillisecondsSince(tpStart));
+
+		size_t iOpportunities = 0;
+		size_t iMandatory = 0;
+		tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			LineBreaker oBreaker;
+			iOpportunities = 0;
+			iMandatory = 0;
+			ProcessChunks(sText, sBuffer, [&](const char32_t* p, size_t iLen)
+				{
+					oBreaker.next(p, iLen, oLineBreaks.data());
+					for (size_t iChar = 0; iChar < iLen; ++iChar)
+					{
+						iOpportunities += oLineBreaks[iChar] != LineBreakOpportunity::None;
+						iMandatory += oLineBreaks[iChar] == LineBreakOpportunity::Mandatory;
+					}
+				});
+		}
+		fnPrint("LineBreaker", MillisecondsSince(tpStart));
+
+		// the chunks must not change the result
+		GraphemeBreaker oGraphemeBreaker;
+		LineBreaker oLineBreaker;
+		size_t iExpectedClusters = 0;
+		size_t iExpectedOpportunities = 0;
+		size_t iExpectedMandatory = 0;
+		const bool bValid = ProcessChunks(sText, sBuffer, [&](const char32_t* p, size_t iLen)
+			{
+				for (size_t iChar = 0; iChar < iLen; ++iChar)
+				{
+					iExpectedClusters += oGraphemeBreaker.next(p[iChar]);
+					const auto e = oLineBreaker.next(p[iChar]);
+					iExpectedOpportunities += e != LineBreakOpportunity::None;
+					iExpectedMandatory += e == LineBreakOpportunity::Mandatory;
+				}
+			});
+		if (!bValid || iClusters != iExpectedClusters ||
+			iOpportunities != iExpectedOpportunities || iMandatory != iExpectedMandatory)
+		{
+			printf("  Different results for the chunks\n");
+			return false;
+		}
+		printf("  %zu grapheme clusters, %zu line break opportunities (%zu mandatory)\n\n",
+			iClusters, iOpportunities, iMandatory);
+	}
+
+	return true;
+}
@@ -8,15 +8,29 @@
 
 bool UnitTest_global();
 
+bool UnitTest_audio_analysis();
+bool UnitTest_audio_codec();
+bool UnitTest_audio_effects();
 bool UnitTest_audio_engine();
+bool UnitTest_audio_mixer();
+bool UnitTest_audio_resampler();
+bool UnitTest_audio_soundbank();
+bool UnitTest_audio_spatializer();
 bool UnitTest_data_filecontainer();
 bool UnitTest_data_online();
 bool UnitTest_data_registry_settings();
+bool UnitTest_graphics_fonts_bitmap_reader();
 bool UnitTest_graphics_opengl_window();
 bool UnitTest_input_keyboard();
 bool UnitTest_runasadmin();
 bool UnitTest_splashscreen();
+bool UnitTest_text_codepages();
 bool UnitTest_text_fileio();
+bool UnitTest_tools_mpscqueue();
+bool UnitTest_tools_publishedptr();
+bool UnitTest_unicode();
+bool UnitTest_unicode_normalization();
+bool UnitTest_unicode_segmentation();
 
 
 
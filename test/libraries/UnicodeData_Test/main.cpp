@@ -1,16 +1,107 @@
 #include <rl/dll/UnicodeData.hpp>
+#include <chrono>
 #include <cstdio> // printf
+#include <string>
+#include <vector>
+
+using namespace rl::UnicodeDataDLL;
+
+namespace
+{
+
+	char ToUpper(char c) { return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c; }
+
+	bool MatchPattern(const char* szName, const char* szPattern)
+	{
+		if (*szPattern == 0)
+			return *szName == 0;
+		if (*szPattern == '*')
+			return MatchPattern(szName, szPattern + 1) ||
+				(*szName != 0 && MatchPattern(szName + 1, szPattern));
+		return ToUpper(*szName) == ToUpper(*szPattern) && MatchPattern(szName + 1, szPattern + 1);
+	}
+
+	/// <summary>
+	/// Reference implementation of <c>FindChars</c>: check the names of all code points
+	/// </summary>
+	std::vector<UChar_t> LinearSearch(const char* szPattern)
+	{
+		std::vector<UChar_t> oResult;
+		char szName[256];
+		for (UChar_t ch = 0; ch < 0x110000; ++ch)
+		{
+			const auto len = GetNameLen(ch);
+			if (len > 1 && GetName(ch, szName, len) && MatchPattern(szName, szPattern))
+				oResult.push_back(ch);
+		}
+		return oResult;
+	}
+
+	/// <summary>
+	/// Reference implementation of the Hangul syllable names (chapter 3.12 of the Unicode
+	/// standard)
+	/// </summary>
+	std::string HangulSyllableName(UChar_t ch)
+	{
+		const char* szL[] = { "G", "GG", "N", "D", "DD", "R", "M", "B", "BB", "S", "SS", "", "J",
+			"JJ", "C", "K", "T", "P", "H" };
+		const char* szV[] = { "A", "AE", "YA", "YAE", "EO", "E", "YEO", "YE", "O", "WA", "WAE",
+			"OE", "YO", "U", "WEO", "WE", "WI", "YU", "EU", "YI", "I" };
+		const char* szT[] = { "", "G", "GG", "GS", "N", "NJ", "NH", "D", "L", "LG", "LM", "LB",
+			"LS", "LT", "LP", "LH", "M", "B", "BS", "S", "SS", "NG", "J", "C", "K", "T", "P", "H" };
+
+		const UChar_t iIndex = ch - 0xAC00;
+		return std::string("HANGUL SYLLABLE ") + szL[iIndex / (21 * 28)] +
+			szV[iIndex % (21 * 28) / 28] + szT[iIndex % 28];
+	}
+
+	/// <summary>
+	/// The ranges with algorithmic names (as of Unicode 14.0; later versions only add to them)
+	/// </summary>
+	struct AlgorithmicRange
+	{
+		UChar_t chFirst;
+		UChar_t chLast;
+		const char* szPrefix; // nullptr = Hangul syllables
+	};
+	constexpr AlgorithmicRange oAlgorithmicRanges[] =
+	{
+		{ 0x3400, 0x4DBF, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0x4E00, 0x9FFF, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0xAC00, 0xD7A3, nullptr },
+		{ 0xF900, 0xFA6D, "CJK COMPATIBILITY IDEOGRAPH-" },
+		{ 0xFA70, 0xFAD9, "CJK COMPATIBILITY IDEOGRAPH-" },
+		{ 0x17000, 0x187F7, "TANGUT IDEOGRAPH-" },
+		{ 0x18B00, 0x18CD5, "KHITAN SMALL SCRIPT CHARACTER-" },
+		{ 0x18D00, 0x18D08, "TANGUT IDEOGRAPH-" },
+		{ 0x1B170, 0x1B2FB, "NUSHU CHARACTER-" },
+		{ 0x20000, 0x2A6DF, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0x2A700, 0x2B738, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0x2B740, 0x2B81D, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0x2B820, 0x2CEA1, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0x2CEB0, 0x2EBE0, "CJK UNIFIED IDEOGRAPH-" },
+		{ 0x2F800, 0x2FA1D, "CJK COMPATIBILITY IDEOGRAPH-" },
+		{ 0x30000, 0x3134A, "CJK UNIFIED IDEOGRAPH-" },
+	};
+
+	double MicrosecondsSince(std::chrono::steady_clock::time_point tpStart)
+	{
+		return std::chrono::duration<double, std::micro>(
+			std::chrono::steady_clock::now() - tpStart).count();
+	}
+
+}
 
 int main(int argc, char* argv[])
 {
-	rl::UnicodeDataDLL::UChar_t iVal = u'';
-	auto len = rl::UnicodeDataDLL::GetNameLen(iVal);
+	UChar_t iVal = u'�';
+	auto len = GetNameLen(iVal);
 	if (len == 0)
 		printf("Codepoint U+%04X has no name", iVal);
 	else
 	{
 		char* szName = new char[len];
-		auto written = rl::UnicodeDataDLL::GetName(iVal, szName, len);
+		auto written = GetName(iVal, szName, len);
 
 		printf("Codepoint U+%04X has the following name:\n\"%s\"", iVal, szName);
 
@@ -19,5 +110,131 @@ int main(int argc, char* argv[])
 
 	printf("\n\n");
 
+
+
+	// ALGORITHMIC NAMES
+
+	// every character of the ranges must have the expanded name
+	size_t iAlgorithmicCount = 0;
+	for (const auto& oRange : oAlgorithmicRanges)
+	{
+		for (UChar_t ch = oRange.chFirst; ch <= oRange.chLast; ++ch)
+		{
+			std::string sExpected;
+			if (oRange.szPrefix == nullptr)
+				sExpected = HangulSyllableName(ch);
+			else
+			{
+				char szCodePoint[16];
+				snprintf(szCodePoint, sizeof(szCodePoint), "%04X", ch);
+				sExpected = std::string(oRange.szPrefix) + szCodePoint;
+			}
+
+			char szName[256] = {};
+			len = GetNameLen(ch);
+			if (len != sExpected.length() + 1 || GetName(ch, szName, len) != sExpected.length() ||
+				sExpected != szName)
+			{
+				printf("U+%04X is named \"%s\" instead of \"%s\"\n", ch, szName,
+					sExpected.c_str());
+				return 1;
+			}
+			++iAlgorithmicCount;
+		}
+	}
+	printf("GetName: %zu algorithmic names OK\n", iAlgorithmicCount);
+
+	const char* szInvalidNames[] =
+	{
+		"CJK UNIFIED IDEOGRAPH-4DC0", // outside of the ranges
+		"CJK UNIFIED IDEOGRAPH-04E00", // leading zero
+		"CJK UNIFIED IDEOGRAPH-4E0", // too short
+		"CJK UNIFIED IDEOGRAPH-F900", // other prefix
+		"HANGUL SYLLABLE GAX",
+		"HANGUL SYLLABLE ",
+	};
+	for (const char* szInvalidName : szInvalidNames)
+	{
+		if (FindChar(szInvalidName) != InvalidChar)
+		{
+			printf("FindChar(\"%s\") found a character\n", szInvalidName);
+			return 1;
+		}
+	}
+	printf("\n");
+
+
+
+	// REVERSE LOOKUP
+
+	// every name must lead back to its character
+	char szName[256];
+	size_t iNameCount = 0;
+	for (UChar_t ch = 0; ch < 0x110000; ++ch)
+	{
+		len = GetNameLen(ch);
+		if (len == 0)
+			continue;
+
+		++iNameCount;
+		GetName(ch, szName, len);
+		const UChar_t chFound = FindChar(szName);
+		if (chFound != ch)
+		{
+			char szOtherName[256] = {};
+			GetName(chFound, szOtherName, sizeof(szOtherName));
+			if (chFound == InvalidChar || _stricmp(szName, szOtherName) != 0) // duplicate name?
+			{
+				printf("FindChar(\"%s\") returned U+%04X instead of U+%04X\n", szName, chFound, ch);
+				return 1;
+			}
+		}
+	}
+	printf("FindChar: %zu names OK\n\n", iNameCount);
+
+	const char* szQueries[] =
+	{
+		"LATIN SMALL LETTER A WITH ACUTE",
+		"latin small letter a with*",
+		"GREEK*LETTER*TONOS",
+		"*WITH ACUTE*",
+		"*CIRCLED*DIGIT*",
+		"*ARROW",
+		"*IDEOGRAPH-F9*",
+		"cjk unified ideograph-2a6d*",
+		"HANGUL SYLLABLE G*",
+		"*SYLLABLE*GAG*",
+		"*",
+	};
+
+	std::vector<UChar_t> oFound(0x110000);
+	printf("%-33s %8s %14s %14s\n", "Pattern", "Matches", "FindChars", "Linear scan");
+	for (const char* szPattern : szQueries)
+	{
+		constexpr size_t iRepeat = 100;
+		unsigned int iCount = 0;
+		auto tpStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iRepeat; ++i)
+		{
+			iCount = FindChars(szPattern, oFound.data(), (unsigned int)oFound.size());
+		}
+		const double dIndexTime = MicrosecondsSince(tpStart) / iRepeat;
+
+		tpStart = std::chrono::steady_clock::now();
+		const auto oExpected = LinearSearch(szPattern);
+		const double dLinearTime = MicrosecondsSince(tpStart);
+
+		oFound.resize(iCount);
+		if (oFound != oExpected)
+		{
+			printf("FindChars(\"%s\") returned a wrong result\n", szPattern);
+			return 1;
+		}
+		oFound.resize(0x110000);
+
+		printf("%-33s %8u %11.1f us %11.1f us\n", szPattern, iCount, dIndexTime, dLinearTime);
+	}
+	printf("\n");
+
 	return 0;
 }
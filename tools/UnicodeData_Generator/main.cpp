@@ -1,300 +1,1661 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <map>
 #include <stdint.h>
-#include <Windows.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 
 
 
 
-bool ReadStr(HANDLE hFile, char** dest);
-bool SkipVal(HANDLE hFile);
+/// <summary>
+/// The compressed names, in the format expected by the UnicodeData DLL
+/// </summary>
+struct NameTables
+{
+	uint8_t iBlockShift = 0; // code points per stage 2 block = 1 << iBlockShift
+	std::vector<uint16_t> oStage1; // code point >> iBlockShift --> block index
+	std::vector<uint16_t> oStage2; // blocks of name indices (0xFFFF = no name)
+	std::vector<char> oWordChars; // all distinct words, concatenated
+	std::vector<uint32_t> oWordOffsets; // word count + 1
+	std::vector<uint8_t> oTokens; // the words of all names
+	std::vector<uint32_t> oNameOffsets; // name count + 1, into oTokens
+	std::vector<uint8_t> oNameLengths; // without terminating zero
+
+	// search index (all sorted case-insensitively)
+	std::vector<uint32_t> oCodePoints; // name index --> code point
+	std::vector<uint16_t> oSortedNames; // name indices, sorted by name
+	std::vector<uint16_t> oSortedWords; // word IDs, sorted by word
+	std::vector<uint32_t> oPostingOffsets; // word count + 1, into oPostings
+	std::vector<uint16_t> oPostings; // per word: the names containing it (ascending)
+};
+
+/// <summary>
+/// The properties of a range of code points, as listed in UnicodeData.txt<para/>
+/// The strings reference the contents of the file.
+/// </summary>
+struct CharProperties
+{
+	uint32_t iFirst = 0;
+	uint32_t iLast = 0; // for "<..., First>"/"<..., Last>" ranges, otherwise iFirst
+	std::string_view sGeneralCategory;
+	uint8_t iCombiningClass = 0;
+	std::string_view sBidiClass;
+	std::string_view sDecomposition; // "[<tag> ]XXXX XXXX..."
+	uint32_t iUpper = 0; // 0 = maps to itself
+	uint32_t iLower = 0; // 0 = maps to itself
+	uint32_t iTitle = 0; // 0 = maps to itself
+};
+
+/// <summary>
+/// A line of UnicodeData.txt<para/>
+/// The strings reference the contents of the file.
+/// </summary>
+struct CharLine
+{
+	uint32_t iCodePoint = 0;
+	std::string_view sName;
+	std::string_view sNameUnicode1;
+	CharProperties oProperties;
+};
+
+using NameEntry = std::pair<uint32_t, std::string_view>; // code point, name
+
+/// <summary>
+/// The ranges of characters whose names are derived from their code points
+/// ("<c>&lt;prefix&gt;XXXX</c>")<para/>
+/// The Hangul syllables aren't included, the DLL composes their names from the jamo.
+/// </summary>
+struct AlgorithmicNames
+{
+	std::vector<uint32_t> oRangeFirst;
+	std::vector<uint32_t> oRangeLast;
+	std::vector<uint8_t> oRangePrefixes; // indices into oPrefixes
+	std::vector<std::string> oPrefixes;
+	size_t iRemovedNames = 0; // count of names that were listed individually in UnicodeData.txt
+};
+
+/// <summary>
+/// The property tables, in the format expected by <c>rl::Unicode</c>
+/// </summary>
+struct PropertyTables
+{
+	uint8_t iBlockShift = 0; // code points per stage 2 block = 1 << iBlockShift
+	std::vector<uint16_t> oStage1; // code point >> iBlockShift --> block index
+	std::vector<uint16_t> oStage2; // blocks of record indices
+
+	// the distinct records (0 = unassigned code point)
+	std::vector<uint8_t> oGeneralCategories;
+	std::vector<uint8_t> oCombiningClasses;
+	std::vector<uint8_t> oBidiClasses;
+	std::vector<int32_t> oUpperDeltas; // simple uppercase mapping - code point
+	std::vector<int32_t> oLowerDeltas; // simple lowercase mapping - code point
+	std::vector<int32_t> oTitleDeltas; // simple titlecase mapping - code point
+
+	uint8_t iDecompositionShift = 0;
+	std::vector<uint16_t> oDecompositionStage1;
+	std::vector<uint16_t> oDecompositionStage2; // offsets into oDecompositions (0 = none)
+	std::vector<uint32_t> oDecompositions; // (type << 8) | length, followed by the mapping
+};
+
+/// <summary>
+/// The break property tables (UAX #29 and UAX #14), in the format expected by
+/// <c>rl::Unicode</c>
+/// </summary>
+struct BreakTables
+{
+	uint8_t iBlockShift = 0; // code points per stage 2 block = 1 << iBlockShift
+	std::vector<uint16_t> oStage1; // code point >> iBlockShift --> block index
+	std::vector<uint16_t> oStage2; // blocks of break property values (see below)
+};
+
+/// <summary>
+/// The normalization tables (UAX #15), in the format expected by <c>rl::Unicode</c>
+/// </summary>
+struct NormalizationTables
+{
+	uint8_t iBlockShift = 0; // code points per stage 2 block = 1 << iBlockShift
+	std::vector<uint16_t> oStage1; // code point >> iBlockShift --> block index
+	std::vector<uint16_t> oStage2; // blocks of normalization property values (see below)
+	std::vector<uint32_t> oCompositions; // sorted (first, second, composite) triples
+};
 
-bool WriteStr(HANDLE hFile, const char* sz);
 
 
+// the values of the properties, in the order of the enums of rl::Unicode
+
+const char* const szGeneralCategories[] =
+{
+	"Lu", "Ll", "Lt", "Lm", "Lo", "Mn", "Mc", "Me", "Nd", "Nl", "No", "Pc", "Pd", "Ps", "Pe",
+	"Pi", "Pf", "Po", "Sm", "Sc", "Sk", "So", "Zs", "Zl", "Zp", "Cc", "Cf", "Cs", "Co", "Cn"
+};
+const uint8_t iUnassignedCategory = 29; // "Cn"
+
+const char* const szBidiClasses[] =
+{
+	"L", "R", "AL", "EN", "ES", "ET", "AN", "CS", "NSM", "BN", "B", "S", "WS", "ON", "LRE",
+	"LRO", "RLE", "RLO", "PDF", "LRI", "RLI", "FSI", "PDI"
+};
+
+const char* const szDecompositionTypes[] =
+{
+	"", "", "<font>", "<noBreak>", "<initial>", "<medial>", "<final>", "<isolated>", "<circle>",
+	"<super>", "<sub>", "<vertical>", "<wide>", "<narrow>", "<small>", "<square>", "<fraction>",
+	"<compat>"
+}; // 0 = none, 1 = canonical
 
-int wmain(int argc, wchar_t* argv[])
+const char* const szGraphemeBreaks[] =
 {
-	if (argc != 3)
+	"Other", "CR", "LF", "Control", "Extend", "ZWJ", "Regional_Indicator", "Prepend",
+	"SpacingMark", "L", "V", "T", "LV", "LVT"
+};
+
+const char* const szLineBreaks[] =
+{
+	"BK", "CR", "LF", "CM", "NL", "SG", "WJ", "ZW", "GL", "SP", "ZWJ", "B2", "BA", "BB", "HY",
+	"CB", "CL", "CP", "EX", "IN", "NS", "OP", "QU", "IS", "NU", "PO", "PR", "SY", "AI", "AL",
+	"CJ", "EB", "EM", "H2", "H3", "HL", "ID", "JL", "JV", "JT", "RI", "SA", "XX"
+};
+const uint8_t iUnknownLineBreak = 42; // "XX"
+
+const char* const szEastAsianWidths[] = { "N", "A", "H", "F", "Na", "W" };
+
+const char* const szEmojiProperties[] = { "", "Extended_Pictographic" }; // others are ignored
+
+// the layout of the break property values:
+// bits 0-5 = Line_Break, bits 6-9 = Grapheme_Cluster_Break, bit 10 = Extended_Pictographic,
+// bit 11 = East_Asian_Width F/W/H, bit 12 = General_Category Mn/Mc
+const unsigned iGraphemeBreakShift = 6;
+const uint16_t iExtendedPictographicFlag = 1 << 10;
+const uint16_t iEastAsianWideFlag = 1 << 11;
+const uint16_t iCombiningMarkFlag = 1 << 12;
+
+const char* const szNormalizationProperties[] = { "", "Full_Composition_Exclusion" };
+
+// the layout of the normalization property values:
+// bits 0-7 = Canonical_Combining_Class, bit 8 = NFD_QC No, bit 9 = NFC_QC No,
+// bit 10 = NFC_QC Maybe
+const uint16_t iNFDQuickCheckNo = 1 << 8;
+const uint16_t iNFCQuickCheckNo = 1 << 9;
+const uint16_t iNFCQuickCheckMaybe = 1 << 10;
+
+
+
+bool LoadFile(const char* szPath, std::string& sDest);
+bool SaveFile(const char* szPath, const std::string& sContent);
+
+/// <summary>
+/// Parse the contents of UnicodeData.txt, on all available cores<para/>
+/// The lines are returned in the order of the file.
+/// </summary>
+bool ParseUnicodeData(std::string_view sInput, std::vector<CharLine>& oDest);
+/// <summary>
+/// Parse a part of UnicodeData.txt that consists of complete lines
+/// </summary>
+/// <param name="sInvalidLine">= receives the first line that couldn't be parsed</param>
+bool ParseLines(std::string_view sText, std::vector<CharLine>& oDest,
+	std::string_view& sInvalidLine);
+/// <summary>
+/// Split a line into the fields separated by semicolons (without copying)
+/// </summary>
+/// <returns>The count of fields in the line (might be greater than <c>N</c>)</returns>
+template <size_t N>
+size_t SplitFields(std::string_view sLine, std::string_view(&oFields)[N]);
+bool ParseHex(std::string_view s, uint32_t& iDest);
+/// <summary>
+/// Parse a list of hexadecimal code points, separated by spaces
+/// </summary>
+bool ParseCodePoints(std::string_view s, std::vector<uint32_t>& oDest);
+
+std::string ToUpper(std::string_view s);
+
+/// <summary>
+/// Parse a property file of the Unicode Character Database
+/// ("<c>XXXX[..YYYY] ; value # comment</c>")<para/>
+/// The default values are taken from the "<c># @missing: XXXX..YYYY; value</c>" lines.
+/// </summary>
+/// <param name="bIgnoreUnknown">= skip lines with values that aren't part of szValues?</param>
+/// <param name="oDest">
+/// = receives the index (in szValues) of the value of every code point (0 to 0x10FFFF)
+/// </param>
+template <size_t N>
+bool ParsePropertyFile(std::string_view sInput, const char* const (&szValues)[N],
+	bool bIgnoreUnknown, std::vector<uint8_t>& oDest);
+
+/// <summary>
+/// Get the version of the Unicode Character Database a property file belongs to, from its
+/// first line ("<c># LineBreak-14.0.0.txt</c>")
+/// </summary>
+/// <returns>The version ("<c>14.0.0</c>"), an empty string if the line has another format</returns>
+std::string GetUCDVersion(std::string_view sInput);
+
+/// <summary>
+/// Move the names that can be derived from the code points from <c>oNames</c> to
+/// <c>oDest</c><para/>
+/// Includes the ranges of UnicodeData.txt ("<c>&lt;CJK Ideograph, First&gt;</c>") and all
+/// individually listed names that end with "<c>-XXXX</c>" (the code point).
+/// </summary>
+bool SplitAlgorithmicNames(std::vector<NameEntry>& oNames, AlgorithmicNames& oDest);
+void CreateNameTables(const std::vector<NameEntry>& oNames, NameTables& oDest);
+bool VerifyNameTables(const std::vector<NameEntry>& oNames, const NameTables& oTables);
+std::string DecodeName(const NameTables& oTables, uint16_t iName);
+
+bool CreatePropertyTables(const std::vector<CharProperties>& oProperties,
+	PropertyTables& oDest);
+bool VerifyPropertyTables(const std::vector<CharProperties>& oProperties,
+	const PropertyTables& oTables);
+
+/// <summary>
+/// Combine the break properties of all code points and compress them
+/// </summary>
+void CreateBreakTables(const std::vector<CharProperties>& oProperties,
+	const std::vector<uint8_t>& oGraphemeBreaks, const std::vector<uint8_t>& oLineBreaks,
+	const std::vector<uint8_t>& oEastAsianWidths, const std::vector<uint8_t>& oEmoji,
+	std::vector<uint16_t>& oValues, BreakTables& oDest);
+
+/// <summary>
+/// Derive the quick check properties and the canonical compositions from the canonical
+/// decompositions and the composition exclusions
+/// </summary>
+bool CreateNormalizationTables(const std::vector<CharProperties>& oProperties,
+	const std::vector<uint8_t>& oExclusions, std::vector<uint16_t>& oValues,
+	NormalizationTables& oDest);
+
+/// <summary>
+/// Create a two-stage table with the block size that needs the least memory
+/// </summary>
+/// <param name="oValues">= the values of all code points (0 to 0x10FFFF)</param>
+void CreateTwoStageTable(const std::vector<uint16_t>& oValues, uint8_t& iBlockShift,
+	std::vector<uint16_t>& oStage1, std::vector<uint16_t>& oStage2);
+
+template <typename T>
+void WriteArray(std::string& sDest, const char* szType, const char* szName,
+	const std::vector<T>& oValues);
+
+
+
+int main(int argc, char* argv[])
+{
+	if (argc != 4)
 	{
 		printf("Please use the following syntax:\n"
-			"\tUnicodeData_Generator <UnicodeData.txt> <OutputFile.cpp>\n\n");
+			"\tUnicodeData_Generator <UnicodeData.txt> <names.hpp> <unicode.tables.hpp>\n\n"
+			"The break and normalization properties are read from the same directory as\n"
+			"UnicodeData.txt, with the layout of UCD.zip (LineBreak.txt, EastAsianWidth.txt,\n"
+			"DerivedNormalizationProps.txt, auxiliary/GraphemeBreakProperty.txt,\n"
+			"emoji/emoji-data.txt). All files must be from the same release of the UCD; its\n"
+			"version is read from the first line of the property files.\n\n");
 		return 1;
 	}
 
-	const wchar_t* szUnicodeDataTXT = argv[1];
-	const wchar_t* szOutputCPP = argv[2];
+	const char* szUnicodeDataTXT = argv[1];
+	const char* szOutputHPP = argv[2];
+	const char* szPropertiesHPP = argv[3];
+
+	const auto tpStart = std::chrono::steady_clock::now();
 
 
 
 	//==============================================================================================
 	// PARSE INPUT FILE
 
-	HANDLE hFile = CreateFileW(szUnicodeDataTXT, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
-		NULL, NULL);
+	std::string sInput;
+	if (!LoadFile(szUnicodeDataTXT, sInput))
+	{
+		printf("Error while reading input file \"%s\"\n\n", szUnicodeDataTXT);
+		return 1;
+	}
+
+	printf("Parsing unicode data... ");
+	std::vector<CharLine> oLines;
+	if (!ParseUnicodeData(sInput, oLines))
+		return 1;
+
+	// names and property ranges, sorted by code point
+	std::vector<NameEntry> oNames;
+	std::vector<CharProperties> oProperties;
+	oNames.reserve(oLines.size());
+	oProperties.reserve(oLines.size());
+	for (const auto& oLine : oLines)
+	{
+		if (!oNames.empty() && oLine.iCodePoint <= oNames.back().first)
+		{
+			printf("Error: The code points are not in ascending order (U+%04X)\n\n",
+				oLine.iCodePoint);
+			return 1;
+		}
+
+		// ranges are stored as "<..., First>" and "<..., Last>"
+		const std::string_view sLast = ", Last>";
+		if (oLine.sName.length() > sLast.length() && !oProperties.empty() &&
+			oLine.sName.substr(oLine.sName.length() - sLast.length()) == sLast)
+			oProperties.back().iLast = oLine.iCodePoint;
+		else
+			oProperties.push_back(oLine.oProperties);
+
+		// decide about string to use
+		std::string_view sName = oLine.sName;
+		if (sName.empty() || (sName[0] == '<' && !oLine.sNameUnicode1.empty()))
+			sName = oLine.sNameUnicode1;
+		oNames.push_back({ oLine.iCodePoint, sName });
+	}
+
+	AlgorithmicNames oAlgorithmicNames;
+	if (!SplitAlgorithmicNames(oNames, oAlgorithmicNames))
+		return 1;
+
+	printf("Done.\n");
+
+
+	printf("Parsing break and normalization properties... ");
 
-	if (hFile == INVALID_HANDLE_VALUE)
+	// the other files of the UCD are located relative to UnicodeData.txt
+	std::string sDirectory = szUnicodeDataTXT;
+	sDirectory.erase(sDirectory.find_last_of("/\\") + 1); // npos + 1 = 0 --> current directory
+
+	std::vector<uint8_t> oGraphemeBreaks(0x110000, 0);
+	std::vector<uint8_t> oLineBreaks(0x110000, iUnknownLineBreak);
+	std::vector<uint8_t> oEastAsianWidths(0x110000, 0);
+	std::vector<uint8_t> oEmoji(0x110000, 0);
+	std::vector<uint8_t> oCompositionExclusions(0x110000, 0);
+	bool bParsed = true;
+	std::string sVersion; // of the Unicode Character Database
+	std::string sVersionFile; // the file sVersion was read from
+	auto fnParse = [&](const char* szFile, const auto& szValues, bool bIgnoreUnknown,
+		bool bVersioned, std::vector<uint8_t>& oDest)
 	{
-		printf("Error while opening input file \"%ls\"\n\n", szUnicodeDataTXT);
+		const std::string sPath = sDirectory + szFile;
+		std::string sFile;
+		if (!LoadFile(sPath.c_str(), sFile))
+		{
+			printf("Error while reading input file \"%s\"\n\n", sPath.c_str());
+			bParsed = false;
+			return;
+		}
+		if (!ParsePropertyFile(sFile, szValues, bIgnoreUnknown, oDest))
+		{
+			printf("Error: Invalid line in \"%s\"\n\n", sPath.c_str());
+			bParsed = false;
+			return;
+		}
+		if (!bVersioned)
+			return; // emoji-data.txt only states the emoji version
+
+		// the tables must not mix different releases of the UCD
+		const std::string sFileVersion = GetUCDVersion(sFile);
+		if (sFileVersion.empty())
+		{
+			printf("Error: \"%s\" doesn't start with its name and version\n\n", sPath.c_str());
+			bParsed = false;
+		}
+		else if (sVersion.empty())
+		{
+			sVersion = sFileVersion;
+			sVersionFile = sPath;
+		}
+		else if (sFileVersion != sVersion)
+		{
+			printf("Error: \"%s\" is from Unicode %s, \"%s\" from Unicode %s\n\n",
+				sVersionFile.c_str(), sVersion.c_str(), sPath.c_str(), sFileVersion.c_str());
+			bParsed = false;
+		}
+	};
+	fnParse("auxiliary/GraphemeBreakProperty.txt", szGraphemeBreaks, false, true,
+		oGraphemeBreaks);
+	fnParse("LineBreak.txt", szLineBreaks, false, true, oLineBreaks);
+	fnParse("EastAsianWidth.txt", szEastAsianWidths, false, true, oEastAsianWidths);
+	fnParse("emoji/emoji-data.txt", szEmojiProperties, true, false, oEmoji);
+	fnParse("DerivedNormalizationProps.txt", szNormalizationProperties, true, true,
+		oCompositionExclusions);
+	if (!bParsed)
 		return 1;
+
+	printf("Done.\n");
+
+
+
+
+	//==============================================================================================
+	// CREATE TABLES
+
+	printf("Creating tables... ");
+
+	// the name tables and the property tables are independent of each other
+	NameTables oTables;
+	bool bNamesValid = false;
+	std::thread oNameThread([&]
+		{
+			CreateNameTables(oNames, oTables);
+			bNamesValid = VerifyNameTables(oNames, oTables);
+		});
+
+	std::vector<uint16_t> oBreakValues;
+	BreakTables oBreakTables;
+	std::thread oBreakThread([&]
+		{
+			CreateBreakTables(oProperties, oGraphemeBreaks, oLineBreaks, oEastAsianWidths, oEmoji,
+				oBreakValues, oBreakTables);
+		});
+
+	PropertyTables oPropertyTables;
+	const bool bPropertiesCreated = CreatePropertyTables(oProperties, oPropertyTables);
+	const bool bPropertiesValid =
+		bPropertiesCreated && VerifyPropertyTables(oProperties, oPropertyTables);
+	std::vector<uint16_t> oNormalizationValues;
+	NormalizationTables oNormalizationTables;
+	const bool bNormalizationCreated = CreateNormalizationTables(oProperties,
+		oCompositionExclusions, oNormalizationValues, oNormalizationTables);
+	oNameThread.join();
+	oBreakThread.join();
+
+	if (!bPropertiesCreated || !bNormalizationCreated)
+		return 1;
+	if (!bNamesValid)
+	{
+		printf("Error: The compressed names differ from the original ones\n\n");
+		return 1;
+	}
+	if (!bPropertiesValid)
+	{
+		printf("Error: The property tables differ from the original data\n\n");
+		return 1;
+	}
+	auto fnLookup = [](uint32_t ch, const auto& o)
+	{
+		const size_t iBlock = o.oStage1[ch >> o.iBlockShift];
+		return o.oStage2[(iBlock << o.iBlockShift) | (ch & ((1u << o.iBlockShift) - 1))];
+	};
+	for (uint32_t ch = 0; ch < 0x110000; ++ch)
+	{
+		if (fnLookup(ch, oBreakTables) != oBreakValues[ch])
+		{
+			printf("Error: The break property tables differ from the original data\n\n");
+			return 1;
+		}
+		if (fnLookup(ch, oNormalizationTables) != oNormalizationValues[ch])
+		{
+			printf("Error: The normalization tables differ from the original data\n\n");
+			return 1;
+		}
+	}
+	printf("Done.\n");
+
+	{
+		const size_t iStage1Size = oTables.oStage1.size() * sizeof(uint16_t);
+		const size_t iStage2Size = oTables.oStage2.size() * sizeof(uint16_t);
+		const size_t iWordsSize =
+			oTables.oWordChars.size() + oTables.oWordOffsets.size() * sizeof(uint32_t);
+		const size_t iNamesSize = oTables.oTokens.size() +
+			oTables.oNameOffsets.size() * sizeof(uint32_t) + oTables.oNameLengths.size();
+		const size_t iIndexSize = oTables.oCodePoints.size() * sizeof(uint32_t) +
+			(oTables.oSortedNames.size() + oTables.oSortedWords.size() +
+				oTables.oPostings.size()) * sizeof(uint16_t) +
+			oTables.oPostingOffsets.size() * sizeof(uint32_t);
+		size_t iRawSize = 0;
+		for (auto& o : oNames)
+		{
+			iRawSize += o.second.length() + 1;
+		}
+
+		printf("\n"
+			"  %zu names, %zu distinct words, blocks of %u code points\n"
+			"  Stage 1: %8zu bytes\n"
+			"  Stage 2: %8zu bytes\n"
+			"  Words:   %8zu bytes\n"
+			"  Names:   %8zu bytes\n"
+			"  Total:   %8zu bytes (raw strings: %zu bytes)\n"
+			"  Search index: %8zu bytes\n\n",
+			oTables.oNameLengths.size(), oTables.oWordOffsets.size() - 1,
+			1u << oTables.iBlockShift, iStage1Size, iStage2Size, iWordsSize, iNamesSize,
+			iStage1Size + iStage2Size + iWordsSize + iNamesSize, iRawSize, iIndexSize);
+
+		const auto& o = oAlgorithmicNames;
+		size_t iCodePointCount = 0;
+		for (size_t i = 0; i < o.oRangeFirst.size(); ++i)
+		{
+			iCodePointCount += o.oRangeLast[i] - o.oRangeFirst[i] + 1;
+		}
+		printf("  %zu algorithmic ranges, %zu prefixes (%zu code points, %zu listed names)\n\n",
+			o.oRangeFirst.size(), o.oPrefixes.size(), iCodePointCount, o.iRemovedNames);
+	}
+
+	{
+		const auto& o = oPropertyTables;
+		size_t iCodePointCount = 0;
+		for (auto& oRange : oProperties)
+		{
+			iCodePointCount += oRange.iLast - oRange.iFirst + 1;
+		}
+		const size_t iStagesSize = (o.oStage1.size() + o.oStage2.size()) * sizeof(uint16_t);
+		const size_t iRecordsSize = o.oGeneralCategories.size() * (3 + 3 * sizeof(int32_t));
+		const size_t iDecompositionsSize = (o.oDecompositionStage1.size() +
+			o.oDecompositionStage2.size()) * sizeof(uint16_t) +
+			o.oDecompositions.size() * sizeof(uint32_t);
+
+		printf("\n"
+			"  %zu code points, %zu distinct records, blocks of %u code points\n"
+			"  Stages:         %8zu bytes\n"
+			"  Records:        %8zu bytes\n"
+			"  Decompositions: %8zu bytes (blocks of %u code points)\n"
+			"  Total:          %8zu bytes\n\n",
+			iCodePointCount, o.oGeneralCategories.size(), 1u << o.iBlockShift, iStagesSize,
+			iRecordsSize, iDecompositionsSize, 1u << o.iDecompositionShift,
+			iStagesSize + iRecordsSize + iDecompositionsSize);
+	}
+
+	{
+		const auto& o = oBreakTables;
+		printf("  Break properties: %8zu bytes (blocks of %u code points)\n",
+			(o.oStage1.size() + o.oStage2.size()) * sizeof(uint16_t), 1u << o.iBlockShift);
 	}
 
-	uint64_t iFileSize;
 	{
-		LARGE_INTEGER liFileSize;
-		GetFileSizeEx(hFile, &liFileSize);
-		iFileSize = liFileSize.QuadPart;
+		const auto& o = oNormalizationTables;
+		printf("  Normalization:    %8zu bytes (blocks of %u code points, %zu compositions)\n\n",
+			(o.oStage1.size() + o.oStage2.size()) * sizeof(uint16_t) +
+			o.oCompositions.size() * sizeof(uint32_t), 1u << o.iBlockShift,
+			o.oCompositions.size() / 3);
 	}
 
-	LARGE_INTEGER liFilePtr;
 
-	std::map<uint32_t, const char*> oNames;
 
-	printf("Parsing unicode data... ");
-	while (SetFilePointerEx(hFile, { 0 }, &liFilePtr, FILE_CURRENT),
-		(uint64_t)liFilePtr.QuadPart < iFileSize)
+
+	//==============================================================================================
+	// WRITE HPP FILE
+
+	printf("Writing file... ");
+
+	std::string sOutput;
+	sOutput +=
+		"/*\n"
+		"This file is created automatically from UnicodeData.txt\n"
+		"Unicode Character Database " + sVersion + "\n"
+		"*/\n"
+		"\n"
+		"\n"
+		"#pragma once\n"
+		"\n"
+		"#include <stdint.h>\n"
+		"\n"
+		"\n"
+		"namespace rl\n"
+		"{\n"
+		"\tnamespace UnicodeDataDLL\n"
+		"\t{\n"
+		"\t\tnamespace Names\n"
+		"\t\t{\n"
+		"\n";
+
+	char szLine[128];
+	snprintf(szLine, sizeof(szLine), "\t\t\tconst unsigned BlockShift = %u;\n",
+		oTables.iBlockShift);
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine), "\t\t\tconst unsigned NameCount = %zu;\n",
+		oTables.oNameLengths.size());
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine), "\t\t\tconst unsigned WordCount = %zu;\n",
+		oTables.oSortedWords.size());
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine), "\t\t\tconst unsigned RangeCount = %zu;\n",
+		oAlgorithmicNames.oRangeFirst.size());
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine), "\t\t\tconst unsigned PrefixCount = %zu;\n",
+		oAlgorithmicNames.oPrefixes.size());
+	sOutput += szLine;
+	sOutput += "\t\t\tconst uint16_t NoName = 0xFFFF;\n\n";
+
+	WriteArray(sOutput, "static const uint16_t", "Stage1", oTables.oStage1);
+	WriteArray(sOutput, "static const uint16_t", "Stage2", oTables.oStage2);
+	WriteArray(sOutput, "static const uint32_t", "WordOffsets", oTables.oWordOffsets);
+	WriteArray(sOutput, "static const uint8_t", "Tokens", oTables.oTokens);
+	WriteArray(sOutput, "static const uint32_t", "NameOffsets", oTables.oNameOffsets);
+	WriteArray(sOutput, "static const uint8_t", "NameLengths", oTables.oNameLengths);
+
+	// search index
+	WriteArray(sOutput, "static const uint32_t", "CodePoints", oTables.oCodePoints);
+	WriteArray(sOutput, "static const uint16_t", "SortedNames", oTables.oSortedNames);
+	WriteArray(sOutput, "static const uint16_t", "SortedWords", oTables.oSortedWords);
+	WriteArray(sOutput, "static const uint32_t", "PostingOffsets", oTables.oPostingOffsets);
+	WriteArray(sOutput, "static const uint16_t", "Postings", oTables.oPostings);
+
+	// algorithmic names
+	WriteArray(sOutput, "static const uint32_t", "RangeFirst", oAlgorithmicNames.oRangeFirst);
+	WriteArray(sOutput, "static const uint32_t", "RangeLast", oAlgorithmicNames.oRangeLast);
+	WriteArray(sOutput, "static const uint8_t", "RangePrefixes",
+		oAlgorithmicNames.oRangePrefixes);
+	sOutput += "\t\t\tstatic const char* const Prefixes[] =\n\t\t\t{\n";
+	for (auto& sPrefix : oAlgorithmicNames.oPrefixes)
 	{
-		DWORD dwRead = 0;
-		char ch;
+		sOutput += "\t\t\t\t\"" + sPrefix + "\",\n";
+	}
+	sOutput += "\t\t\t};\n\n";
 
-		char szHexVal[7] = {};
-		uint32_t iBinVal = 0;
-		for (uint8_t i = 0; i < 7; ++i)
+	// the words as a single string literal, split into lines
+	sOutput += "\t\t\tstatic const char WordChars[] =\n";
+	for (size_t i = 0; i < oTables.oWordChars.size(); i += 80)
+	{
+		sOutput += "\t\t\t\t\"";
+		sOutput.append(oTables.oWordChars.data() + i,
+			std::min<size_t>(80, oTables.oWordChars.size() - i));
+		sOutput += "\"\n";
+	}
+	sOutput += "\t\t\t\t;\n\n";
+
+	sOutput +=
+		"\t\t}\n"
+		"\t}\n"
+		"}\n";
+
+	if (!SaveFile(szOutputHPP, sOutput))
+	{
+		printf("Could not write output file \"%s\"\n\n", szOutputHPP);
+		return 1;
+	}
+
+	printf("Done.\n\nFile \"%s\" was successfully generated\n\n", szOutputHPP);
+
+
+
+
+	//==============================================================================================
+	// WRITE PROPERTIES FILE
+
+	printf("Writing file... ");
+
+	sOutput =
+		"/*\n"
+		"This file is created automatically from UnicodeData.txt, LineBreak.txt,\n"
+		"EastAsianWidth.txt, DerivedNormalizationProps.txt,\n"
+		"auxiliary/GraphemeBreakProperty.txt and emoji/emoji-data.txt\n"
+		"Unicode Character Database " + sVersion + "\n"
+		"Don't include it directly, use unicode.hpp\n"
+		"*/\n"
+		"\n"
+		"\n"
+		"#pragma once\n"
+		"\n"
+		"#include <cstdint>\n"
+		"\n"
+		"\n"
+		"namespace rl\n"
+		"{\n"
+		"\tnamespace Unicode\n"
+		"\t{\n"
+		"\t\tnamespace Tables\n"
+		"\t\t{\n"
+		"\n";
+
+	snprintf(szLine, sizeof(szLine), "\t\t\tinline constexpr unsigned BlockShift = %u;\n",
+		oPropertyTables.iBlockShift);
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine), "\t\t\tinline constexpr unsigned DecompositionShift = %u;\n",
+		oPropertyTables.iDecompositionShift);
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine), "\t\t\tinline constexpr unsigned BreakShift = %u;\n",
+		oBreakTables.iBlockShift);
+	sOutput += szLine;
+	snprintf(szLine, sizeof(szLine),
+		"\t\t\tinline constexpr unsigned NormalizationShift = %u;\n\n",
+		oNormalizationTables.iBlockShift);
+	sOutput += szLine;
+
+	WriteArray(sOutput, "inline constexpr uint16_t", "Stage1", oPropertyTables.oStage1);
+	WriteArray(sOutput, "inline constexpr uint16_t", "Stage2", oPropertyTables.oStage2);
+
+	// records
+	WriteArray(sOutput, "inline constexpr uint8_t", "GeneralCategories",
+		oPropertyTables.oGeneralCategories);
+	WriteArray(sOutput, "inline constexpr uint8_t", "CombiningClasses",
+		oPropertyTables.oCombiningClasses);
+	WriteArray(sOutput, "inline constexpr uint8_t", "BidiClasses", oPropertyTables.oBidiClasses);
+	WriteArray(sOutput, "inline constexpr int32_t", "UpperDeltas", oPropertyTables.oUpperDeltas);
+	WriteArray(sOutput, "inline constexpr int32_t", "LowerDeltas", oPropertyTables.oLowerDeltas);
+	WriteArray(sOutput, "inline constexpr int32_t", "TitleDeltas", oPropertyTables.oTitleDeltas);
+
+	// decompositions
+	WriteArray(sOutput, "inline constexpr uint16_t", "DecompositionStage1",
+		oPropertyTables.oDecompositionStage1);
+	WriteArray(sOutput, "inline constexpr uint16_t", "DecompositionStage2",
+		oPropertyTables.oDecompositionStage2);
+	WriteArray(sOutput, "inline constexpr char32_t", "Decompositions",
+		oPropertyTables.oDecompositions);
+
+	// break properties
+	WriteArray(sOutput, "inline constexpr uint16_t", "BreakStage1", oBreakTables.oStage1);
+	WriteArray(sOutput, "inline constexpr uint16_t", "BreakStage2", oBreakTables.oStage2);
+
+	// normalization
+	WriteArray(sOutput, "inline constexpr uint16_t", "NormalizationStage1",
+		oNormalizationTables.oStage1);
+	WriteArray(sOutput, "inline constexpr uint16_t", "NormalizationStage2",
+		oNormalizationTables.oStage2);
+	WriteArray(sOutput, "inline constexpr char32_t", "Compositions",
+		oNormalizationTables.oCompositions);
+
+	sOutput +=
+		"\t\t}\n"
+		"\t}\n"
+		"}\n";
+
+	if (!SaveFile(szPropertiesHPP, sOutput))
+	{
+		printf("Could not write output file \"%s\"\n\n", szPropertiesHPP);
+		return 1;
+	}
+
+	printf("Done.\n\nFile \"%s\" was successfully generated\n\n", szPropertiesHPP);
+
+	printf("Finished in %.0f ms\n\n", std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - tpStart).count());
+
+	return 0;
+}
+
+
+bool LoadFile(const char* szPath, std::string& sDest)
+{
+	std::ifstream oFile(szPath, std::ios::binary | std::ios::ate);
+	if (!oFile)
+		return false;
+
+	const std::streamoff iSize = oFile.tellg();
+	sDest.resize((size_t)iSize);
+	oFile.seekg(0);
+	return (bool)oFile.read(sDest.data(), iSize);
+}
+
+bool SaveFile(const char* szPath, const std::string& sContent)
+{
+	std::ofstream oFile(szPath, std::ios::binary | std::ios::trunc);
+	return oFile && oFile.write(sContent.data(), (std::streamsize)sContent.length());
+}
+
+bool ParseUnicodeData(std::string_view sInput, std::vector<CharLine>& oDest)
+{
+	// one chunk of complete lines per thread
+	const size_t iThreadCount = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::string_view> oChunks;
+	size_t iStart = 0;
+	for (size_t i = 1; i <= iThreadCount && iStart < sInput.length(); ++i)
+	{
+		size_t iEnd = std::max(iStart, sInput.length() * i / iThreadCount);
+		iEnd = sInput.find('\n', iEnd);
+		iEnd = (iEnd == std::string_view::npos) ? sInput.length() : iEnd + 1;
+
+		oChunks.push_back(sInput.substr(iStart, iEnd - iStart));
+		iStart = iEnd;
+	}
+
+	std::vector<std::vector<CharLine>> oResults(oChunks.size());
+	std::vector<std::string_view> oInvalidLines(oChunks.size());
+	std::vector<char> oSuccess(oChunks.size()); // not std::vector<bool> (written concurrently)
+	std::vector<std::thread> oThreads;
+	for (size_t i = 0; i < oChunks.size(); ++i)
+	{
+		oThreads.emplace_back([&, i]
+			{
+				oSuccess[i] = ParseLines(oChunks[i], oResults[i], oInvalidLines[i]);
+			});
+	}
+	for (auto& oThread : oThreads)
+	{
+		oThread.join();
+	}
+
+	oDest.clear();
+	for (size_t i = 0; i < oChunks.size(); ++i)
+	{
+		if (!oSuccess[i])
+		{
+			printf("Error: Invalid line \"%.*s\"\n\n", (int)oInvalidLines[i].length(),
+				oInvalidLines[i].data());
+			return false;
+		}
+		oDest.insert(oDest.end(), oResults[i].begin(), oResults[i].end());
+	}
+
+	return true;
+}
+
+bool ParseLines(std::string_view sText, std::vector<CharLine>& oDest,
+	std::string_view& sInvalidLine)
+{
+	oDest.reserve(sText.length() / 32);
+
+	std::string_view oFields[15];
+	while (!sText.empty())
+	{
+		const size_t iLineEnd = sText.find('\n');
+		std::string_view sLine = sText.substr(0, iLineEnd);
+		sText.remove_prefix((iLineEnd == std::string_view::npos) ? sText.length() : iLineEnd + 1);
+		if (!sLine.empty() && sLine.back() == '\r')
+			sLine.remove_suffix(1);
+		if (sLine.empty())
+			continue;
+
+		// 0 code point, 1 name, 2 general category, 3 canonical combining class,
+		// 4 bidi class, 5 decomposition, 6-8 numeric values, 9 mirrored, 10 Unicode 1.0 name,
+		// 11 ISO comment, 12 uppercase, 13 lowercase, 14 titlecase
+		uint32_t iCombiningClass = 0;
+		CharLine oLine;
+		auto& oProperties = oLine.oProperties;
+		if (SplitFields(sLine, oFields) != std::size(oFields) ||
+			!ParseHex(oFields[0], oLine.iCodePoint) || oLine.iCodePoint >= 0x110000 ||
+			std::from_chars(oFields[3].data(), oFields[3].data() + oFields[3].length(),
+				iCombiningClass).ec != std::errc() || iCombiningClass > 0xFF ||
+			!ParseHex(oFields[12], oProperties.iUpper) ||
+			!ParseHex(oFields[13], oProperties.iLower) ||
+			!ParseHex(oFields[14], oProperties.iTitle))
 		{
-			if (!ReadFile(hFile, &ch, 1, &dwRead, NULL))
-				return 1; // read error
+			sInvalidLine = sLine;
+			return false;
+		}
+
+		oLine.sName = oFields[1];
+		oLine.sNameUnicode1 = oFields[10];
+		oProperties.iFirst = oLine.iCodePoint;
+		oProperties.iLast = oLine.iCodePoint;
+		oProperties.sGeneralCategory = oFields[2];
+		oProperties.iCombiningClass = (uint8_t)iCombiningClass;
+		oProperties.sBidiClass = oFields[4];
+		oProperties.sDecomposition = oFields[5];
+
+		oDest.push_back(oLine);
+	}
 
-			if (ch == ';')
+	return true;
+}
+
+template <size_t N>
+size_t SplitFields(std::string_view sLine, std::string_view(&oFields)[N])
+{
+	size_t iCount = 0;
+	while (true)
+	{
+		const size_t iEnd = sLine.find(';');
+		if (iCount < N)
+			oFields[iCount] = sLine.substr(0, iEnd);
+		++iCount;
+
+		if (iEnd == std::string_view::npos)
+			break;
+		sLine.remove_prefix(iEnd + 1);
+	}
+
+	return iCount;
+}
+
+bool ParseHex(std::string_view s, uint32_t& iDest)
+{
+	iDest = 0;
+	if (s.empty())
+		return true;
+
+	const auto oResult = std::from_chars(s.data(), s.data() + s.length(), iDest, 16);
+	return oResult.ec == std::errc() && oResult.ptr == s.data() + s.length();
+}
+
+
+
+bool SplitAlgorithmicNames(std::vector<NameEntry>& oNames, AlgorithmicNames& oDest)
+{
+	oDest = {};
+
+	// the prefixes of the ranges in UnicodeData.txt
+	const std::pair<std::string_view, std::string_view> oRangePrefixes[] =
+	{
+		{ "<CJK Ideograph", "CJK UNIFIED IDEOGRAPH-" },
+		{ "<Tangut Ideograph", "TANGUT IDEOGRAPH-" },
+		{ "<Hangul Syllable", "" }, // composed of the jamo
+	};
+
+	auto fnAddRange = [&](uint32_t iFirst, uint32_t iLast, std::string_view sPrefix)
+	{
+		if (sPrefix.empty())
+			return;
+
+		auto itPrefix = std::find(oDest.oPrefixes.begin(), oDest.oPrefixes.end(), sPrefix);
+		if (itPrefix == oDest.oPrefixes.end())
+			itPrefix = oDest.oPrefixes.insert(itPrefix, std::string(sPrefix));
+		const uint8_t iPrefix = uint8_t(itPrefix - oDest.oPrefixes.begin());
+
+		// continuation of the previous range?
+		if (!oDest.oRangeFirst.empty() && oDest.oRangeLast.back() + 1 == iFirst &&
+			oDest.oRangePrefixes.back() == iPrefix)
+			oDest.oRangeLast.back() = iLast;
+		else
+		{
+			oDest.oRangeFirst.push_back(iFirst);
+			oDest.oRangeLast.push_back(iLast);
+			oDest.oRangePrefixes.push_back(iPrefix);
+		}
+	};
+
+	std::vector<NameEntry> oRemainingNames;
+	oRemainingNames.reserve(oNames.size());
+	for (size_t i = 0; i < oNames.size(); ++i)
+	{
+		const uint32_t iCodePoint = oNames[i].first;
+		const std::string_view sName = oNames[i].second;
+
+		// 1. range ("<..., First>" directly followed by "<..., Last>")
+		const std::string_view sFirst = ", First>";
+		if (sName.length() > sFirst.length() &&
+			sName.substr(sName.length() - sFirst.length()) == sFirst && i + 1 < oNames.size())
+		{
+			const auto itPrefix = std::find_if(std::begin(oRangePrefixes),
+				std::end(oRangePrefixes),
+				[&](const auto& o) { return sName.substr(0, o.first.length()) == o.first; });
+			if (itPrefix != std::end(oRangePrefixes))
 			{
-				szHexVal[i] = 0;
-				break;
+				const uint32_t iLast = oNames[i + 1].first;
+				if (itPrefix->second.empty() && (iCodePoint != 0xAC00 || iLast != 0xD7A3))
+				{
+					printf("Error: Unexpected range of Hangul syllables\n\n");
+					return false;
+				}
+
+				fnAddRange(iCodePoint, iLast, itPrefix->second);
+				++i; // skip "<..., Last>"
+				continue;
 			}
-			else if (i == 6)
-				return 1; // hex number was too long
-			else
-				szHexVal[i] = ch;
 		}
-		iBinVal = strtoul(szHexVal, nullptr, 16); // convert hex string to binary value
 
+		// 2. individually listed name "<prefix>XXXX"
+		char szCodePoint[16];
+		snprintf(szCodePoint, sizeof(szCodePoint), "-%04X", iCodePoint);
+		const size_t iSuffixLen = strlen(szCodePoint);
+		if (sName.length() > iSuffixLen &&
+			sName.substr(sName.length() - iSuffixLen) == szCodePoint)
+		{
+			fnAddRange(iCodePoint, iCodePoint, sName.substr(0, sName.length() - iSuffixLen + 1));
+			++oDest.iRemovedNames;
+			continue;
+		}
+
+		oRemainingNames.push_back(oNames[i]);
+	}
 
-		char* szName = nullptr;
-		if (!ReadStr(hFile, &szName))
+	if (oDest.oPrefixes.size() > 0xFF)
+	{
+		printf("Error: Too many prefixes of algorithmic names\n\n");
+		return false;
+	}
+	for (auto& sPrefix : oDest.oPrefixes)
+	{
+		if (sPrefix.length() + 6 > 63) // the limit of the pattern search of the DLL
 		{
-			CloseHandle(hFile);
-			return 1; // couldn't read current name
+			printf("Error: The prefix \"%s\" is too long\n\n", sPrefix.c_str());
+			return false;
 		}
+	}
 
-		char* szNameUnicode1 = nullptr;
+	oNames.swap(oRemainingNames);
+	return true;
+}
 
-		// skip values not interested in
-		for (uint8_t i = 0; i < 8; ++i)
+void CreateNameTables(const std::vector<NameEntry>& oNames, NameTables& oDest)
+{
+	oDest = {};
+
+	// 1. split the names into words; every word is followed by ' ', '-' or the end of the name
+	std::map<std::string, size_t> oWordFrequency;
+	std::vector<std::vector<std::pair<std::string, char>>> oSplitNames;
+	oSplitNames.reserve(oNames.size());
+	for (auto& o : oNames)
+	{
+		std::vector<std::pair<std::string, char>> oWords;
+		std::string sWord;
+		for (size_t i = 0; i <= o.second.length(); ++i)
 		{
-			if (!SkipVal(hFile))
+			const char c = (i < o.second.length()) ? o.second[i] : 0;
+			if (c == ' ' || c == '-' || c == 0)
 			{
-				CloseHandle(hFile);
-				return 1; // couldn't skip value
+				oWords.push_back({ sWord, c });
+				++oWordFrequency[sWord];
+				sWord.clear();
 			}
+			else
+				sWord += c;
 		}
+		oSplitNames.push_back(std::move(oWords));
+	}
+
+	// 2. the most frequent words get the lowest IDs (--> single-byte tokens)
+	std::vector<std::pair<std::string, size_t>> oWords(oWordFrequency.begin(),
+		oWordFrequency.end());
+	std::stable_sort(oWords.begin(), oWords.end(),
+		[](const auto& a, const auto& b) { return a.second > b.second; });
+
+	std::map<std::string, uint16_t> oWordIDs;
+	oDest.oWordOffsets.push_back(0);
+	for (auto& o : oWords)
+	{
+		const uint16_t iID = (uint16_t)oWordIDs.size();
+		oWordIDs[o.first] = iID;
+		oDest.oWordChars.insert(oDest.oWordChars.end(), o.first.begin(), o.first.end());
+		oDest.oWordOffsets.push_back((uint32_t)oDest.oWordChars.size());
+	}
+
+	// 3. tokens
+	// 1st byte: bit 7    = the word is followed by '-' instead of ' '
+	//           bit 6    = two-byte token, the word ID is ((bits 0-5 << 8) | 2nd byte)
+	//           bits 0-5 = the word ID (single-byte token)
+	oDest.oNameOffsets.push_back(0);
+	for (auto& oSplit : oSplitNames)
+	{
+		size_t iLength = 0;
+		for (auto& oWord : oSplit)
+		{
+			const uint16_t iID = oWordIDs[oWord.first];
+			const uint8_t iHyphen = (oWord.second == '-') ? 0x80 : 0x00;
+			if (iID < 0x40)
+				oDest.oTokens.push_back(uint8_t(iHyphen | iID));
+			else
+			{
+				oDest.oTokens.push_back(uint8_t(iHyphen | 0x40 | (iID >> 8)));
+				oDest.oTokens.push_back(uint8_t(iID & 0xFF));
+			}
+			iLength += oWord.first.length() + (oWord.second ? 1 : 0);
+		}
+		oDest.oNameOffsets.push_back((uint32_t)oDest.oTokens.size());
+		oDest.oNameLengths.push_back((uint8_t)iLength);
+	}
+
+	// 4. two-stage lookup table
+	{
+		std::vector<uint16_t> oValues(0x110000, 0xFFFF);
+		uint16_t iName = 0;
+		for (auto& o : oNames)
+		{
+			oValues[o.first] = iName++;
+		}
+		CreateTwoStageTable(oValues, oDest.iBlockShift, oDest.oStage1, oDest.oStage2);
+	}
+
+	// 5. search index
+	std::vector<std::string> oUpperNames;
+	oUpperNames.reserve(oNames.size());
+	for (auto& o : oNames)
+	{
+		oDest.oCodePoints.push_back(o.first);
+		oUpperNames.push_back(ToUpper(o.second));
+	}
+
+	for (size_t i = 0; i < oUpperNames.size(); ++i)
+	{
+		oDest.oSortedNames.push_back((uint16_t)i);
+	}
+	std::stable_sort(oDest.oSortedNames.begin(), oDest.oSortedNames.end(),
+		[&](uint16_t a, uint16_t b) { return oUpperNames[a] < oUpperNames[b]; });
+
+	std::vector<std::string> oUpperWords;
+	oUpperWords.reserve(oWords.size());
+	for (size_t i = 0; i < oWords.size(); ++i)
+	{
+		oUpperWords.push_back(ToUpper(oWords[i].first));
+		oDest.oSortedWords.push_back((uint16_t)i);
+	}
+	std::stable_sort(oDest.oSortedWords.begin(), oDest.oSortedWords.end(),
+		[&](uint16_t a, uint16_t b) { return oUpperWords[a] < oUpperWords[b]; });
+
+	std::vector<std::vector<uint16_t>> oWordPostings(oWords.size());
+	for (size_t iName = 0; iName < oSplitNames.size(); ++iName)
+	{
+		for (auto& oWord : oSplitNames[iName])
+		{
+			auto& oPostings = oWordPostings[oWordIDs[oWord.first]];
+			if (oPostings.empty() || oPostings.back() != iName) // word used twice in the name
+				oPostings.push_back((uint16_t)iName);
+		}
+	}
+	oDest.oPostingOffsets.push_back(0);
+	for (auto& oPostings : oWordPostings)
+	{
+		oDest.oPostings.insert(oDest.oPostings.end(), oPostings.begin(), oPostings.end());
+		oDest.oPostingOffsets.push_back((uint32_t)oDest.oPostings.size());
+	}
+}
+
+bool VerifyNameTables(const std::vector<NameEntry>& oNames, const NameTables& oTables)
+{
+	const uint32_t iMask = (1u << oTables.iBlockShift) - 1;
+	for (auto& o : oNames)
+	{
+		const size_t iBlock = oTables.oStage1[o.first >> oTables.iBlockShift];
+		const uint16_t iName = oTables.oStage2[(iBlock << oTables.iBlockShift) | (o.first & iMask)];
+		if (iName == 0xFFFF || DecodeName(oTables, iName) != o.second ||
+			oTables.oNameLengths[iName] != o.second.length())
+			return false;
+	}
+
+	return true;
+}
+
+std::string DecodeName(const NameTables& oTables, uint16_t iName)
+{
+	std::string sResult;
+
+	const uint32_t iEnd = oTables.oNameOffsets[(size_t)iName + 1];
+	for (uint32_t i = oTables.oNameOffsets[iName]; i < iEnd; ++i)
+	{
+		const uint8_t iToken = oTables.oTokens[i];
+		uint16_t iID = iToken & 0x3F;
+		if (iToken & 0x40)
+			iID = uint16_t((iID << 8) | oTables.oTokens[++i]);
+
+		sResult.append(oTables.oWordChars.data() + oTables.oWordOffsets[iID],
+			oTables.oWordOffsets[(size_t)iID + 1] - oTables.oWordOffsets[iID]);
+		if (i + 1 < iEnd)
+			sResult += (iToken & 0x80) ? '-' : ' ';
+	}
 
-		if (!ReadStr(hFile, &szNameUnicode1))
+	return sResult;
+}
+
+bool CreatePropertyTables(const std::vector<CharProperties>& oProperties,
+	PropertyTables& oDest)
+{
+	oDest = {};
+
+	auto fnFind = [](const auto& szValues, std::string_view s, size_t iFirst = 0) -> int
+	{
+		for (size_t i = iFirst; i < std::size(szValues); ++i)
 		{
-			CloseHandle(hFile);
-			return 1; // couldn't read Unicode 1.0 name
+			if (s == szValues[i])
+				return (int)i;
 		}
+		return -1;
+	};
 
+	// 1. distinct records
+	using Record = std::tuple<uint8_t, uint8_t, uint8_t, int32_t, int32_t, int32_t>;
+	std::map<Record, uint16_t> oRecordIDs;
+	auto fnAddRecord = [&](const Record& oRecord)
+	{
+		auto it = oRecordIDs.find(oRecord);
+		if (it == oRecordIDs.end())
+		{
+			it = oRecordIDs.emplace(oRecord, (uint16_t)oRecordIDs.size()).first;
+			oDest.oGeneralCategories.push_back(std::get<0>(oRecord));
+			oDest.oCombiningClasses.push_back(std::get<1>(oRecord));
+			oDest.oBidiClasses.push_back(std::get<2>(oRecord));
+			oDest.oUpperDeltas.push_back(std::get<3>(oRecord));
+			oDest.oLowerDeltas.push_back(std::get<4>(oRecord));
+			oDest.oTitleDeltas.push_back(std::get<5>(oRecord));
+		}
+		return it->second;
+	};
+	fnAddRecord({ iUnassignedCategory, 0, 0, 0, 0, 0 }); // unassigned, bidi class "L"
+
+	std::vector<uint16_t> oRecords(0x110000, 0);
+	std::vector<uint16_t> oDecompositions(0x110000, 0);
+	oDest.oDecompositions.push_back(0); // offset 0 = no decomposition
+	for (auto& oChar : oProperties)
+	{
+		const int iCategory = fnFind(szGeneralCategories, oChar.sGeneralCategory);
+		const int iBidiClass = fnFind(szBidiClasses, oChar.sBidiClass);
+		if (iCategory < 0 || iBidiClass < 0)
+		{
+			printf("Error: Unknown property value of U+%04X\n\n", oChar.iFirst);
+			return false;
+		}
 
+		// 2. decomposition: "[<tag> ]XXXX XXXX..."
+		int iType = 0; // none
+		std::vector<uint32_t> oMapping;
+		if (!oChar.sDecomposition.empty())
 		{
-			char ch = 0;
-			while (ch != '\n')
+			iType = 1; // canonical
+			std::string_view sMapping = oChar.sDecomposition;
+			if (sMapping[0] == '<')
 			{
-				if (!ReadFile(hFile, &ch, 1, &dwRead, NULL))
+				const size_t iTagEnd = sMapping.find('>') + 1;
+				iType = fnFind(szDecompositionTypes, sMapping.substr(0, iTagEnd), 2);
+				if (iType < 0)
 				{
-					CloseHandle(hFile);
-					return 1; // couldn't read until end of line
+					printf("Error: Unknown decomposition type of U+%04X\n\n", oChar.iFirst);
+					return false;
 				}
+				sMapping.remove_prefix(iTagEnd);
+			}
+
+			if (!ParseCodePoints(sMapping, oMapping))
+			{
+				printf("Error: Invalid decomposition of U+%04X\n\n", oChar.iFirst);
+				return false;
 			}
 		}
 
+		for (uint32_t ch = oChar.iFirst; ch <= oChar.iLast; ++ch)
+		{
+			auto fnDelta = [&](uint32_t iMapping)
+			{
+				return (iMapping == 0) ? 0 : int32_t(iMapping) - int32_t(ch);
+			};
+			oRecords[ch] = fnAddRecord({ (uint8_t)iCategory, oChar.iCombiningClass,
+				(uint8_t)iBidiClass, fnDelta(oChar.iUpper), fnDelta(oChar.iLower),
+				fnDelta(oChar.iTitle) });
 
+			if (iType == 0)
+				continue;
 
-		// decide about string to use
-		const char* szNameFinal = szName;
-		if (strlen(szName) == 0 || ((szName[0] == '<') && (strlen(szNameUnicode1) > 0)))
-			szNameFinal = szNameUnicode1;
+			if (oDest.oDecompositions.size() > 0xFFFF)
+			{
+				printf("Error: Too many decompositions\n\n");
+				return false;
+			}
+			oDecompositions[ch] = (uint16_t)oDest.oDecompositions.size();
+			oDest.oDecompositions.push_back(uint32_t(iType << 8) | (uint32_t)oMapping.size());
+			oDest.oDecompositions.insert(oDest.oDecompositions.end(), oMapping.begin(),
+				oMapping.end());
+		}
+	}
 
-		if (szNameFinal == szName)
-			delete[] szNameUnicode1;
-		else
-			delete[] szName;
+	// 3. two-stage lookup tables
+	CreateTwoStageTable(oRecords, oDest.iBlockShift, oDest.oStage1, oDest.oStage2);
+	CreateTwoStageTable(oDecompositions, oDest.iDecompositionShift, oDest.oDecompositionStage1,
+		oDest.oDecompositionStage2);
+
+	return true;
+}
+
+bool VerifyPropertyTables(const std::vector<CharProperties>& oProperties,
+	const PropertyTables& oTables)
+{
+	auto fnLookup = [](uint32_t ch, uint8_t iShift, const std::vector<uint16_t>& oStage1,
+		const std::vector<uint16_t>& oStage2)
+	{
+		const size_t iBlock = oStage1[ch >> iShift];
+		return oStage2[(iBlock << iShift) | (ch & ((1u << iShift) - 1))];
+	};
+
+	auto itRange = oProperties.begin(); // the first range that doesn't end before ch
+	for (uint32_t ch = 0; ch < 0x110000; ++ch)
+	{
+		const uint16_t iRecord = fnLookup(ch, oTables.iBlockShift, oTables.oStage1,
+			oTables.oStage2);
+		const uint16_t iDecomposition = fnLookup(ch, oTables.iDecompositionShift,
+			oTables.oDecompositionStage1, oTables.oDecompositionStage2);
+
+		while (itRange != oProperties.end() && itRange->iLast < ch)
+		{
+			++itRange;
+		}
+		if (itRange == oProperties.end() || itRange->iFirst > ch)
+		{
+			if (iRecord != 0 || iDecomposition != 0)
+				return false;
+			continue;
+		}
+		const auto& oChar = *itRange;
+
+		auto fnMapping = [&](int32_t iDelta) { return iDelta ? uint32_t(ch + iDelta) : 0; };
+		if (oChar.sGeneralCategory != szGeneralCategories[oTables.oGeneralCategories[iRecord]] ||
+			oChar.iCombiningClass != oTables.oCombiningClasses[iRecord] ||
+			oChar.sBidiClass != szBidiClasses[oTables.oBidiClasses[iRecord]] ||
+			oChar.iUpper != fnMapping(oTables.oUpperDeltas[iRecord]) ||
+			oChar.iLower != fnMapping(oTables.oLowerDeltas[iRecord]) ||
+			oChar.iTitle != fnMapping(oTables.oTitleDeltas[iRecord]))
+			return false;
 
+		std::string sDecomposition;
+		if (iDecomposition != 0)
+		{
+			const uint32_t iHeader = oTables.oDecompositions[iDecomposition];
+			if ((iHeader >> 8) > 1)
+				sDecomposition = std::string(szDecompositionTypes[iHeader >> 8]) + " ";
+			for (uint32_t i = 0; i < (iHeader & 0xFF); ++i)
+			{
+				char szCodePoint[16];
+				snprintf(szCodePoint, sizeof(szCodePoint), (i > 0) ? " %04X" : "%04X",
+					oTables.oDecompositions[iDecomposition + 1 + i]);
+				sDecomposition += szCodePoint;
+			}
+		}
+		if (sDecomposition != oChar.sDecomposition)
+			return false;
+	}
 
-		oNames[iBinVal] = szNameFinal;
+	return true;
+}
+
+void CreateBreakTables(const std::vector<CharProperties>& oProperties,
+	const std::vector<uint8_t>& oGraphemeBreaks, const std::vector<uint8_t>& oLineBreaks,
+	const std::vector<uint8_t>& oEastAsianWidths, const std::vector<uint8_t>& oEmoji,
+	std::vector<uint16_t>& oValues, BreakTables& oDest)
+{
+	oDest = {};
+
+	oValues.resize(0x110000);
+	for (uint32_t ch = 0; ch < 0x110000; ++ch)
+	{
+		uint16_t iValue = uint16_t(oLineBreaks[ch] | (oGraphemeBreaks[ch] << iGraphemeBreakShift));
+		if (oEmoji[ch] == 1)
+			iValue |= iExtendedPictographicFlag;
+		const std::string_view sWidth = szEastAsianWidths[oEastAsianWidths[ch]];
+		if (sWidth == "F" || sWidth == "W" || sWidth == "H")
+			iValue |= iEastAsianWideFlag;
+		oValues[ch] = iValue;
 	}
-	CloseHandle(hFile);
 
-	printf("Done.\n");
+	// combining marks (for resolving the line break class SA)
+	for (auto& oRange : oProperties)
+	{
+		if (oRange.sGeneralCategory != "Mn" && oRange.sGeneralCategory != "Mc")
+			continue;
 
+		for (uint32_t ch = oRange.iFirst; ch <= oRange.iLast; ++ch)
+		{
+			oValues[ch] |= iCombiningMarkFlag;
+		}
+	}
 
+	CreateTwoStageTable(oValues, oDest.iBlockShift, oDest.oStage1, oDest.oStage2);
+}
 
+bool CreateNormalizationTables(const std::vector<CharProperties>& oProperties,
+	const std::vector<uint8_t>& oExclusions, std::vector<uint16_t>& oValues,
+	NormalizationTables& oDest)
+{
+	oDest = {};
 
-	//==============================================================================================
-	// WRITE CPP FILE
+	// 1. combining classes and canonical decompositions
+	oValues.assign(0x110000, 0);
+	std::map<uint32_t, std::vector<uint32_t>> oDecompositions;
+	for (auto& oRange : oProperties)
+	{
+		for (uint32_t ch = oRange.iFirst; ch <= oRange.iLast; ++ch)
+		{
+			oValues[ch] = oRange.iCombiningClass;
+		}
 
-	hFile = CreateFileW(szOutputCPP, GENERIC_WRITE, NULL, NULL, CREATE_ALWAYS,
-		FILE_ATTRIBUTE_NORMAL, NULL);
+		if (oRange.sDecomposition.empty() || oRange.sDecomposition[0] == '<')
+			continue; // none or compatibility decomposition
 
-	if (hFile == INVALID_HANDLE_VALUE)
+		std::vector<uint32_t> oMapping;
+		if (!ParseCodePoints(oRange.sDecomposition, oMapping) || oMapping.empty())
+		{
+			printf("Error: Invalid decomposition of U+%04X\n\n", oRange.iFirst);
+			return false;
+		}
+		oDecompositions[oRange.iFirst] = std::move(oMapping);
+	}
+
+	// 2. the decomposed characters are never NFD; the primary composites can be NFC
+	std::vector<std::array<uint32_t, 3>> oCompositions; // sorted by the decomposition
+	for (auto& [ch, oMapping] : oDecompositions)
 	{
-		printf("Could not create output file \"%ls\"\n\n", szOutputCPP);
-		return 1;
+		oValues[ch] |= iNFDQuickCheckNo;
+
+		// the singletons and non-starter decompositions are excluded, even if they aren't listed
+		const bool bExcluded = oExclusions[ch] || oMapping.size() != 2 ||
+			(oValues[ch] & 0xFF) != 0 || (oValues[oMapping[0]] & 0xFF) != 0;
+		if (bExcluded)
+		{
+			oValues[ch] |= iNFCQuickCheckNo;
+			continue;
+		}
+
+		oCompositions.push_back({ oMapping[0], oMapping[1], ch });
 	}
+	std::sort(oCompositions.begin(), oCompositions.end());
 
-	printf("Writing file... ");
+	// 3. the characters that might be composed with the previous character
+	for (auto& o : oCompositions)
+	{
+		oValues[o[1]] |= iNFCQuickCheckMaybe;
+		oDest.oCompositions.insert(oDest.oCompositions.end(), o.begin(), o.end());
+	}
 
-#define WRITE_STRING(s) if (!WriteStr(hFile, s)) { CloseHandle(hFile); return 1; }
-#define ENDL "\r\n"
-
-	char szNumber[7] = {}; // codepoint value as hex string
-	char szLen[5] = {}; // length of the name
-
-	WRITE_STRING("/*"																			ENDL);
-	WRITE_STRING("This file is created automatically from UnicodeData.txt"						ENDL);
-	WRITE_STRING("*/"																			ENDL);
-	WRITE_STRING(""																				ENDL);
-	WRITE_STRING(""																				ENDL);
-	WRITE_STRING("#define LIBRARY_EXPORTS"														ENDL);
-	WRITE_STRING(""																				ENDL);
-	WRITE_STRING("#include <rl/dll/UnicodeData.hpp>" 											ENDL);
-	WRITE_STRING("#include <string.h> // strcpy_s" 												ENDL);
-	WRITE_STRING("#include <stdint.h>"															ENDL);
-	WRITE_STRING(""																				ENDL);
-	WRITE_STRING(""																				ENDL);
-	WRITE_STRING("namespace rl" 																ENDL);
-	WRITE_STRING("{"																			ENDL);
-	WRITE_STRING("	namespace UnicodeDataDLL" 													ENDL);
-	WRITE_STRING("	{" 																			ENDL);
-	WRITE_STRING("		NameLen_t __stdcall GetNameLen(UChar_t ch)"								ENDL);
-	WRITE_STRING("		{"																		ENDL);
-	WRITE_STRING("			switch (ch)" 														ENDL);
-	WRITE_STRING("			{" 																	ENDL);
-	for (auto& o : oNames)
+	// Hangul syllables are decomposed and composed algorithmically
+	for (uint32_t ch = 0xAC00; ch <= 0xD7A3; ++ch)
 	{
-		// convert codepoint to string
-		sprintf_s(szNumber, "%X", o.first);
-
-		// convert length to string
-		sprintf_s(szLen, "%X", (uint32_t)strlen(o.second) + 1);
-
-		// write case
-		WRITE_STRING("			case 0x");
-		WRITE_STRING(szNumber);
-		WRITE_STRING(":" ENDL);
-		WRITE_STRING("				return 0x");
-		WRITE_STRING(szLen);
-		WRITE_STRING(";" ENDL);
-	}
-	WRITE_STRING("			"																	ENDL);
-	WRITE_STRING("			default: // not defined" 											ENDL);
-	WRITE_STRING("				return 0;"														ENDL);
-	WRITE_STRING("			}"																	ENDL);
-	WRITE_STRING("		}"																		ENDL);
-	WRITE_STRING("		"																		ENDL);
-	WRITE_STRING("		NameLen_t __stdcall GetName(UChar_t ch, char* buf, NameLen_t buf_size)"	ENDL);
-	WRITE_STRING("		{"																		ENDL);
-	WRITE_STRING("			const NameLen_t len = GetNameLen(ch);"								ENDL);
-	WRITE_STRING("			if (len == 0 || len > buf_size)"									ENDL);
-	WRITE_STRING("				return 0;"														ENDL);
-	WRITE_STRING("			" 																	ENDL);
-	WRITE_STRING("			switch (ch)" 														ENDL);
-	WRITE_STRING("			{" 																	ENDL);
-	for (auto& o : oNames)
+		oValues[ch] |= iNFDQuickCheckNo;
+	}
+	for (uint32_t ch = 0x1161; ch <= 0x11C2; ++ch) // vowels and trailing consonants
 	{
-		// convert codepoint to string
-		sprintf_s(szNumber, "%X", o.first);
-
-		// write case
-		WRITE_STRING("			case 0x");
-		WRITE_STRING(szNumber);
-		WRITE_STRING(":" ENDL);
-		WRITE_STRING("				strcpy_s(buf, buf_size, \"");
-		WRITE_STRING(o.second);
-		WRITE_STRING("\");" ENDL);
-		WRITE_STRING("				break;" ENDL);
-	}
-	WRITE_STRING("			"																	ENDL);
-	WRITE_STRING("			default: // not defined" 											ENDL);
-	WRITE_STRING("				return 0;" 														ENDL);
-	WRITE_STRING("			}" 																	ENDL);
-	WRITE_STRING("			" 																	ENDL);
-	WRITE_STRING("			return (NameLen_t)strlen(buf);"										ENDL);
-	WRITE_STRING("		}" 																		ENDL);
-	WRITE_STRING("	}" 																			ENDL);
-	WRITE_STRING("}" 																			ENDL);
-
-#undef WRITE_STRING
-#undef ENDL
-
-	CloseHandle(hFile);
-	printf("Done.\n\nFile \"%ls\" was successfully generated\n\n", szOutputCPP);
+		if (ch <= 0x1175 || ch >= 0x11A8)
+			oValues[ch] |= iNFCQuickCheckMaybe;
+	}
 
-	return 0;
+	CreateTwoStageTable(oValues, oDest.iBlockShift, oDest.oStage1, oDest.oStage2);
+	return true;
 }
 
-
-bool ReadStr(HANDLE hFile, char** dest)
+void CreateTwoStageTable(const std::vector<uint16_t>& oValues, uint8_t& iBlockShift,
+	std::vector<uint16_t>& oStage1, std::vector<uint16_t>& oStage2)
 {
-	LARGE_INTEGER liFilePtr;
-	SetFilePointerEx(hFile, { 0 }, &liFilePtr, FILE_CURRENT);
+	constexpr uint8_t iMinShift = 4;
+	constexpr uint8_t iMaxShift = 10;
 
-	char ch = 0;
-	DWORD dwRead = 0;
+	// every block size is tried on its own thread
+	struct Candidate
+	{
+		std::vector<uint16_t> oStage1;
+		std::vector<uint16_t> oStage2;
+	};
+	Candidate oCandidates[iMaxShift - iMinShift + 1];
+	std::vector<std::thread> oThreads;
+	for (uint8_t iShift = iMinShift; iShift <= iMaxShift; ++iShift)
+	{
+		oThreads.emplace_back([&oValues, &oCandidate = oCandidates[iShift - iMinShift], iShift]
+			{
+				const uint32_t iBlockSize = 1u << iShift;
 
-	// 1. count the characters
-	uint16_t len = 0;
-	while (ch != ';')
+				// the blocks are compared bytewise; the IDs are assigned in order of appearance
+				std::unordered_map<std::string_view, uint16_t> oBlocks;
+				for (uint32_t iFirst = 0; iFirst < oValues.size(); iFirst += iBlockSize)
+				{
+					const std::string_view sBlock(
+						reinterpret_cast<const char*>(oValues.data() + iFirst),
+						iBlockSize * sizeof(uint16_t));
+
+					auto itBlock = oBlocks.find(sBlock);
+					if (itBlock == oBlocks.end())
+					{
+						itBlock = oBlocks.emplace(sBlock, (uint16_t)oBlocks.size()).first;
+						oCandidate.oStage2.insert(oCandidate.oStage2.end(),
+							oValues.begin() + iFirst, oValues.begin() + iFirst + iBlockSize);
+					}
+					oCandidate.oStage1.push_back(itBlock->second);
+				}
+			});
+	}
+	for (auto& oThread : oThreads)
 	{
-		if (!ReadFile(hFile, &ch, 1, &dwRead, NULL))
-			return false;
+		oThread.join();
+	}
 
-		++len;
+	// smallest tables; the smaller block size on a tie
+	size_t iBestSize = SIZE_MAX;
+	for (uint8_t iShift = iMinShift; iShift <= iMaxShift; ++iShift)
+	{
+		auto& oCandidate = oCandidates[iShift - iMinShift];
+		const size_t iSize =
+			(oCandidate.oStage1.size() + oCandidate.oStage2.size()) * sizeof(uint16_t);
+		if (iSize < iBestSize)
+		{
+			iBestSize = iSize;
+			iBlockShift = iShift;
+			oStage1 = std::move(oCandidate.oStage1);
+			oStage2 = std::move(oCandidate.oStage2);
+		}
 	}
+}
 
-	*dest = new char[len];
-	(*dest)[len - 1] = 0; // terminating zero
+bool ParseCodePoints(std::string_view s, std::vector<uint32_t>& oDest)
+{
+	const char* p = s.data();
+	const char* const pEnd = p + s.length();
+	while (p < pEnd)
+	{
+		if (*p == ' ')
+		{
+			++p;
+			continue;
+		}
 
-	SetFilePointerEx(hFile, liFilePtr, NULL, FILE_BEGIN); // reset to start of value
+		uint32_t iCodePoint = 0;
+		const auto oResult = std::from_chars(p, pEnd, iCodePoint, 16);
+		if (oResult.ec != std::errc())
+			return false;
+		oDest.push_back(iCodePoint);
+		p = oResult.ptr;
+	}
 
-	// 2. read the characters
-	if (!ReadFile(hFile, *dest, len - 1, &dwRead, NULL))
+	return true;
+}
+
+std::string ToUpper(std::string_view sText)
+{
+	std::string s(sText);
+	for (char& c : s)
 	{
-		delete[](*dest);
-		*dest = nullptr;
-		return false;
+		if (c >= 'a' && c <= 'z')
+			c = char(c - 'a' + 'A');
 	}
-	SetFilePointer(hFile, 1, NULL, FILE_CURRENT); // skip ";"
 
-	return true;
+	return s;
 }
 
-bool SkipVal(HANDLE hFile)
+template <size_t N>
+bool ParsePropertyFile(std::string_view sInput, const char* const (&szValues)[N],
+	bool bIgnoreUnknown, std::vector<uint8_t>& oDest)
 {
-	char ch = 0;
-	DWORD dwRead = 0;
+	auto fnTrim = [](std::string_view s)
+	{
+		while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+			s.remove_prefix(1);
+		while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+			s.remove_suffix(1);
+		return s;
+	};
+
+	// "XXXX[..YYYY]; value" --> oDest
+	auto fnParseLine = [&](std::string_view sLine)
+	{
+		std::string_view oFields[2];
+		if (SplitFields(sLine, oFields) < 2)
+			return false;
 
-	while (ch != ';')
-		if (!ReadFile(hFile, &ch, 1, &dwRead, NULL))
+		const std::string_view sRange = fnTrim(oFields[0]);
+		const std::string_view sValue = fnTrim(oFields[1]);
+		const size_t iDots = sRange.find("..");
+		uint32_t iFirst = 0;
+		uint32_t iLast = 0;
+		if (sRange.empty() || !ParseHex(sRange.substr(0, iDots), iFirst))
+			return false;
+		if (iDots == std::string_view::npos)
+			iLast = iFirst;
+		else if (!ParseHex(sRange.substr(iDots + 2), iLast))
+			return false;
+		if (iFirst > iLast || iLast >= 0x110000)
 			return false;
 
+		size_t iValue = 0;
+		while (iValue < N && sValue != szValues[iValue])
+		{
+			++iValue;
+		}
+		if (iValue == N)
+			return bIgnoreUnknown;
+
+		std::fill(oDest.begin() + iFirst, oDest.begin() + iLast + 1, (uint8_t)iValue);
+		return true;
+	};
+
+	// two passes, so the defaults never overwrite listed values
+	const std::string_view sMissing = "# @missing:";
+	for (const bool bDefaults : { true, false })
+	{
+		std::string_view sText = sInput;
+		while (!sText.empty())
+		{
+			const size_t iEnd = sText.find('\n');
+			std::string_view sLine = sText.substr(0, iEnd);
+			sText.remove_prefix((iEnd == std::string_view::npos) ? sText.length() : iEnd + 1);
+
+			if (bDefaults)
+			{
+				if (sLine.substr(0, sMissing.length()) == sMissing &&
+					!fnParseLine(sLine.substr(sMissing.length())))
+					return false;
+				continue;
+			}
+
+			sLine = fnTrim(sLine.substr(0, sLine.find('#')));
+			if (!sLine.empty() && !fnParseLine(sLine))
+				return false;
+		}
+	}
+
 	return true;
 }
 
-bool WriteStr(HANDLE hFile, const char* sz)
+std::string GetUCDVersion(std::string_view sInput)
 {
-	const size_t len = strlen(sz);
-	DWORD dwWritten = 0;
-	if (!WriteFile(hFile, sz, (DWORD)len, &dwWritten, NULL) || dwWritten != len)
-		return false;
+	// "# Name-X.Y.Z.txt"
+	std::string_view sLine = sInput.substr(0, sInput.find('\n'));
+	while (!sLine.empty() && (sLine.back() == '\r' || sLine.back() == ' '))
+		sLine.remove_suffix(1);
+
+	const std::string_view sExtension = ".txt";
+	if (sLine.substr(0, 2) != "# " || sLine.length() < sExtension.length() ||
+		sLine.substr(sLine.length() - sExtension.length()) != sExtension)
+		return {};
+	sLine.remove_suffix(sExtension.length());
+
+	const size_t iDash = sLine.find_last_of('-');
+	if (iDash == std::string_view::npos)
+		return {};
+	const std::string_view sVersion = sLine.substr(iDash + 1);
+	if (sVersion.empty() || sVersion.front() == '.' || sVersion.back() == '.' ||
+		sVersion.find_first_not_of("0123456789.") != std::string_view::npos)
+		return {};
+
+	return std::string(sVersion);
+}
 
-	return true;
+template <typename T>
+void WriteArray(std::string& sDest, const char* szType, const char* szName,
+	const std::vector<T>& oValues)
+{
+	char szValue[16];
+
+	sDest += "\t\t\t";
+	sDest += szType;
+	sDest += " ";
+	sDest += szName;
+	sDest += "[] =\n\t\t\t{";
+
+	// values per line, so a line stays within 100 columns (tab width 4)
+	const size_t iPerLine = (sizeof(T) == 1) ? 12 : (sizeof(T) == 2 ? 10 : 7);
+	for (size_t i = 0; i < oValues.size(); ++i)
+	{
+		if (i % iPerLine == 0)
+			sDest += "\n\t\t\t\t";
+		else
+			sDest += " ";
+
+		if (std::is_signed<T>::value)
+			snprintf(szValue, sizeof(szValue), "%d,", (int)oValues[i]);
+		else
+			snprintf(szValue, sizeof(szValue), "0x%0*X,", int(sizeof(T) * 2), (unsigned)oValues[i]);
+		sDest += szValue;
+	}
+
+	sDest += "\n\t\t\t};\n\n";
 }